@@ -98,6 +98,7 @@ int main(int argc, char **argv) {
 
 
     ierr = opt->WriteLogFile(); CHKERRQ(ierr);
+    ierr = opt->WriteJSONLog(); CHKERRQ(ierr);
     ierr = opt->DisplayTimeToSolution(); CHKERRQ(ierr);
 
     if (opt != NULL) {delete opt; opt = NULL;}
@@ -1,37 +1,1467 @@
-#include <iostream>
-#include "petsc.h"
+/*************************************************************************
+ *  Copyright (c) 2016.
+ *  All rights reserved.
+ *  This file is part of the CLAIRE library.
+ *
+ *  CLAIRE is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CLAIRE is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CLAIRE. If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
 
+#include <cstdio>
+#include "CLAIREUtils.hpp"
+#include "RegOpt.hpp"
+#include "VecField.hpp"
+#include "CLAIRE.hpp"
+#include "Optimizer.hpp"
+#include "ReadWriteReg.hpp"
+#include "DistanceMeasureMI.hpp"
+#include "Preprocessing.hpp"
+#include "SemiLagrangian.hpp"
+#include "CommCounter.hpp"
+
+PetscErrorCode CheckLBFGSConvergence(reg::RegOpt*, bool&);
+PetscErrorCode CheckDistanceGradient(reg::RegOpt*, reg::DMType, std::string, bool&);
+PetscErrorCode CheckParzenWindow(reg::RegOpt*, bool&);
+PetscErrorCode CheckCLRReadWrite(reg::RegOpt*, bool&);
+PetscErrorCode CheckNIIReadWrite(reg::RegOpt*, bool&);
+PetscErrorCode CheckTimeSeries(reg::RegOpt*, bool&);
+PetscErrorCode CheckScalingSquaring(reg::RegOpt*, bool&);
+PetscErrorCode CheckInverseDeformationMap(reg::RegOpt*, bool&);
+PetscErrorCode CheckDetDefGradLowMem(reg::RegOpt*, bool&);
+PetscErrorCode CheckRecursiveSmoothing(reg::RegOpt*, bool&);
+PetscErrorCode CheckPlacedComponents(reg::RegOpt*, bool&);
+PetscErrorCode CheckFusedReductions(reg::RegOpt*, bool&);
+PetscErrorCode CheckRestrictionCache(reg::RegOpt*, bool&);
+PetscErrorCode CheckCommCounterReset(reg::RegOpt*, bool&);
+
+PetscErrorCode ComputeSyntheticData(reg::VecField*&, reg::RegOpt*, int);
+PetscErrorCode ComputeRegularGrid(reg::VecField*&, reg::RegOpt*);
+
+PetscErrorCode ReportCheck(std::string, ScalarType, ScalarType, bool&);
+
+
+
+
+/********************************************************************
+ * @brief main function to run consistency checks; the checks run on
+ * synthetic data on the grid defined by the user (e.g., -nx 16); the
+ * program returns a nonzero exit code if any of the checks fails
+ *******************************************************************/
 int main(int argc, char **argv) {
-    PetscErrorCode ierr;
-    PetscScalar maxval, minval;
-    PetscInt posmin, posmax;
-    Vec x; PetscScalar* p_x = NULL;
+    PetscErrorCode ierr = 0;
+    reg::RegOpt* opt = NULL;
+    int nfailed = 0;
+    bool passed;
+    std::stringstream ss;
 
+    // initialize petsc (user is not allowed to set petsc options)
     ierr = PetscInitialize(0, reinterpret_cast<char***>(NULL),
                               reinterpret_cast<char*>(NULL),
                               reinterpret_cast<char*>(NULL)); CHKERRQ(ierr);
-    PetscInt n = 16;
+    PetscFunctionBegin;
+
+    // allocate class for controlling everything
+    try {opt = new reg::RegOpt(argc, argv);}
+    catch (std::bad_alloc& err) {
+        ierr = reg::ThrowError(err); CHKERRQ(ierr);
+    }
+    ierr = opt->DoSetup(false); CHKERRQ(ierr);
+
+    ierr = CheckLBFGSConvergence(opt, passed); CHKERRQ(ierr);
+    if (!passed) ++nfailed;
+
+    ierr = CheckDistanceGradient(opt, reg::LNCC, "lncc", passed); CHKERRQ(ierr);
+    if (!passed) ++nfailed;
+
+    ierr = CheckDistanceGradient(opt, reg::MI, "mi", passed); CHKERRQ(ierr);
+    if (!passed) ++nfailed;
+
+    ierr = CheckParzenWindow(opt, passed); CHKERRQ(ierr);
+    if (!passed) ++nfailed;
+
+    ierr = CheckCLRReadWrite(opt, passed); CHKERRQ(ierr);
+    if (!passed) ++nfailed;
+
+    ierr = CheckNIIReadWrite(opt, passed); CHKERRQ(ierr);
+    if (!passed) ++nfailed;
+
+    ierr = CheckTimeSeries(opt, passed); CHKERRQ(ierr);
+    if (!passed) ++nfailed;
+
+    ierr = CheckScalingSquaring(opt, passed); CHKERRQ(ierr);
+    if (!passed) ++nfailed;
+
+    ierr = CheckInverseDeformationMap(opt, passed); CHKERRQ(ierr);
+    if (!passed) ++nfailed;
+
+    ierr = CheckDetDefGradLowMem(opt, passed); CHKERRQ(ierr);
+    if (!passed) ++nfailed;
+
+    ierr = CheckRecursiveSmoothing(opt, passed); CHKERRQ(ierr);
+    if (!passed) ++nfailed;
+
+    ierr = CheckPlacedComponents(opt, passed); CHKERRQ(ierr);
+    if (!passed) ++nfailed;
+
+    ierr = CheckFusedReductions(opt, passed); CHKERRQ(ierr);
+    if (!passed) ++nfailed;
+
+    ierr = CheckRestrictionCache(opt, passed); CHKERRQ(ierr);
+    if (!passed) ++nfailed;
+
+    ierr = CheckCommCounterReset(opt, passed); CHKERRQ(ierr);
+    if (!passed) ++nfailed;
+
+    ss << nfailed << " check(s) failed";
+    ierr = reg::Msg(ss.str()); CHKERRQ(ierr);
+    ss.str(std::string()); ss.clear();
+
+    if (opt != NULL) {delete opt; opt = NULL;}
+
+    ierr = reg::Finalize(); CHKERRQ(ierr);
+
+    return nfailed > 0 ? 1 : 0;
+}
+
+
+
+
+/********************************************************************
+ * @brief check that the limited memory bfgs method reduces the
+ * relative gradient below the user defined tolerance on a synthetic
+ * problem
+ *******************************************************************/
+PetscErrorCode CheckLBFGSConvergence(reg::RegOpt* opt, bool& passed) {
+    PetscErrorCode ierr = 0;
+    Vec mR = NULL, mT = NULL;
+    reg::VecField* v = NULL;
+    reg::CLAIRE* registration = NULL;
+    reg::Optimizer* optimizer = NULL;
+    reg::OptMeth method;
+    int maxiter;
+    ScalarType relgrad;
+    bool converged = false;
+    PetscFunctionBegin;
+
+    ierr = reg::DbgMsg("checking convergence of l-bfgs"); CHKERRQ(ierr);
+
+    // remember the options we change
+    method = opt->m_OptPara.method;
+    maxiter = opt->m_OptPara.maxiter;
+
+    opt->m_OptPara.method = reg::QUASINEWTON;
+    opt->m_OptPara.maxiter = 50;
+
+    try {registration = new reg::CLAIRE(opt);}
+    catch (std::bad_alloc& err) {
+        ierr = reg::ThrowError(err); CHKERRQ(ierr);
+    }
+    ierr = registration->SetupSyntheticProb(mR, mT); CHKERRQ(ierr);
+    ierr = registration->SetReferenceImage(mR); CHKERRQ(ierr);
+    ierr = registration->SetTemplateImage(mT); CHKERRQ(ierr);
+
+    try {v = new reg::VecField(opt);}
+    catch (std::bad_alloc& err) {
+        ierr = reg::ThrowError(err); CHKERRQ(ierr);
+    }
+    ierr = v->SetValue(0.0); CHKERRQ(ierr);
+
+    ierr = registration->SetControlVariable(v); CHKERRQ(ierr);
+    ierr = registration->InitializeSolver(); CHKERRQ(ierr);
+    ierr = registration->InitializeOptimization(); CHKERRQ(ierr);
+
+    try {optimizer = new reg::Optimizer(opt);}
+    catch (std::bad_alloc& err) {
+        ierr = reg::ThrowError(err); CHKERRQ(ierr);
+    }
+    ierr = optimizer->SetProblem(registration); CHKERRQ(ierr);
+    ierr = optimizer->SetInitialGuess(v); CHKERRQ(ierr);
+    ierr = optimizer->Run(); CHKERRQ(ierr);
+    ierr = optimizer->GetSolutionStatus(converged); CHKERRQ(ierr);
+
+    // ||g(v)||/||g(v0)|| is the stopping condition of the optimizer
+    relgrad = opt->m_Monitor.gradnorm;
+    relgrad /= opt->m_Monitor.gradnorm0 > 0.0 ? opt->m_Monitor.gradnorm0 : 1.0;
+
+    ierr = ReportCheck("l-bfgs: relative gradient", relgrad, opt->m_OptPara.tol[2], passed); CHKERRQ(ierr);
+    passed = passed && converged;
+
+    // reset options
+    opt->m_OptPara.method = method;
+    opt->m_OptPara.maxiter = maxiter;
+
+    if (optimizer != NULL) {delete optimizer; optimizer = NULL;}
+    if (registration != NULL) {delete registration; registration = NULL;}
+    if (v != NULL) {delete v; v = NULL;}
+    if (mR != NULL) {ierr = VecDestroy(&mR); CHKERRQ(ierr); mR = NULL;}
+    if (mT != NULL) {ierr = VecDestroy(&mT); CHKERRQ(ierr); mT = NULL;}
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief check the gradient for a given distance measure against
+ * central differences of the objective along a smooth direction w,
+ * i.e., (J(v + hw) - J(v - hw))/(2h) = <g(v), w> + O(h^2)
+ *******************************************************************/
+PetscErrorCode CheckDistanceGradient(reg::RegOpt* opt, reg::DMType type,
+                                     std::string name, bool& passed) {
+    PetscErrorCode ierr = 0;
+    Vec mR = NULL, mT = NULL, v = NULL, w = NULL, vtilde = NULL, g = NULL;
+    reg::VecField *vf = NULL, *wf = NULL;
+    reg::CLAIRE* registration = NULL;
+    reg::DMType distance;
+    ScalarType h, jv, jp, jm, wtg, fd, error, minerror, scale;
+    IntType nl, ng;
+    std::stringstream ss;
+    PetscFunctionBegin;
+
+    ierr = reg::DbgMsg("checking gradient for " + name); CHKERRQ(ierr);
+
+    nl = opt->m_Domain.nl;
+    ng = opt->m_Domain.ng;
+
+    // remember the options we change
+    distance = opt->m_Distance.type;
+    scale = opt->m_Distance.scale;
+
+    opt->m_Distance.type = type;
+
+    try {registration = new reg::CLAIRE(opt);}
+    catch (std::bad_alloc& err) {
+        ierr = reg::ThrowError(err); CHKERRQ(ierr);
+    }
+    ierr = registration->SetupSyntheticProb(mR, mT); CHKERRQ(ierr);
+    ierr = registration->SetReferenceImage(mR); CHKERRQ(ierr);
+    ierr = registration->SetTemplateImage(mT); CHKERRQ(ierr);
+
+    // velocity and perturbation (optimizer uses flat vectors)
+    ierr = ComputeSyntheticData(vf, opt, 0); CHKERRQ(ierr);
+    ierr = ComputeSyntheticData(wf, opt, 1); CHKERRQ(ierr);
+
+    ierr = reg::VecCreate(v, 3*nl, 3*ng); CHKERRQ(ierr);
+    ierr = VecDuplicate(v, &w); CHKERRQ(ierr);
+    ierr = VecDuplicate(v, &vtilde); CHKERRQ(ierr);
+    ierr = VecDuplicate(v, &g); CHKERRQ(ierr);
+    ierr = vf->GetComponents(v); CHKERRQ(ierr);
+    ierr = wf->GetComponents(w); CHKERRQ(ierr);
+
+    // the gradient needs the state for v
+    ierr = registration->EvaluateObjective(&jv, v); CHKERRQ(ierr);
+    ierr = registration->EvaluateGradient(g, v); CHKERRQ(ierr);
+    ierr = VecTDot(w, g, &wtg); CHKERRQ(ierr);
+
+    // the error decreases with h until round off dominates; we
+    // keep the smallest error
+    minerror = PETSC_MAX_REAL;
+    h = 1E-1;
+    for (int i = 0; i < 4; ++i) {
+        ierr = VecWAXPY(vtilde, h, w, v); CHKERRQ(ierr);
+        ierr = registration->EvaluateObjective(&jp, vtilde); CHKERRQ(ierr);
+        ierr = VecWAXPY(vtilde, -h, w, v); CHKERRQ(ierr);
+        ierr = registration->EvaluateObjective(&jm, vtilde); CHKERRQ(ierr);
+
+        fd = (jp - jm)/(2.0*h);
+        error = std::abs(fd - wtg);
+        error /= std::abs(wtg) > 0.0 ? std::abs(wtg) : 1.0;
+        minerror = error < minerror ? error : minerror;
+
+        if (opt->m_Verbosity > 1) {
+            ss  << "h = " << std::scientific << h << " <g,w> = " << wtg
+                << " fd = " << fd << " rel. error = " << error;
+            ierr = reg::DbgMsg(ss.str()); CHKERRQ(ierr);
+            ss.str(std::string()); ss.clear();
+        }
+        h /= 10.0;
+    }
+
+    ierr = ReportCheck(name + ": gradient vs finite differences", minerror, 5E-2, passed); CHKERRQ(ierr);
+
+    // reset options
+    opt->m_Distance.type = distance;
+    opt->m_Distance.scale = scale;
+
+    if (registration != NULL) {delete registration; registration = NULL;}
+    if (vf != NULL) {delete vf; vf = NULL;}
+    if (wf != NULL) {delete wf; wf = NULL;}
+    if (v != NULL) {ierr = VecDestroy(&v); CHKERRQ(ierr); v = NULL;}
+    if (w != NULL) {ierr = VecDestroy(&w); CHKERRQ(ierr); w = NULL;}
+    if (g != NULL) {ierr = VecDestroy(&g); CHKERRQ(ierr); g = NULL;}
+    if (vtilde != NULL) {ierr = VecDestroy(&vtilde); CHKERRQ(ierr); vtilde = NULL;}
+    if (mR != NULL) {ierr = VecDestroy(&mR); CHKERRQ(ierr); mR = NULL;}
+    if (mT != NULL) {ierr = VecDestroy(&mT); CHKERRQ(ierr); mT = NULL;}
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief check that the weights of the parzen window for mutual
+ * information sum to one on the entire intensity range (including
+ * the bounds) and that no intensity below the maximum is treated as
+ * outside of the range (which zeroes the derivative)
+ *******************************************************************/
+PetscErrorCode CheckParzenWindow(reg::RegOpt* opt, bool& passed) {
+    PetscErrorCode ierr = 0;
+    ScalarType lo = 0.0, hi = 1.0, dv, v, w[4], dw[4], wsum, error = 0.0;
+    int nb, i0, n = 100;
+    bool inside = true;
+    PetscFunctionBegin;
+
+    ierr = reg::DbgMsg("checking parzen window for mi"); CHKERRQ(ierr);
+
+    nb = opt->m_Distance.mibins;
+    dv = (hi - lo)/static_cast<ScalarType>(nb - 4);
+
+    for (int k = 0; k <= n; ++k) {
+        v = lo + (hi - lo)*static_cast<ScalarType>(k)/static_cast<ScalarType>(n);
+        // (at the bounds, round off may put v outside of the range)
+        if (!reg::DistanceMeasureMI::ParzenWindow(v, lo, dv, nb, i0, w, dw, NULL)) {
+            inside = inside && (k == 0 || k == n);
+        }
+        inside = inside && i0 >= 0 && i0 + 3 < nb;
+
+        wsum = w[0] + w[1] + w[2] + w[3];
+        error = PetscMax(error, PetscAbsReal(wsum - 1.0));
+    }
+
+    ierr = ReportCheck("mi: parzen window partition of unity", error, 1E2*PETSC_MACHINE_EPSILON, passed); CHKERRQ(ierr);
+    passed = passed && inside;
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief check that writing and reading a claire volume (*.clr)
+ * reproduces the data (the format is lossless); we read the file
+ * back with the decomposition it was written with and (if we have
+ * more than one task) with a different process grid
+ *******************************************************************/
+PetscErrorCode CheckCLRReadWrite(reg::RegOpt* opt, bool& passed) {
+    PetscErrorCode ierr = 0;
+    PetscFunctionBegin;
+
+#ifdef REG_HAS_ZLIB
+    Vec x = NULL;
+    reg::VecField *v = NULL, *vg = NULL;
+    reg::RegOpt* optg = NULL;
+    reg::ReadWriteReg *readwrite = NULL, *readwriteg = NULL;
+    std::string filename = "checkclaire.clr";
+    ScalarType value, normx;
+    int rank, nprocs, np[2];
+    bool passedg;
+
+    ierr = reg::DbgMsg("checking read/write of claire volume"); CHKERRQ(ierr);
+
+    MPI_Comm_rank(PETSC_COMM_WORLD, &rank);
+    MPI_Comm_size(PETSC_COMM_WORLD, &nprocs);
+
+    try {readwrite = new reg::ReadWriteReg(opt);}
+    catch (std::bad_alloc& err) {
+        ierr = reg::ThrowError(err); CHKERRQ(ierr);
+    }
+
+    ierr = ComputeSyntheticData(v, opt, 0); CHKERRQ(ierr);
+
+    // write adds the output folder; read takes the full path
+    ierr = readwrite->Write(v->m_X1, filename); CHKERRQ(ierr);
+    ierr = readwrite->Read(&x, opt->m_FileNames.xfolder + filename); CHKERRQ(ierr);
+    ierr = reg::Assert(x != NULL, "null pointer"); CHKERRQ(ierr);
+
+    ierr = VecNorm(v->m_X1, NORM_2, &normx); CHKERRQ(ierr);
+    ierr = VecAXPY(x, -1.0, v->m_X1); CHKERRQ(ierr);
+    ierr = VecNorm(x, NORM_2, &value); CHKERRQ(ierr);
+    value /= normx > 0.0 ? normx : 1.0;
+
+    ierr = ReportCheck("clr: write/read round trip", value, PETSC_MACHINE_EPSILON, passed); CHKERRQ(ierr);
+
+    // read back on a different process grid (the pencils have a
+    // different shape; swapping p1 x p2 keeps the number of tasks)
+    if (nprocs > 1) {
+        np[0] = opt->m_CartGridDims[1];
+        np[1] = opt->m_CartGridDims[0];
+        if (np[0] == np[1]) {
+            np[0] = 1; np[1] = nprocs;
+        }
+
+        try {optg = new reg::RegOpt(*opt);}
+        catch (std::bad_alloc& err) {
+            ierr = reg::ThrowError(err); CHKERRQ(ierr);
+        }
+        optg->m_CartGridDims[0] = np[0];
+        optg->m_CartGridDims[1] = np[1];
+        ierr = optg->DoSetup(false); CHKERRQ(ierr);
+
+        try {readwriteg = new reg::ReadWriteReg(optg);}
+        catch (std::bad_alloc& err) {
+            ierr = reg::ThrowError(err); CHKERRQ(ierr);
+        }
+
+        // the synthetic field does not depend on the decomposition
+        ierr = ComputeSyntheticData(vg, optg, 0); CHKERRQ(ierr);
+        ierr = readwriteg->Read(&x, optg->m_FileNames.xfolder + filename); CHKERRQ(ierr);
+        ierr = reg::Assert(x != NULL, "null pointer"); CHKERRQ(ierr);
+
+        ierr = VecAXPY(x, -1.0, vg->m_X1); CHKERRQ(ierr);
+        ierr = VecNorm(x, NORM_2, &value); CHKERRQ(ierr);
+        value /= normx > 0.0 ? normx : 1.0;
+
+        ierr = ReportCheck("clr: read on different process grid", value, PETSC_MACHINE_EPSILON, passedg); CHKERRQ(ierr);
+        passed = passed && passedg;
+
+        if (x != NULL) {ierr = VecDestroy(&x); CHKERRQ(ierr); x = NULL;}
+        if (vg != NULL) {delete vg; vg = NULL;}
+        if (readwriteg != NULL) {delete readwriteg; readwriteg = NULL;}
+        if (optg != NULL) {delete optg; optg = NULL;}
+    }
+
+    if (rank == 0) std::remove((opt->m_FileNames.xfolder + filename).c_str());
+
+    if (readwrite != NULL) {delete readwrite; readwrite = NULL;}
+    if (v != NULL) {delete v; v = NULL;}
+    if (x != NULL) {ierr = VecDestroy(&x); CHKERRQ(ierr); x = NULL;}
+#else
+    ierr = reg::WrngMsg("zlib support not enabled; skipping check for claire volumes"); CHKERRQ(ierr);
+    passed = true;
+#endif
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief check that an uncompressed nifti image written and read with
+ * mpi-io (one block per rank) matches the original data, also if we
+ * read it back on a different process grid
+ *******************************************************************/
+PetscErrorCode CheckNIIReadWrite(reg::RegOpt* opt, bool& passed) {
+    PetscErrorCode ierr = 0;
+    PetscFunctionBegin;
+
+#ifdef REG_HAS_NIFTI
+    Vec x = NULL;
+    reg::VecField *v = NULL, *vg = NULL;
+    reg::RegOpt* optg = NULL;
+    reg::ReadWriteReg *readwrite = NULL, *readwriteg = NULL;
+    std::string filename = "checkclaire.nii";
+    ScalarType value, normx;
+    int rank, nprocs, np[2];
+    bool passedg;
+
+    ierr = reg::DbgMsg("checking read/write of nifti image (mpi-io)"); CHKERRQ(ierr);
+
+    MPI_Comm_rank(PETSC_COMM_WORLD, &rank);
+    MPI_Comm_size(PETSC_COMM_WORLD, &nprocs);
+
+    try {readwrite = new reg::ReadWriteReg(opt);}
+    catch (std::bad_alloc& err) {
+        ierr = reg::ThrowError(err); CHKERRQ(ierr);
+    }
+
+    ierr = ComputeSyntheticData(v, opt, 0); CHKERRQ(ierr);
+
+    // write adds the output folder; read takes the full path
+    ierr = readwrite->Write(v->m_X1, filename); CHKERRQ(ierr);
+    ierr = readwrite->Flush(); CHKERRQ(ierr);
+    ierr = readwrite->Read(&x, opt->m_FileNames.xfolder + filename); CHKERRQ(ierr);
+    ierr = reg::Assert(x != NULL, "null pointer"); CHKERRQ(ierr);
+
+    ierr = VecNorm(v->m_X1, NORM_2, &normx); CHKERRQ(ierr);
+    ierr = VecAXPY(x, -1.0, v->m_X1); CHKERRQ(ierr);
+    ierr = VecNorm(x, NORM_2, &value); CHKERRQ(ierr);
+    value /= normx > 0.0 ? normx : 1.0;
+
+    ierr = ReportCheck("nii: write/read round trip", value, PETSC_MACHINE_EPSILON, passed); CHKERRQ(ierr);
+
+    // read back on a different process grid (see CheckCLRReadWrite)
+    if (nprocs > 1) {
+        np[0] = opt->m_CartGridDims[1];
+        np[1] = opt->m_CartGridDims[0];
+        if (np[0] == np[1]) {
+            np[0] = 1; np[1] = nprocs;
+        }
+
+        try {optg = new reg::RegOpt(*opt);}
+        catch (std::bad_alloc& err) {
+            ierr = reg::ThrowError(err); CHKERRQ(ierr);
+        }
+        optg->m_CartGridDims[0] = np[0];
+        optg->m_CartGridDims[1] = np[1];
+        ierr = optg->DoSetup(false); CHKERRQ(ierr);
+
+        try {readwriteg = new reg::ReadWriteReg(optg);}
+        catch (std::bad_alloc& err) {
+            ierr = reg::ThrowError(err); CHKERRQ(ierr);
+        }
+
+        ierr = ComputeSyntheticData(vg, optg, 0); CHKERRQ(ierr);
+        ierr = readwriteg->Read(&x, optg->m_FileNames.xfolder + filename); CHKERRQ(ierr);
+        ierr = reg::Assert(x != NULL, "null pointer"); CHKERRQ(ierr);
+
+        ierr = VecAXPY(x, -1.0, vg->m_X1); CHKERRQ(ierr);
+        ierr = VecNorm(x, NORM_2, &value); CHKERRQ(ierr);
+        value /= normx > 0.0 ? normx : 1.0;
+
+        ierr = ReportCheck("nii: read on different process grid", value, PETSC_MACHINE_EPSILON, passedg); CHKERRQ(ierr);
+        passed = passed && passedg;
+
+        if (x != NULL) {ierr = VecDestroy(&x); CHKERRQ(ierr); x = NULL;}
+        if (vg != NULL) {delete vg; vg = NULL;}
+        if (readwriteg != NULL) {delete readwriteg; readwriteg = NULL;}
+        if (optg != NULL) {delete optg; optg = NULL;}
+    }
+
+    if (rank == 0) std::remove((opt->m_FileNames.xfolder + filename).c_str());
+
+    if (readwrite != NULL) {delete readwrite; readwrite = NULL;}
+    if (v != NULL) {delete v; v = NULL;}
+    if (x != NULL) {ierr = VecDestroy(&x); CHKERRQ(ierr); x = NULL;}
+#else
+    ierr = reg::WrngMsg("nifti support not enabled; skipping check for nifti images"); CHKERRQ(ierr);
+    passed = true;
+#endif
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief check that a time series recorded one time point at a time
+ * (see ReadWriteReg::AppendTimeSeries) can be read back; we record
+ * nt+1 time points with two components each (time point j holds
+ * (j+1)*v); for netcdf output all records are in a single file, for
+ * the other formats there is one file per time point and component
+ *******************************************************************/
+PetscErrorCode CheckTimeSeries(reg::RegOpt* opt, bool& passed) {
+    PetscErrorCode ierr = 0;
+    Vec x = NULL, y = NULL;
+    reg::VecField* v = NULL;
+    reg::ReadWriteReg* readwrite = NULL;
+    std::string filename = "checkclaire-ts", extension, ext;
+    std::vector<std::string> formats;
+    std::stringstream ss;
+    ScalarType *p_x = NULL, value, normx, error = 0.0;
+    const ScalarType *p_v[2] = {NULL, NULL};
+    IntType nl, ng, nt = 2, nc = 2;
+    int rank;
+#ifdef REG_HAS_PNETCDF
+    int ncerr, fileid, varid;
+    MPI_Offset istart[5], isize[5];
+#endif
+    PetscFunctionBegin;
+
+    ierr = reg::DbgMsg("checking time series output"); CHKERRQ(ierr);
+
+    MPI_Comm_rank(PETSC_COMM_WORLD, &rank);
+
+    nl = opt->m_Domain.nl;
+    ng = opt->m_Domain.ng;
+
+#ifdef REG_HAS_PNETCDF
+    formats.push_back(".nc");
+#endif
+#ifdef REG_HAS_NIFTI
+    formats.push_back(".nii");
+#endif
+#ifdef REG_HAS_ZLIB
+    formats.push_back(".clr");
+#endif
+    if (formats.empty()) {
+        ierr = reg::WrngMsg("no output format with parallel read enabled; skipping check for time series"); CHKERRQ(ierr);
+        passed = true;
+        PetscFunctionReturn(ierr);
+    }
+
+    // remember the options we change
+    extension = opt->m_FileNames.extension;
+
+    try {readwrite = new reg::ReadWriteReg(opt);}
+    catch (std::bad_alloc& err) {
+        ierr = reg::ThrowError(err); CHKERRQ(ierr);
+    }
+
+    ierr = ComputeSyntheticData(v, opt, 0); CHKERRQ(ierr);
+    ierr = VecNorm(v->m_X1, NORM_2, &normx); CHKERRQ(ierr);
+    normx = normx > 0.0 ? normx : 1.0;
+
+    ierr = reg::VecCreate(x, nc*nl, nc*ng); CHKERRQ(ierr);
+
+    for (size_t f = 0; f < formats.size(); ++f) {
+        ext = formats[f];
+        opt->m_FileNames.extension = ext;
+
+        // record time points
+        ierr = readwrite->OpenTimeSeries(filename, nc); CHKERRQ(ierr);
+        for (IntType j = 0; j <= nt; ++j) {
+            ierr = VecGetArray(x, &p_x); CHKERRQ(ierr);
+            ierr = VecGetArrayRead(v->m_X1, &p_v[0]); CHKERRQ(ierr);
+            ierr = VecGetArrayRead(v->m_X2, &p_v[1]); CHKERRQ(ierr);
+            for (IntType k = 0; k < nc; ++k) {
+                for (IntType i = 0; i < nl; ++i) {
+                    p_x[k*nl + i] = static_cast<ScalarType>(j+1)*p_v[k][i];
+                }
+            }
+            ierr = VecRestoreArrayRead(v->m_X2, &p_v[1]); CHKERRQ(ierr);
+            ierr = VecRestoreArrayRead(v->m_X1, &p_v[0]); CHKERRQ(ierr);
+            ierr = VecRestoreArray(x, &p_x); CHKERRQ(ierr);
+            ierr = readwrite->AppendTimeSeries(x, 0); CHKERRQ(ierr);
+        }
+        ierr = readwrite->CloseTimeSeries(); CHKERRQ(ierr);
+        ierr = readwrite->Flush(); CHKERRQ(ierr);
+
+        // read back and compare
+        for (IntType j = 0; j <= nt; ++j) {
+            for (IntType k = 0; k < nc; ++k) {
+                if (ext == ".nc") {
+#ifdef REG_HAS_PNETCDF
+                    if (y == NULL) {
+                        ierr = reg::VecCreate(y, nl, ng); CHKERRQ(ierr);
+                    }
+                    ncerr = ncmpi_open(PETSC_COMM_WORLD, (opt->m_FileNames.xfolder + filename + ext).c_str(),
+                                       NC_NOWRITE, MPI_INFO_NULL, &fileid);
+                    ierr = reg::NCERRQ(ncerr); CHKERRQ(ierr);
+                    ncerr = ncmpi_inq_varid(fileid, "data", &varid);
+                    ierr = reg::NCERRQ(ncerr); CHKERRQ(ierr);
+
+                    istart[0] = static_cast<MPI_Offset>(j);
+                    istart[1] = static_cast<MPI_Offset>(k);
+                    isize[0] = 1;
+                    isize[1] = 1;
+                    for (int i = 0; i < 3; ++i) {
+                        istart[2+i] = static_cast<MPI_Offset>(opt->m_Domain.istart[i]);
+                        isize[2+i] = static_cast<MPI_Offset>(opt->m_Domain.isize[i]);
+                    }
+
+                    ierr = VecGetArray(y, &p_x); CHKERRQ(ierr);
+                    ncerr = ncmpi_get_vara_all(fileid, varid, istart, isize, p_x, nl, MPIU_SCALAR);
+                    ierr = reg::NCERRQ(ncerr); CHKERRQ(ierr);
+                    ierr = VecRestoreArray(y, &p_x); CHKERRQ(ierr);
+
+                    ncerr = ncmpi_close(fileid);
+                    ierr = reg::NCERRQ(ncerr); CHKERRQ(ierr);
+#endif
+                } else {
+                    ss << filename
+                       << "-k=" << std::setw(3) << std::setfill('0') << k
+                       << "-j=" << std::setw(3) << std::setfill('0') << j << ext;
+                    ierr = readwrite->Read(&y, opt->m_FileNames.xfolder + ss.str()); CHKERRQ(ierr);
+                    ierr = reg::Assert(y != NULL, "null pointer"); CHKERRQ(ierr);
+                    if (rank == 0) std::remove((opt->m_FileNames.xfolder + ss.str()).c_str());
+                    ss.str(std::string()); ss.clear();
+                }
+
+                ierr = VecAXPY(y, -static_cast<ScalarType>(j+1), k == 0 ? v->m_X1 : v->m_X2); CHKERRQ(ierr);
+                ierr = VecNorm(y, NORM_2, &value); CHKERRQ(ierr);
+                error = PetscMax(error, value/(static_cast<ScalarType>(j+1)*normx));
+            }
+        }
+        if (ext == ".nc" && rank == 0) std::remove((opt->m_FileNames.xfolder + filename + ext).c_str());
+    }
+
+    ierr = ReportCheck("time series: record/read back", error, 1E1*PETSC_MACHINE_EPSILON, passed); CHKERRQ(ierr);
+
+    // reset options
+    opt->m_FileNames.extension = extension;
+
+    if (readwrite != NULL) {delete readwrite; readwrite = NULL;}
+    if (v != NULL) {delete v; v = NULL;}
+    if (x != NULL) {ierr = VecDestroy(&x); CHKERRQ(ierr); x = NULL;}
+    if (y != NULL) {ierr = VecDestroy(&y); CHKERRQ(ierr); y = NULL;}
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief check the deformation map computed by scaling and squaring
+ * against the map computed by integrating the characteristic with
+ * the sl solver (the error is measured relative to the displacement)
+ *******************************************************************/
+PetscErrorCode CheckScalingSquaring(reg::RegOpt* opt, bool& passed) {
+    PetscErrorCode ierr = 0;
+    reg::VecField *v = NULL, *x = NULL, *ysl = NULL, *yss = NULL;
+    reg::CLAIRE* registration = NULL;
+    reg::PDESolverType type;
+    bool scalingsquaring;
+    IntType nt;
+    ScalarType value, normu;
+    PetscFunctionBegin;
+
+    ierr = reg::DbgMsg("checking scaling and squaring"); CHKERRQ(ierr);
+
+    // remember the options we change
+    type = opt->m_PDESolver.type;
+    scalingsquaring = opt->m_PDESolver.scalingsquaring;
+    nt = opt->m_Domain.nt;
+
+    // the time integration error of the sl solver has to be small
+    // compared to the tolerance
+    opt->m_PDESolver.type = reg::SL;
+    opt->m_Domain.nt = 16;
+
+    try {registration = new reg::CLAIRE(opt);}
+    catch (std::bad_alloc& err) {
+        ierr = reg::ThrowError(err); CHKERRQ(ierr);
+    }
+
+    ierr = ComputeSyntheticData(v, opt, 0); CHKERRQ(ierr);
+    ierr = ComputeRegularGrid(x, opt); CHKERRQ(ierr);
+
+    try {ysl = new reg::VecField(opt);}
+    catch (std::bad_alloc& err) {
+        ierr = reg::ThrowError(err); CHKERRQ(ierr);
+    }
+    try {yss = new reg::VecField(opt);}
+    catch (std::bad_alloc& err) {
+        ierr = reg::ThrowError(err); CHKERRQ(ierr);
+    }
+
+    ierr = registration->SetControlVariable(v); CHKERRQ(ierr);
+
+    opt->m_PDESolver.scalingsquaring = false;
+    ierr = registration->ComputeDeformationMap(ysl); CHKERRQ(ierr);
+
+    opt->m_PDESolver.scalingsquaring = true;
+    ierr = registration->ComputeDeformationMap(yss); CHKERRQ(ierr);
+
+    // ||y_ss - y_sl||/||y_sl - x||
+    ierr = yss->AXPY(-1.0, ysl); CHKERRQ(ierr);
+    ierr = yss->Norm(value); CHKERRQ(ierr);
+    ierr = ysl->AXPY(-1.0, x); CHKERRQ(ierr);
+    ierr = ysl->Norm(normu); CHKERRQ(ierr);
+    value /= normu > 0.0 ? normu : 1.0;
 
-    ierr = VecCreate(PETSC_COMM_WORLD, &x); CHKERRQ(ierr);
-    ierr = VecSetSizes(x, n, n); CHKERRQ(ierr);
-    ierr = VecSetFromOptions(x); CHKERRQ(ierr);
+    ierr = ReportCheck("scaling and squaring vs sl: deformation map", value, 5E-2, passed); CHKERRQ(ierr);
 
+    // reset options
+    opt->m_PDESolver.type = type;
+    opt->m_PDESolver.scalingsquaring = scalingsquaring;
+    opt->m_Domain.nt = nt;
+
+    if (registration != NULL) {delete registration; registration = NULL;}
+    if (v != NULL) {delete v; v = NULL;}
+    if (x != NULL) {delete x; x = NULL;}
+    if (ysl != NULL) {delete ysl; ysl = NULL;}
+    if (yss != NULL) {delete yss; yss = NULL;}
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief check that the inverse deformation map computed jointly
+ * with the deformation map (sl solver, rk2) satisfies y(yinv(x)) = x;
+ * with u = y - x we have y(yinv(x)) = yinv(x) + u(yinv(x))
+ *******************************************************************/
+PetscErrorCode CheckInverseDeformationMap(reg::RegOpt* opt, bool& passed) {
+    PetscErrorCode ierr = 0;
+    reg::VecField *v = NULL, *x = NULL, *y = NULL, *yinv = NULL, *w = NULL;
+    reg::CLAIRE* registration = NULL;
+    reg::SemiLagrangian* semilagrangian = NULL;
+    reg::PDESolverType type;
+    bool scalingsquaring, fixedpoint;
+    int rkorder;
+    IntType nt;
+    ScalarType *p_y1 = NULL, *p_y2 = NULL, *p_y3 = NULL;
+    ScalarType value, normu;
+    PetscFunctionBegin;
+
+    ierr = reg::DbgMsg("checking inverse deformation map"); CHKERRQ(ierr);
+
+    // remember the options we change
+    type = opt->m_PDESolver.type;
+    rkorder = opt->m_PDESolver.rkorder;
+    scalingsquaring = opt->m_PDESolver.scalingsquaring;
+    fixedpoint = opt->m_RegFlags.invdefmapfixedpoint;
+    nt = opt->m_Domain.nt;
+
+    // these options select the joint time integration
+    opt->m_PDESolver.type = reg::SL;
+    opt->m_PDESolver.rkorder = 2;
+    opt->m_PDESolver.scalingsquaring = false;
+    opt->m_RegFlags.invdefmapfixedpoint = false;
+    opt->m_Domain.nt = 16;
+
+    try {registration = new reg::CLAIRE(opt);}
+    catch (std::bad_alloc& err) {
+        ierr = reg::ThrowError(err); CHKERRQ(ierr);
+    }
+    try {semilagrangian = new reg::SemiLagrangian(opt);}
+    catch (std::bad_alloc& err) {
+        ierr = reg::ThrowError(err); CHKERRQ(ierr);
+    }
+
+    ierr = ComputeSyntheticData(v, opt, 0); CHKERRQ(ierr);
+    ierr = ComputeRegularGrid(x, opt); CHKERRQ(ierr);
+
+    try {y = new reg::VecField(opt);}
+    catch (std::bad_alloc& err) {
+        ierr = reg::ThrowError(err); CHKERRQ(ierr);
+    }
+    try {yinv = new reg::VecField(opt);}
+    catch (std::bad_alloc& err) {
+        ierr = reg::ThrowError(err); CHKERRQ(ierr);
+    }
+    try {w = new reg::VecField(opt);}
+    catch (std::bad_alloc& err) {
+        ierr = reg::ThrowError(err); CHKERRQ(ierr);
+    }
+
+    ierr = registration->SetControlVariable(v); CHKERRQ(ierr);
+    ierr = registration->ComputeDeformationMap(y, yinv); CHKERRQ(ierr);
+
+    // displacement u = y - x
+    ierr = y->AXPY(-1.0, x); CHKERRQ(ierr);
+    ierr = y->Norm(normu); CHKERRQ(ierr);
+
+    // evaluate u(yinv(x))
+    ierr = yinv->GetArrays(p_y1, p_y2, p_y3); CHKERRQ(ierr);
+    ierr = semilagrangian->SetQueryPoints(p_y1, p_y2, p_y3, "state"); CHKERRQ(ierr);
+    ierr = yinv->RestoreArrays(p_y1, p_y2, p_y3); CHKERRQ(ierr);
+    ierr = semilagrangian->Interpolate(w, y, "state"); CHKERRQ(ierr);
+
+    // ||yinv + u(yinv) - x||/||u||
+    ierr = w->AXPY(1.0, yinv); CHKERRQ(ierr);
+    ierr = w->AXPY(-1.0, x); CHKERRQ(ierr);
+    ierr = w->Norm(value); CHKERRQ(ierr);
+    value /= normu > 0.0 ? normu : 1.0;
+
+    ierr = ReportCheck("inverse deformation map: y(yinv(x)) = x", value, 5E-2, passed); CHKERRQ(ierr);
+
+    // reset options
+    opt->m_PDESolver.type = type;
+    opt->m_PDESolver.rkorder = rkorder;
+    opt->m_PDESolver.scalingsquaring = scalingsquaring;
+    opt->m_RegFlags.invdefmapfixedpoint = fixedpoint;
+    opt->m_Domain.nt = nt;
+
+    if (semilagrangian != NULL) {delete semilagrangian; semilagrangian = NULL;}
+    if (registration != NULL) {delete registration; registration = NULL;}
+    if (v != NULL) {delete v; v = NULL;}
+    if (x != NULL) {delete x; x = NULL;}
+    if (y != NULL) {delete y; y = NULL;}
+    if (yinv != NULL) {delete yinv; yinv = NULL;}
+    if (w != NULL) {delete w; w = NULL;}
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief check that the low memory evaluation of det(grad(y)) from
+ * the displacement field agrees with the evaluation that stores the
+ * full gradient (both are spectral; they only differ by round off)
+ *******************************************************************/
+PetscErrorCode CheckDetDefGradLowMem(reg::RegOpt* opt, bool& passed) {
+    PetscErrorCode ierr = 0;
+    Vec detj = NULL, detjlowmem = NULL;
+    reg::VecField* v = NULL;
+    reg::CLAIRE* registration = NULL;
+    reg::PDESolverType type;
+    bool fromdeffield, lowmem;
+    ScalarType value, normdetj;
+    IntType nl, ng;
+    PetscFunctionBegin;
+
+    ierr = reg::DbgMsg("checking low memory det(grad(y))"); CHKERRQ(ierr);
+
+    nl = opt->m_Domain.nl;
+    ng = opt->m_Domain.ng;
+
+    // remember the options we change
+    type = opt->m_PDESolver.type;
+    fromdeffield = opt->m_RegFlags.detdefgradfromdeffield;
+    lowmem = opt->m_RegFlags.detdefgradlowmem;
+
+    // for the sl solver the low memory path transports det(grad(y))
+    // instead of using the displacement field
+    opt->m_PDESolver.type = reg::RK2;
+    opt->m_RegFlags.detdefgradfromdeffield = true;
+
+    try {registration = new reg::CLAIRE(opt);}
+    catch (std::bad_alloc& err) {
+        ierr = reg::ThrowError(err); CHKERRQ(ierr);
+    }
+
+    ierr = ComputeSyntheticData(v, opt, 0); CHKERRQ(ierr);
+    ierr = reg::VecCreate(detj, nl, ng); CHKERRQ(ierr);
+    ierr = VecDuplicate(detj, &detjlowmem); CHKERRQ(ierr);
+
+    ierr = registration->SetControlVariable(v); CHKERRQ(ierr);
+
+    opt->m_RegFlags.detdefgradlowmem = false;
+    ierr = registration->ComputeDetDefGrad(false, detj); CHKERRQ(ierr);
+
+    opt->m_RegFlags.detdefgradlowmem = true;
+    ierr = registration->ComputeDetDefGrad(false, detjlowmem); CHKERRQ(ierr);
+
+    ierr = VecNorm(detj, NORM_2, &normdetj); CHKERRQ(ierr);
+    ierr = VecAXPY(detjlowmem, -1.0, detj); CHKERRQ(ierr);
+    ierr = VecNorm(detjlowmem, NORM_2, &value); CHKERRQ(ierr);
+    value /= normdetj > 0.0 ? normdetj : 1.0;
+
+    // tolerance allows for single precision builds
+    ierr = ReportCheck("det(grad(y)): low memory vs full gradient", value, 1E-4, passed); CHKERRQ(ierr);
+
+    // reset options
+    opt->m_PDESolver.type = type;
+    opt->m_RegFlags.detdefgradfromdeffield = fromdeffield;
+    opt->m_RegFlags.detdefgradlowmem = lowmem;
+
+    if (registration != NULL) {delete registration; registration = NULL;}
+    if (v != NULL) {delete v; v = NULL;}
+    if (detj != NULL) {ierr = VecDestroy(&detj); CHKERRQ(ierr); detj = NULL;}
+    if (detjlowmem != NULL) {ierr = VecDestroy(&detjlowmem); CHKERRQ(ierr); detjlowmem = NULL;}
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief check the recursive gaussian filter against the spectral
+ * gaussian filter on a synthetic image
+ *******************************************************************/
+PetscErrorCode CheckRecursiveSmoothing(reg::RegOpt* opt, bool& passed) {
+    PetscErrorCode ierr = 0;
+    Vec mR = NULL, mT = NULL, ms = NULL, msrec = NULL;
+    reg::CLAIRE* registration = NULL;
+    reg::Preprocessing* preproc = NULL;
+    bool recursive;
+    ScalarType sigma[3], value, norms;
+    PetscFunctionBegin;
+
+    ierr = reg::DbgMsg("checking recursive gaussian smoothing"); CHKERRQ(ierr);
+
+    // remember the options we change
+    recursive = opt->m_RegFlags.recursivesmoothing;
+    for (int i = 0; i < 3; ++i) {
+        sigma[i] = opt->m_Sigma[i];
+        opt->m_Sigma[i] = 2.0;
+    }
+
+    try {registration = new reg::CLAIRE(opt);}
+    catch (std::bad_alloc& err) {
+        ierr = reg::ThrowError(err); CHKERRQ(ierr);
+    }
+    try {preproc = new reg::Preprocessing(opt);}
+    catch (std::bad_alloc& err) {
+        ierr = reg::ThrowError(err); CHKERRQ(ierr);
+    }
+    ierr = registration->SetupSyntheticProb(mR, mT); CHKERRQ(ierr);
+
+    ierr = VecDuplicate(mT, &ms); CHKERRQ(ierr);
+    ierr = VecDuplicate(mT, &msrec); CHKERRQ(ierr);
+
+    opt->m_RegFlags.recursivesmoothing = false;
+    ierr = preproc->Smooth(ms, mT); CHKERRQ(ierr);
+
+    opt->m_RegFlags.recursivesmoothing = true;
+    ierr = preproc->Smooth(msrec, mT); CHKERRQ(ierr);
+
+    ierr = VecNorm(ms, NORM_2, &norms); CHKERRQ(ierr);
+    ierr = VecAXPY(msrec, -1.0, ms); CHKERRQ(ierr);
+    ierr = VecNorm(msrec, NORM_2, &value); CHKERRQ(ierr);
+    value /= norms > 0.0 ? norms : 1.0;
+
+    ierr = ReportCheck("gaussian smoothing: recursive vs spectral", value, 5E-2, passed); CHKERRQ(ierr);
+
+    // reset options
+    opt->m_RegFlags.recursivesmoothing = recursive;
+    for (int i = 0; i < 3; ++i) {
+        opt->m_Sigma[i] = sigma[i];
+    }
+
+    if (preproc != NULL) {delete preproc; preproc = NULL;}
+    if (registration != NULL) {delete registration; registration = NULL;}
+    if (ms != NULL) {ierr = VecDestroy(&ms); CHKERRQ(ierr); ms = NULL;}
+    if (msrec != NULL) {ierr = VecDestroy(&msrec); CHKERRQ(ierr); msrec = NULL;}
+    if (mR != NULL) {ierr = VecDestroy(&mR); CHKERRQ(ierr); mR = NULL;}
+    if (mT != NULL) {ierr = VecDestroy(&mT); CHKERRQ(ierr); mT = NULL;}
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief check the operators that work on views of flat vectors
+ * (see VecField::PlaceComponents): the inverse regularization
+ * operator applied in place has to match the result for separate
+ * input and output; the hessian matvec must neither change its input
+ * nor depend on the initial content of its output
+ *******************************************************************/
+PetscErrorCode CheckPlacedComponents(reg::RegOpt* opt, bool& passed) {
+    PetscErrorCode ierr = 0;
+    Vec mR = NULL, mT = NULL, x = NULL, y = NULL, z = NULL, g = NULL;
+    reg::VecField *vf = NULL, *wf = NULL;
+    reg::CLAIRE* registration = NULL;
+    ScalarType value, normy, error = 0.0, jv;
+    IntType nl, ng;
+    PetscFunctionBegin;
+
+    ierr = reg::DbgMsg("checking operators on placed components"); CHKERRQ(ierr);
+
+    nl = opt->m_Domain.nl;
+    ng = opt->m_Domain.ng;
+
+    try {registration = new reg::CLAIRE(opt);}
+    catch (std::bad_alloc& err) {
+        ierr = reg::ThrowError(err); CHKERRQ(ierr);
+    }
+    ierr = registration->SetupSyntheticProb(mR, mT); CHKERRQ(ierr);
+    ierr = registration->SetReferenceImage(mR); CHKERRQ(ierr);
+    ierr = registration->SetTemplateImage(mT); CHKERRQ(ierr);
+
+    ierr = ComputeSyntheticData(vf, opt, 0); CHKERRQ(ierr);
+    ierr = ComputeSyntheticData(wf, opt, 1); CHKERRQ(ierr);
+
+    ierr = reg::VecCreate(x, 3*nl, 3*ng); CHKERRQ(ierr);
+    ierr = VecDuplicate(x, &y); CHKERRQ(ierr);
+    ierr = VecDuplicate(x, &z); CHKERRQ(ierr);
+    ierr = VecDuplicate(x, &g); CHKERRQ(ierr);
+
+    // inverse regularization operator: out of place vs in place
+    ierr = wf->GetComponents(x); CHKERRQ(ierr);
+    ierr = registration->ApplyInvRegularizationOperator(y, x, false); CHKERRQ(ierr);
+    ierr = registration->ApplyInvRegularizationOperator(x, x, false); CHKERRQ(ierr);
+
+    ierr = VecNorm(y, NORM_2, &normy); CHKERRQ(ierr);
+    ierr = VecAXPY(x, -1.0, y); CHKERRQ(ierr);
+    ierr = VecNorm(x, NORM_2, &value); CHKERRQ(ierr);
+    error = PetscMax(error, value/(normy > 0.0 ? normy : 1.0));
+
+    // hessian matvec (needs state and adjoint for v)
+    ierr = vf->GetComponents(x); CHKERRQ(ierr);
+    ierr = registration->EvaluateObjective(&jv, x); CHKERRQ(ierr);
+    ierr = registration->EvaluateGradient(g, x); CHKERRQ(ierr);
+
+    ierr = wf->GetComponents(x); CHKERRQ(ierr);
+    ierr = VecSet(y, 0.0); CHKERRQ(ierr);
+    ierr = registration->HessianMatVec(y, x); CHKERRQ(ierr);
+
+    // the input is readonly
+    ierr = wf->GetComponents(z); CHKERRQ(ierr);
+    ierr = VecAXPY(z, -1.0, x); CHKERRQ(ierr);
+    ierr = VecNorm(z, NORM_2, &value); CHKERRQ(ierr);
+    ierr = VecNorm(x, NORM_2, &normy); CHKERRQ(ierr);
+    error = PetscMax(error, value/(normy > 0.0 ? normy : 1.0));
+
+    // the output does not depend on its initial content
+    ierr = VecSet(z, 1E3); CHKERRQ(ierr);
+    ierr = registration->HessianMatVec(z, x); CHKERRQ(ierr);
+    ierr = VecNorm(y, NORM_2, &normy); CHKERRQ(ierr);
+    ierr = VecAXPY(z, -1.0, y); CHKERRQ(ierr);
+    ierr = VecNorm(z, NORM_2, &value); CHKERRQ(ierr);
+    error = PetscMax(error, value/(normy > 0.0 ? normy : 1.0));
+
+    ierr = ReportCheck("placed components: inverse reg. / hessian", error, 1E2*PETSC_MACHINE_EPSILON, passed); CHKERRQ(ierr);
+
+    if (registration != NULL) {delete registration; registration = NULL;}
+    if (vf != NULL) {delete vf; vf = NULL;}
+    if (wf != NULL) {delete wf; wf = NULL;}
+    if (x != NULL) {ierr = VecDestroy(&x); CHKERRQ(ierr); x = NULL;}
+    if (y != NULL) {ierr = VecDestroy(&y); CHKERRQ(ierr); y = NULL;}
+    if (z != NULL) {ierr = VecDestroy(&z); CHKERRQ(ierr); z = NULL;}
+    if (g != NULL) {ierr = VecDestroy(&g); CHKERRQ(ierr); g = NULL;}
+    if (mR != NULL) {ierr = VecDestroy(&mR); CHKERRQ(ierr); mR = NULL;}
+    if (mT != NULL) {ierr = VecDestroy(&mT); CHKERRQ(ierr); mT = NULL;}
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief check the fused reductions (see ReductionEngine) against
+ * separate reductions: the local norms of a vector field resolved in
+ * a deferred block have to match VecTDot/VecNorm, and the objective
+ * (one allreduce for distance and regularization) has to match the
+ * distance measure evaluated on its own plus the l2 regularization
+ * computed with VecTDot
+ *******************************************************************/
+PetscErrorCode CheckFusedReductions(reg::RegOpt* opt, bool& passed) {
+    PetscErrorCode ierr = 0;
+    Vec mR = NULL, mT = NULL, v = NULL;
+    reg::VecField* vf = NULL;
+    reg::CLAIRE* registration = NULL;
+    reg::RegNormType regnorm;
+    ScalarType nv[3], nvref[3], nvmax, nvmaxloc, vi, value, jv, dref, rref, error = 0.0;
+    IntType nl, ng;
+    int rval;
+    PetscFunctionBegin;
+
+    ierr = reg::DbgMsg("checking fused reductions"); CHKERRQ(ierr);
+
+    nl = opt->m_Domain.nl;
+    ng = opt->m_Domain.ng;
+
+    ierr = ComputeSyntheticData(vf, opt, 0); CHKERRQ(ierr);
+
+    // squared l2 norms of the components (deferred and resolved in a
+    // single allreduce) vs separate VecTDot
+    ierr = vf->SquaredNormLocal(nv[0], nv[1], nv[2]); CHKERRQ(ierr);
+    ierr = opt->m_Reduction.Begin(); CHKERRQ(ierr);
+    for (int i = 0; i < 3; ++i) {
+        ierr = opt->m_Reduction.Add(nv[i], &nv[i]); CHKERRQ(ierr);
+    }
+    ierr = opt->m_Reduction.End(); CHKERRQ(ierr);
+
+    ierr = VecTDot(vf->m_X1, vf->m_X1, &nvref[0]); CHKERRQ(ierr);
+    ierr = VecTDot(vf->m_X2, vf->m_X2, &nvref[1]); CHKERRQ(ierr);
+    ierr = VecTDot(vf->m_X3, vf->m_X3, &nvref[2]); CHKERRQ(ierr);
+    for (int i = 0; i < 3; ++i) {
+        error = PetscMax(error, std::abs(nv[i] - nvref[i])/(nvref[i] > 0.0 ? nvref[i] : 1.0));
+    }
+
+    // max norm over all components (see CLAIREBase::IsVelocityZero)
+    ierr = vf->NormInfLocal(nvmaxloc); CHKERRQ(ierr);
+    rval = MPI_Allreduce(&nvmaxloc, &nvmax, 1, MPIU_REAL, MPI_MAX, PETSC_COMM_WORLD);
+    ierr = reg::Assert(rval == MPI_SUCCESS, "mpi error"); CHKERRQ(ierr);
+    value = 0.0;
+    ierr = VecNorm(vf->m_X1, NORM_INFINITY, &vi); CHKERRQ(ierr); value = PetscMax(value, vi);
+    ierr = VecNorm(vf->m_X2, NORM_INFINITY, &vi); CHKERRQ(ierr); value = PetscMax(value, vi);
+    ierr = VecNorm(vf->m_X3, NORM_INFINITY, &vi); CHKERRQ(ierr); value = PetscMax(value, vi);
+    error = PetscMax(error, std::abs(nvmax - value)/(value > 0.0 ? value : 1.0));
+
+    // objective; the l2 regularization is 0.5*beta*hd*||v||^2
+    regnorm = opt->m_RegNorm.type;
+    opt->m_RegNorm.type = reg::L2;
+
+    try {registration = new reg::CLAIRE(opt);}
+    catch (std::bad_alloc& err) {
+        ierr = reg::ThrowError(err); CHKERRQ(ierr);
+    }
+    ierr = registration->SetupSyntheticProb(mR, mT); CHKERRQ(ierr);
+    ierr = registration->SetReferenceImage(mR); CHKERRQ(ierr);
+    ierr = registration->SetTemplateImage(mT); CHKERRQ(ierr);
+
+    ierr = reg::VecCreate(v, 3*nl, 3*ng); CHKERRQ(ierr);
+    ierr = vf->GetComponents(v); CHKERRQ(ierr);
+
+    ierr = registration->EvaluateObjective(&jv, v); CHKERRQ(ierr);
+    ierr = registration->EvaluateDistanceMeasure(&dref); CHKERRQ(ierr);
+    rref = 0.5*opt->m_RegNorm.beta[0]*opt->GetLebesgueMeasure()*(nvref[0] + nvref[1] + nvref[2]);
+
+    error = PetscMax(error, std::abs(jv - (dref + rref))/(std::abs(dref + rref) > 0.0 ? std::abs(dref + rref) : 1.0));
+    error = PetscMax(error, std::abs(opt->m_Monitor.rval - rref)/(rref > 0.0 ? rref : 1.0));
+
+    ierr = ReportCheck("fused reductions: norms / objective", error, 1E2*PETSC_MACHINE_EPSILON, passed); CHKERRQ(ierr);
+
+    // reset options
+    opt->m_RegNorm.type = regnorm;
+
+    if (registration != NULL) {delete registration; registration = NULL;}
+    if (vf != NULL) {delete vf; vf = NULL;}
+    if (v != NULL) {ierr = VecDestroy(&v); CHKERRQ(ierr); v = NULL;}
+    if (mR != NULL) {ierr = VecDestroy(&mR); CHKERRQ(ierr); mR = NULL;}
+    if (mT != NULL) {ierr = VecDestroy(&mT); CHKERRQ(ierr); mT = NULL;}
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief check that the restriction recomputes the cached spectrum of
+ * the fine grid data (see Preprocessing::Restrict) if it is given a
+ * different vector or if the data of the vector changed in between
+ * (both in place operations and writes through the raw array); the
+ * restriction is linear and preserves constants, so the results are
+ * known from the first restriction
+ *******************************************************************/
+PetscErrorCode CheckRestrictionCache(reg::RegOpt* opt, bool& passed) {
+    PetscErrorCode ierr = 0;
+    Vec x = NULL, y = NULL, xc = NULL, yc = NULL, zc = NULL;
+    reg::VecField* v = NULL;
+    reg::RegOpt* optc = NULL;
+    reg::Preprocessing* preproc = NULL;
+    IntType nx[3], nxc[3], nl;
+    ScalarType *p_x = NULL, value, normz, error = 0.0;
+    PetscFunctionBegin;
+
+    ierr = reg::DbgMsg("checking cached spectrum in restriction"); CHKERRQ(ierr);
+
+    // coarse grid (see Preconditioner::SetupCoarseGrid)
+    try {optc = new reg::RegOpt(*opt);}
+    catch (std::bad_alloc& err) {
+        ierr = reg::ThrowError(err); CHKERRQ(ierr);
+    }
+    for (int i = 0; i < 3; ++i) {
+        nx[i] = opt->m_Domain.nx[i];
+        nxc[i] = static_cast<IntType>(std::ceil(static_cast<ScalarType>(nx[i])/2.0));
+        optc->m_Domain.nx[i] = nxc[i];
+    }
+    ierr = optc->DoSetup(false); CHKERRQ(ierr);
+
+    try {preproc = new reg::Preprocessing(opt);}
+    catch (std::bad_alloc& err) {
+        ierr = reg::ThrowError(err); CHKERRQ(ierr);
+    }
+
+    nl = opt->m_Domain.nl;
+
+    ierr = ComputeSyntheticData(v, opt, 0); CHKERRQ(ierr);
+    ierr = VecDuplicate(v->m_X1, &x); CHKERRQ(ierr);
+    ierr = VecDuplicate(v->m_X1, &y); CHKERRQ(ierr);
+    ierr = VecCopy(v->m_X1, x); CHKERRQ(ierr);
+
+    ierr = reg::VecCreate(xc, optc->m_Domain.nl, optc->m_Domain.ng); CHKERRQ(ierr);
+    ierr = VecDuplicate(xc, &yc); CHKERRQ(ierr);
+    ierr = VecDuplicate(xc, &zc); CHKERRQ(ierr);
+
+    // reference
+    ierr = preproc->Restrict(&xc, x, nxc, nx); CHKERRQ(ierr);
+
+    // different vector: R(3x) = 3R(x)
+    ierr = VecCopy(x, y); CHKERRQ(ierr);
+    ierr = VecScale(y, 3.0); CHKERRQ(ierr);
+    ierr = preproc->Restrict(&yc, y, nxc, nx); CHKERRQ(ierr);
+
+    ierr = VecWAXPY(zc, -3.0, xc, yc); CHKERRQ(ierr);
+    ierr = VecNorm(zc, NORM_2, &value); CHKERRQ(ierr);
+    ierr = VecNorm(yc, NORM_2, &normz); CHKERRQ(ierr);
+    error = PetscMax(error, value/(normz > 0.0 ? normz : 1.0));
+
+    // same vector, changed in place and through the raw array:
+    // R(2x + 1) = 2R(x) + 1
+    ierr = VecScale(x, 2.0); CHKERRQ(ierr);
     ierr = VecGetArray(x, &p_x); CHKERRQ(ierr);
-    for (PetscInt i = 0; i < n; ++i) {
-        p_x[i] = static_cast<PetscScalar>(i);
-        std::cout << p_x[i] << " ";
+    for (IntType i = 0; i < nl; ++i) {
+        p_x[i] += 1.0;
     }
     ierr = VecRestoreArray(x, &p_x); CHKERRQ(ierr);
+    ierr = preproc->Restrict(&yc, x, nxc, nx); CHKERRQ(ierr);
+
+    ierr = VecCopy(xc, zc); CHKERRQ(ierr);
+    ierr = VecScale(zc, 2.0); CHKERRQ(ierr);
+    ierr = VecShift(zc, 1.0); CHKERRQ(ierr);
+    ierr = VecNorm(zc, NORM_2, &normz); CHKERRQ(ierr);
+    ierr = VecAXPY(zc, -1.0, yc); CHKERRQ(ierr);
+    ierr = VecNorm(zc, NORM_2, &value); CHKERRQ(ierr);
+    error = PetscMax(error, value/(normz > 0.0 ? normz : 1.0));
+
+    ierr = ReportCheck("restriction: cached spectrum recomputed", error, 1E2*PETSC_MACHINE_EPSILON, passed); CHKERRQ(ierr);
+
+    if (preproc != NULL) {delete preproc; preproc = NULL;}
+    if (optc != NULL) {delete optc; optc = NULL;}
+    if (v != NULL) {delete v; v = NULL;}
+    if (x != NULL) {ierr = VecDestroy(&x); CHKERRQ(ierr); x = NULL;}
+    if (y != NULL) {ierr = VecDestroy(&y); CHKERRQ(ierr); y = NULL;}
+    if (xc != NULL) {ierr = VecDestroy(&xc); CHKERRQ(ierr); xc = NULL;}
+    if (yc != NULL) {ierr = VecDestroy(&yc); CHKERRQ(ierr); yc = NULL;}
+    if (zc != NULL) {ierr = VecDestroy(&zc); CHKERRQ(ierr); zc = NULL;}
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief check that the workload counters (communication volume and
+ * fft count) are reset with the timers/counters of the options, so
+ * that the log only reports the work of the solve; copying options
+ * (e.g., for a coarse grid) must not reset the shared counters
+ *******************************************************************/
+PetscErrorCode CheckCommCounterReset(reg::RegOpt* opt, bool& passed) {
+    PetscErrorCode ierr = 0;
+    reg::RegOpt* optcopy = NULL;
+    ScalarType value = 1.0, error = 0.0;
+    bool kept;
+    PetscFunctionBegin;
+
+    ierr = reg::DbgMsg("checking reset of workload counters"); CHKERRQ(ierr);
+
+    // generate some work (one reduction, one fft)
+    ierr = opt->m_Reduction.Add(value, &value); CHKERRQ(ierr);
+    ierr = opt->m_Reduction.Flush(); CHKERRQ(ierr);
+    opt->IncrementCounter(reg::FFT);
+
+    try {optcopy = new reg::RegOpt(*opt);}
+    catch (std::bad_alloc& err) {
+        ierr = reg::ThrowError(err); CHKERRQ(ierr);
+    }
+    kept = reg::CommCounter::Get(reg::COMMREDUCE, reg::COMMMSGSENT) > 0.0;
+    if (optcopy != NULL) {delete optcopy; optcopy = NULL;}
+
+    ierr = opt->ResetTimers(); CHKERRQ(ierr);
+    ierr = opt->ResetCounters(); CHKERRQ(ierr);
+
+    for (int i = 0; i < reg::NCOMMPHASES; ++i) {
+        for (int j = 0; j < reg::NCOMMVALUES; ++j) {
+            error += std::abs(reg::CommCounter::Get(static_cast<reg::CommPhase>(i),
+                                                    static_cast<reg::CommValue>(j)));
+        }
+    }
+    error += static_cast<ScalarType>(opt->GetCounter(reg::FFT));
+
+    ierr = ReportCheck("workload counters reset", error, 0.0, passed); CHKERRQ(ierr);
+    if (!kept) {
+        ierr = reg::Msg("copy of options reset the communication counters"); CHKERRQ(ierr);
+    }
+    passed = passed && kept;
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief compute smooth synthetic velocity field
+ *******************************************************************/
+PetscErrorCode ComputeSyntheticData(reg::VecField*& v, reg::RegOpt* opt, int vcase) {
+    PetscErrorCode ierr = 0;
+    ScalarType *p_v1 = NULL, *p_v2 = NULL, *p_v3 = NULL;
+    ScalarType hx[3], x1, x2, x3;
+    IntType i;
+    PetscFunctionBegin;
+
+    opt->Enter(__func__);
+
+    // get grid size
+    hx[0] = opt->m_Domain.hx[0];
+    hx[1] = opt->m_Domain.hx[1];
+    hx[2] = opt->m_Domain.hx[2];
+
+    // allocate velocity field
+    if (v == NULL) {
+        try {v = new reg::VecField(opt);}
+        catch (std::bad_alloc& err) {
+            ierr = reg::ThrowError(err); CHKERRQ(ierr);
+        }
+    }
+
+    ierr = v->GetArrays(p_v1, p_v2, p_v3); CHKERRQ(ierr);
+    for (IntType i1 = 0; i1 < opt->m_Domain.isize[0]; ++i1) {  // x1
+        for (IntType i2 = 0; i2 < opt->m_Domain.isize[1]; ++i2) {  // x2
+            for (IntType i3 = 0; i3 < opt->m_Domain.isize[2]; ++i3) {  // x3
+                // compute coordinates (nodal grid)
+                x1 = hx[0]*static_cast<ScalarType>(i1 + opt->m_Domain.istart[0]);
+                x2 = hx[1]*static_cast<ScalarType>(i2 + opt->m_Domain.istart[1]);
+                x3 = hx[2]*static_cast<ScalarType>(i3 + opt->m_Domain.istart[2]);
+
+                // compute linear / flat index
+                i = reg::GetLinearIndex(i1, i2, i3, opt->m_Domain.isize);
+
+                if (vcase == 0) {
+                    p_v1[i] = 0.5*PetscSinReal(x3)*PetscCosReal(x2)*PetscSinReal(x2);
+                    p_v2[i] = 0.5*PetscSinReal(x1)*PetscCosReal(x3)*PetscSinReal(x3);
+                    p_v3[i] = 0.5*PetscSinReal(x2)*PetscCosReal(x1)*PetscSinReal(x1);
+                } else {
+                    // divergence free velocity field
+                    p_v1[i] = PetscCosReal(x2)*PetscCosReal(x3);
+                    p_v2[i] = PetscSinReal(x3)*PetscSinReal(x1);
+                    p_v3[i] = PetscCosReal(x1)*PetscCosReal(x2);
+                }
+            }  // i1
+        }  // i2
+    }  // i3
+    ierr = v->RestoreArrays(p_v1, p_v2, p_v3); CHKERRQ(ierr);
+
+    opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief compute coordinates of regular grid (nodal grid)
+ *******************************************************************/
+PetscErrorCode ComputeRegularGrid(reg::VecField*& x, reg::RegOpt* opt) {
+    PetscErrorCode ierr = 0;
+    ScalarType *p_x1 = NULL, *p_x2 = NULL, *p_x3 = NULL;
+    ScalarType hx[3];
+    IntType i;
+    PetscFunctionBegin;
+
+    opt->Enter(__func__);
+
+    // get grid size
+    hx[0] = opt->m_Domain.hx[0];
+    hx[1] = opt->m_Domain.hx[1];
+    hx[2] = opt->m_Domain.hx[2];
+
+    if (x == NULL) {
+        try {x = new reg::VecField(opt);}
+        catch (std::bad_alloc& err) {
+            ierr = reg::ThrowError(err); CHKERRQ(ierr);
+        }
+    }
+
+    ierr = x->GetArrays(p_x1, p_x2, p_x3); CHKERRQ(ierr);
+    for (IntType i1 = 0; i1 < opt->m_Domain.isize[0]; ++i1) {  // x1
+        for (IntType i2 = 0; i2 < opt->m_Domain.isize[1]; ++i2) {  // x2
+            for (IntType i3 = 0; i3 < opt->m_Domain.isize[2]; ++i3) {  // x3
+                // compute linear / flat index
+                i = reg::GetLinearIndex(i1, i2, i3, opt->m_Domain.isize);
+
+                p_x1[i] = hx[0]*static_cast<ScalarType>(i1 + opt->m_Domain.istart[0]);
+                p_x2[i] = hx[1]*static_cast<ScalarType>(i2 + opt->m_Domain.istart[1]);
+                p_x3[i] = hx[2]*static_cast<ScalarType>(i3 + opt->m_Domain.istart[2]);
+            }  // i1
+        }  // i2
+    }  // i3
+    ierr = x->RestoreArrays(p_x1, p_x2, p_x3); CHKERRQ(ierr);
+
+    opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
 
-    std::cout << std::endl;
+/********************************************************************
+ * @brief display the outcome of a check (the error has to be below
+ * the tolerance)
+ *******************************************************************/
+PetscErrorCode ReportCheck(std::string name, ScalarType error, ScalarType tol, bool& passed) {
+    PetscErrorCode ierr = 0;
+    std::stringstream ss;
+    PetscFunctionBegin;
 
-    ierr = VecMin(x, &posmin, &minval); CHKERRQ(ierr);
-    ierr = VecMax(x, &posmax, &maxval); CHKERRQ(ierr);
+    passed = !PetscIsInfOrNanReal(error) && error <= tol;
 
-    std::cout << "min " << minval << " at " << posmin << std::endl;
-    std::cout << "max " << maxval << " at " << posmax << std::endl;
+    ss  << std::left << std::setw(44) << name << std::scientific
+        << error << " (tolerance " << tol << ") "
+        << (passed ? "passed" : "FAILED");
+    ierr = reg::Msg(ss.str()); CHKERRQ(ierr);
 
-    ierr = VecDestroy(&x); CHKERRQ(ierr);
-    ierr = PetscFinalize(); CHKERRQ(ierr);
-    return 0;
+    PetscFunctionReturn(ierr);
 }
@@ -39,6 +39,10 @@ int main(int argc, char **argv) {
     reg::CLAIREInterface* registration = NULL;
     std::stringstream ss;
 
+    // split mpi tasks into groups for parallel search for regularization
+    // parameter (has to be done before petsc is initialized)
+    if (reg::SplitCommunicator(argc, argv) != MPI_SUCCESS) return 1;
+
     // initialize petsc (user is not allowed to set petsc options)
     ierr = PetscInitialize(0, reinterpret_cast<char***>(NULL),
                               reinterpret_cast<char*>(NULL),
@@ -306,7 +306,11 @@ PetscErrorCode TransportLabelMap(reg::RegToolsOpt* regopt) {
     reg::ReadWriteReg* readwrite = NULL;
     reg::CLAIREInterface* registration = NULL;
     reg::Preprocessing* preproc = NULL;
-    IntType nl, ng, nc;
+    IntType nl, ng, nc, nlabels;
+    std::vector<int> color;
+    int ncolors = 0;
+    bool usecolors = false;
+    std::stringstream ss;
     PetscFunctionBegin;
 
     regopt->Enter(__func__);
@@ -323,19 +327,36 @@ PetscErrorCode TransportLabelMap(reg::RegToolsOpt* regopt) {
     ierr = ReadData(regopt, readwrite, v); CHKERRQ(ierr);
     ierr = reg::Assert(v != NULL, "set input velocity field"); CHKERRQ(ierr);
 
-    // treat individual labels as components
-    regopt->m_Domain.nc = regopt->m_LabelIDs.size();
-    ierr = reg::Assert(regopt->m_Domain.nc > 0, "number of labels is zero"); CHKERRQ(ierr);
+    nlabels = regopt->m_LabelIDs.size();
+    ierr = reg::Assert(nlabels > 0, "number of labels is zero"); CHKERRQ(ierr);
 
     // make sure we apply smoothing before we solve the forward problem
     regopt->m_RegFlags.applysmoothing = true;
 
-    // allocate class for registration interface
-    try {registration = new reg::CLAIREInterface(regopt);}
+    try {preproc = new reg::Preprocessing(regopt);}
     catch (std::bad_alloc&) {
         ierr = reg::ThrowError("allocation failed"); CHKERRQ(ierr);
     }
-    try {preproc = new reg::Preprocessing(regopt);}
+
+    // labels that are far apart from one another can share a component
+    // (color); we only do this if it reduces the number of components
+    // and the user does not want the probability maps of all labels
+    if (!regopt->m_RegToolFlags.saveprob) {
+        ierr = preproc->ColorLabels(labelmap, color, ncolors); CHKERRQ(ierr);
+        usecolors = 2*ncolors < nlabels;
+    }
+
+    // treat individual labels (colors) as components
+    regopt->m_Domain.nc = usecolors ? 2*ncolors : nlabels;
+
+    if (usecolors) {
+        ss << "transporting " << nlabels << " labels using " << ncolors << " colors";
+        ierr = reg::DbgMsg(ss.str()); CHKERRQ(ierr);
+        ss.str(std::string()); ss.clear();
+    }
+
+    // allocate class for registration interface
+    try {registration = new reg::CLAIREInterface(regopt);}
     catch (std::bad_alloc&) {
         ierr = reg::ThrowError("allocation failed"); CHKERRQ(ierr);
     }
@@ -351,7 +372,11 @@ PetscErrorCode TransportLabelMap(reg::RegToolsOpt* regopt) {
 
     // map label image / hard segmentation to multi component image
     ierr = reg::DbgMsg("extracting individual label maps"); CHKERRQ(ierr);
-    ierr = preproc->Labels2MultiCompImage(m0, labelmap); CHKERRQ(ierr);
+    if (usecolors) {
+        ierr = preproc->Labels2ColorCompImage(m0, labelmap, color, ncolors); CHKERRQ(ierr);
+    } else {
+        ierr = preproc->Labels2MultiCompImage(m0, labelmap); CHKERRQ(ierr);
+    }
 //    ierr = readwrite->WriteT(m0, regopt->m_FileNames.xsc, nc); CHKERRQ(ierr);
 
     // solve forward problem
@@ -375,7 +400,11 @@ PetscErrorCode TransportLabelMap(reg::RegToolsOpt* regopt) {
     // map transported "probability maps" (smooth classes)
     // to a hard segmentation
     ierr = reg::DbgMsg("generating hard segmentation"); CHKERRQ(ierr);
-    ierr = preproc->MultiCompImage2Labels(labelmap, m1); CHKERRQ(ierr);
+    if (usecolors) {
+        ierr = preproc->ColorCompImage2Labels(labelmap, m1, color, ncolors); CHKERRQ(ierr);
+    } else {
+        ierr = preproc->MultiCompImage2Labels(labelmap, m1); CHKERRQ(ierr);
+    }
 
     // write transported scalar field to file
     ierr = readwrite->WriteT(labelmap, regopt->m_FileNames.xsc); CHKERRQ(ierr);
@@ -2,6 +2,10 @@ CPPFILES=$(SRCDIR)/RegOpt.cpp \
 		$(SRCDIR)/RegToolsOpt.cpp \
 		$(SRCDIR)/BenchmarkOpt.cpp \
 		$(SRCDIR)/CLAIREUtils.cpp \
+		$(SRCDIR)/ReductionEngine.cpp \
+		$(SRCDIR)/Tracer.cpp \
+		$(SRCDIR)/CommCounter.cpp \
+		$(SRCDIR)/PerfCounter.cpp \
 		$(SRCDIR)/ghost.cpp \
 		$(SRCDIR)/interp3.cpp \
 		$(SRCDIR)/Interp3_Plan.cpp \
@@ -12,6 +16,8 @@ CPPFILES=$(SRCDIR)/RegOpt.cpp \
 		$(SRCDIR)/DeformationFields.cpp \
 		$(SRCDIR)/DistanceMeasure.cpp \
 		$(SRCDIR)/DistanceMeasureNCC.cpp \
+		$(SRCDIR)/DistanceMeasureLNCC.cpp \
+		$(SRCDIR)/DistanceMeasureMI.cpp \
 		$(SRCDIR)/DistanceMeasureSL2.cpp \
 		$(SRCDIR)/DistanceMeasureSL2aux.cpp \
 		$(SRCDIR)/SemiLagrangian.cpp \
@@ -29,6 +35,7 @@ CPPFILES=$(SRCDIR)/RegOpt.cpp \
 		$(SRCDIR)/RegularizationH2SN.cpp \
 		$(SRCDIR)/RegularizationH3.cpp \
 		$(SRCDIR)/RegularizationH3SN.cpp \
+		$(SRCDIR)/SpectralOperator.cpp \
 		$(SRCDIR)/OptimizationProblem.cpp \
 		$(SRCDIR)/CLAIREBase.cpp \
 		$(SRCDIR)/CLAIRE.cpp \
@@ -53,6 +53,11 @@ endif
 
 ifeq ($(USENIFTI),yes)
 	CXXFLAGS += -DREG_HAS_NIFTI
+	CXXFLAGS += -DREG_HAS_ZLIB
+endif
+
+ifeq ($(USEPERF),yes)
+	CXXFLAGS += -DREG_HAS_PERF
 endif
 
 BINDIR = ./bin
@@ -90,6 +95,7 @@ CLAIRE_INC += -I./deps/3rdparty
 
 ifeq ($(USENIFTI),yes)
 	CLAIRE_INC += -I$(NIFTI_DIR)/include/nifti
+	CLAIRE_INC += -I$(ZLIB_DIR)/include
 endif
 
 ifeq ($(USEPNETCDF),yes)
@@ -151,4 +157,5 @@ BIN += $(BINDIR)/claire
 ifeq ($(BUILDTOOLS),yes)
 	BIN += $(BINDIR)/benchmark
 	BIN += $(BINDIR)/clairetools
+	BIN += $(BINDIR)/checkclaire
 endif
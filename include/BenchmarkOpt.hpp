@@ -47,6 +47,8 @@ class BenchmarkOpt : public RegOpt {
     inline double GetRunTime() const {return this->m_RunTime;};
     inline void SetRunTime(double value){this->m_RunTime = value;};
 
+    PetscErrorCode WriteJSONLog(void);
+
  protected:
     virtual PetscErrorCode Initialize(void);
     virtual PetscErrorCode ClearMemory(void);
@@ -57,6 +59,7 @@ class BenchmarkOpt : public RegOpt {
     int m_BenchmarkID;
     int m_NumRepeats;
     double m_RunTime;
+    std::string m_JSONFile;  ///< output file for machine readable timings (benchmark sweeps)
 };
 
 
@@ -171,11 +171,22 @@ class CLAIRE : public CLAIREBase {
         body force and the incremental body force */
     virtual PetscErrorCode ApplyProjection();
 
+    /*! append the projection of the body force to a chain of
+        spectral operators (no-op if the model does not project) */
+    virtual PetscErrorCode AppendProjection(SpectralOperator*);
+
+    /*! apply (square root of) inverse of regularization operator to
+        a body force whose projection has been deferred (fused into
+        the same fft round trip) */
+    PetscErrorCode ApplyProjectedInverse(VecField*, VecField*, bool applysqrt = false);
+
     Vec m_StateVariable;        ///< time dependent state variable m(x,t)
     Vec m_AdjointVariable;      ///< time dependent adjoint variable \lambda(x,t)
     Vec m_IncStateVariable;     ///< time dependent incremental state variable \tilde{m}(x,t)
     Vec m_IncAdjointVariable;   ///< time dependent incremental adjoint variable \tilde{\lambda}(x,t)
 
+    bool m_DeferProjection;     ///< body force is projected by its consumer (see ApplyProjectedInverse)
+
  private:
     /*! compute the initial guess for the velocity field */
     PetscErrorCode ComputeInitialVelocity(void);
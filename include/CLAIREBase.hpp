@@ -31,6 +31,8 @@
 #include "DistanceMeasureSL2.hpp"
 #include "DistanceMeasureSL2aux.hpp"
 #include "DistanceMeasureNCC.hpp"
+#include "DistanceMeasureLNCC.hpp"
+#include "DistanceMeasureMI.hpp"
 #include "Regularization.hpp"
 #include "Regularization.hpp"
 #include "RegularizationL2.hpp"
@@ -40,6 +42,7 @@
 #include "RegularizationH1SN.hpp"
 #include "RegularizationH2SN.hpp"
 #include "RegularizationH3SN.hpp"
+#include "SpectralOperator.hpp"
 #include "OptimizationProblem.hpp"
 #include "SemiLagrangian.hpp"
 
@@ -117,6 +120,9 @@ class CLAIREBase : public OptimizationProblem {
     /*! compute deformation map */
     PetscErrorCode ComputeDeformationMaps(bool write2file = false);
 
+    /*! compute deformation map (and its inverse) for current velocity field */
+    PetscErrorCode ComputeDeformationMap(VecField* y, VecField* yinv = NULL);
+
     /*! compute synthetic test problem */
     PetscErrorCode SetupSyntheticProb(Vec&, Vec&);
 
@@ -168,6 +174,12 @@ class CLAIREBase : public OptimizationProblem {
     /*! allocate all the memory we need */
     virtual PetscErrorCode InitializeSolver() = 0;
 
+    /*! adapt accuracy of pde solver to progress of optimizer */
+    PetscErrorCode AdaptAccuracy(Vec, ScalarType, bool&);
+
+    /*! restore full accuracy of pde solver */
+    PetscErrorCode RestoreAccuracy(void);
+
  protected:
     PetscErrorCode Initialize(void);
     PetscErrorCode ComputeInitialGuess(void);
@@ -187,10 +199,15 @@ class CLAIREBase : public OptimizationProblem {
     PetscErrorCode SetupRegularization();
     PetscErrorCode SetupDeformationField();
     PetscErrorCode SetupSpectralData();
+    PetscErrorCode SetupSpectralOperator();
     PetscErrorCode SetupDistanceMeasure();
 
     /*! compute cfl condition */
-    PetscErrorCode ComputeCFLCondition();
+    PetscErrorCode ComputeCFLCondition(IntType* ntcfl = NULL);
+
+    /*! post-processing acts on the entire domain (calls can be nested) */
+    PetscErrorCode SuspendActiveRegion(void);
+    PetscErrorCode ResumeActiveRegion(void);
 
     Vec m_TemplateImage;           ///< data container for reference image mR
     Vec m_ReferenceImage;          ///< data container for template image mT
@@ -217,13 +234,22 @@ class CLAIREBase : public OptimizationProblem {
 
     ReadWriteReg* m_ReadWrite;                   ///< io; set from outside (not to be delted)
     RegularizationType* m_Regularization;        ///< regularization functional
+    SpectralOperator* m_SpectralOperator;        ///< chained fourier multipliers (one fft round trip)
     DistanceMeasure* m_DistanceMeasure;          ///< distance measure
     SemiLagrangianType* m_SemiLagrangianMethod;  ///< semi-lagrangian method
     DeformationFields* m_DeformationFields;      ///< interface to compute deformation fields from velocity
 
     bool m_VelocityIsZero;
+    bool m_VelocityIsZeroValid;             ///< cached flag is valid for (id, state) below
+    PetscObjectId m_VelocityId[3];
+    PetscObjectState m_VelocityState[3];
     bool m_StoreTimeHistory;
 
+    IntType m_AccuracyNt;   ///< number of time steps for full accuracy (-1: accuracy not adapted)
+
+    int m_ActiveRegionSuspended;  ///< depth of nested post-processing blocks
+    bool m_ActiveRegion;          ///< user setting for active region (while suspended)
+
     ComplexType *m_x1hat;
     ComplexType *m_x2hat;
     ComplexType *m_x3hat;
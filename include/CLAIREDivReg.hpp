@@ -59,6 +59,9 @@ class CLAIREDivReg : public CLAIRE {
         body force and the incremental body force */
     virtual PetscErrorCode ApplyProjection();
 
+    /*! append the projection to a chain of spectral operators */
+    virtual PetscErrorCode AppendProjection(SpectralOperator*);
+
  private:
     PetscErrorCode EvaluteRegularizationDIV(ScalarType*);
 };
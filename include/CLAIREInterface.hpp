@@ -92,6 +92,8 @@ class CLAIREInterface {
     PetscErrorCode RunSolverRegParaContBinarySearch();
     PetscErrorCode RunSolverRegParaContReductSearch();
     PetscErrorCode RunSolverRegParaContReduction();
+    PetscErrorCode RunSolverRegParaContParallelSearch();
+    PetscErrorCode BcastSolution(MPI_Comm, int);
 
     PetscErrorCode ProlongVelocityField(VecField*&, int);
 
@@ -63,6 +63,9 @@ class CLAIREStokes : public CLAIRE {
         body force and the incremental body force */
     virtual PetscErrorCode ApplyProjection();
 
+    /*! append the projection to a chain of spectral operators */
+    virtual PetscErrorCode AppendProjection(SpectralOperator*);
+
  private:
 };
 
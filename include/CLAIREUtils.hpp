@@ -138,6 +138,9 @@ std::vector<int> String2Vec(const std::string&, std::string);
 
 PetscErrorCode InitializeDataDistribution(int, int*, MPI_Comm&, bool);
 
+/*! split world communicator into groups (has to be called before PetscInitialize) */
+int SplitCommunicator(int, char**);
+
 PetscErrorCode Finalize();
 
 /* get raw pointer to write, read and read,write */
@@ -0,0 +1,90 @@
+/*************************************************************************
+ *  Copyright (c) 2018.
+ *  All rights reserved.
+ *  This file is part of the CLAIRE library.
+ *
+ *  CLAIRE is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CLAIRE is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CLAIRE.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+#ifndef _COMMCOUNTER_HPP_
+#define _COMMCOUNTER_HPP_
+
+#include <cstddef>
+
+
+
+
+namespace reg {
+
+
+
+
+/*! phases of the solver that communicate */
+enum CommPhase {
+    COMMFFT = 0,     ///< transposes of parallel fft (estimated from pencil decomposition)
+    COMMGHOST,       ///< ghost layer exchange for interpolation
+    COMMSCATTER,     ///< scatter of query points (semi-lagrangian)
+    COMMVALUES,      ///< return of interpolated values (semi-lagrangian)
+    COMMGRIDCHANGE,  ///< restriction/prolongation between grids
+    COMMREDUCE,      ///< global reductions (see ReductionEngine)
+    NCOMMPHASES,     ///< to allocate the counters
+};
+
+
+/*! quantities we count per phase */
+enum CommValue {
+    COMMBYTESSENT = 0,  ///< bytes sent
+    COMMBYTESRECV,      ///< bytes received
+    COMMMSGSENT,        ///< messages sent (collectives count as one message)
+    COMMMSGRECV,        ///< messages received
+    COMMPEERS,          ///< max number of peers in a single exchange
+    NCOMMVALUES,        ///< to allocate the counters
+};
+
+
+
+
+/*! per rank communication volume; the low level communication kernels
+    (ghost exchange, interpolation plans) have no access to RegOpt, so
+    we keep the counters in static storage; messages to the rank
+    itself are not counted; must only be called outside of parallel
+    regions */
+class CommCounter {
+ public:
+    static inline void Add(CommPhase phase, double bytessent, double bytesrecv,
+                           int nsend, int nrecv, int npeers) {
+        double* v = s_Value[phase];
+        v[COMMBYTESSENT] += bytessent;
+        v[COMMBYTESRECV] += bytesrecv;
+        v[COMMMSGSENT] += static_cast<double>(nsend);
+        v[COMMMSGRECV] += static_cast<double>(nrecv);
+        if (static_cast<double>(npeers) > v[COMMPEERS]) v[COMMPEERS] = static_cast<double>(npeers);
+    }
+
+    static inline double Get(CommPhase phase, CommValue id) {return s_Value[phase][id];}
+
+    static void Reset(void);
+
+ private:
+    static double s_Value[NCOMMPHASES][NCOMMVALUES];
+};
+
+
+
+
+}  // namespace reg
+
+
+
+
+#endif  // _COMMCOUNTER_HPP_
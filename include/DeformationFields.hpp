@@ -74,6 +74,9 @@ class DeformationFields {
     /*! compute deformation map */
     PetscErrorCode ComputeDeformationMap(bool write2file = false, VecField* y = NULL);
 
+    /*! compute deformation map and its inverse */
+    PetscErrorCode ComputeDeformationMapAndInverse(bool write2file = false, VecField* y = NULL, VecField* yinv = NULL);
+
     /*! compute displacement field */
     PetscErrorCode ComputeDisplacementField(bool write2file = false);
 
@@ -95,8 +98,16 @@ private:
     PetscErrorCode ComputeDetDefGradRK2();              ///< implemented via RK2 time integrator
     PetscErrorCode ComputeDetDefGradRK2A();             ///< implemented via RK2 time integrator (assymetric form)
     PetscErrorCode ComputeDetDefGradViaDispField();     ///< implemented via RK2 time integrator (asymetric form)
+    PetscErrorCode ComputeDetDefGradViaDispFieldLowMem();   ///< via displacement field; row by row (no tensor field)
+    PetscErrorCode ComputePartialDerivative(ScalarType*, ScalarType*, int);  ///< single partial derivative
+    PetscErrorCode CheckMemoryDetDefGrad(bool&);        ///< decide if we can afford to store grad(y)
     PetscErrorCode ComputeDeformationMapSLRK2();        ///< implementation via SL time integrator using RK2
     PetscErrorCode ComputeDeformationMapSLRK4();        ///< implementation via SL time integrator using RK4
+    PetscErrorCode ComputeDeformationMapSS();           ///< implementation via scaling and squaring
+    PetscErrorCode ComputeDeformationMapSLRK2Joint();   ///< forward and inverse map via SL time integrator using RK2
+    PetscErrorCode ComputeInverseDefMapFixedPoint();    ///< invert deformation map by fixed point iteration
+    PetscErrorCode ComputeDisplacementFieldSS(ScalarType);  ///< implementation via scaling and squaring
+    PetscErrorCode ComputeScalingSquaringSteps(int&);   ///< number of squarings
     PetscErrorCode ComputeDeformationMapRK2();          ///< implementation via RK2 time integrator
     PetscErrorCode ComputeDeformationMapRK2A();         ///< implementation via RK2A time integrator
     PetscErrorCode ComputeDisplacementFieldSL();        ///< implementation via SL time integrator
@@ -123,6 +134,8 @@ private:
     TenField* m_WorkTenField3;  ///< data container for tensor field (temporary variable)
     TenField* m_WorkTenField4;  ///< data container for tensor field (temporary variable)
 
+    VecField* m_InverseDeformationMap;  ///< inverse deformation map (allocated on demand)
+
     ReadWriteReg* m_ReadWrite; ///< io; set from outside (not to be delted)
 
     bool m_ComputeInverseDefMap;
@@ -0,0 +1,77 @@
+/*************************************************************************
+ *  Copyright (c) 2018.
+ *  All rights reserved.
+ *  This file is part of the CLAIRE library.
+ *
+ *  CLAIRE is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CLAIRE is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CLAIRE.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#ifndef _DISTANCEMEASURELNCC_HPP_
+#define _DISTANCEMEASURELNCC_HPP_
+
+#include "DistanceMeasure.hpp"
+
+
+
+
+namespace reg {
+
+
+
+
+/*! local (windowed) normalized cross-correlation; the local
+    statistics are computed with separable running sum box filters,
+    so that the cost does not depend on the window size */
+class DistanceMeasureLNCC : public DistanceMeasure {
+ public:
+    typedef DistanceMeasure SuperClass;
+    typedef DistanceMeasureLNCC Self;
+
+    DistanceMeasureLNCC(void);
+    DistanceMeasureLNCC(RegOpt*);
+    virtual ~DistanceMeasureLNCC(void);
+
+    PetscErrorCode SetupScale();
+    PetscErrorCode EvaluateFunctional(ScalarType*);
+    PetscErrorCode SetFinalConditionAE();
+    PetscErrorCode SetFinalConditionIAE();
+
+ protected:
+    PetscErrorCode Initialize(void);
+    PetscErrorCode ClearMemory(void);
+
+ private:
+    enum {NWORK = 10};
+
+    PetscErrorCode AllocateMemory(void);
+    PetscErrorCode BoxFilter(ScalarType*, ScalarType*);
+    PetscErrorCode ComputeLocalStatistics(ScalarType*, ScalarType*);
+    PetscErrorCode ComputeCorrelation(ScalarType*, ScalarType*, ScalarType*, ScalarType&);
+
+    ScalarType* m_Work[NWORK];  ///< work arrays (local size)
+    ScalarType* m_Ghost;        ///< ghost padded input of box filter (x1 and x2)
+    ScalarType* m_BoxSum1;      ///< partial sums along x3 (ghost padded in x1 and x2)
+    ScalarType* m_BoxSum2;      ///< partial sums along x3 and x2 (ghost padded in x1)
+    int m_Radius;               ///< radius of window; window has (2r+1)^3 points
+};
+
+
+
+
+}  // namespace reg
+
+
+
+
+#endif  // _DISTANCEMEASURELNCC_HPP_
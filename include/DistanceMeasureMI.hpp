@@ -0,0 +1,87 @@
+/*************************************************************************
+ *  Copyright (c) 2018.
+ *  All rights reserved.
+ *  This file is part of the CLAIRE library.
+ *
+ *  CLAIRE is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CLAIRE is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CLAIRE.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#ifndef _DISTANCEMEASUREMI_HPP_
+#define _DISTANCEMEASUREMI_HPP_
+
+#include "DistanceMeasure.hpp"
+
+
+
+
+namespace reg {
+
+
+
+
+/*! mutual information based on a Parzen window (cubic B-spline)
+    estimate of the joint intensity distribution; the functional is
+    the conditional entropy D = H(m1,mR) - H(m1) = H(mR) - MI(m1,mR);
+    each thread fills a private histogram; the histograms of all
+    threads are merged and combined across ranks in one reduction */
+class DistanceMeasureMI : public DistanceMeasure {
+ public:
+    typedef DistanceMeasure SuperClass;
+    typedef DistanceMeasureMI Self;
+
+    DistanceMeasureMI(void);
+    DistanceMeasureMI(RegOpt*);
+    virtual ~DistanceMeasureMI(void);
+
+    PetscErrorCode SetupScale();
+    PetscErrorCode EvaluateFunctional(ScalarType*);
+    PetscErrorCode SetFinalConditionAE();
+    PetscErrorCode SetFinalConditionIAE();
+
+    /*! cubic B-spline Parzen window: weights (and derivatives) of
+        the four bins that intensity v contributes to */
+    static bool ParzenWindow(ScalarType v, ScalarType lo, ScalarType dv, int nb,
+                             int& i0, ScalarType* w, ScalarType* dw, ScalarType* ddw);
+
+ protected:
+    PetscErrorCode Initialize(void);
+    PetscErrorCode ClearMemory(void);
+
+ private:
+    PetscErrorCode AllocateMemory(void);
+    PetscErrorCode ComputeIntensityRange(void);
+    PetscErrorCode ComputeJointHistogram(double*, const ScalarType*, const ScalarType*,
+                                         const ScalarType*, const ScalarType*);
+    PetscErrorCode ComputeLogRatio(void);
+    PetscErrorCode EvaluateConditionalEntropy(ScalarType*, const ScalarType*);
+
+    int m_NumBins;              ///< number of bins per image (including padding)
+    int m_NumThreads;           ///< number of thread private histograms
+    double* m_ThreadHistogram;  ///< thread private histograms (one component)
+    double* m_JointPDF;         ///< joint pdf p(a,b) for all components
+    double* m_JointPDFTilde;    ///< directional derivative of p in direction mtilde
+    double* m_LogRatio;         ///< log(p(a,b)/p(a)) for all components
+    ScalarType m_Range[4];      ///< intensity range of m1 and mR
+    bool m_RangeSet;            ///< flag: intensity range has been computed
+};
+
+
+
+
+}  // namespace reg
+
+
+
+
+#endif  // _DISTANCEMEASUREMI_HPP_
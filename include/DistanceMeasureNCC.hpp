@@ -30,7 +30,7 @@ namespace reg {
 
 
 
-class DistanceMeasureNCC : public DistanceMeasure {
+class DistanceMeasureNCC : public DistanceMeasure, public ReductionCallback {
  public:
     typedef DistanceMeasure SuperClass;
     typedef DistanceMeasureNCC Self;
@@ -45,9 +45,16 @@ class DistanceMeasureNCC : public DistanceMeasure {
     PetscErrorCode SetFinalConditionAE();
     PetscErrorCode SetFinalConditionIAE();
 
+    /*! evaluate functional from reduced sums */
+    PetscErrorCode FinalizeReduction(void);
+
  protected:
     PetscErrorCode Initialize(void);
     PetscErrorCode ClearMemory(void);
+
+ private:
+    ScalarType m_Sum[3];    ///< (reduced) ||m1||^2, ||mR||^2 and <m1,mR>
+    ScalarType* m_Value;    ///< functional value (set in FinalizeReduction)
 };
 
 
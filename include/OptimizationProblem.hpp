@@ -120,6 +120,12 @@ class OptimizationProblem {
     /*! apply two level preconditioner */
     virtual PetscErrorCode CheckBounds(Vec, bool&) = 0;
 
+    /*! adapt accuracy of forward/adjoint solves to progress of optimizer */
+    virtual PetscErrorCode AdaptAccuracy(Vec, ScalarType, bool&) = 0;
+
+    /*! restore full accuracy of forward/adjoint solves */
+    virtual PetscErrorCode RestoreAccuracy(void) = 0;
+
     /*! check gradient (derivative check via taylor expansion) */
     PetscErrorCode DerivativeCheckGradient(void);
     PetscErrorCode DerivativeCheckHessian(void);
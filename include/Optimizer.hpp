@@ -49,12 +49,39 @@ class Optimizer {
 
     PetscErrorCode Finalize();
 
+    /*! apply limited memory bfgs approximation of inverse hessian */
+    PetscErrorCode ApplyLBFGS(Vec, Vec);
+
  private:
     PetscErrorCode Initialize(void);
     PetscErrorCode ClearMemory(void);
     PetscErrorCode SetupTao(void);
     PetscErrorCode SetInitialGuess(void);
 
+    /*! allocate / reset / update memory of limited memory bfgs */
+    PetscErrorCode SetupLBFGS(void);
+    PetscErrorCode ResetLBFGS(void);
+    PetscErrorCode UpdateLBFGS(void);
+
+    /*! inner product of two vector fields (single reduction) */
+    PetscErrorCode Dot(VecField*, VecField*, ScalarType&);
+
+    struct LBFGSMemory {
+        int m;              ///< max number of stored update pairs
+        int n;              ///< number of stored update pairs
+        int head;           ///< index of most recent update pair
+        IntType iter;       ///< iteration at which we last updated (-1: empty)
+        ScalarType gamma;   ///< scaling of initial hessian (inverse regularization operator)
+        ScalarType* rho;    ///< 1/(y_k^T s_k)
+        ScalarType* alpha;  ///< coefficients of two loop recursion
+        VecField** s;       ///< steps s_k = x_{k+1} - x_k
+        VecField** y;       ///< gradient differences y_k = g_{k+1} - g_k
+        VecField* xold;     ///< previous iterate
+        VecField* gold;     ///< previous gradient
+        VecField* q;        ///< work vector for two loop recursion
+        Vec work;           ///< work vector (flat layout)
+    };
+
     RegOpt* m_Opt;
     OptProbType* m_OptimizationProblem;
 
@@ -66,6 +93,7 @@ class Optimizer {
     Preprocessing* m_PreProc;
     Mat m_MatVec;
     Vec m_Solution; ///< solution vector
+    LBFGSMemory m_LBFGS; ///< memory for limited memory bfgs
 };
 
 
@@ -0,0 +1,98 @@
+/*************************************************************************
+ *  Copyright (c) 2018.
+ *  All rights reserved.
+ *  This file is part of the CLAIRE library.
+ *
+ *  CLAIRE is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CLAIRE is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CLAIRE.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+#ifndef _PERFCOUNTER_HPP_
+#define _PERFCOUNTER_HPP_
+
+#include <vector>
+
+
+
+
+namespace reg {
+
+
+
+
+/*! kernel regions with hardware counters */
+enum PerfRegion {
+    PERFFFT = 0,   ///< fft execution (including spectral operators)
+    PERFINTERP,    ///< interpolation kernel (no communication)
+    PERFSPECTRAL,  ///< pointwise spectral operators (hadamard products)
+    NPERFREGIONS,  ///< to allocate the counters
+};
+
+
+/*! hardware events (summed over all threads of a rank) */
+enum PerfEvent {
+    PERFCYCLES = 0,  ///< cpu cycles
+    PERFINSTR,       ///< retired instructions
+    PERFLLCREF,      ///< last level cache references
+    PERFLLCMISS,     ///< last level cache misses (x cache line = memory traffic proxy)
+    PERFRAW,         ///< user defined raw event (e.g., vector fp ops; see -perfrawevent)
+    NPERFEVENTS,     ///< to allocate the counters
+};
+
+
+
+
+/*! hardware performance counters via linux perf_event_open (requires
+    build with REG_HAS_PERF); we open one counter group per openmp
+    thread and read all groups at the start and the end of a region;
+    regions must be entered and left outside of parallel regions; as
+    for CommCounter, the storage is static, so that low level kernels
+    without access to RegOpt can be instrumented */
+class PerfCounter {
+ public:
+    /*! open counters; returns false if not supported (the counters
+        stay disabled); raw event config is ignored if zero */
+    static bool Initialize(unsigned long rawconfig = 0);
+    static void Finalize(void);
+
+    static void Start(PerfRegion);
+    static void Stop(PerfRegion);
+
+    static inline bool IsEnabled(void) {return s_Enabled;}
+    static inline bool HasRawEvent(void) {return s_HasRaw;}
+    static inline double Get(PerfRegion region, PerfEvent id) {return s_Value[region][id];}
+    static inline double GetCalls(PerfRegion region) {return s_Calls[region];}
+
+ private:
+    static void Read(double*);
+
+    static std::vector<int> s_Leader;  ///< group leader per thread
+    static std::vector<int> s_FD;      ///< all file descriptors
+    static int s_NumEvents;            ///< number of events per group
+    static int s_EventID[NPERFEVENTS]; ///< position of event in group (-1 if not available)
+    static bool s_Enabled;
+    static bool s_HasRaw;
+    static int s_Depth[NPERFREGIONS];
+    static double s_Start[NPERFREGIONS][NPERFEVENTS];
+    static double s_Value[NPERFREGIONS][NPERFEVENTS];
+    static double s_Calls[NPERFREGIONS];
+};
+
+
+
+
+}  // namespace reg
+
+
+
+
+#endif  // _PERFCOUNTER_HPP_
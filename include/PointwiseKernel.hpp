@@ -0,0 +1,104 @@
+/*************************************************************************
+ *  Copyright (c) 2018.
+ *  All rights reserved.
+ *  This file is part of the CLAIRE library.
+ *
+ *  CLAIRE is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CLAIRE is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CLAIRE.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+
+
+#ifndef _POINTWISEKERNEL_HPP_
+#define _POINTWISEKERNEL_HPP_
+
+#include "CLAIREUtils.hpp"
+
+
+
+
+namespace reg {
+
+
+
+
+/*! evaluate a pointwise expression for all local grid points in a
+    single pass over memory; multi-term updates (e.g., b += w*l*grad m
+    for all three components) are written as one functor instead of a
+    sequence of VecAXPY/VecPointwiseMult calls, each of which streams
+    the operands again; the functor is called as kernel(i) and must
+    only touch entry i, so that the loop can be vectorized; the static
+    schedule assigns the same index range to a thread in every pass,
+    which, together with FirstTouch, keeps the pages on the NUMA node
+    of that thread; host memory only (do not use with cuda arrays) */
+template <typename Kernel>
+inline void PointwiseKernel(IntType n, const Kernel& kernel) {
+#pragma omp parallel for simd schedule(static)
+    for (IntType i = 0; i < n; ++i) {
+        kernel(i);
+    }
+}
+
+
+
+
+/*! as above, but only for the local indices in the list (e.g., the
+    points the semi-lagrangian method is restricted to; see
+    SemiLagrangian::GetActiveIndex); the entries outside of the list
+    are not touched; all n points are processed if the list is NULL */
+template <typename Kernel>
+inline void PointwiseKernel(IntType n, const std::vector<IntType>* index, const Kernel& kernel) {
+    if (index == NULL) {
+        PointwiseKernel(n, kernel);
+        return;
+    }
+    const IntType* idx = index->data();
+    IntType m = static_cast<IntType>(index->size());
+#pragma omp parallel for schedule(static)
+    for (IntType j = 0; j < m; ++j) {
+        kernel(idx[j]);
+    }
+}
+
+
+
+
+/*! initialize freshly allocated memory with the same thread to
+    index mapping as PointwiseKernel (first touch placement) */
+inline PetscErrorCode FirstTouch(Vec x) {
+    PetscErrorCode ierr = 0;
+#ifndef REG_HAS_CUDA
+    IntType n;
+    ScalarType* p_x = NULL;
+    PetscFunctionBegin;
+
+    ierr = VecGetLocalSize(x, &n); CHKERRQ(ierr);
+    ierr = VecGetArray(x, &p_x); CHKERRQ(ierr);
+    PointwiseKernel(n, [=] (IntType i) {p_x[i] = 0.0;});
+    ierr = VecRestoreArray(x, &p_x); CHKERRQ(ierr);
+#else
+    PetscFunctionBegin;
+#endif
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+}  // namespace reg
+
+
+
+
+#endif  // _POINTWISEKERNEL_HPP_
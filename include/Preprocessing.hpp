@@ -23,6 +23,8 @@
 #include "RegOpt.hpp"
 #include "CLAIREUtils.hpp"
 #include "ReadWriteReg.hpp"
+#include <map>
+#include <list>
 
 
 
@@ -57,6 +59,57 @@ struct GridData {
 };
 
 
+/*! fft plan and spectral buffer for a given grid size (shared by all
+    grid transfer operators that involve this grid) */
+struct FFTGridOps {
+    IntType nx[3];
+    IntType osize[3];
+    IntType ostart[3];
+    ScalarType scale;
+    accfft_plan_t<ScalarType, ComplexType, FFTWPlanType>* plan;
+    ComplexType* xhat;
+    MPI_Comm mpicomm;
+
+    bool xhatvalid;             ///< xhat holds spectrum of data with given id/state
+    PetscObjectId xhatid;
+    PetscObjectState xhatstate;
+
+    int refs;                   ///< number of grid transfer operators that use this grid
+    size_t bytes;               ///< (estimated) memory footprint
+};
+
+
+/*! index maps and communication buffers for restriction/prolongation
+    between a pair of grids */
+struct GridChangeOps {
+    IntType nx_f[3];
+    IntType nx_c[3];
+    FFTGridOps* fine;
+    FFTGridOps* coarse;
+    bool indicescomputed;
+
+    IntType *numsend;
+    IntType *numrecv;
+    IntType *offsetsend;
+    IntType *offsetrecv;
+    IntType nallocsend;
+    IntType nallocrecv;
+
+    IntType *indicessendf;
+    IntType *indicessendc;
+    IntType *indicesrecvf;
+    IntType *indicesrecvc;
+
+    ScalarType *coeffsendf;
+    ScalarType *coeffsendc;
+    ScalarType *coeffrecvf;
+    ScalarType *coeffrecvc;
+
+    int refs;                   ///< number of instances that currently use these operators
+    size_t bytes;               ///< (estimated) memory footprint
+};
+
+
 class Preprocessing {
  public:
     typedef Preprocessing Self;
@@ -77,23 +130,35 @@ class Preprocessing {
     PetscErrorCode Restrict(Vec*, Vec, IntType*, IntType*);
     PetscErrorCode Restrict(VecField*, VecField*, IntType*, IntType*);
 
+    /*! grid transfer operators are cached per pair of grids; this is kept for compatibility */
     inline void ResetGridChangeOps(bool flag){this->m_ResetGridChangeOps = flag;};
     PetscErrorCode ComputeGridChangeIndices(IntType*, IntType*);
 
     PetscErrorCode Labels2MultiCompImage(Vec, Vec);
     PetscErrorCode MultiCompImage2Labels(Vec, Vec);
 
+    /*! map labels to a small number of colors (no two nearby labels share a color) */
+    PetscErrorCode ColorLabels(Vec, std::vector<int>&, int&);
+    PetscErrorCode Labels2ColorCompImage(Vec, Vec, const std::vector<int>&, int);
+    PetscErrorCode ColorCompImage2Labels(Vec, Vec, const std::vector<int>&, int);
+
  private:
     PetscErrorCode ClearMemory();
     PetscErrorCode Initialize();
 
     PetscErrorCode GaussianSmoothing(Vec, Vec, IntType);
+    PetscErrorCode RecursiveGaussianSmoothing(Vec, Vec, IntType);
+    PetscErrorCode RecursiveGaussianFilter(ScalarType*, int, MPI_Comm);
     PetscErrorCode LaplacianSmoothing(Vec, Vec, IntType);
 
     PetscErrorCode GridChangeCommDataRestrict();
     PetscErrorCode GridChangeCommDataProlong();
     PetscErrorCode GridChangeCommIndices();
+    PetscErrorCode CountGridChangeComm(IntType*, IntType*, size_t);
     PetscErrorCode SetupGridChangeOps(IntType*, IntType*);
+    PetscErrorCode GetFFTGridOps(FFTGridOps**, IntType*);
+    PetscErrorCode ReleaseGridChangeOps();
+    PetscErrorCode TrimGridChangeCache(bool clear = false);
 
     RegOpt* m_Opt;
     ComplexType* m_xhat;
@@ -147,6 +212,8 @@ class Preprocessing {
     bool m_IndicesCommunicated;
     bool m_GridChangeIndicesComputed;
 
+    GridChangeOps* m_GridChangeOps;     ///< active grid transfer operators (owned by cache)
+
 //    int *m_LabelValues;
 //    int m_NoLabel;
     double *m_OverlapMeasures;
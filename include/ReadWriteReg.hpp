@@ -29,6 +29,15 @@
 #include "pnetcdf.h"
 #endif
 
+#ifdef REG_HAS_ZLIB
+#include "zlib.h"
+#endif
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+
 #include "RegOpt.hpp"
 #include "VecField.hpp"
 
@@ -85,6 +94,14 @@ class ReadWriteReg {
     PetscErrorCode Write(Vec, std::string, bool multicomponent = false);
     PetscErrorCode Write(VecField*, std::string);
 
+    /*! wait until all pending (asynchronous) output has been written */
+    PetscErrorCode Flush();
+
+    /*! streaming output of time series (one record per time point) */
+    PetscErrorCode OpenTimeSeries(std::string, IntType nc = 1);
+    PetscErrorCode AppendTimeSeries(Vec, IntType j = 0);
+    PetscErrorCode CloseTimeSeries();
+
  private:
     PetscErrorCode Initialize();
     PetscErrorCode ClearMemory();
@@ -102,12 +119,17 @@ class ReadWriteReg {
     PetscErrorCode ReadBIN(Vec*);
     PetscErrorCode WriteBIN(Vec);
 
+#ifdef REG_HAS_ZLIB
+    /*! chunked, compressed claire volume format (*.clr) */
+    PetscErrorCode ReadCLR(Vec*);
+    PetscErrorCode WriteCLR(Vec);
+#endif
+
     PetscErrorCode ReadNetCDF(Vec);
     PetscErrorCode ReadTimeSeriesNetCDF(Vec);
     PetscErrorCode ReadBlockNetCDF(Vec, int*);
 
     PetscErrorCode WriteNetCDF(Vec);
-    PetscErrorCode WriteTimeSeriesNetCDF(Vec);
     PetscErrorCode WriteBlockNetCDF(Vec, int*);
 
     PetscErrorCode CollectSizes();
@@ -115,8 +137,13 @@ class ReadWriteReg {
 #ifdef REG_HAS_NIFTI
     PetscErrorCode ReadNII(Vec*);
     PetscErrorCode ReadNII(VecField*);
-    PetscErrorCode ReadNII(nifti_image*);
-    template <typename T> PetscErrorCode ReadNII(nifti_image*);
+    PetscErrorCode ReadNII(nifti_image*, Vec);
+    template <typename T> PetscErrorCode ReadNII(nifti_image*, Vec);
+    PetscErrorCode ReadNIIHeader(nifti_image**);
+
+    /*! parallel io of uncompressed images (local block per rank) */
+    template <typename T> PetscErrorCode ReadBlockNII(nifti_image*, Vec);
+    template <typename T> PetscErrorCode WriteBlockNII(nifti_image*, Vec);
 
     PetscErrorCode WriteNII(Vec);
     PetscErrorCode WriteNII(nifti_image**);
@@ -125,7 +152,17 @@ class ReadWriteReg {
     PetscErrorCode GetComponentType(nifti_image*, DataType&);;
     PetscErrorCode AllocateImage(nifti_image**, Vec);
 
+    /*! hand copy of image to background writer */
+    PetscErrorCode EnqueueNII(nifti_image*);
+    void WriterLoop();
+
     nifti_image* m_ImageData;
+
+    std::deque<nifti_image*> m_WriteQueue;  ///< images pending to be written (front is being written)
+    std::thread m_Writer;                   ///< background writer thread (master rank only)
+    std::mutex m_WriteQueueMutex;
+    std::condition_variable m_WriteQueueCond;
+    bool m_StopWriter;
 #endif
 
     ImageType m_TemplateImage;
@@ -141,6 +178,16 @@ class ReadWriteReg {
     ScalarType* m_Data;
     IntType m_nx[3];
 
+    std::string m_TimeSeriesName;   ///< file name of time series (without extension)
+    std::string m_TimeSeriesExt;    ///< file extension of time series
+    IntType m_TimeSeriesNC;         ///< number of components per time point
+    IntType m_TimeSeriesRecord;     ///< index of next time point (record)
+    Vec m_TimeSeriesSlice;          ///< work vector (one file per time point)
+#ifdef REG_HAS_PNETCDF
+    int m_TimeSeriesFile;           ///< id of netcdf file (-1 if closed)
+    int m_TimeSeriesVar;
+#endif
+
     std::string m_FileName;
 };
 
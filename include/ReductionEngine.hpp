@@ -0,0 +1,145 @@
+/*************************************************************************
+ *  Copyright (c) 2018.
+ *  All rights reserved.
+ *  This file is part of the CLAIRE library.
+ *
+ *  CLAIRE is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CLAIRE is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CLAIRE.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#ifndef _REDUCTIONENGINE_HPP_
+#define _REDUCTIONENGINE_HPP_
+
+#include "CLAIREUtils.hpp"
+
+
+
+
+namespace reg {
+
+
+
+
+/*! interface for components that need to post-process the result of
+    a deferred reduction (e.g., if the value is a nonlinear function
+    of several global sums) */
+class ReductionCallback {
+ public:
+    virtual ~ReductionCallback() {}
+    virtual PetscErrorCode FinalizeReduction(void) = 0;
+};
+
+
+
+
+/*! collects scalar partial sums of different components and resolves
+    them with a single allreduce; between Begin() and End() all
+    reductions are deferred; outside of such a block Flush() reduces
+    immediately; Post() and Wait() allow to overlap the (non-blocking)
+    reduction with computation; result pointers have to stay valid
+    until the reduction has been resolved; components (distance
+    measures, regularization models) register their local sums with
+    Add() followed by Flush(), so that they reduce immediately when
+    called on their own and are fused into a single allreduce when
+    called inside an objective evaluation (see CLAIRE::EvaluateObjective) */
+class ReductionEngine {
+ public:
+    typedef ReductionEngine Self;
+
+    ReductionEngine();
+    ~ReductionEngine();
+
+    /*! start deferring reductions (blocks can be nested) */
+    PetscErrorCode Begin(void);
+
+    /*! resolve all pending reductions if outermost block */
+    PetscErrorCode End(void);
+
+    /*! close block without resolving (error paths); no communication;
+        all entries (also posted ones) are discarded if outermost block */
+    void Abort(void);
+
+    /*! register local partial sum; after the reduction we set
+        *result = shift + scale*(global sum) */
+    PetscErrorCode Add(ScalarType, ScalarType*, ScalarType scale = 1.0, ScalarType shift = 0.0);
+
+    /*! register callback; executed after all entries registered
+        before it have been resolved */
+    PetscErrorCode AddCallback(ReductionCallback*);
+
+    /*! resolve pending reductions (no-op if deferred) */
+    PetscErrorCode Flush(void);
+
+    /*! resolve pending reductions now (also if deferred); for
+        callers that need the result immediately */
+    PetscErrorCode Reduce(void);
+
+    /*! start non-blocking reduction of all pending entries */
+    PetscErrorCode Post(void);
+
+    /*! wait for non-blocking reduction and set results */
+    PetscErrorCode Wait(void);
+
+    inline bool IsDeferred(void) const {return this->m_Depth > 0;}
+
+    /*! number of allreduce calls issued */
+    inline unsigned int GetNumReductions(void) const {return this->m_NumReductions;}
+
+ private:
+    struct Entry {
+        ScalarType value;
+        ScalarType* result;
+        ScalarType scale;
+        ScalarType shift;
+        ReductionCallback* callback;
+    };
+
+    std::vector<Entry> m_Entries;       ///< pending (and posted) entries
+    std::vector<ScalarType> m_SendBuffer;
+    std::vector<ScalarType> m_RecvBuffer;
+    MPI_Request m_Request;
+    size_t m_NumPosted;                 ///< number of entries in flight
+    bool m_Posted;
+    int m_Depth;
+    unsigned int m_NumReductions;
+};
+
+
+
+
+/*! scope guard for a deferred reduction block; Begin() is called on
+    construction; if the scope is left before End() has been called
+    (e.g., by CHKERRQ) the block is aborted, so that the depth of the
+    engine stays balanced */
+class ReductionBlock {
+ public:
+    explicit ReductionBlock(ReductionEngine*);
+    ~ReductionBlock();
+
+    PetscErrorCode Begin(void);
+    PetscErrorCode End(void);
+
+ private:
+    ReductionEngine* m_Engine;
+    bool m_Open;
+};
+
+
+
+
+}  // namespace reg
+
+
+
+
+#endif  // _REDUCTIONENGINE_HPP_
@@ -22,6 +22,10 @@
 
 // local includes
 #include "CLAIREUtils.hpp"
+#include "ReductionEngine.hpp"
+#include "Tracer.hpp"
+#include "CommCounter.hpp"
+#include "PerfCounter.hpp"
 
 
 
@@ -64,6 +68,8 @@ enum RegNormType {
 enum DMType {
     SL2,    ///< flag for squared L2-norm
     NCC,    ///< flag for normalized cross-correlation
+    LNCC,   ///< flag for local normalized cross-correlation
+    MI,     ///< flag for mutual information
     SL2AUX, ///< flag for squared L2-norm (coupling)
 };
 
@@ -112,6 +118,7 @@ enum OptMeth {
     GAUSSNEWTON,  ///< Gauss-Newton approximation
     FULLNEWTON,   ///< full Newton
     GRADDESCENT,  ///< gradient descent (gradient in sobolev space)
+    QUASINEWTON,  ///< limited memory BFGS (initial hessian: inverse regularization operator)
 };
 
 
@@ -217,6 +224,8 @@ enum LogType{
     LOGJAC,
     LOGLOAD,
     LOGGRAD,
+    LOGTRACE,
+    LOGPERF,
     NLOGFLAGS
 };
 
@@ -239,11 +248,13 @@ struct ReadWriteFlags {
     bool residual;            ///< write dataset with residual between reference and transported template (i.e., the mismatch; abs(m1 - mR))
     bool invresidual;         ///< write dataset with residual between reference and transported template (i.e., the mismatch; 1 - abs(m1 - mR))
     bool defmap;              ///< write deformation map y
+    bool invdefmap;           ///< write inverse deformation map y^{-1}
     bool templateim;          ///< write template image (original dataset)
     bool referenceim;         ///< write reference image (original dataset)
     bool deftemplate;         ///< write deformed/transported template
     bool deffield;            ///< write deformation field (displacement field)
     bool velocity;            ///< write velocity field
+    int asyncdepth;           ///< max number of pending asynchronous (write-behind) outputs (0: synchronous io)
 };
 
 
@@ -287,6 +298,8 @@ struct Optimization {
     ScalarType tol[3];           ///< tolerances for optimization
     ScalarType gtolbound;        ///< tolerances for gradient (lower bound; if maxiter is small, this is what we at least would like to achieve)
     OptMeth method;              ///< optimization method
+    bool methodset;              ///< optimization method set by user (presets do not change it)
+    int lbfgsmem;                ///< number of update pairs stored for limited memory BFGS
     GlobalMethType glmethod;     ///< method for globalization (line search; trust region; ...)
     GradientType gradtype;       ///< flag for type of gradient (sobolev or ell-2)
     StopCondType stopcond;       ///< stopping conditions
@@ -346,6 +359,8 @@ struct ParCont {
     ScalarType targetbeta;                              ///< target regularization parameter
     ScalarType beta0;                                   ///< initial regularization parameter
     ScalarType stepsize;
+    int ngroups;                                        ///< number of groups (communicators) for parallel search
+    int group;                                          ///< id of group this task belongs to
 };
 
 
@@ -392,6 +407,8 @@ struct Monitor {
     ScalarType rval;            ///< value of regularization functional
     ScalarType gradnorm;        ///< norm of gradient at current iteration
     ScalarType gradnorm0;       ///< initial value of norm of gradient
+    bool accuracychanged;       ///< accuracy of pde solver changed (tao solve has to be restarted)
+    IntType iteroffset;         ///< iterations of former tao solves (restarts; tao starts counting at zero)
     std::string solverstatus;   ///< string to hold solver status (used in coupling)
 };
 
@@ -407,6 +424,8 @@ struct Distance {
     DMType type;
     bool reset;
     ScalarType scale;
+    int lnccradius;     ///< window radius for local ncc (in grid points)
+    int mibins;         ///< number of histogram bins for mutual information
 };
 
 
@@ -420,14 +439,20 @@ struct FourierTransform {
     IntType nalloc;     ///< size for allocation in fourier domain
     IntType osize[3];   ///< size of grid in fourier domain for mpi proc
     IntType ostart[3];  ///< start index in fourier domain for mpi proc
+    IntType gridopscache;  ///< memory budget (MB) for cached grid transfer operators
+    std::string wisdomdir; ///< directory for persistent fftw wisdom (empty: disabled)
 };
 
 
 struct RegFlags {
     bool applysmoothing;         ///< apply smoothing to images
     bool applyrescaling;         ///< apply rescaling to images (map the intensity range to [0,1])
+    bool recursivesmoothing;     ///< apply gaussian smoothing with recursive filters (instead of spectral)
+    bool activeregion;           ///< restrict trajectories/interpolation to region of interest (mask)
     bool registerprobmaps;       ///< flag to identify that we are performing a registration of probabilty maps
     bool detdefgradfromdeffield; ///< compute determinant fo deformation gradient from deformation field (displacement field)
+    bool detdefgradlowmem;       ///< compute determinant of deformation gradient without storing the gradient
+    bool invdefmapfixedpoint;    ///< compute inverse deformation map by fixed point iteration
     bool invdefgrad;             ///< compute inverse of deformation gradient
     bool checkdefmapsolve;       ///< check
     bool runinversion;           ///< flag to identify if we are running an inversion or not (lower memory footprint for fwd solve if not)
@@ -444,6 +469,9 @@ struct PDESolver {
     ScalarType cflnumber;
     bool monitorcflnumber;
     bool adapttimestep;
+    bool adaptaccuracy;     ///< tie nt and interpolation order to progress of optimizer
+    bool iplinear;          ///< use linear interpolation (set by accuracy adaptive solver; not with INTERP_USE_MORE_MEM_L1)
+    bool scalingsquaring;   ///< compute deformation map/displacement field by scaling and squaring
 };
 
 
@@ -459,6 +487,8 @@ struct Logger {
     std::vector<int> kryloviterations;       ///< iterations of krylov method
     ScalarType finalresidual[4];
     bool enabled[NLOGFLAGS];
+    IntType tracebuffer;                     ///< number of trace events per thread
+    unsigned long perfrawevent;              ///< raw hardware event (perf_event config)
 
     bool memoryusage;
     double timer[NTIMERS][NVALTYPES];
@@ -550,7 +580,8 @@ class RegOpt {
     PetscErrorCode WriteLogFile(bool coarse = false);
     PetscErrorCode DoSetup(bool dispteaser = true);
 
-    inline void Enter(std::string fname) {
+    inline void Enter(const char* fname) {
+        if (this->m_Tracer.IsEnabled()) this->m_Tracer.Begin(fname);
         #ifdef _REG_DEBUG_
         std::stringstream ss;
         ss << std::string(this->m_Indent++, ' ') << ">> " << fname << std::endl;
@@ -558,7 +589,8 @@ class RegOpt {
         #endif
     }
 
-    inline void Exit(std::string fname) {
+    inline void Exit(const char* fname) {
+        if (this->m_Tracer.IsEnabled()) this->m_Tracer.End(fname);
         #ifdef _REG_DEBUG_
         std::stringstream ss;
         ss << std::string(--this->m_Indent, ' ') << "<< " << fname << std::endl;
@@ -567,6 +599,10 @@ class RegOpt {
     }
 
     PetscErrorCode EnableFastSolve();
+
+    /*! persistent fftw wisdom (see -fftwisdom) */
+    PetscErrorCode ImportFFTWisdom(int*, MPI_Comm, bool&);
+    PetscErrorCode ExportFFTWisdom(int*, MPI_Comm);
     PetscErrorCode ResetDM(DMType type);
 
     RegModel m_RegModel {};              ///< flag for particular registration model
@@ -587,6 +623,8 @@ class RegOpt {
     FileNames m_FileNames {};            ///< file names for input/output
     Logger m_Log {};                     ///< log
     ScalarType m_Sigma[3];               ///< standard deviation for gaussian smoothing
+    ReductionEngine m_Reduction;         ///< deferred (fused) global reductions
+    Tracer m_Tracer;                     ///< span tracer (see -logtrace)
 
     bool m_SetupDone;
     bool m_StoreCheckPoints;
@@ -617,6 +655,8 @@ class RegOpt {
     PetscErrorCode WriteKSPLog();
     PetscErrorCode WriteConvergenceLog();
     PetscErrorCode WriteFinalResidualLog();
+    PetscErrorCode ProcessCommCounters();
+    PetscErrorCode ProcessPerfCounters();
 
     enum TimerValue {LOG = 0, MIN, MAX, AVG, NVALTYPES};
 
@@ -628,6 +668,8 @@ class RegOpt {
     double m_FFTAccumTime;
     double m_InterpTimers[4][NVALTYPES];
     double m_IPAccumTime;
+    double m_CommStats[NCOMMPHASES][NCOMMVALUES][NVALTYPES];
+    double m_PerfStats[NPERFREGIONS][NPERFEVENTS][NVALTYPES];
     double m_IPSlowest;
     double m_TTSSlowest;
     double m_FFTSlowest;
@@ -49,6 +49,11 @@ class Regularization {
     virtual PetscErrorCode ApplyInverse(VecField*, VecField*, bool applysqrt = false) = 0;
     virtual PetscErrorCode GetExtremeEigValsInvOp(ScalarType&, ScalarType&) = 0;
 
+    /*! fourier symbol of inverse operator at wavenumber with laplacian symbol
+        lapik = -|k|^2 (without fft scaling); used to fuse the inverse with
+        other spectral operators */
+    virtual ScalarType GetInverseSymbol(ScalarType, bool applysqrt = false) = 0;
+
  protected:
     PetscErrorCode Initialize(void);
     PetscErrorCode ClearMemory(void);
@@ -45,6 +45,7 @@ class RegularizationH1 : public Regularization {
     virtual PetscErrorCode HessianMatVec(VecField*, VecField*);
     virtual PetscErrorCode ApplyInverse(VecField*, VecField*, bool applysqrt = false);
     virtual PetscErrorCode GetExtremeEigValsInvOp(ScalarType&, ScalarType&);
+    virtual ScalarType GetInverseSymbol(ScalarType, bool applysqrt = false);
 };
 
 
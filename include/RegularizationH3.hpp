@@ -44,6 +44,7 @@ class RegularizationH3 : public Regularization {
     virtual PetscErrorCode HessianMatVec(VecField*, VecField*);
     virtual PetscErrorCode ApplyInverse(VecField*, VecField*, bool applysqrt = false);
     virtual PetscErrorCode GetExtremeEigValsInvOp(ScalarType&, ScalarType&);
+    virtual ScalarType GetInverseSymbol(ScalarType, bool applysqrt = false);
 };
 
 
@@ -56,6 +56,12 @@ class SemiLagrangian {
                                        ScalarType*, ScalarType*, ScalarType*,
                                        std::string);
 
+    /*! interpolate vector field at state and adjoint query points
+        (the ghost layer is communicated only once) */
+    PetscErrorCode InterpolateStateAndAdjoint(ScalarType*, ScalarType*, ScalarType*,
+                                              ScalarType*, ScalarType*, ScalarType*,
+                                              ScalarType*, ScalarType*, ScalarType*);
+
     /*! set coordinate vector */
     PetscErrorCode SetQueryPoints(ScalarType*, ScalarType*, ScalarType*, std::string);
 
@@ -64,6 +70,13 @@ class SemiLagrangian {
     PetscErrorCode SetReadWrite(ReadWriteReg*);
     PetscErrorCode SetWorkVecField(VecField*);
 
+    /*! restrict trajectories and interpolation to region of interest */
+    PetscErrorCode SetActiveRegion(Vec);
+
+    /*! local indices of the points the plan is restricted to (NULL if
+        the plan acts on all points) */
+    PetscErrorCode GetActiveIndex(const std::vector<IntType>*&, std::string);
+
  protected:
     PetscErrorCode Initialize();
     PetscErrorCode ClearMemory();
@@ -71,6 +84,9 @@ class SemiLagrangian {
     virtual PetscErrorCode CommunicateCoord(std::string);
     PetscErrorCode ComputeTrajectoryRK2(VecField*, std::string);
     PetscErrorCode ComputeTrajectoryRK4(VecField*, std::string);
+    PetscErrorCode ComputeActiveRegion(VecField*, std::string);
+    PetscErrorCode SetActiveValues(ScalarType*, const ScalarType*, const ScalarType*, int);
+    ScalarType TaperWeight(IntType, IntType, IntType, IntType);
 
     RegOpt* m_Opt;
 
@@ -86,6 +102,14 @@ class SemiLagrangian {
 
     int m_Dofs[2];
 
+    Vec m_Mask;                             ///< mask that defines region of interest
+    PetscObjectState m_MaskState;
+    IntType m_MaskBox[6];                   ///< bounding box of mask support (global indices)
+    std::vector<IntType> m_ActiveIndex[2];  ///< active points for state/adjoint plan
+    std::vector<ScalarType> m_ActiveWeight[2];  ///< taper at boundary of active region
+    bool m_UseActiveRegion;                 ///< restrict next scatter to active points
+    bool m_Compact[2];                      ///< state/adjoint plan uses active points only
+
     struct GhostPoints {
         int isize[3];
         int istart[3];
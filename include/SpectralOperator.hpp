@@ -0,0 +1,107 @@
+/*************************************************************************
+ *  Copyright (c) 2016.
+ *  All rights reserved.
+ *  This file is part of the CLAIRE library.
+ *
+ *  CLAIRE is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CLAIRE is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CLAIRE.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#ifndef _SPECTRALOPERATOR_HPP_
+#define _SPECTRALOPERATOR_HPP_
+
+#include "RegOpt.hpp"
+#include "CLAIREUtils.hpp"
+#include "VecField.hpp"
+#include "Regularization.hpp"
+
+
+
+
+namespace reg {
+
+
+
+
+/*! pointwise fourier multipliers that can be chained */
+enum SpectralStageType {
+    SPECPROJECTION,  ///< (relaxed) leray projection onto divergence free fields
+    SPECINVREG,      ///< inverse of regularization operator
+    SPECGAUSSIAN,    ///< gaussian filter
+};
+
+
+
+
+/*! chain of pointwise fourier multipliers acting on a vector field;
+    all stages are applied in a single forward / inverse fft round
+    trip (3 r2c and 3 c2r transforms, independent of the number of
+    stages); the spectral work arrays are shared with the caller */
+class SpectralOperator {
+ public:
+    typedef SpectralOperator Self;
+
+    SpectralOperator(void);
+    SpectralOperator(RegOpt*);
+    ~SpectralOperator(void);
+
+    PetscErrorCode SetSpectralData(ComplexType*, ComplexType*, ComplexType*);
+
+    /*! remove all stages */
+    PetscErrorCode Reset(void);
+
+    /*! append projection x - c K x with K = grad lap^{-1} div; c = 1
+        (betaw = 0) is the leray projection; otherwise we use the
+        relaxed projection c = (betav (betaw(-lap + 1))^{-1} + 1)^{-1} */
+    PetscErrorCode AddProjection(ScalarType betav = 0.0, ScalarType betaw = 0.0);
+
+    /*! append (square root of) inverse of regularization operator */
+    PetscErrorCode AddInverseRegularization(Regularization*, bool applysqrt = false);
+
+    /*! append gaussian filter (sigma in number of grid points) */
+    PetscErrorCode AddGaussianFilter(ScalarType*);
+
+    /*! number of stages in chain */
+    inline int GetNumStages(void) const {return static_cast<int>(this->m_Stages.size());}
+
+    /*! apply chain y = S_n ... S_1 x (y and x may be the same field) */
+    PetscErrorCode Apply(VecField*, VecField*);
+
+ private:
+    struct Stage {
+        SpectralStageType type;
+        ScalarType param[3];
+        bool applysqrt;
+        Regularization* regularization;
+    };
+
+    PetscErrorCode Initialize(void);
+    PetscErrorCode ClearMemory(void);
+
+    RegOpt* m_Opt;
+    std::vector<Stage> m_Stages;
+
+    ComplexType *m_x1hat;
+    ComplexType *m_x2hat;
+    ComplexType *m_x3hat;
+};
+
+
+
+
+}  // namespace reg
+
+
+
+
+#endif  // _SPECTRALOPERATOR_HPP_
@@ -25,6 +25,7 @@
 #include "Preconditioner.hpp"
 #include "KrylovInterface.hpp"
 #include "OptimizationProblem.hpp"
+#include "Optimizer.hpp"
 
 
 
@@ -43,6 +44,7 @@ PetscErrorCode ConstructHessian(Tao, Vec, Mat*, Mat*, MatStructure*, void*);
 PetscErrorCode EvaluateHessian(Tao, Vec, Mat, Mat, void*);
 PetscErrorCode HessianMatVec(Mat, Vec, Vec);
 PetscErrorCode PrecondMatVec(PC, Vec, Vec);
+PetscErrorCode LBFGSMatVec(PC, Vec, Vec);
 
 PetscErrorCode CheckConvergenceGrad(Tao, void*);
 PetscErrorCode CheckConvergenceGradObj(Tao, void*);
@@ -0,0 +1,109 @@
+/*************************************************************************
+ *  Copyright (c) 2018.
+ *  All rights reserved.
+ *  This file is part of the CLAIRE library.
+ *
+ *  CLAIRE is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CLAIRE is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CLAIRE.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#ifndef _TRACER_HPP_
+#define _TRACER_HPP_
+
+#include "CLAIREUtils.hpp"
+
+
+
+
+namespace reg {
+
+
+
+
+/*! lightweight tracer for nested spans (fed by RegOpt::Enter/Exit and
+    the timers); events are recorded per thread into preallocated ring
+    buffers (the oldest events are overwritten); at the end we write a
+    trace per rank in chrome trace event format (loadable in perfetto
+    or chrome://tracing) and a summary of the slowest rank per span */
+class Tracer {
+ public:
+    typedef Tracer Self;
+
+    Tracer();
+    ~Tracer();
+
+    /*! allocate ring buffers (number of events per thread) */
+    PetscErrorCode Initialize(size_t);
+
+    /*! write per rank trace and merged summary (collective) */
+    PetscErrorCode Write(std::string, std::string);
+
+    inline bool IsEnabled(void) const {return this->m_Enabled;}
+
+    /*! record begin/end of span; name has to be a string literal
+        (or otherwise outlive the tracer; e.g., __func__) */
+    inline void Begin(const char* name) {this->Record(name, true);}
+    inline void End(const char* name) {this->Record(name, false);}
+
+ private:
+    struct Event {
+        const char* name;
+        double time;
+        bool begin;
+    };
+
+    struct Buffer {
+        std::vector<Event> events;
+        size_t head;        ///< next position to write
+        size_t count;       ///< number of valid events
+        size_t dropped;     ///< number of overwritten events
+        char pad[64];       ///< avoid false sharing between threads
+    };
+
+    struct Span {
+        int thread;
+        const char* name;
+        double start, duration, self;
+    };
+
+    inline void Record(const char* name, bool begin) {
+        int tid = omp_in_parallel() ? omp_get_thread_num() : 0;
+        if (tid >= this->m_NumThreads) return;
+        Buffer& b = this->m_Buffer[tid];
+        Event& e = b.events[b.head];
+        e.name = name;
+        e.time = MPI_Wtime();
+        e.begin = begin;
+        b.head = (b.head + 1 == b.events.size()) ? 0 : b.head + 1;
+        if (b.count < b.events.size()) ++b.count; else ++b.dropped;
+    }
+
+    PetscErrorCode ComputeSpans(std::vector<Span>&);
+    PetscErrorCode WriteTrace(std::string, const std::vector<Span>&);
+    PetscErrorCode WriteSummary(std::string, const std::vector<Span>&);
+
+    std::vector<Buffer> m_Buffer;
+    int m_NumThreads;
+    double m_T0;
+    bool m_Enabled;
+};
+
+
+
+
+}  // namespace reg
+
+
+
+
+#endif  // _TRACER_HPP_
@@ -52,6 +52,15 @@ class VecField {
         flat PETSc vector as an input */
     PetscErrorCode GetComponents(Vec);
 
+    /*! alias individual components to the blocks of a flat
+        PETSc vector (no copy); the flat vector is locked until
+        ResetComponents is called; a readonly view must not be
+        written and must not alias a writable view */
+    PetscErrorCode PlaceComponents(Vec, bool readonly = false);
+
+    /*! release the view created by PlaceComponents */
+    PetscErrorCode ResetComponents(void);
+
     /*! set all components to a given value*/
     PetscErrorCode SetValue(ScalarType);
 
@@ -81,6 +90,7 @@ class VecField {
 
     PetscErrorCode WAXPY(ScalarType, VecField*, VecField*);
     PetscErrorCode AXPY(ScalarType, VecField*);
+    PetscErrorCode AYPX(ScalarType, VecField*);
     
     PetscErrorCode DebugInfo(std::string, int, const char*);
 
@@ -89,6 +99,12 @@ class VecField {
     PetscErrorCode Norm(ScalarType&);
     PetscErrorCode Norm(ScalarType&, ScalarType&, ScalarType&);
 
+    /*! local (not reduced) squared l2 norm (see ReductionEngine) */
+    PetscErrorCode SquaredNormLocal(ScalarType&);
+    PetscErrorCode SquaredNormLocal(ScalarType&, ScalarType&, ScalarType&);
+    /*! local (not reduced) max norm over all components */
+    PetscErrorCode NormInfLocal(ScalarType&);
+
     // individual components
     Vec m_X1;
     Vec m_X2;
@@ -102,7 +118,17 @@ class VecField {
     PetscErrorCode Allocate(IntType,IntType);
     PetscErrorCode Allocate(int);
 
+    PetscErrorCode SetupLocalVector(IntType);
+
     RegOpt* m_Opt;
+
+    // flat vector the components are placed on (if any)
+    Vec m_PlacedVec;
+    ScalarType* m_PlacedArray;
+    bool m_PlacedReadOnly;
+
+    // sequential view on the local part (device reductions)
+    Vec m_LocalVec;
 };
 
 
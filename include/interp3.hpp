@@ -81,6 +81,11 @@ void interp3_ghost_xyz_p(Real* reg_grid_vals, int data_dof, int* N_reg,
 		Real* query_points, Real* query_values, int interp_order,
 		bool query_values_already_scaled = false); // higher order interpolation
 
+void lin_interp3_ghost_xyz_p(Real* reg_grid_vals, int data_dof, int* N_reg,
+		int * N_reg_g, int* isize_g, int* istart, const int N_pts, int g_size,
+		Real* query_points, Real* query_values,
+		bool query_values_already_scaled = false); // linear interpolation
+
 void interp3_ghost_p(Real* reg_grid_vals, int data_dof, int* N_reg,
 		int * N_reg_g, int* isize_g, int* istart, const int N_pts, int g_size,
 		Real* query_points, Real* query_values);
@@ -109,7 +114,8 @@ public:
 	// 		Real* query_values, int* c_dims, MPI_Comm c_comm, double * timings);
   void interpolate(Real* __restrict ghost_reg_grid_vals,
 		int*__restrict N_reg, int *__restrict isize, int*__restrict istart, const int N_pts, const int g_size,
-		Real*__restrict query_values, int*__restrict c_dims, MPI_Comm c_comm, double *__restrict timings, int version =0);
+		Real*__restrict query_values, int*__restrict c_dims, MPI_Comm c_comm, double *__restrict timings, int version =0,
+		int interp_order = 3);
 	void high_order_interpolate(Real* ghost_reg_grid_vals, int data_dof, int* N_reg,
 			int * isize, int* istart, const int N_pts, const int g_size,
 			Real* query_values, int* c_dims, MPI_Comm c_comm, double * timings, int interp_order);
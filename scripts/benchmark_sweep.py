@@ -0,0 +1,208 @@
+#!/usr/bin/env python3
+'''
+run a sweep of CLAIRE benchmarks (bin/benchmark) over grid sizes, number of
+time steps, interpolation orders, regularization norms, pde solvers and
+mpi/thread layouts; per-phase timings are collected into a single json file
+that can be compared against a baseline to flag performance regressions
+
+examples:
+    # strong scaling of the forward solver at 128^3 on one node
+    python3 scripts/benchmark_sweep.py --benchmark forward --nx 128 \
+        --layout 1x1 1x2 2x2 2x4 --out strong.json
+
+    # weak scaling (nx1 and nx2 are scaled with the process grid)
+    python3 scripts/benchmark_sweep.py --mode weak --nx 64 \
+        --layout 1x1 1x2 2x2 --out weak.json
+
+    # compare against a previous run (exit code 1 on regression)
+    python3 scripts/benchmark_sweep.py --compare-only --results weak.json \
+        --baseline weak-baseline.json --tolerance 0.1
+'''
+import argparse
+import itertools
+import json
+import os
+import shlex
+import subprocess
+import sys
+import tempfile
+
+
+# phases that are compared against the baseline by default
+DEFAULT_PHASES = ['time-to-solution', 'pde-solve', 'fft-selfexec', 'interp-selfexec']
+
+
+def parse_layout(layout):
+    '''
+    parse process grid "p1xp2" (or "p" for a 1 x p grid)
+    '''
+    p = [int(i) for i in layout.lower().split('x')]
+    if len(p) == 1:
+        p = [1, p[0]]
+    if len(p) != 2 or min(p) < 1:
+        raise ValueError('invalid layout: ' + layout)
+    return p
+
+
+def grid_size(nx, layout, mode):
+    '''
+    grid size of a run; for weak scaling the local problem size is fixed,
+    i.e., nx1 and nx2 grow with the process grid (pencil decomposition)
+    '''
+    if mode == 'weak':
+        return [nx * layout[0], nx * layout[1], nx]
+    return [nx, nx, nx]
+
+
+def config_key(cfg):
+    '''
+    key used to match runs between results and baseline
+    '''
+    return '{}_nx{}_nt{}_np{}x{}_nth{}_{}_ip{}_{}'.format(
+        cfg['benchmark'], 'x'.join(str(n) for n in cfg['nx']), cfg['nt'],
+        cfg['np'][0], cfg['np'][1], cfg['nthreads'],
+        cfg['pdesolver'], cfg['iporder'], cfg['regnorm'])
+
+
+def run_sweep(args):
+    '''
+    execute all runs in the sweep and return the collected results
+    '''
+    runs = []
+    sweep = itertools.product(args.nx, args.nt, args.iporder, args.regnorm,
+                              args.pdesolver, args.layout, args.nthreads)
+    for nx, nt, iporder, regnorm, pdesolver, layout, nthreads in sweep:
+        np = parse_layout(layout)
+        gsize = grid_size(nx, np, args.mode)
+
+        fd, jsonfile = tempfile.mkstemp(suffix='.json', prefix='claire-bench-')
+        os.close(fd)
+
+        cmd = shlex.split(args.mpirun) + ['-np', str(np[0] * np[1])]
+        cmd += shlex.split(args.mpiargs)
+        cmd += [args.bin, '-' + args.benchmark,
+                '-nx', 'x'.join(str(n) for n in gsize),
+                '-nt', str(nt),
+                '-np', '{}x{}'.format(np[0], np[1]),
+                '-nthreads', str(nthreads),
+                '-iporder', str(iporder),
+                '-regnorm', regnorm,
+                '-pdesolver', pdesolver,
+                '-repeats', str(args.repeats),
+                '-json', jsonfile]
+
+        print(' '.join(cmd), flush=True)
+        if args.dry_run:
+            os.remove(jsonfile)
+            continue
+
+        env = dict(os.environ, OMP_NUM_THREADS=str(nthreads))
+        proc = subprocess.run(cmd, env=env, stdout=subprocess.PIPE,
+                              stderr=subprocess.STDOUT, universal_newlines=True)
+        if proc.returncode != 0:
+            print(proc.stdout)
+            print('run failed with exit code {}'.format(proc.returncode), file=sys.stderr)
+            os.remove(jsonfile)
+            continue
+
+        with open(jsonfile) as f:
+            run = json.load(f)
+        os.remove(jsonfile)
+
+        run['config']['mode'] = args.mode
+        run['key'] = config_key(run['config'])
+        runs.append(run)
+
+        print('    time-to-solution {:.4e}s'.format(
+            run['phases']['time-to-solution']['max']), flush=True)
+
+    return {'runs': runs}
+
+
+def compare(results, baseline, phases, tolerance):
+    '''
+    compare max time (across ranks) of each phase against baseline;
+    returns the number of regressions
+    '''
+    ref = {run['key']: run for run in baseline['runs']}
+    nregress = 0
+    for run in results['runs']:
+        key = run['key']
+        if key not in ref:
+            print('{:<60} no baseline'.format(key))
+            continue
+        for phase in phases:
+            if phase not in run['phases'] or phase not in ref[key]['phases']:
+                continue
+            t = run['phases'][phase]['max']
+            tref = ref[key]['phases'][phase]['max']
+            if tref <= 0.0:
+                continue
+            ratio = t / tref
+            status = 'ok'
+            if ratio > 1.0 + tolerance:
+                status = 'REGRESSION'
+                nregress += 1
+            elif ratio < 1.0 - tolerance:
+                status = 'improved'
+            print('{:<60} {:<18} {:.4e} {:.4e} {:6.3f} {}'.format(
+                key, phase, tref, t, ratio, status))
+    return nregress
+
+
+def main():
+    parser = argparse.ArgumentParser(description='scaling benchmark sweeps for CLAIRE')
+    parser.add_argument('--bin', default='bin/benchmark', help='path to benchmark binary')
+    parser.add_argument('--mpirun', default='mpirun', help='mpi launcher')
+    parser.add_argument('--mpiargs', default='', help='additional arguments for mpi launcher')
+    parser.add_argument('--benchmark', default='forward',
+                        choices=['forward', 'gradient', 'hessmatvec'])
+    parser.add_argument('--mode', default='strong', choices=['strong', 'weak'],
+                        help='strong: fixed global grid; weak: fixed grid per process')
+    parser.add_argument('--nx', type=int, nargs='+', default=[64],
+                        help='grid size (global for strong, per process grid dimension for weak scaling)')
+    parser.add_argument('--nt', type=int, nargs='+', default=[4], help='number of time steps')
+    parser.add_argument('--iporder', type=int, nargs='+', default=[3], help='interpolation orders')
+    parser.add_argument('--regnorm', nargs='+', default=['h1s'], help='regularization norms')
+    parser.add_argument('--pdesolver', nargs='+', default=['sl'], help='pde solvers (sl, rk2)')
+    parser.add_argument('--layout', nargs='+', default=['1x1'], help='process grids (e.g., 1x1 1x2 2x2)')
+    parser.add_argument('--nthreads', type=int, nargs='+', default=[1], help='omp threads per process')
+    parser.add_argument('--repeats', type=int, default=5, help='number of repeats per run')
+    parser.add_argument('--out', default='benchmark.json', help='output file for results')
+    parser.add_argument('--baseline', default=None, help='baseline results to compare against')
+    parser.add_argument('--tolerance', type=float, default=0.1,
+                        help='relative slowdown that is flagged as regression (default: 0.1)')
+    parser.add_argument('--phases', nargs='+', default=DEFAULT_PHASES, help='phases to compare')
+    parser.add_argument('--compare-only', action='store_true',
+                        help='do not run; compare --results against --baseline')
+    parser.add_argument('--results', default=None, help='results file (with --compare-only)')
+    parser.add_argument('--dry-run', action='store_true', help='only print the commands')
+    args = parser.parse_args()
+
+    if args.compare_only:
+        if args.results is None or args.baseline is None:
+            parser.error('--compare-only requires --results and --baseline')
+        with open(args.results) as f:
+            results = json.load(f)
+    else:
+        results = run_sweep(args)
+        if args.dry_run:
+            return 0
+        with open(args.out, 'w') as f:
+            json.dump(results, f, indent=2)
+        print('results written to ' + args.out)
+
+    if args.baseline is not None:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+        nregress = compare(results, baseline, args.phases, args.tolerance)
+        if nregress > 0:
+            print('{} regression(s) detected (tolerance {:.0f}%)'.format(
+                nregress, 100.0 * args.tolerance))
+            return 1
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
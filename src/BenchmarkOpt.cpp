@@ -134,6 +134,9 @@ PetscErrorCode BenchmarkOpt::ParseArguments(int argc, char** argv) {
         } else if (strcmp(argv[1], "-nthreads") == 0) {
             argc--; argv++;
             this->m_NumThreads = atoi(argv[1]);
+        } else if (strcmp(argv[1], "-fftwisdom") == 0) {
+            argc--; argv++;
+            this->m_FFT.wisdomdir = argv[1];
         } else if (strcmp(argv[1], "-np") == 0) {
             argc--; argv++;
             const std::string npinput = argv[1];
@@ -161,6 +164,31 @@ PetscErrorCode BenchmarkOpt::ParseArguments(int argc, char** argv) {
             this->m_BenchmarkID = 2;
         } else if (strcmp(argv[1], "-terror") == 0) {
             this->m_BenchmarkID = 3;
+        } else if (strcmp(argv[1], "-regnorm") == 0) {
+            argc--; argv++;
+            if (strcmp(argv[1], "h1s") == 0) {
+                this->m_RegNorm.type = H1SN;
+            } else if (strcmp(argv[1], "h2s") == 0) {
+                this->m_RegNorm.type = H2SN;
+            } else if (strcmp(argv[1], "h3s") == 0) {
+                this->m_RegNorm.type = H3SN;
+            } else if (strcmp(argv[1], "h1") == 0) {
+                this->m_RegNorm.type = H1;
+            } else if (strcmp(argv[1], "h2") == 0) {
+                this->m_RegNorm.type = H2;
+            } else if (strcmp(argv[1], "h3") == 0) {
+                this->m_RegNorm.type = H3;
+            } else if (strcmp(argv[1], "l2") == 0) {
+                this->m_RegNorm.type = L2;
+            } else {
+                msg = "\n\x1b[31m regularization norm not available: %s\x1b[0m\n";
+                ierr = PetscPrintf(PETSC_COMM_WORLD, msg.c_str(), argv[1]); CHKERRQ(ierr);
+                ierr = this->Usage(true); CHKERRQ(ierr);
+            }
+            this->m_RegModel = COMPRESSIBLE;
+        } else if (strcmp(argv[1], "-json") == 0) {
+            argc--; argv++;
+            this->m_JSONFile = argv[1];
         } else if (strcmp(argv[1], "-repeats") == 0) {
             argc--; argv++;
             this->m_NumRepeats = atoi(argv[1]);
@@ -169,6 +197,8 @@ PetscErrorCode BenchmarkOpt::ParseArguments(int argc, char** argv) {
             this->m_Verbosity = std::min(atoi(argv[1]),2);
         } else if (strcmp(argv[1], "-logwork") == 0) {
             this->m_Log.enabled[LOGLOAD] = true;
+        } else if (strcmp(argv[1], "-logtrace") == 0) {
+            this->m_Log.enabled[LOGTRACE] = true;
         } else if (strcmp(argv[1], "-debug") == 0) {
             this->m_Verbosity = 3;
         } else {
@@ -225,6 +255,7 @@ PetscErrorCode BenchmarkOpt::Initialize() {
 
     this->m_BenchmarkID = -1;
     this->m_NumRepeats = 1;
+    this->m_JSONFile.clear();
 
     PetscFunctionReturn(ierr);
 }
@@ -255,8 +286,11 @@ PetscErrorCode BenchmarkOpt::Usage(bool advanced) {
         std::cout << " -forward                    benchmark forward solver"<<std::endl;
         std::cout << " -gradient                   benchmark gradient evaluation"<<std::endl;
         std::cout << " -repeats <int>              set number of repeats"<<std::endl;
+        std::cout << " -json <file>                write timings of individual phases to <file> (json format;"<<std::endl;
+        std::cout << "                             used by scripts/benchmark_sweep.py)"<<std::endl;
         std::cout << " -terror                     compute numerical error for solution of transport equation"<<std::endl;
         std::cout << " -logwork                    log work load (requires -x option)"<<std::endl;
+        std::cout << " -logtrace                   write trace of function calls (requires -x option)"<<std::endl;
         if (advanced) {
         std::cout << line << std::endl;
         std::cout << " memory distribution and parallelism"<<std::endl;
@@ -264,6 +298,7 @@ PetscErrorCode BenchmarkOpt::Usage(bool advanced) {
         std::cout << " -nthreads <int>             number of threads (default: 1)"<<std::endl;
         std::cout << " -np <int>x<int>             distribution of mpi tasks (cartesian grid) (example: -np 2x4 results"<<std::endl;
         std::cout << "                             results in MPI distribution of size (nx1/2,nx2/4,nx3) for each mpi task)"<<std::endl;
+        std::cout << " -fftwisdom <dir>            import/export fftw wisdom from/to <dir> (reduces fft setup time)"<<std::endl;
         }
         // ####################### advanced options #######################
         std::cout << line << std::endl;
@@ -285,6 +320,15 @@ PetscErrorCode BenchmarkOpt::Usage(bool advanced) {
         std::cout << " -adapttimestep              vary number of time steps according to defined number"<<std::endl;
         std::cout << " -cflnumber <dbl>            set cfl number"<<std::endl;
         std::cout << " -iporder <int>              order of interpolation model (default is 3)" << std::endl;
+        std::cout << " -regnorm <type>             regularization norm for velocity field" << std::endl;
+        std::cout << "                             <type> is one of the following" << std::endl;
+        std::cout << "                                 h1s          H1-seminorm (default)" << std::endl;
+        std::cout << "                                 h2s          H2-seminorm" << std::endl;
+        std::cout << "                                 h3s          H3-seminorm" << std::endl;
+        std::cout << "                                 h1           H1-norm" << std::endl;
+        std::cout << "                                 h2           H2-norm" << std::endl;
+        std::cout << "                                 h3           H3-norm" << std::endl;
+        std::cout << "                                 l2           L2-norm" << std::endl;
         std::cout << line << std::endl;
         // ####################### advanced options #######################
         std::cout << line << std::endl;
@@ -399,6 +443,122 @@ PetscErrorCode BenchmarkOpt::CheckArguments() {
 
 
 
+/********************************************************************
+ * @brief write timings of the individual phases of the benchmark
+ * to a json file (one object per run); min/max/avg are taken across
+ * mpi ranks (requires ProcessTimers to be called before)
+ *******************************************************************/
+PetscErrorCode BenchmarkOpt::WriteJSONLog() {
+    PetscErrorCode ierr = 0;
+    int rank, nproc, rval, isopen = 0;
+    unsigned int nip, nfft;
+    std::ofstream logwriter;
+    std::string benchmark, pdesolver, regnorm;
+    PetscFunctionBegin;
+
+    this->Enter(__func__);
+
+    if (this->m_JSONFile.empty()) {
+        this->Exit(__func__);
+        PetscFunctionReturn(ierr);
+    }
+
+    MPI_Comm_rank(PETSC_COMM_WORLD, &rank);
+    MPI_Comm_size(PETSC_COMM_WORLD, &nproc);
+
+    switch (this->m_BenchmarkID) {
+        case 0: benchmark = "forward"; break;
+        case 1: benchmark = "gradient"; break;
+        case 2: benchmark = "hessmatvec"; break;
+        case 3: benchmark = "terror"; break;
+        default: benchmark = "undefined"; break;
+    }
+
+    switch (this->m_PDESolver.type) {
+        case RK2: pdesolver = "rk2"; break;
+        case RK2A: pdesolver = "rk2a"; break;
+        case SL: pdesolver = "sl"; break;
+        default: pdesolver = "undefined"; break;
+    }
+
+    switch (this->m_RegNorm.type) {
+        case H1SN: regnorm = "h1s"; break;
+        case H2SN: regnorm = "h2s"; break;
+        case H3SN: regnorm = "h3s"; break;
+        case H1: regnorm = "h1"; break;
+        case H2: regnorm = "h2"; break;
+        case H3: regnorm = "h3"; break;
+        case L2: regnorm = "l2"; break;
+        default: regnorm = "undefined"; break;
+    }
+
+    nfft = this->m_Counter[FFT];
+    nip = this->m_Counter[IP] + 3*this->m_Counter[IPVEC];
+
+    // open file on master rank; all ranks fail together
+    if (rank == 0) {
+        logwriter.open(this->m_JSONFile.c_str());
+        isopen = logwriter.is_open() ? 1 : 0;
+    }
+    rval = MPI_Bcast(&isopen, 1, MPI_INT, 0, PETSC_COMM_WORLD);
+    ierr = MPIERRQ(rval); CHKERRQ(ierr);
+    ierr = Assert(isopen == 1, "could not open file for writing"); CHKERRQ(ierr);
+
+    if (rank == 0) {
+        // write a single phase as {"count":..., "min":..., "max":..., "avg":...}
+        auto phase = [&logwriter](const char* name, unsigned int count,
+                                  const double* value, bool last) {
+            logwriter << "    \"" << name << "\": {\"count\": " << count
+                      << std::scientific << std::setprecision(8)
+                      << ", \"min\": " << value[MIN]
+                      << ", \"max\": " << value[MAX]
+                      << ", \"avg\": " << value[AVG] << "}"
+                      << (last ? "" : ",") << std::endl;
+        };
+
+        logwriter << "{" << std::endl;
+        logwriter << "  \"config\": {" << std::endl;
+        logwriter << "    \"benchmark\": \"" << benchmark << "\"," << std::endl;
+        logwriter << "    \"nx\": [" << this->m_Domain.nx[0] << ", "
+                                     << this->m_Domain.nx[1] << ", "
+                                     << this->m_Domain.nx[2] << "]," << std::endl;
+        logwriter << "    \"nt\": " << this->m_Domain.nt << "," << std::endl;
+        logwriter << "    \"np\": [" << this->m_CartGridDims[0] << ", "
+                                     << this->m_CartGridDims[1] << "]," << std::endl;
+        logwriter << "    \"nprocs\": " << nproc << "," << std::endl;
+        logwriter << "    \"nthreads\": " << omp_get_max_threads() << "," << std::endl;
+        logwriter << "    \"pdesolver\": \"" << pdesolver << "\"," << std::endl;
+        logwriter << "    \"iporder\": " << this->m_PDESolver.iporder << "," << std::endl;
+        logwriter << "    \"regnorm\": \"" << regnorm << "\"," << std::endl;
+        logwriter << "    \"repeats\": " << this->m_NumRepeats << std::endl;
+        logwriter << "  }," << std::endl;
+        logwriter << "  \"phases\": {" << std::endl;
+        phase("time-to-solution", this->m_NumRepeats, this->m_Timer[T2SEXEC], false);
+        phase("pde-solve", this->m_Counter[PDESOLVE], this->m_Timer[PDEEXEC], false);
+        phase("objective", this->m_Counter[OBJEVAL], this->m_Timer[OBJEXEC], false);
+        phase("gradient", this->m_Counter[GRADEVAL], this->m_Timer[GRADEXEC], false);
+        phase("hessian-matvec", this->m_Counter[HESSMATVEC], this->m_Timer[HMVEXEC], false);
+        phase("fft-setup", 1, this->m_Timer[FFTSETUP], false);
+        phase("fft-selfexec", nfft, this->m_Timer[FFTSELFEXEC], false);
+        phase("fft-comm", nfft, this->m_FFTTimers[FFTCOMM], false);
+        phase("fft-exec", nfft, this->m_FFTTimers[FFTEXECUTE], false);
+        phase("interp-selfexec", nip, this->m_Timer[IPSELFEXEC], false);
+        phase("interp-comm", nip, this->m_InterpTimers[0], false);
+        phase("interp-exec", nip, this->m_InterpTimers[1], true);
+        logwriter << "  }" << std::endl;
+        logwriter << "}" << std::endl;
+
+        logwriter.close();
+    }
+
+    this->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
 }  // namespace reg
 
 
@@ -26,6 +26,7 @@
 
 // local includes
 #include "CLAIRE.hpp"
+#include "PointwiseKernel.hpp"
 
 
 
@@ -77,6 +78,8 @@ PetscErrorCode CLAIRE::Initialize() {
     this->m_IncStateVariable = NULL;    ///< incremental state variable
     this->m_IncAdjointVariable = NULL;  ///< incremental adjoint variable
 
+    this->m_DeferProjection = false;    ///< projection of body force fused with consumer
+
     PetscFunctionReturn(ierr);
 }
 
@@ -163,11 +166,15 @@ PetscErrorCode CLAIRE::InitializeSolver(void) {
         if (this->m_AdjointVariable == NULL) {
             ierr = VecCreate(this->m_AdjointVariable, nc*nl, nc*ng); CHKERRQ(ierr);
         }
-        if (this->m_IncAdjointVariable == NULL) {
-            ierr = VecCreate(this->m_IncAdjointVariable, nc*nl, nc*ng); CHKERRQ(ierr);
-        }
-        if (this->m_IncStateVariable == NULL) {
-            ierr = VecCreate(this->m_IncStateVariable, nc*nl, nc*ng); CHKERRQ(ierr);
+        // quasi-newton methods never apply the hessian; incremental
+        // variables are only allocated (lazily) if needed
+        if (this->m_Opt->m_OptPara.method != QUASINEWTON) {
+            if (this->m_IncAdjointVariable == NULL) {
+                ierr = VecCreate(this->m_IncAdjointVariable, nc*nl, nc*ng); CHKERRQ(ierr);
+            }
+            if (this->m_IncStateVariable == NULL) {
+                ierr = VecCreate(this->m_IncStateVariable, nc*nl, nc*ng); CHKERRQ(ierr);
+            }
         }
     }
 
@@ -203,6 +210,7 @@ PetscErrorCode CLAIRE::InitializeSolver(void) {
         }
         ierr = Assert(this->m_VelocityField != NULL, "null pointer"); CHKERRQ(ierr);
         ierr = this->m_SemiLagrangianMethod->SetWorkVecField(this->m_WorkVecField1); CHKERRQ(ierr);
+        ierr = this->m_SemiLagrangianMethod->SetActiveRegion(this->m_Mask); CHKERRQ(ierr);
         ierr = this->m_SemiLagrangianMethod->ComputeTrajectory(this->m_VelocityField, "state"); CHKERRQ(ierr);
         ierr = this->m_SemiLagrangianMethod->ComputeTrajectory(this->m_VelocityField, "adjoint"); CHKERRQ(ierr);
     }
@@ -471,8 +479,8 @@ PetscErrorCode CLAIRE::SetFinalAdjoint(Vec l1) {
     nl = this->m_Opt->m_Domain.nl;
     ng = this->m_Opt->m_Domain.ng;
 
-    // we do not store the time history for a gauss-newton approximation
-    if (this->m_Opt->m_OptPara.method == GAUSSNEWTON) {
+    // we only store the time history for a full newton method
+    if (this->m_Opt->m_OptPara.method != FULLNEWTON) {
         nt = 0;
     }
 
@@ -639,6 +647,7 @@ PetscErrorCode CLAIRE::SetStateVariable(Vec m) {
             }
         }
         ierr = this->m_SemiLagrangianMethod->SetWorkVecField(this->m_WorkVecField1); CHKERRQ(ierr);
+        ierr = this->m_SemiLagrangianMethod->SetActiveRegion(this->m_Mask); CHKERRQ(ierr);
         ierr = this->m_SemiLagrangianMethod->ComputeTrajectory(this->m_VelocityField, "state"); CHKERRQ(ierr);
     }
 
@@ -718,6 +727,7 @@ PetscErrorCode CLAIRE::SetAdjointVariable(Vec lambda) {
             }
         }
         ierr = this->m_SemiLagrangianMethod->SetWorkVecField(this->m_WorkVecField1); CHKERRQ(ierr);
+        ierr = this->m_SemiLagrangianMethod->SetActiveRegion(this->m_Mask); CHKERRQ(ierr);
         ierr = this->m_SemiLagrangianMethod->ComputeTrajectory(this->m_VelocityField, "adjoint"); CHKERRQ(ierr);
     }
 
@@ -794,6 +804,7 @@ PetscErrorCode CLAIRE::EvaluateObjective(ScalarType* J, Vec v) {
     PetscErrorCode ierr = 0;
     ScalarType D = 0.0, R = 0.0;
     std::stringstream ss;
+    ReductionBlock reduction(&this->m_Opt->m_Reduction);
     PetscFunctionBegin;
 
     this->m_Opt->Enter(__func__);
@@ -819,6 +830,11 @@ PetscErrorCode CLAIRE::EvaluateObjective(ScalarType* J, Vec v) {
     // set components of velocity field
     ierr = this->m_VelocityField->SetComponents(v); CHKERRQ(ierr);
 
+    // defer the global reductions of the distance measure and the
+    // regularization model; they are resolved in a single allreduce
+    // (the block is closed on error paths by the guard)
+    ierr = reduction.Begin(); CHKERRQ(ierr);
+
     // evaluate the regularization model
     ierr = this->EvaluateDistanceMeasure(&D); CHKERRQ(ierr);
 
@@ -835,6 +851,9 @@ PetscErrorCode CLAIRE::EvaluateObjective(ScalarType* J, Vec v) {
         ierr = this->m_Regularization->EvaluateFunctional(&R, this->m_VelocityField); CHKERRQ(ierr);
     }
 
+    // resolve deferred reductions (sets D and R)
+    ierr = reduction.End(); CHKERRQ(ierr);
+
     // add up the contributions
     *J = D + R;
 
@@ -910,17 +929,26 @@ PetscErrorCode CLAIRE::EvaluateGradient(Vec g, Vec v) {
     }
 
     if (this->m_Opt->m_Verbosity > 2) {
-        ierr = this->m_VelocityField->Norm(nvx1, nvx2, nvx3); CHKERRQ(ierr);
-        ss  << "||v||_2 = (" << std::scientific
-            << nvx1 << "," << nvx2 << "," << nvx3 << ")";
-        ierr = DbgMsg(ss.str()); CHKERRQ(ierr);
-        ss.clear(); ss.str(std::string());
+        // post reduction; overlaps with the adjoint solve
+        ierr = this->m_VelocityField->SquaredNormLocal(nvx1, nvx2, nvx3); CHKERRQ(ierr);
+        ierr = this->m_Opt->m_Reduction.Add(nvx1, &nvx1); CHKERRQ(ierr);
+        ierr = this->m_Opt->m_Reduction.Add(nvx2, &nvx2); CHKERRQ(ierr);
+        ierr = this->m_Opt->m_Reduction.Add(nvx3, &nvx3); CHKERRQ(ierr);
+        ierr = this->m_Opt->m_Reduction.Post(); CHKERRQ(ierr);
     }
 
     // compute solution of adjoint equation (i.e., \lambda(x,t))
     // and compute body force \int_0^1 grad(m)\lambda dt
     // which is assigned to work vecfield 2
     ierr = this->SolveAdjointEquation(); CHKERRQ(ierr);
+
+    if (this->m_Opt->m_Verbosity > 2) {
+        ierr = this->m_Opt->m_Reduction.Wait(); CHKERRQ(ierr);
+        ss  << "||v||_2 = (" << std::scientific
+            << PetscSqrtReal(nvx1) << "," << PetscSqrtReal(nvx2) << "," << PetscSqrtReal(nvx3) << ")";
+        ierr = DbgMsg(ss.str()); CHKERRQ(ierr);
+        ss.clear(); ss.str(std::string());
+    }
     
     ierr = this->m_WorkVecField2->DebugInfo("adjoint grad", __LINE__, __FILE__); CHKERRQ(ierr);
 
@@ -1022,6 +1050,9 @@ PetscErrorCode CLAIRE::EvaluateL2Gradient(Vec g) {
         ierr = this->SetupRegularization(); CHKERRQ(ierr);
     }
 
+    // assemble gradient in output vector directly
+    ierr = this->m_WorkVecField1->PlaceComponents(g); CHKERRQ(ierr);
+
     // evaluate / apply gradient operator for regularization
     ierr = this->m_Regularization->EvaluateGradient(this->m_WorkVecField1, this->m_VelocityField); CHKERRQ(ierr);
 
@@ -1033,8 +1064,8 @@ PetscErrorCode CLAIRE::EvaluateL2Gradient(Vec g) {
       else DbgMsg("gradient         : nullptr");
     }
 
-    // copy
-    ierr = this->m_WorkVecField1->GetComponents(g); CHKERRQ(ierr);
+    // release view on output
+    ierr = this->m_WorkVecField1->ResetComponents(); CHKERRQ(ierr);
 
     this->m_Opt->Exit(__func__);
 
@@ -1058,14 +1089,17 @@ PetscErrorCode CLAIRE::EvaluateSobolevGradient(Vec g, bool flag) {
         ierr = this->SetupRegularization(); CHKERRQ(ierr);
     }
 
+    // assemble gradient in output vector directly
+    ierr = this->m_WorkVecField1->PlaceComponents(g); CHKERRQ(ierr);
+
     // evaluate / apply gradient operator for regularization
     ierr = this->m_Regularization->ApplyInverse(this->m_WorkVecField1, this->m_WorkVecField2, flag); CHKERRQ(ierr);
 
     // \vect{g}_v = \vect{v} + (\beta_v \D{A})^{-1}\D{K}[\vect{b}]
     ierr = this->m_WorkVecField1->AXPY(1.0, this->m_VelocityField); CHKERRQ(ierr);
 
-    // copy to output
-    ierr = this->m_WorkVecField1->GetComponents(g); CHKERRQ(ierr);
+    // release view on output
+    ierr = this->m_WorkVecField1->ResetComponents(); CHKERRQ(ierr);
 
     this->m_Opt->Exit(__func__);
 
@@ -1084,10 +1118,10 @@ PetscErrorCode CLAIRE::ComputeBodyForce() {
     IntType nt, nl, nc, l;
     std::stringstream ss;
     std::bitset<3> xyz; xyz[0] = 1; xyz[1] = 1; xyz[2] = 1;
-    ScalarType *p_mt = NULL, *p_m = NULL, *p_l = NULL,
+    ScalarType *p_mt = NULL, *p_m = NULL, *p_l = NULL, *p_lk = NULL,
                *p_gradm1 = NULL, *p_gradm2 = NULL, *p_gradm3 = NULL,
                *p_b1 = NULL, *p_b2 = NULL, *p_b3 = NULL;
-    ScalarType ht, scale, lambda, value;
+    ScalarType ht, scale, weight, value;
     double timer[NFFTTIMERS] = {0};
 
     PetscFunctionBegin;
@@ -1142,17 +1176,15 @@ PetscErrorCode CLAIRE::ComputeBodyForce() {
             this->m_Opt->IncrementCounter(FFT, FFTGRAD);
 
             // b = \sum_k\int_{\Omega} \lambda_k \grad m_k dt
-#pragma omp parallel
-{
-#pragma omp for
-            for (IntType i = 0; i < nl; ++i) {
-                lambda = p_l[k*nl+i];
-                p_b1[i] += lambda*p_gradm1[i]/static_cast<ScalarType>(nc);
-                p_b2[i] += lambda*p_gradm2[i]/static_cast<ScalarType>(nc);
-                p_b3[i] += lambda*p_gradm3[i]/static_cast<ScalarType>(nc);
-            }
+            weight = 1.0/static_cast<ScalarType>(nc);
+            p_lk = p_l + k*nl;
+            PointwiseKernel(nl, [=] (IntType i) {
+                ScalarType wl = weight*p_lk[i];
+                p_b1[i] += wl*p_gradm1[i];
+                p_b2[i] += wl*p_gradm2[i];
+                p_b3[i] += wl*p_gradm3[i];
+            });
         }
-}  // omp
         ierr = RestoreRawPointer(this->m_TemplateImage, &p_mt); CHKERRQ(ierr);
     } else {  // non zero velocity field
         ierr = GetRawPointer(this->m_StateVariable, &p_m); CHKERRQ(ierr);
@@ -1169,18 +1201,16 @@ PetscErrorCode CLAIRE::ComputeBodyForce() {
                 this->m_Opt->StopTimer(FFTSELFEXEC);
                 this->m_Opt->IncrementCounter(FFT, FFTGRAD);
 
-#pragma omp parallel
-{
-#pragma omp for
                 // \vect{b}_i += h_d*ht*\lambda^j (\grad m^j)_i
-                for (IntType i = 0; i < nl; ++i) {
-                    lambda = p_l[l+i];  // get \lambda(x_i,t^j)
-                    p_b1[i] += scale*p_gradm1[i]*lambda/static_cast<ScalarType>(nc);
-                    p_b2[i] += scale*p_gradm2[i]*lambda/static_cast<ScalarType>(nc);
-                    p_b3[i] += scale*p_gradm3[i]*lambda/static_cast<ScalarType>(nc);
-                }
+                weight = scale/static_cast<ScalarType>(nc);
+                p_lk = p_l + l;  // \lambda(x,t^j)
+                PointwiseKernel(nl, [=] (IntType i) {
+                    ScalarType wl = weight*p_lk[i];
+                    p_b1[i] += wl*p_gradm1[i];
+                    p_b2[i] += wl*p_gradm2[i];
+                    p_b3[i] += wl*p_gradm3[i];
+                });
             }
-}  // omp
             // trapezoidal rule (revert scaling)
             if ((j == 0) || (j == nt)) scale *= 2.0;
         }
@@ -1337,9 +1367,9 @@ PetscErrorCode CLAIRE::HessMatVec(Vec Hvtilde, Vec vtilde) {
         ierr = this->SetupRegularization(); CHKERRQ(ierr);
     }
 
-    // parse input
+    // parse input (view on krylov vector; not modified below)
     if (vtilde != NULL) {
-        ierr = this->m_IncVelocityField->SetComponents(vtilde); CHKERRQ(ierr);
+        ierr = this->m_IncVelocityField->PlaceComponents(vtilde, true); CHKERRQ(ierr);
     }
 
     // compute \tilde{m}(x,t)
@@ -1348,6 +1378,11 @@ PetscErrorCode CLAIRE::HessMatVec(Vec Hvtilde, Vec vtilde) {
     // compute \tilde{\lambda}(x,t)
     ierr = this->SolveIncAdjointEquation(); CHKERRQ(ierr);
 
+    // work field 1 is overwritten from here on; write into output directly
+    if (Hvtilde != NULL) {
+        ierr = this->m_WorkVecField1->PlaceComponents(Hvtilde); CHKERRQ(ierr);
+    }
+
     // compute incremental body force
 //    ierr = this->ComputeIncBodyForce(); CHKERRQ(ierr);
 
@@ -1364,14 +1399,13 @@ PetscErrorCode CLAIRE::HessMatVec(Vec Hvtilde, Vec vtilde) {
       if(this->m_WorkVecField1) this->m_WorkVecField1->DebugInfo("hessian     ",__LINE__,__FILE__);
       else DbgMsg("hessian          : nullptr");
     }
-    // pass to output
-    if (Hvtilde != NULL) {
-        ierr = this->m_WorkVecField1->GetComponents(Hvtilde); CHKERRQ(ierr);
-    }
-    
     ierr = this->m_VelocityField->DebugInfo("velocity", __LINE__, __FILE__); CHKERRQ(ierr);
     ierr = this->m_IncVelocityField->DebugInfo("inc velocity", __LINE__, __FILE__); CHKERRQ(ierr);
 
+    // release views on input and output
+    ierr = this->m_WorkVecField1->ResetComponents(); CHKERRQ(ierr);
+    ierr = this->m_IncVelocityField->ResetComponents(); CHKERRQ(ierr);
+
 
     this->m_Opt->Exit(__func__);
 
@@ -1419,31 +1453,37 @@ PetscErrorCode CLAIRE::PrecondHessMatVec(Vec Hvtilde, Vec vtilde) {
         ierr = this->SetupRegularization(); CHKERRQ(ierr);
     }
 
-    // parse input
+    // parse input (view on krylov vector; not modified below)
     if (vtilde != NULL) {
-        ierr = this->m_IncVelocityField->SetComponents(vtilde); CHKERRQ(ierr);
+        ierr = this->m_IncVelocityField->PlaceComponents(vtilde, true); CHKERRQ(ierr);
     }
 
     // compute \tilde{m}(x,t)
     ierr = this->SolveIncStateEquation(); CHKERRQ(ierr);
 
-    // compute \tilde{\lambda}(x,t) and incremental body force
-    ierr = this->SolveIncAdjointEquation(); CHKERRQ(ierr);
+    // compute \tilde{\lambda}(x,t) and incremental body force; the
+    // projection \D{K} is applied together with the inverse below
+    this->m_DeferProjection = true;
+    ierr = this->SolveIncAdjointEquation();
+    this->m_DeferProjection = false; CHKERRQ(ierr);
 
     // apply inverse of 2nd variation of regularization model to
     // incremental body force: (\beta \D{A})^{-1}\D{K}[\vect{\tilde{b}}]
-    ierr = this->m_Regularization->ApplyInverse(this->m_WorkVecField1, this->m_WorkVecField2, false); CHKERRQ(ierr);
+    ierr = this->ApplyProjectedInverse(this->m_WorkVecField1, this->m_WorkVecField2, false); CHKERRQ(ierr);
 
     // \D{H}\vect{\tilde{v}} = \vect{\tilde{v}} + (\beta \D{A})^{-1} \D{K}[\vect{\tilde{b}}]
     // we use the same container for the bodyforce and the incremental body force to
     // save some memory
+    // (the body force is no longer needed; write into output directly)
     hd = this->m_Opt->GetLebesgueMeasure();
-    ierr = this->m_WorkVecField2->WAXPY(hd, this->m_IncVelocityField, this->m_WorkVecField1); CHKERRQ(ierr);
-
-    // pass to output
     if (Hvtilde != NULL) {
-        ierr = this->m_WorkVecField2->GetComponents(Hvtilde); CHKERRQ(ierr);
+        ierr = this->m_WorkVecField2->PlaceComponents(Hvtilde); CHKERRQ(ierr);
     }
+    ierr = this->m_WorkVecField2->WAXPY(hd, this->m_IncVelocityField, this->m_WorkVecField1); CHKERRQ(ierr);
+
+    // release views on input and output
+    ierr = this->m_WorkVecField2->ResetComponents(); CHKERRQ(ierr);
+    ierr = this->m_IncVelocityField->ResetComponents(); CHKERRQ(ierr);
 
     this->m_Opt->Exit(__func__);
 
@@ -1500,6 +1540,12 @@ PetscErrorCode CLAIRE::PrecondHessMatVecSym(Vec Hvtilde, Vec vtilde) {
         }
     }
 
+    // work field 5 accumulates the result; place it on the output
+    // so that it is written without an additional copy
+    if (Hvtilde != NULL) {
+        ierr = this->m_WorkVecField5->PlaceComponents(Hvtilde); CHKERRQ(ierr);
+    }
+
     // parse input (store incremental velocity field \tilde{v})
     if (vtilde != NULL) {
         ierr = this->m_WorkVecField5->SetComponents(vtilde); CHKERRQ(ierr);
@@ -1517,23 +1563,24 @@ PetscErrorCode CLAIRE::PrecondHessMatVecSym(Vec Hvtilde, Vec vtilde) {
     // compute \tilde{m}(x,t)
     ierr = this->SolveIncStateEquation(); CHKERRQ(ierr);
 
-    // compute \tilde{\lambda}(x,t) and compute incremental body force
-    ierr = this->SolveIncAdjointEquation(); CHKERRQ(ierr);
+    // compute \tilde{\lambda}(x,t) and compute incremental body force; the
+    // projection \D{K} is applied together with the inverse below
+    this->m_DeferProjection = true;
+    ierr = this->SolveIncAdjointEquation();
+    this->m_DeferProjection = false; CHKERRQ(ierr);
 
     // apply (\beta\D{A})^{-1/2} to incremental body force
-    ierr = this->m_Regularization->ApplyInverse(this->m_WorkVecField1, this->m_WorkVecField2, true); CHKERRQ(ierr);
+    ierr = this->ApplyProjectedInverse(this->m_WorkVecField1, this->m_WorkVecField2, true); CHKERRQ(ierr);
 
     // \D{H}\vect{\tilde{v}} = \vect{\tilde{v}} + (\beta \D{A})^{-1/2}\D{K}[\vect{\tilde{b}}](\beta \D{A})^{-1/2}
     // we use the same container for the bodyforce and the incremental body force to
     // save some memory
     hd = this->m_Opt->GetLebesgueMeasure();
-    ierr = this->m_WorkVecField5->Scale(hd); CHKERRQ(ierr);
-    ierr = this->m_WorkVecField5->AXPY(1.0, this->m_WorkVecField1); CHKERRQ(ierr);
+    ierr = this->m_WorkVecField5->AYPX(hd, this->m_WorkVecField1); CHKERRQ(ierr);
+
+    // release view on output
+    ierr = this->m_WorkVecField5->ResetComponents(); CHKERRQ(ierr);
 
-    // pass to output
-    if (Hvtilde != NULL) {
-        ierr = this->m_WorkVecField5->GetComponents(Hvtilde); CHKERRQ(ierr);
-    }
     this->m_Opt->Exit(__func__);
 
     PetscFunctionReturn(ierr);
@@ -1797,10 +1844,7 @@ PetscErrorCode CLAIRE::ComputeIncBodyForce() {
  *******************************************************************/
 PetscErrorCode CLAIRE::StoreStateVariable() {
     PetscErrorCode ierr = 0;
-    IntType nl, ng, nc, nt;
-    ScalarType *p_m = NULL, *p_mj = NULL;
-    std::stringstream ss;
-    std::string ext;
+    IntType nc, nt;
 
     PetscFunctionBegin;
 
@@ -1808,42 +1852,19 @@ PetscErrorCode CLAIRE::StoreStateVariable() {
 
     nt = this->m_Opt->m_Domain.nt;
     nc = this->m_Opt->m_Domain.nc;
-    nl = this->m_Opt->m_Domain.nl;
-    ng = this->m_Opt->m_Domain.ng;
 
     ierr = Assert(nt > 0, "nt <= 0"); CHKERRQ(ierr);
-    ext = this->m_Opt->m_FileNames.extension;
-
-    if (this->m_WorkScaField1 == NULL) {
-        ierr = VecCreate(this->m_WorkScaField1, nl, ng); CHKERRQ(ierr);
-    }
     ierr = Assert(this->m_ReadWrite != NULL, "null pointer"); CHKERRQ(ierr);
 
-    // store time history
-    ierr = GetRawPointer(this->m_StateVariable, &p_m); CHKERRQ(ierr);
-    // store individual time points
-    for (IntType j = 0; j <= nt; ++j) {
-        for (IntType k = 0; k < nc; ++k) {
-            ierr = GetRawPointer(this->m_WorkScaField1, &p_mj); CHKERRQ(ierr);
-            try {std::copy(p_m+j*nl*nc + k*nl, p_m+j*nl*nc + (k+1)*nl, p_mj);}
-            catch (std::exception& err) {
-                ierr = ThrowError(err); CHKERRQ(ierr);
-            }
-            ierr = RestoreRawPointer(this->m_WorkScaField1, &p_mj); CHKERRQ(ierr);
-            // write out
-            ss.str(std::string()); ss.clear();
-
-            if (nc > 1) {
-                ss << "state-variable-k=" << std::setw(3) << std::setfill('0')  << k
-                   << "-j=" << std::setw(3) << std::setfill('0') << j << ext;
-            } else {
-                ss << "state-variable-j=" << std::setw(3) << std::setfill('0') << j << ext;
-            }
-            ierr = this->m_ReadWrite->Write(this->m_WorkScaField1, ss.str()); CHKERRQ(ierr);
-        }  // for number of vector components
-    }  // for number of time points
-    ierr = RestoreRawPointer(this->m_StateVariable, &p_m); CHKERRQ(ierr);
+    // we only have the final state if we did not store the time history
+    if (!this->m_Opt->m_RegFlags.runinversion) nt = 0;
 
+    // write individual time points
+    ierr = this->m_ReadWrite->OpenTimeSeries("state-variable", nc); CHKERRQ(ierr);
+    for (IntType j = 0; j <= nt; ++j) {
+        ierr = this->m_ReadWrite->AppendTimeSeries(this->m_StateVariable, j); CHKERRQ(ierr);
+    }
+    ierr = this->m_ReadWrite->CloseTimeSeries(); CHKERRQ(ierr);
 
     this->m_Opt->Exit(__func__);
 
@@ -1862,6 +1883,7 @@ PetscErrorCode CLAIRE::SolveStateEquation() {
     PetscErrorCode ierr = 0;
     IntType nl, nc, nt;
     ScalarType *p_m = NULL;
+    bool streamed = false;
     std::stringstream ss;
     std::string ext;
     PetscFunctionBegin;
@@ -1933,6 +1955,7 @@ PetscErrorCode CLAIRE::SolveStateEquation() {
                 case SL:
                 {
                     ierr = this->SolveStateEquationSL(); CHKERRQ(ierr);
+                    streamed = true;
                     break;
                 }
                 default:
@@ -1966,8 +1989,8 @@ PetscErrorCode CLAIRE::SolveStateEquation() {
     }
 
 
-    // store time series
-    if (this->m_Opt->m_ReadWriteFlags.timeseries) {
+    // store time series (the sl solver streams the time series itself)
+    if (this->m_Opt->m_ReadWriteFlags.timeseries && !streamed) {
         ierr = this->StoreStateVariable(); CHKERRQ(ierr);
     }
     if (this->m_Opt->m_Verbosity > 2) {
@@ -1996,9 +2019,10 @@ PetscErrorCode CLAIRE::SolveStateEquationRK2(void) {
     PetscErrorCode ierr = 0;
     IntType nl, ng, nc, nt, l, lnext;
     ScalarType *p_m = NULL, *p_mbar = NULL, *p_rhs0 = NULL,
+                *p_mj = NULL, *p_mjnext = NULL,
                 *p_gmx1 = NULL, *p_gmx2 = NULL, *p_gmx3 = NULL,
                 *p_vx1 = NULL, *p_vx2 = NULL, *p_vx3 = NULL;
-    ScalarType ht = 0.0, hthalf = 0.0, rhs1;
+    ScalarType ht = 0.0, hthalf = 0.0;
     bool store = true;
     std::bitset<3> XYZ; XYZ[0] = 1; XYZ[1] = 1; XYZ[2] = 1;
     double timer[NFFTTIMERS] = {0};
@@ -2054,18 +2078,15 @@ PetscErrorCode CLAIRE::SolveStateEquationRK2(void) {
             this->m_Opt->IncrementCounter(FFT, FFTGRAD);
 
             // evaluate right hand side and compute intermediate rk2 step
-#pragma omp parallel
-{
-#pragma omp for
-            for (IntType i = 0; i < nl; ++i) {
+            p_mj = p_m + l + k*nl;
+            PointwiseKernel(nl, [=] (IntType i) {
                  p_rhs0[i] = -p_gmx1[i]*p_vx1[i]
                              -p_gmx2[i]*p_vx2[i]
                              -p_gmx3[i]*p_vx3[i];
 
                  // compute intermediate result
-                 p_mbar[i] = p_m[l + k*nl + i] + ht*p_rhs0[i];
-            }
-}  // omp
+                 p_mbar[i] = p_mj[i] + ht*p_rhs0[i];
+            });
             // compute gradient of \bar{m}
             this->m_Opt->StartTimer(FFTSELFEXEC);
             accfft_grad_t(p_gmx1, p_gmx2, p_gmx3, p_mbar, this->m_Opt->m_FFT.plan, &XYZ, timer);
@@ -2073,19 +2094,16 @@ PetscErrorCode CLAIRE::SolveStateEquationRK2(void) {
             this->m_Opt->IncrementCounter(FFT, FFTGRAD);
 
             // evaluate right hand side and wrap up integration
-#pragma omp parallel
-{
-#pragma omp for
-            for (IntType i = 0; i < nl; ++i) {
-                rhs1 = -p_gmx1[i]*p_vx1[i]
-                       -p_gmx2[i]*p_vx2[i]
-                       -p_gmx3[i]*p_vx3[i];
+            p_mjnext = p_m + lnext + k*nl;
+            PointwiseKernel(nl, [=] (IntType i) {
+                ScalarType rhs1 = -p_gmx1[i]*p_vx1[i]
+                                  -p_gmx2[i]*p_vx2[i]
+                                  -p_gmx3[i]*p_vx3[i];
 
                 // we have overwritten m_j with intermediate result
                 // m_{j+1} = m_j + 0.5*ht*(RHS0 + RHS1)
-                p_m[lnext + k*nl + i] = p_m[l + k*nl + i] + hthalf*(p_rhs0[i] + rhs1);
-            }
-}  // omp
+                p_mjnext[i] = p_mj[i] + hthalf*(p_rhs0[i] + rhs1);
+            });
         }  // for all components
     }  // for all time points
 
@@ -2117,7 +2135,7 @@ PetscErrorCode CLAIRE::SolveStateEquationSL(void) {
     PetscErrorCode ierr = 0;
     IntType nl, nc, nt, l, lnext;
     ScalarType *p_m = NULL;
-    bool store = true;
+    bool store = true, timeseries = false;
     std::stringstream ss;
     std::string filename;
 
@@ -2146,8 +2164,18 @@ PetscErrorCode CLAIRE::SolveStateEquationSL(void) {
 
     // compute trajectory
     ierr = this->m_SemiLagrangianMethod->SetWorkVecField(this->m_WorkVecField1); CHKERRQ(ierr);
+    ierr = this->m_SemiLagrangianMethod->SetActiveRegion(this->m_Mask); CHKERRQ(ierr);
     ierr = this->m_SemiLagrangianMethod->ComputeTrajectory(this->m_VelocityField, "state"); CHKERRQ(ierr);
 
+    // stream time series to file as we go (we do not need to
+    // store the time history to write it out)
+    timeseries = this->m_Opt->m_ReadWriteFlags.timeseries;
+    if (timeseries) {
+        ierr = Assert(this->m_ReadWrite != NULL, "null pointer"); CHKERRQ(ierr);
+        ierr = this->m_ReadWrite->OpenTimeSeries("state-variable", nc); CHKERRQ(ierr);
+        ierr = this->m_ReadWrite->AppendTimeSeries(this->m_StateVariable, 0); CHKERRQ(ierr);
+    }
+
     // get state variable m
     ierr = GetRawPointerReadWrite(this->m_StateVariable, &p_m); CHKERRQ(ierr);
     for (IntType j = 0; j < nt; ++j) {  // for all time points
@@ -2160,10 +2188,20 @@ PetscErrorCode CLAIRE::SolveStateEquationSL(void) {
             // compute m(X,t^{j+1}) (interpolate state variable)
             ierr = this->m_SemiLagrangianMethod->Interpolate(p_m + lnext + k*nl, p_m + l + k*nl, "state"); CHKERRQ(ierr);
         }
+
+        if (timeseries) {
+            ierr = RestoreRawPointerReadWrite(this->m_StateVariable, &p_m); CHKERRQ(ierr);
+            ierr = this->m_ReadWrite->AppendTimeSeries(this->m_StateVariable, store ? j+1 : 0); CHKERRQ(ierr);
+            ierr = GetRawPointerReadWrite(this->m_StateVariable, &p_m); CHKERRQ(ierr);
+        }
     }
 
     ierr = RestoreRawPointerReadWrite(this->m_StateVariable, &p_m); CHKERRQ(ierr);
 
+    if (timeseries) {
+        ierr = this->m_ReadWrite->CloseTimeSeries(); CHKERRQ(ierr);
+    }
+
     this->m_Opt->Exit(__func__);
 
     PetscFunctionReturn(ierr);
@@ -2334,8 +2372,10 @@ PetscErrorCode CLAIRE::SolveAdjointEquation() {
     ierr = this->m_WorkVecField2->DebugInfo("post adj grad", __LINE__, __FILE__); CHKERRQ(ierr);
 
     
-    // apply projection
-    ierr = this->ApplyProjection(); CHKERRQ(ierr);
+    // apply projection (unless fused with the operator applied next)
+    if (!this->m_DeferProjection) {
+        ierr = this->ApplyProjection(); CHKERRQ(ierr);
+    }
 
     // scale result by hd
     ierr = this->m_WorkVecField2->Scale(hd); CHKERRQ(ierr);
@@ -2368,8 +2408,9 @@ PetscErrorCode CLAIRE::SolveAdjointEquationRK2(void) {
     ScalarType *p_l = NULL, *p_m = NULL, *p_rhs0 = NULL, *p_rhs1 = NULL,
                *p_v1 = NULL, *p_v2 = NULL, *p_v3 = NULL,
                *p_vec1 = NULL, *p_vec2 = NULL, *p_vec3 = NULL,
-               *p_b1 = NULL, *p_b2 = NULL, *p_b3 = NULL;
-    ScalarType hthalf, ht, lambdabar, lambda, scale;
+               *p_b1 = NULL, *p_b2 = NULL, *p_b3 = NULL,
+               *p_lj = NULL, *p_ljnext = NULL;
+    ScalarType hthalf, ht, scale, weight;
     std::bitset<3> xyz; xyz[0] = 1; xyz[1] = 1; xyz[2] = 1;
     double timer[NFFTTIMERS] = {0};
     bool fullnewton = false;
@@ -2441,36 +2482,29 @@ PetscErrorCode CLAIRE::SolveAdjointEquationRK2(void) {
         if (j == 0) scale *= 0.5;
         for (IntType k = 0; k < nc; ++k) {  // for all image components
             // scale \vect{v} by \lambda
-
-#pragma omp parallel
-{
-#pragma omp for
-            for (IntType i = 0; i < nl; ++i) {  // for all grid points
-                lambda = p_l[ll + k*nl + i];
+            p_lj = p_l + ll + k*nl;
+            p_ljnext = p_l + llnext + k*nl;
+            PointwiseKernel(nl, [=] (IntType i) {  // for all grid points
+                ScalarType lambda = p_lj[i];
                 p_vec1[i] = lambda*p_v1[i];
                 p_vec2[i] = lambda*p_v2[i];
                 p_vec3[i] = lambda*p_v3[i];
-            }  // for all grid points
-}  // omp
+            });  // for all grid points
             // compute \idiv(\lambda\vect{v})
             this->m_Opt->StartTimer(FFTSELFEXEC);
             accfft_divergence_t(p_rhs0, p_vec1, p_vec2, p_vec3, this->m_Opt->m_FFT.plan, timer);
             this->m_Opt->StopTimer(FFTSELFEXEC);
             this->m_Opt->IncrementCounter(FFT, FFTDIV);
 
-#pragma omp parallel
-{
-#pragma omp for
-            for (IntType i = 0; i < nl; ++i) {  // for all grid points
+            PointwiseKernel(nl, [=] (IntType i) {  // for all grid points
                 // compute \bar{\lambda} = \lambda_j + ht*\idiv(\lambda\vect{v})
-                lambdabar = p_l[ll + k*nl +i] + ht*p_rhs0[i];
+                ScalarType lambdabar = p_lj[i] + ht*p_rhs0[i];
 
                 // scale \vect{v} by \bar{\lambda}
                 p_vec1[i] = p_v1[i]*lambdabar;
                 p_vec2[i] = p_v2[i]*lambdabar;
                 p_vec3[i] = p_v3[i]*lambdabar;
-            }
-}  // omp
+            });
             // compute \idiv(\bar{\lambda}\vect{v})
             this->m_Opt->StartTimer(FFTSELFEXEC);
             accfft_divergence_t(p_rhs1, p_vec1, p_vec2, p_vec3, this->m_Opt->m_FFT.plan, timer);
@@ -2483,20 +2517,20 @@ PetscErrorCode CLAIRE::SolveAdjointEquationRK2(void) {
             this->m_Opt->StopTimer(FFTSELFEXEC);
             this->m_Opt->IncrementCounter(FFT, FFTGRAD);
 
-#pragma omp parallel
-{
-#pragma omp for
-            for (IntType i = 0; i < nl; ++i) {  // for all grid points
-                lambda = p_l[ll + k*nl + i];
+            // rk2 update and body force in one pass (if ll == llnext,
+            // \lambda is read before it is overwritten)
+            weight = scale/static_cast<ScalarType>(nc);
+            PointwiseKernel(nl, [=] (IntType i) {  // for all grid points
+                ScalarType lambda = p_lj[i];
                 // second step of rk2 time integration
-                p_l[llnext + k*nl + i] = lambda + hthalf*(p_rhs0[i] + p_rhs1[i]);
+                p_ljnext[i] = lambda + hthalf*(p_rhs0[i] + p_rhs1[i]);
 
                 // compute bodyforce
-                p_b1[i] += scale*p_vec1[i]*lambda/static_cast<ScalarType>(nc);
-                p_b2[i] += scale*p_vec2[i]*lambda/static_cast<ScalarType>(nc);
-                p_b3[i] += scale*p_vec3[i]*lambda/static_cast<ScalarType>(nc);
-            }
-}  // omp
+                ScalarType wl = weight*lambda;
+                p_b1[i] += wl*p_vec1[i];
+                p_b2[i] += wl*p_vec2[i];
+                p_b3[i] += wl*p_vec3[i];
+            });
         }  // for all image components
         // trapezoidal rule (revert scaling)
         if (j == 0) scale *= 2.0;
@@ -2512,13 +2546,15 @@ PetscErrorCode CLAIRE::SolveAdjointEquationRK2(void) {
         this->m_Opt->StopTimer(FFTSELFEXEC);
         this->m_Opt->IncrementCounter(FFT, FFTGRAD);
 
-        for (IntType i = 0; i < nl; ++i) {  // for all grid points
-            lambda = p_l[ll + i];
+        weight = 0.5*scale/static_cast<ScalarType>(nc);
+        p_lj = p_l + ll;
+        PointwiseKernel(nl, [=] (IntType i) {  // for all grid points
             // compute bodyforce
-            p_b1[i] += 0.5*scale*p_vec1[i]*lambda/static_cast<ScalarType>(nc);
-            p_b2[i] += 0.5*scale*p_vec2[i]*lambda/static_cast<ScalarType>(nc);
-            p_b3[i] += 0.5*scale*p_vec3[i]*lambda/static_cast<ScalarType>(nc);
-        }
+            ScalarType wl = weight*p_lj[i];
+            p_b1[i] += wl*p_vec1[i];
+            p_b2[i] += wl*p_vec2[i];
+            p_b3[i] += wl*p_vec3[i];
+        });
     }
 
     ierr = RestoreRawPointer(this->m_AdjointVariable, &p_l); CHKERRQ(ierr);
@@ -2553,11 +2589,13 @@ PetscErrorCode CLAIRE::SolveAdjointEquationSL() {
                 *p_divv = NULL, *p_divvx = NULL,
                 *p_l = NULL, *p_lx = NULL, *p_m = NULL,
                 *p_vec1 = NULL, *p_vec2 = NULL, *p_vec3 = NULL,
-                *p_b1 = NULL, *p_b2 = NULL, *p_b3 = NULL;
-    ScalarType ht, lambdax, lambda, rhs0, rhs1, scale;
+                *p_b1 = NULL, *p_b2 = NULL, *p_b3 = NULL,
+                *p_lj = NULL, *p_ljnext = NULL;
+    ScalarType ht, scale, weight;
     IntType nl, ng, nc, nt, ll, lm, llnext;
     std::bitset<3> xyz; xyz[0] = 1; xyz[1] = 1; xyz[2] = 1;
     bool fullnewton = false;
+    const std::vector<IntType>* active = NULL;
     double timer[NFFTTIMERS] = {0};
 
     PetscFunctionBegin;
@@ -2604,8 +2642,13 @@ PetscErrorCode CLAIRE::SolveAdjointEquationSL() {
 
     // compute trajectory for adjoint equations
     ierr = this->m_SemiLagrangianMethod->SetWorkVecField(this->m_WorkVecField1); CHKERRQ(ierr);
+    ierr = this->m_SemiLagrangianMethod->SetActiveRegion(this->m_Mask); CHKERRQ(ierr);
     ierr = this->m_SemiLagrangianMethod->ComputeTrajectory(this->m_VelocityField, "adjoint"); CHKERRQ(ierr);
 
+    // \lambda is not transported outside of the active region (if any);
+    // the pointwise updates below are restricted to the same points
+    ierr = this->m_SemiLagrangianMethod->GetActiveIndex(active, "adjoint"); CHKERRQ(ierr);
+
     // for full newton we store the adjoint variable
     if (this->m_Opt->m_OptPara.method == FULLNEWTON) {
         fullnewton = true;
@@ -2662,26 +2705,32 @@ PetscErrorCode CLAIRE::SolveAdjointEquationSL() {
             accfft_grad_t(p_vec1, p_vec2, p_vec3, p_m + lm + k*nl, this->m_Opt->m_FFT.plan, &xyz, timer);
             this->m_Opt->StopTimer(FFTSELFEXEC);
             this->m_Opt->IncrementCounter(FFT, FFTGRAD);
-#pragma omp parallel
-{
-#pragma omp for
-            for (IntType i = 0; i < nl; ++i) {
-                lambda  = p_l[ll + k*nl + i];
-                lambdax = p_lx[i];
+            // time step and body force in one pass (if ll == llnext,
+            // \lambda is read before it is overwritten)
+            weight = scale/static_cast<ScalarType>(nc);
+            p_lj = p_l + ll + k*nl;
+            p_ljnext = p_l + llnext + k*nl;
+            if (active != NULL && ll != llnext) {
+                // \lambda is kept constant outside of active region
+                PointwiseKernel(nl, [=] (IntType i) {p_ljnext[i] = p_lj[i];});
+            }
+            PointwiseKernel(nl, active, [=] (IntType i) {
+                ScalarType lambda  = p_lj[i];
+                ScalarType lambdax = p_lx[i];
 
-                rhs0 = lambdax*p_divvx[i];
-                rhs1 = (lambdax + ht*rhs0)*p_divv[i];
+                ScalarType rhs0 = lambdax*p_divvx[i];
+                ScalarType rhs1 = (lambdax + ht*rhs0)*p_divv[i];
 
                 // compute \lambda(x,t^{j+1})
-                p_l[llnext + k*nl + i] = lambdax + 0.5*ht*(rhs0 + rhs1);
+                p_ljnext[i] = lambdax + 0.5*ht*(rhs0 + rhs1);
 
                 // compute bodyforce
-                p_b1[i] += scale*p_vec1[i]*lambda/static_cast<ScalarType>(nc);
-                p_b2[i] += scale*p_vec2[i]*lambda/static_cast<ScalarType>(nc);
-                p_b3[i] += scale*p_vec3[i]*lambda/static_cast<ScalarType>(nc);
-            }
+                ScalarType wl = weight*lambda;
+                p_b1[i] += wl*p_vec1[i];
+                p_b2[i] += wl*p_vec2[i];
+                p_b3[i] += wl*p_vec3[i];
+            });
         }
-}  // omp
         // trapezoidal rule (revert scaling; for body force)
         if (j == 0) scale *= 2.0;
     }
@@ -2696,18 +2745,16 @@ PetscErrorCode CLAIRE::SolveAdjointEquationSL() {
         this->m_Opt->StopTimer(FFTSELFEXEC);
         this->m_Opt->IncrementCounter(FFT, FFTGRAD);
 
-#pragma omp parallel
-{
-#pragma omp for
-        for (IntType i = 0; i < nl; ++i) {  // for all grid points
-            lambda = p_l[ll + i];
+        weight = 0.5*scale/static_cast<ScalarType>(nc);
+        p_lj = p_l + ll;
+        PointwiseKernel(nl, active, [=] (IntType i) {  // for all active grid points
             // compute bodyforce
-            p_b1[i] += 0.5*scale*p_vec1[i]*lambda/static_cast<ScalarType>(nc);
-            p_b2[i] += 0.5*scale*p_vec2[i]*lambda/static_cast<ScalarType>(nc);
-            p_b3[i] += 0.5*scale*p_vec3[i]*lambda/static_cast<ScalarType>(nc);
-        }
+            ScalarType wl = weight*p_lj[i];
+            p_b1[i] += wl*p_vec1[i];
+            p_b2[i] += wl*p_vec2[i];
+            p_b3[i] += wl*p_vec3[i];
+        });
     }
-}  // omp
     ierr = this->m_WorkVecField2->RestoreArrays(p_b1, p_b2, p_b3); CHKERRQ(ierr);
     ierr = this->m_WorkVecField1->RestoreArrays(p_vec1, p_vec2, p_vec3); CHKERRQ(ierr);
 
@@ -2784,6 +2831,7 @@ PetscErrorCode CLAIRE::SolveContinuityEquationSL() {
 
     // compute trajectory
     ierr = this->m_SemiLagrangianMethod->SetWorkVecField(this->m_WorkVecField1); CHKERRQ(ierr);
+    ierr = this->m_SemiLagrangianMethod->SetActiveRegion(this->m_Mask); CHKERRQ(ierr);
     ierr = this->m_SemiLagrangianMethod->ComputeTrajectory(this->m_VelocityField, "state"); CHKERRQ(ierr);
 
 
@@ -3146,11 +3194,14 @@ PetscErrorCode CLAIRE::SolveIncStateEquationRK2(void) {
  *******************************************************************/
 PetscErrorCode CLAIRE::SolveIncStateEquationSL(void) {
     PetscErrorCode ierr = 0;
-    IntType nl, ng, nt, nc, lm, lmnext, lmt, lmtnext;
+    IntType nl, nt, nc, lmnext, lmt, lmtnext;
     std::bitset<3> XYZ; XYZ[0] = 1; XYZ[1] = 1; XYZ[2] = 1;
     ScalarType ht, hthalf;
     ScalarType *p_gm1 = NULL, *p_gm2 = NULL, *p_gm3 = NULL,
-                *p_mtilde = NULL, *p_m = NULL, *p_mx = NULL;
+               *p_gn1 = NULL, *p_gn2 = NULL, *p_gn3 = NULL,
+               *p_gmj1 = NULL, *p_gmj2 = NULL, *p_gmj3 = NULL,
+               *p_gmn1 = NULL, *p_gmn2 = NULL, *p_gmn3 = NULL,
+               *p_mtilde = NULL, *p_m = NULL, *p_swap = NULL;
     const ScalarType *p_vtilde1 = NULL, *p_vtilde2 = NULL, *p_vtilde3 = NULL,
                      *p_vtildex1 = NULL, *p_vtildex2 = NULL, *p_vtildex3 = NULL;
     double timer[NFFTTIMERS] = {0};
@@ -3162,7 +3213,6 @@ PetscErrorCode CLAIRE::SolveIncStateEquationSL(void) {
     nt = this->m_Opt->m_Domain.nt;
     nc = this->m_Opt->m_Domain.nc;
     nl = this->m_Opt->m_Domain.nl;
-    ng = this->m_Opt->m_Domain.ng;
     ht = this->m_Opt->GetTimeStepSize();
     hthalf = 0.5*ht;
 
@@ -3170,9 +3220,6 @@ PetscErrorCode CLAIRE::SolveIncStateEquationSL(void) {
     ierr = Assert(this->m_IncStateVariable != NULL, "null pointer"); CHKERRQ(ierr);
     ierr = Assert(this->m_IncVelocityField != NULL, "null pointer"); CHKERRQ(ierr);
 
-    if (this->m_WorkScaField1 == NULL) {
-        ierr = VecCreate(this->m_WorkScaField1, nl, ng); CHKERRQ(ierr);
-    }
     if (this->m_WorkVecField1 == NULL) {
         try {this->m_WorkVecField1 = new VecField(this->m_Opt);}
         catch (std::bad_alloc&) {
@@ -3185,19 +3232,26 @@ PetscErrorCode CLAIRE::SolveIncStateEquationSL(void) {
             ierr = reg::ThrowError(err); CHKERRQ(ierr);
         }
     }
+    if (this->m_WorkVecField3 == NULL) {
+        try {this->m_WorkVecField3 = new VecField(this->m_Opt);}
+        catch (std::bad_alloc& err) {
+            ierr = reg::ThrowError(err); CHKERRQ(ierr);
+        }
+    }
     if (this->m_SemiLagrangianMethod == NULL) {
         try {this->m_SemiLagrangianMethod = new SemiLagrangianType(this->m_Opt);}
         catch (std::bad_alloc& err) {
             ierr = reg::ThrowError(err); CHKERRQ(ierr);
         }
         ierr = this->m_SemiLagrangianMethod->SetWorkVecField(this->m_WorkVecField1); CHKERRQ(ierr);
+        ierr = this->m_SemiLagrangianMethod->SetActiveRegion(this->m_Mask); CHKERRQ(ierr);
         ierr = this->m_SemiLagrangianMethod->ComputeTrajectory(this->m_VelocityField, "state"); CHKERRQ(ierr);
     }
 
     if (this->m_Opt->m_OptPara.method == FULLNEWTON) {   // gauss newton
         fullnewton = true;
     }
-    
+
     ierr = this->m_VelocityField->DebugInfo("velocity", __LINE__, __FILE__); CHKERRQ(ierr);
     ierr = this->m_IncVelocityField->DebugInfo("inc velocity", __LINE__, __FILE__); CHKERRQ(ierr);
     if (this->m_Opt->m_Verbosity > 2) {
@@ -3207,81 +3261,81 @@ PetscErrorCode CLAIRE::SolveIncStateEquationSL(void) {
 
     ierr = GetRawPointer(this->m_StateVariable, &p_m); CHKERRQ(ierr);
     ierr = GetRawPointer(this->m_IncStateVariable, &p_mtilde); CHKERRQ(ierr);
-    ierr = GetRawPointer(this->m_WorkScaField1, &p_mx); CHKERRQ(ierr);
     ierr = this->m_WorkVecField1->GetArrays(p_gm1, p_gm2, p_gm3); CHKERRQ(ierr);
+    ierr = this->m_WorkVecField3->GetArrays(p_gn1, p_gn2, p_gn3); CHKERRQ(ierr);
 
     ierr = this->m_SemiLagrangianMethod->Interpolate(this->m_WorkVecField2, this->m_IncVelocityField, "state"); CHKERRQ(ierr);
-    
+
     ierr = this->m_WorkVecField2->DebugInfo("work vec", __LINE__, __FILE__); CHKERRQ(ierr);
 
     ierr = this->m_WorkVecField2->GetArraysRead(p_vtildex1, p_vtildex2, p_vtildex3); CHKERRQ(ierr);
     ierr = this->m_IncVelocityField->GetArraysRead(p_vtilde1, p_vtilde2, p_vtilde3); CHKERRQ(ierr);
 
-    for (IntType j = 0; j < nt; ++j) {  // for all time points
-        lm = j*nl*nc; lmnext = (j+1)*nl*nc;
-        if (fullnewton) {   // full newton
-            lmt = j*nl*nc; lmtnext = (j+1)*nl*nc;
-        } else {
-            lmt = 0; lmtnext = 0;
-        }
-
-        for (IntType k = 0; k < nc; ++k) {  // for all image components
-            // interpolate incremental adjoint variable \tilde{m}^j(X)
-            ierr = this->m_SemiLagrangianMethod->Interpolate(p_mtilde + lmtnext + k*nl, p_mtilde + lmt + k*nl, "state"); CHKERRQ(ierr);
-            // interpolate m
-//            ierr = this->m_SemiLagrangianMethod->Interpolate(p_mx, p_m + lm + k*nl, "state"); CHKERRQ(ierr);
+    // the image components are decoupled; we march each component
+    // through time separately, so that the gradient of m^{j+1} computed
+    // in the second stage of step j can be reused as the gradient of m^j
+    // in step j+1 (one gradient per time step instead of two); in the
+    // gauss-newton case only the current time slice of \tilde{m} is kept
+    for (IntType k = 0; k < nc; ++k) {  // for all image components
+        // two buffers for \igrad m^j and \igrad m^{j+1} (swapped after each step)
+        p_gmj1 = p_gm1; p_gmj2 = p_gm2; p_gmj3 = p_gm3;
+        p_gmn1 = p_gn1; p_gmn2 = p_gn2; p_gmn3 = p_gn3;
 
-            // compute gradient for state variable
-//            this->m_Opt->StartTimer(FFTSELFEXEC);
-//            accfft_grad_t(p_gm1, p_gm2, p_gm3, p_mx, this->m_Opt->m_FFT.plan, &XYZ, timer);
-//            this->m_Opt->StopTimer(FFTSELFEXEC);
-//            this->m_Opt->IncrementCounter(FFT, FFTGRAD);
+        // compute gradient of m^0
+        this->m_Opt->StartTimer(FFTSELFEXEC);
+        accfft_grad_t(p_gmj1, p_gmj2, p_gmj3, p_m + k*nl, this->m_Opt->m_FFT.plan, &XYZ, timer);
+        this->m_Opt->StopTimer(FFTSELFEXEC);
+        this->m_Opt->IncrementCounter(FFT, FFTGRAD);
 
+        for (IntType j = 0; j < nt; ++j) {  // for all time points
+            lmnext = (j+1)*nl*nc;
+            if (fullnewton) {   // full newton
+                lmt = j*nl*nc; lmtnext = (j+1)*nl*nc;
+            } else {
+                lmt = 0; lmtnext = 0;
+            }
 
-            // compute gradient for state variable
-            this->m_Opt->StartTimer(FFTSELFEXEC);
-            accfft_grad_t(p_gm1, p_gm2, p_gm3, p_m + lm + k*nl, this->m_Opt->m_FFT.plan, &XYZ, timer);
-            this->m_Opt->StopTimer(FFTSELFEXEC);
-            this->m_Opt->IncrementCounter(FFT, FFTGRAD);
+            // interpolate incremental state variable \tilde{m}^j(X)
+            ierr = this->m_SemiLagrangianMethod->Interpolate(p_mtilde + lmtnext + k*nl, p_mtilde + lmt + k*nl, "state"); CHKERRQ(ierr);
 
-            ierr = this->m_SemiLagrangianMethod->Interpolate(p_gm1, p_gm2, p_gm3, p_gm1, p_gm2, p_gm3, "state"); CHKERRQ(ierr);
+            // interpolate gradient of m^j (overwrites buffer; \igrad m^j
+            // is not needed once it has been evaluated at X)
+            ierr = this->m_SemiLagrangianMethod->Interpolate(p_gmj1, p_gmj2, p_gmj3, p_gmj1, p_gmj2, p_gmj3, "state"); CHKERRQ(ierr);
 
-            // first part of time integration
-#pragma omp parallel
-{
-#pragma omp for
-            for (IntType i = 0; i < nl; ++i) {
-                p_mtilde[lmtnext + k*nl + i] -= hthalf*(p_gm1[i]*p_vtildex1[i]
-                                                      + p_gm2[i]*p_vtildex2[i]
-                                                      + p_gm3[i]*p_vtildex3[i]);
-            }
-}  // omp
             // compute gradient for state variable at next time time point
             this->m_Opt->StartTimer(FFTSELFEXEC);
-            accfft_grad_t(p_gm1, p_gm2, p_gm3, p_m + lmnext + k*nl, this->m_Opt->m_FFT.plan, &XYZ, timer);
+            accfft_grad_t(p_gmn1, p_gmn2, p_gmn3, p_m + lmnext + k*nl, this->m_Opt->m_FFT.plan, &XYZ, timer);
             this->m_Opt->StopTimer(FFTSELFEXEC);
             this->m_Opt->IncrementCounter(FFT, FFTGRAD);
 
 #pragma omp parallel
 {
 #pragma omp for
-            // second part of time integration
+            // both stages of the time integration in a single sweep
             for (IntType i = 0; i < nl; ++i) {
-                p_mtilde[lmtnext + k*nl + i] -= hthalf*(p_gm1[i]*p_vtilde1[i]
-                                                      + p_gm2[i]*p_vtilde2[i]
-                                                      + p_gm3[i]*p_vtilde3[i]);
+                p_mtilde[lmtnext + k*nl + i] -= hthalf*(p_gmj1[i]*p_vtildex1[i]
+                                                      + p_gmj2[i]*p_vtildex2[i]
+                                                      + p_gmj3[i]*p_vtildex3[i]
+                                                      + p_gmn1[i]*p_vtilde1[i]
+                                                      + p_gmn2[i]*p_vtilde2[i]
+                                                      + p_gmn3[i]*p_vtilde3[i]);
             }
-        }  // for all image components
 }  // omp
-    }  // for all time points
+
+            // \igrad m^{j+1} becomes \igrad m^j for the next step
+            p_swap = p_gmj1; p_gmj1 = p_gmn1; p_gmn1 = p_swap;
+            p_swap = p_gmj2; p_gmj2 = p_gmn2; p_gmn2 = p_swap;
+            p_swap = p_gmj3; p_gmj3 = p_gmn3; p_gmn3 = p_swap;
+        }  // for all time points
+    }  // for all image components
 
     ierr = this->m_IncVelocityField->RestoreArraysRead(p_vtilde1, p_vtilde2, p_vtilde3); CHKERRQ(ierr);
     ierr = this->m_WorkVecField2->RestoreArraysRead(p_vtildex1, p_vtildex2, p_vtildex3); CHKERRQ(ierr);
+    ierr = this->m_WorkVecField3->RestoreArrays(p_gn1, p_gn2, p_gn3); CHKERRQ(ierr);
     ierr = this->m_WorkVecField1->RestoreArrays(p_gm1, p_gm2, p_gm3); CHKERRQ(ierr);
-    ierr = RestoreRawPointer(this->m_WorkScaField1, &p_mx); CHKERRQ(ierr);
     ierr = RestoreRawPointer(this->m_IncStateVariable, &p_mtilde); CHKERRQ(ierr);
     ierr = RestoreRawPointer(this->m_StateVariable, &p_m); CHKERRQ(ierr);
-    
+
     if (this->m_Opt->m_Verbosity > 2) {
       ierr = DebugInfo(this->m_IncStateVariable, "inc state post", __LINE__, __FILE__); CHKERRQ(ierr);
     }
@@ -3464,8 +3518,10 @@ PetscErrorCode CLAIRE::SolveIncAdjointEquation(void) {
         ierr = ThrowError("update method not defined"); CHKERRQ(ierr);
     }
 
-    // apply K[\tilde{b}]
-    ierr = this->ApplyProjection(); CHKERRQ(ierr);
+    // apply K[\tilde{b}] (unless fused with the operator applied next)
+    if (!this->m_DeferProjection) {
+        ierr = this->ApplyProjection(); CHKERRQ(ierr);
+    }
 
     // scale result by hd
     ierr = this->m_WorkVecField2->Scale(hd); CHKERRQ(ierr);
@@ -3854,8 +3910,9 @@ PetscErrorCode CLAIRE::SolveIncAdjointEquationGNSL(void) {
                 *p_v1 = NULL, *p_v2 = NULL, *p_v3 = NULL,
                 *p_bt1 = NULL, *p_bt2 = NULL, *p_bt3 = NULL,
                 *p_gradm1 = NULL, *p_gradm2 = NULL, *p_gradm3 = NULL;
-    ScalarType ht, hthalf, ltilde, ltildex, rhs0, rhs1, scale;
+    ScalarType ht, hthalf, scale, weight;
     std::bitset<3> xyz; xyz[0] = 1; xyz[1] = 1; xyz[2] = 1;
+    const std::vector<IntType>* active = NULL;
     double timer[NFFTTIMERS] = {0};
 
     PetscFunctionBegin;
@@ -3901,6 +3958,7 @@ PetscErrorCode CLAIRE::SolveIncAdjointEquationGNSL(void) {
             ierr = reg::ThrowError(err); CHKERRQ(ierr);
         }
         ierr = this->m_SemiLagrangianMethod->SetWorkVecField(this->m_WorkVecField1); CHKERRQ(ierr);
+        ierr = this->m_SemiLagrangianMethod->SetActiveRegion(this->m_Mask); CHKERRQ(ierr);
         ierr = this->m_SemiLagrangianMethod->ComputeTrajectory(this->m_VelocityField, "adjoint"); CHKERRQ(ierr);
     }
 
@@ -3928,6 +3986,10 @@ PetscErrorCode CLAIRE::SolveIncAdjointEquationGNSL(void) {
     ierr = GetRawPointer(this->m_WorkScaField2, &p_divvx); CHKERRQ(ierr);
     ierr = this->m_SemiLagrangianMethod->Interpolate(p_divvx, p_divv, "adjoint"); CHKERRQ(ierr);
 
+    // \tilde{\lambda} is not transported outside of the active region
+    // (if any); the pointwise updates are restricted to the same points
+    ierr = this->m_SemiLagrangianMethod->GetActiveIndex(active, "adjoint"); CHKERRQ(ierr);
+
     ierr = GetRawPointer(this->m_StateVariable, &p_m); CHKERRQ(ierr);
     ierr = GetRawPointer(this->m_IncAdjointVariable, &p_ltilde); CHKERRQ(ierr);
     ierr = GetRawPointer(this->m_WorkScaField3, &p_ltildex); CHKERRQ(ierr);
@@ -3950,27 +4012,25 @@ PetscErrorCode CLAIRE::SolveIncAdjointEquationGNSL(void) {
             this->m_Opt->StopTimer(FFTSELFEXEC);
             this->m_Opt->IncrementCounter(FFT, FFTGRAD);
 
-#pragma omp parallel
-{
-#pragma omp for
-            for (IntType i = 0; i < nl; ++i) {
-                ltilde  = p_ltilde[ll + i];   // get \tilde{\lambda}(x)
-                ltildex = p_ltildex[i];       // get \tilde{\lambda}(X) (interpolated)
+            // time step and incremental body force in one pass
+            weight = scale/static_cast<ScalarType>(nc);
+            PointwiseKernel(nl, active, [=] (IntType i) {
+                ScalarType ltilde  = p_ltilde[ll + i];   // get \tilde{\lambda}(x)
+                ScalarType ltildex = p_ltildex[i];       // get \tilde{\lambda}(X) (interpolated)
 
                 // scale div(v)(X) by \tilde{\lambda}(X)
-                rhs0 = ltildex*p_divvx[i];
+                ScalarType rhs0 = ltildex*p_divvx[i];
 
                 // scale div(v) by \tilde{\lambda}*
-                rhs1 = (ltildex + ht*rhs0)*p_divv[i];
+                ScalarType rhs1 = (ltildex + ht*rhs0)*p_divv[i];
 
                 // final rk2 step
                 p_ltilde[ll + i] = ltildex + hthalf*(rhs0 + rhs1);
 
-                p_bt1[i] += scale*p_gradm1[i]*ltilde/static_cast<ScalarType>(nc);
-                p_bt2[i] += scale*p_gradm2[i]*ltilde/static_cast<ScalarType>(nc);
-                p_bt3[i] += scale*p_gradm3[i]*ltilde/static_cast<ScalarType>(nc);
-            }
-}  // omp
+                p_bt1[i] += weight*p_gradm1[i]*ltilde;
+                p_bt2[i] += weight*p_gradm2[i]*ltilde;
+                p_bt3[i] += weight*p_gradm3[i]*ltilde;
+            });
         }  // for all image components
         if (j == 0) scale *= 2.0;
     }  // for all time points
@@ -3985,17 +4045,14 @@ PetscErrorCode CLAIRE::SolveIncAdjointEquationGNSL(void) {
         this->m_Opt->StopTimer(FFTSELFEXEC);
         this->m_Opt->IncrementCounter(FFT, FFTGRAD);
 
-#pragma omp parallel
-{
-#pragma omp for
-        for (IntType i = 0; i < nl; ++i) {  // for all grid points
-            ltilde = p_ltilde[ll + i];
+        weight = 0.5*scale/static_cast<ScalarType>(nc);
+        PointwiseKernel(nl, active, [=] (IntType i) {  // for all active grid points
+            ScalarType ltilde = p_ltilde[ll + i];
             // compute bodyforce
-            p_bt1[i] += 0.5*scale*p_gradm1[i]*ltilde/static_cast<ScalarType>(nc);
-            p_bt2[i] += 0.5*scale*p_gradm2[i]*ltilde/static_cast<ScalarType>(nc);
-            p_bt3[i] += 0.5*scale*p_gradm3[i]*ltilde/static_cast<ScalarType>(nc);
-        }
-}  // omp
+            p_bt1[i] += weight*p_gradm1[i]*ltilde;
+            p_bt2[i] += weight*p_gradm2[i]*ltilde;
+            p_bt3[i] += weight*p_gradm3[i]*ltilde;
+        });
     }
 
     ierr = RestoreRawPointer(this->m_IncAdjointVariable, &p_ltilde); CHKERRQ(ierr);
@@ -4050,6 +4107,55 @@ PetscErrorCode CLAIRE::ApplyProjection() {
 
 
 
+/********************************************************************
+ * @brief append projection of body force to spectral operator (the
+ * body force is not projected in this model)
+ *******************************************************************/
+PetscErrorCode CLAIRE::AppendProjection(SpectralOperator* op) {
+    PetscErrorCode ierr = 0;
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief apply (square root of) inverse of regularization operator
+ * to body force; if the model projects the body force, projection
+ * and inverse are applied in a single fft round trip (the body force
+ * has to be computed with m_DeferProjection set)
+ *******************************************************************/
+PetscErrorCode CLAIRE::ApplyProjectedInverse(VecField* ainvx, VecField* x, bool applysqrt) {
+    PetscErrorCode ierr = 0;
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    if (this->m_Regularization == NULL) {
+        ierr = this->SetupRegularization(); CHKERRQ(ierr);
+    }
+    ierr = this->SetupSpectralOperator(); CHKERRQ(ierr);
+
+    ierr = this->m_SpectralOperator->Reset(); CHKERRQ(ierr);
+    ierr = this->AppendProjection(this->m_SpectralOperator); CHKERRQ(ierr);
+
+    if (this->m_SpectralOperator->GetNumStages() == 0) {
+        // nothing to fuse
+        ierr = this->m_Regularization->ApplyInverse(ainvx, x, applysqrt); CHKERRQ(ierr);
+    } else {
+        ierr = this->m_SpectralOperator->AddInverseRegularization(this->m_Regularization, applysqrt); CHKERRQ(ierr);
+        ierr = this->m_SpectralOperator->Apply(ainvx, x); CHKERRQ(ierr);
+    }
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
 /********************************************************************
  * @brief finalize the current iteration
  *******************************************************************/
@@ -4230,6 +4336,16 @@ PetscErrorCode CLAIRE::Finalize(VecField* v) {
     // parse extension
     ext = this->m_Opt->m_FileNames.extension;
 
+    // the output is needed on the entire domain; the state computed
+    // during the solve is only valid in the active region
+    ierr = this->SuspendActiveRegion(); CHKERRQ(ierr);
+    if (this->m_ActiveRegion && !this->m_Opt->m_Log.enabled[LOGDIST]
+        && (this->m_Opt->m_ReadWriteFlags.deftemplate
+            || this->m_Opt->m_ReadWriteFlags.residual
+            || this->m_Opt->m_ReadWriteFlags.invresidual)) {
+        ierr = this->SolveStateEquation(); CHKERRQ(ierr);
+    }
+
     // compute residuals
     if (this->m_Opt->m_Log.enabled[LOGDIST]) {
         ierr = VecWAXPY(this->m_WorkScaFieldMC, -1.0, this->m_TemplateImage, this->m_ReferenceImage); CHKERRQ(ierr);
@@ -4367,7 +4483,11 @@ PetscErrorCode CLAIRE::Finalize(VecField* v) {
         if (this->m_DeformationFields == NULL) {
             ierr = this->SetupDeformationField(); CHKERRQ(ierr);
         }
-        ierr = this->m_DeformationFields->ComputeDeformationMap(true); CHKERRQ(ierr);
+        if (this->m_Opt->m_ReadWriteFlags.invdefmap) {
+            ierr = this->m_DeformationFields->ComputeDeformationMapAndInverse(true); CHKERRQ(ierr);
+        } else {
+            ierr = this->m_DeformationFields->ComputeDeformationMap(true); CHKERRQ(ierr);
+        }
     }
 
     // write deformation field to file
@@ -4378,6 +4498,8 @@ PetscErrorCode CLAIRE::Finalize(VecField* v) {
         ierr = this->m_DeformationFields->ComputeDisplacementField(true); CHKERRQ(ierr);
     }
 
+    ierr = this->ResumeActiveRegion(); CHKERRQ(ierr);
+
     // write template and reference image
     if (this->m_Opt->m_ReadWriteFlags.templateim) {
 //        ierr = ShowValues(this->m_TemplateImage, nc); CHKERRQ(ierr);
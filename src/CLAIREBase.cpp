@@ -21,6 +21,7 @@
 #define _CLAIREBASE_CPP_
 
 #include "CLAIREBase.hpp"
+#include "CommCounter.hpp"
 
 
 
@@ -101,12 +102,17 @@ PetscErrorCode CLAIREBase::Initialize() {
     // objects
     this->m_ReadWrite = NULL;               ///< read / write object
     this->m_Regularization = NULL;          ///< pointer for regularization class
+    this->m_SpectralOperator = NULL;        ///< fused spectral operators
     this->m_DistanceMeasure = NULL;         ///< distance measure
     this->m_SemiLagrangianMethod = NULL;    ///< semi lagranigan
     this->m_DeformationFields = NULL;       ///< interface for computing deformation field (jacobian; mapping; ...)
 
     this->m_VelocityIsZero = false;          ///< flag: is velocity zero
+    this->m_VelocityIsZeroValid = false;     ///< flag: m_VelocityIsZero is up to date
     this->m_StoreTimeHistory = true;         ///< flag: store time history (needed for inversion)
+    this->m_AccuracyNt = -1;                 ///< number of time steps for full accuracy (accuracy adaptive solver)
+    this->m_ActiveRegionSuspended = 0;       ///< active region is used (if enabled)
+    this->m_ActiveRegion = false;
 
     this->m_DeleteControlVariable = true;    ///< flag: clear memory for control variable
     this->m_DeleteIncControlVariable = true; ///< flag: clear memory for incremental control variable
@@ -153,6 +159,11 @@ PetscErrorCode CLAIREBase::ClearMemory() {
         this->m_Regularization = NULL;
     }
 
+    if (this->m_SpectralOperator != NULL) {
+        delete this->m_SpectralOperator;
+        this->m_SpectralOperator = NULL;
+    }
+
     if (this->m_SemiLagrangianMethod != NULL) {
         delete this->m_SemiLagrangianMethod;
         this->m_SemiLagrangianMethod = NULL;
@@ -255,6 +266,31 @@ PetscErrorCode CLAIREBase::SetupSpectralData() {
 
 
 
+/********************************************************************
+ * @brief allocate operator that chains fourier multipliers (shares
+ * the spectral data with the regularization model)
+ *******************************************************************/
+PetscErrorCode CLAIREBase::SetupSpectralOperator() {
+    PetscErrorCode ierr = 0;
+    PetscFunctionBegin;
+
+    if (this->m_SpectralOperator == NULL) {
+        try {this->m_SpectralOperator = new SpectralOperator(this->m_Opt);}
+        catch (std::bad_alloc&) {
+            ierr = reg::ThrowError("allocation failed"); CHKERRQ(ierr);
+        }
+        ierr = this->SetupSpectralData(); CHKERRQ(ierr);
+        ierr = this->m_SpectralOperator->SetSpectralData(this->m_x1hat,
+                                                         this->m_x2hat,
+                                                         this->m_x3hat); CHKERRQ(ierr);
+    }
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
 /********************************************************************
  * @brief set read write operator
  *******************************************************************/
@@ -573,23 +609,49 @@ PetscErrorCode CLAIREBase::ComputeInitialGuess() {
 
 
 /********************************************************************
- * @brief check if velocity field is zero
+ * @brief check if velocity field is zero; the result is cached on the
+ * id/state of the components, so that repeated calls for the same
+ * velocity (objective, state, adjoint, gradient) do not communicate;
+ * otherwise we do a single max-reduction over all components (this
+ * cannot be deferred, since the caller branches on the result)
  *******************************************************************/
 PetscErrorCode CLAIREBase::IsVelocityZero() {
     PetscErrorCode ierr = 0;
-    ScalarType normv1 = 0.0, normv2 = 0.0, normv3 = 0.0;
+    ScalarType vmaxloc = 0.0, vmax = 0.0;
+    PetscObjectId id[3];
+    PetscObjectState state[3];
+    Vec x[3];
+    bool valid;
+    int rval;
     PetscFunctionBegin;
 
     this->m_Opt->Enter(__func__);
 
-    this->m_VelocityIsZero = false;
     ierr = Assert(this->m_VelocityField != NULL, "null pointer"); CHKERRQ(ierr);
 
-    ierr = VecNorm(this->m_VelocityField->m_X1, NORM_INFINITY, &normv1); CHKERRQ(ierr);
-    ierr = VecNorm(this->m_VelocityField->m_X2, NORM_INFINITY, &normv2); CHKERRQ(ierr);
-    ierr = VecNorm(this->m_VelocityField->m_X3, NORM_INFINITY, &normv3); CHKERRQ(ierr);
+    x[0] = this->m_VelocityField->m_X1;
+    x[1] = this->m_VelocityField->m_X2;
+    x[2] = this->m_VelocityField->m_X3;
+    valid = this->m_VelocityIsZeroValid;
+    for (int i = 0; i < 3; ++i) {
+        ierr = PetscObjectGetId(reinterpret_cast<PetscObject>(x[i]), &id[i]); CHKERRQ(ierr);
+        ierr = PetscObjectStateGet(reinterpret_cast<PetscObject>(x[i]), &state[i]); CHKERRQ(ierr);
+        valid = valid && id[i] == this->m_VelocityId[i] && state[i] == this->m_VelocityState[i];
+    }
 
-    this->m_VelocityIsZero = (normv1 == 0.0) && (normv2 == 0.0) && (normv3 == 0.0);
+    if (!valid) {
+        ierr = this->m_VelocityField->NormInfLocal(vmaxloc); CHKERRQ(ierr);
+        rval = MPI_Allreduce(&vmaxloc, &vmax, 1, MPIU_REAL, MPI_MAX, PETSC_COMM_WORLD);
+        ierr = Assert(rval == MPI_SUCCESS, "mpi error"); CHKERRQ(ierr);
+        CommCounter::Add(COMMREDUCE, sizeof(ScalarType), sizeof(ScalarType), 1, 1, 0);
+
+        this->m_VelocityIsZero = (vmax == 0.0);
+        for (int i = 0; i < 3; ++i) {
+            this->m_VelocityId[i] = id[i];
+            this->m_VelocityState[i] = state[i];
+        }
+        this->m_VelocityIsZeroValid = true;
+    }
 
     if (this->m_Opt->m_Verbosity > 2) {
         if (this->m_VelocityIsZero) {
@@ -655,6 +717,22 @@ PetscErrorCode CLAIREBase::SetupDistanceMeasure() {
             }
             break;
         }
+        case LNCC:
+        {
+            try {this->m_DistanceMeasure = new DistanceMeasureLNCC(this->m_Opt);}
+            catch (std::bad_alloc&) {
+                ierr = reg::ThrowError("allocation failed"); CHKERRQ(ierr);
+            }
+            break;
+        }
+        case MI:
+        {
+            try {this->m_DistanceMeasure = new DistanceMeasureMI(this->m_Opt);}
+            catch (std::bad_alloc&) {
+                ierr = reg::ThrowError("allocation failed"); CHKERRQ(ierr);
+            }
+            break;
+        }
         default:
         {
             ierr = reg::ThrowError("distance measure not defined"); CHKERRQ(ierr);
@@ -865,6 +943,7 @@ PetscErrorCode CLAIREBase::SetupDeformationField() {
             ierr = reg::ThrowError(err); CHKERRQ(ierr);
         }
         ierr = this->m_SemiLagrangianMethod->SetWorkVecField(this->m_WorkVecField1); CHKERRQ(ierr);
+        ierr = this->m_SemiLagrangianMethod->SetActiveRegion(this->m_Mask); CHKERRQ(ierr);
         ierr = this->m_SemiLagrangianMethod->ComputeTrajectory(this->m_VelocityField, "state"); CHKERRQ(ierr);
     }
     ierr = this->m_DeformationFields->SetSLM(this->m_SemiLagrangianMethod); CHKERRQ(ierr);
@@ -1008,9 +1087,22 @@ PetscErrorCode CLAIREBase::ApplyInvRegularizationOperator(Vec ainvx, Vec x, bool
         ierr = this->SetupRegularization(); CHKERRQ(ierr);
     }
 
-    ierr = this->m_WorkVecField1->SetComponents(x); CHKERRQ(ierr);
-    ierr = this->m_Regularization->ApplyInverse(this->m_WorkVecField2, this->m_WorkVecField1, flag); CHKERRQ(ierr);
-    ierr = this->m_WorkVecField2->GetComponents(ainvx); CHKERRQ(ierr);
+    // operate on views of input and output (no copies); most callers
+    // apply the operator in place; in this case we place a single
+    // (writable) view, so that the readonly view never aliases the
+    // output (ApplyInverse transforms all components of the input
+    // before it writes the output, i.e., it can be applied in place)
+    if (ainvx == x) {
+        ierr = this->m_WorkVecField2->PlaceComponents(ainvx); CHKERRQ(ierr);
+        ierr = this->m_Regularization->ApplyInverse(this->m_WorkVecField2, this->m_WorkVecField2, flag); CHKERRQ(ierr);
+        ierr = this->m_WorkVecField2->ResetComponents(); CHKERRQ(ierr);
+    } else {
+        ierr = this->m_WorkVecField1->PlaceComponents(x, true); CHKERRQ(ierr);
+        ierr = this->m_WorkVecField2->PlaceComponents(ainvx); CHKERRQ(ierr);
+        ierr = this->m_Regularization->ApplyInverse(this->m_WorkVecField2, this->m_WorkVecField1, flag); CHKERRQ(ierr);
+        ierr = this->m_WorkVecField2->ResetComponents(); CHKERRQ(ierr);
+        ierr = this->m_WorkVecField1->ResetComponents(); CHKERRQ(ierr);
+    }
 
     this->m_Opt->Exit(__func__);
 
@@ -1293,7 +1385,7 @@ PetscErrorCode CLAIREBase::CopyToAllTimePoints(Vec u, Vec uj) {
 /********************************************************************
  * @brief copies some input data field to all time points
  *******************************************************************/
-PetscErrorCode CLAIREBase::ComputeCFLCondition() {
+PetscErrorCode CLAIREBase::ComputeCFLCondition(IntType* ntcflout) {
     PetscErrorCode ierr = 0;
     std::stringstream ss;
     ScalarType hx[3], cflnum, vmax, vmaxscaled;
@@ -1359,6 +1451,8 @@ PetscErrorCode CLAIREBase::ComputeCFLCondition() {
         ss.str(std::string()); ss.clear();
     }
 
+    if (ntcflout != NULL) *ntcflout = ntcfl;
+
     if (this->m_Opt->m_PDESolver.adapttimestep) {
         if (ntcfl > nt) {
             if (this->m_Opt->m_Verbosity > 1) {
@@ -1380,6 +1474,160 @@ PetscErrorCode CLAIREBase::ComputeCFLCondition() {
 
 
 
+/********************************************************************
+ * @brief adapt the accuracy of the pde solves (number of time steps
+ * and interpolation order) to the progress of the optimizer (inexact
+ * newton); the accuracy is tied to the forcing term of the krylov
+ * method: we use full accuracy once the forcing term reaches the value
+ * it takes when the relative gradient is within one order of magnitude
+ * of the tolerance; before that, we reduce nt proportional to the
+ * forcing term (at most by a factor of 4; not below the cfl condition)
+ * and use linear interpolation if nt is halved or more; the accuracy
+ * is only ever increased during a solve; this has to be called between
+ * line searches; the objective and gradient have to be re-evaluated
+ * if the accuracy has changed
+ * @param[in] x current iterate (velocity)
+ * @param[in] relgrad relative gradient norm ||g_k||/||g_0||
+ * @param[out] changed flag: accuracy has changed
+ *******************************************************************/
+PetscErrorCode CLAIREBase::AdaptAccuracy(Vec x, ScalarType relgrad, bool& changed) {
+    PetscErrorCode ierr = 0;
+    IntType nt, ntfull, ntnew, ntcfl, ntmin;
+    ScalarType eta, etamin, gttol, ratio;
+    bool iplinear, firstcall;
+    std::stringstream ss;
+
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    changed = false;
+    if (!this->m_Opt->m_PDESolver.adaptaccuracy) {
+        this->m_Opt->Exit(__func__);
+        PetscFunctionReturn(ierr);
+    }
+
+    // remember number of time steps for full accuracy
+    firstcall = (this->m_AccuracyNt == -1);
+    if (firstcall) {
+        this->m_AccuracyNt = this->m_Opt->m_Domain.nt;
+    }
+    ntfull = this->m_AccuracyNt;
+    nt = this->m_Opt->m_Domain.nt;
+
+    // forcing term for current iterate and target forcing term
+    gttol = this->m_Opt->m_OptPara.tol[2];
+    switch (this->m_Opt->m_KrylovMethod.fseqtype) {
+        case QDFS:
+        {
+            eta    = PetscMin(0.5, relgrad);
+            etamin = PetscMin(0.5, 10.0*gttol);
+            break;
+        }
+        case SLFS:
+        {
+            eta    = PetscMin(0.5, std::sqrt(relgrad));
+            etamin = PetscMin(0.5, std::sqrt(10.0*gttol));
+            break;
+        }
+        default:
+        {
+            eta    = relgrad;
+            etamin = 10.0*gttol;
+            break;
+        }
+    }
+
+    ratio = etamin > 0.0 ? eta/etamin : 1.0;
+    if (ratio <= 1.0) {
+        ntnew = ntfull;
+        iplinear = false;
+    } else {
+        ntmin = PetscMax(1, ntfull/4);
+        ntnew = static_cast<IntType>(std::ceil(static_cast<ScalarType>(ntfull)/ratio));
+        ntnew = PetscMax(ntnew, ntmin);
+
+        // respect cfl condition (never more than nt for full accuracy)
+        if (this->m_VelocityField == NULL) {
+            try {this->m_VelocityField = new VecField(this->m_Opt);}
+            catch (std::bad_alloc&) {
+                ierr = reg::ThrowError("allocation failed"); CHKERRQ(ierr);
+            }
+        }
+        ierr = this->m_VelocityField->SetComponents(x); CHKERRQ(ierr);
+        ierr = this->ComputeCFLCondition(&ntcfl); CHKERRQ(ierr);
+        ntnew = PetscMax(ntnew, PetscMin(ntcfl, ntfull));
+
+        iplinear = (ratio >= 2.0);
+    }
+
+#ifdef INTERP_USE_MORE_MEM_L1
+    // the query points are stored with precomputed offsets for the
+    // cubic stencil; the interpolation kernel ignores the order
+    if (firstcall && this->m_Opt->m_Verbosity > 0) {
+        ierr = WrngMsg("linear interpolation not available (INTERP_USE_MORE_MEM_L1); adapting time steps only"); CHKERRQ(ierr);
+    }
+    iplinear = false;
+#endif
+
+    // only increase accuracy during a solve
+    if (!firstcall) {
+        ntnew = PetscMax(ntnew, this->m_Opt->m_Domain.nt);
+        iplinear = iplinear && this->m_Opt->m_PDESolver.iplinear;
+    }
+
+    if (ntnew != this->m_Opt->m_Domain.nt) {
+        // variables depend on number of time steps
+        ierr = this->ClearVariables(); CHKERRQ(ierr);
+        this->m_Opt->m_Domain.nt = ntnew;
+        changed = true;
+    }
+    if (iplinear != this->m_Opt->m_PDESolver.iplinear) {
+        this->m_Opt->m_PDESolver.iplinear = iplinear;
+        changed = true;
+    }
+
+    if (changed && this->m_Opt->m_Verbosity > 1) {
+        ss << "adapting accuracy of pde solver: nt = " << nt << " -> " << ntnew
+           << " (" << (iplinear ? "linear" : "cubic") << " interpolation)";
+        ierr = DbgMsg(ss.str()); CHKERRQ(ierr);
+        ss.str(std::string()); ss.clear();
+    }
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief restore full accuracy of pde solves (called after the solve)
+ *******************************************************************/
+PetscErrorCode CLAIREBase::RestoreAccuracy() {
+    PetscErrorCode ierr = 0;
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    if (this->m_AccuracyNt != -1) {
+        if (this->m_Opt->m_Domain.nt < this->m_AccuracyNt) {
+            ierr = this->ClearVariables(); CHKERRQ(ierr);
+            this->m_Opt->m_Domain.nt = this->m_AccuracyNt;
+        }
+        this->m_AccuracyNt = -1;
+    }
+    this->m_Opt->m_PDESolver.iplinear = false;
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
 /********************************************************************
  * @brief compute determinant of deformation gradient
  *******************************************************************/
@@ -1447,6 +1695,53 @@ PetscErrorCode CLAIREBase::CheckBounds(Vec v, bool& boundreached) {
 
 
 
+/********************************************************************
+ * @brief disable the active region (see SemiLagrangian::SetActiveRegion)
+ * for post-processing; deformation maps, the determinant of the
+ * deformation gradient, the deformed template and the residuals are
+ * needed on the entire domain; the solvers set the active region
+ * before every trajectory computation, so we switch off the flag
+ * (and not only clear the mask of the semi-lagrangian method)
+ *******************************************************************/
+PetscErrorCode CLAIREBase::SuspendActiveRegion() {
+    PetscErrorCode ierr = 0;
+    PetscFunctionBegin;
+
+    if (this->m_ActiveRegionSuspended++ == 0) {
+        this->m_ActiveRegion = this->m_Opt->m_RegFlags.activeregion;
+        this->m_Opt->m_RegFlags.activeregion = false;
+        if (this->m_SemiLagrangianMethod != NULL) {
+            ierr = this->m_SemiLagrangianMethod->SetActiveRegion(NULL); CHKERRQ(ierr);
+        }
+    }
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief restore the active region after post-processing
+ *******************************************************************/
+PetscErrorCode CLAIREBase::ResumeActiveRegion() {
+    PetscErrorCode ierr = 0;
+    PetscFunctionBegin;
+
+    ierr = Assert(this->m_ActiveRegionSuspended > 0, "active region not suspended"); CHKERRQ(ierr);
+    if (--this->m_ActiveRegionSuspended == 0) {
+        this->m_Opt->m_RegFlags.activeregion = this->m_ActiveRegion;
+        if (this->m_SemiLagrangianMethod != NULL) {
+            ierr = this->m_SemiLagrangianMethod->SetActiveRegion(this->m_Mask); CHKERRQ(ierr);
+        }
+    }
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
 /********************************************************************
  * @brief compute determinant of deformation gradient
  *******************************************************************/
@@ -1482,7 +1777,9 @@ PetscErrorCode CLAIREBase::ComputeDetDefGrad(bool write2file, Vec detj) {
     // check if velocity field is zero
     ierr = this->IsVelocityZero(); CHKERRQ(ierr);
     if (this->m_VelocityIsZero == false) {
+        ierr = this->SuspendActiveRegion(); CHKERRQ(ierr);
         ierr = this->m_DeformationFields->ComputeDetDefGrad(); CHKERRQ(ierr);
+        ierr = this->ResumeActiveRegion(); CHKERRQ(ierr);
     }
 
     if (write2file) {
@@ -1503,6 +1800,53 @@ PetscErrorCode CLAIREBase::ComputeDetDefGrad(bool write2file, Vec detj) {
 
 
 
+/********************************************************************
+ * @brief compute deformation map y for the current velocity field
+ * (the map starts at the regular grid)
+ * @param[out] y deformation map
+ * @param[out] yinv inverse deformation map (optional)
+ *******************************************************************/
+PetscErrorCode CLAIREBase::ComputeDeformationMap(VecField* y, VecField* yinv) {
+    PetscErrorCode ierr = 0;
+
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    ierr = Assert(y != NULL, "null pointer"); CHKERRQ(ierr);
+
+    if (this->m_VelocityField == NULL) {
+        try {this->m_VelocityField = new VecField(this->m_Opt);}
+        catch (std::bad_alloc&) {
+            ierr = reg::ThrowError("allocation failed"); CHKERRQ(ierr);
+        }
+        ierr = this->m_VelocityField->SetValue(0.0); CHKERRQ(ierr);
+    }
+
+    if (this->m_DeformationFields == NULL) {
+        ierr = this->SetupDeformationField(); CHKERRQ(ierr);
+    }
+
+    ierr = this->SuspendActiveRegion(); CHKERRQ(ierr);
+
+    if (yinv != NULL) {
+        ierr = this->m_DeformationFields->ComputeDeformationMapAndInverse(false, y, yinv); CHKERRQ(ierr);
+    } else {
+        // the map is stored in work vector field one
+        ierr = this->m_DeformationFields->ComputeDeformationMap(false); CHKERRQ(ierr);
+        ierr = y->Copy(this->m_WorkVecField1); CHKERRQ(ierr);
+    }
+
+    ierr = this->ResumeActiveRegion(); CHKERRQ(ierr);
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
 /********************************************************************
  * @brief compute determinant of deformation gradient
  *******************************************************************/
@@ -1517,6 +1861,8 @@ PetscErrorCode CLAIREBase::ComputeDeformationMaps(bool write2file) {
         ierr = this->SetupDeformationField(); CHKERRQ(ierr);
     }
 
+    ierr = this->SuspendActiveRegion(); CHKERRQ(ierr);
+
     if (this->m_Opt->m_ReadWriteFlags.detdefgrad) {
         ierr = Msg("computing determinant of deformation gradient"); CHKERRQ(ierr);
         ierr = this->ComputeDetDefGrad(true); CHKERRQ(ierr);
@@ -1525,7 +1871,10 @@ PetscErrorCode CLAIREBase::ComputeDeformationMaps(bool write2file) {
         ierr = Msg("computing deformation gradient"); CHKERRQ(ierr);
         ierr = this->m_DeformationFields->ComputeDefGrad(true); CHKERRQ(ierr);
     }
-    if (this->m_Opt->m_ReadWriteFlags.defmap) {
+    if (this->m_Opt->m_ReadWriteFlags.defmap && this->m_Opt->m_ReadWriteFlags.invdefmap) {
+        ierr = Msg("computing deformation map and its inverse"); CHKERRQ(ierr);
+        ierr = this->m_DeformationFields->ComputeDeformationMapAndInverse(true); CHKERRQ(ierr);
+    } else if (this->m_Opt->m_ReadWriteFlags.defmap) {
         ierr = Msg("computing deformation map"); CHKERRQ(ierr);
         ierr = this->m_DeformationFields->ComputeDeformationMap(true); CHKERRQ(ierr);
     }
@@ -1534,6 +1883,8 @@ PetscErrorCode CLAIREBase::ComputeDeformationMaps(bool write2file) {
         ierr = this->m_DeformationFields->ComputeDisplacementField(true); CHKERRQ(ierr);
     }
 
+    ierr = this->ResumeActiveRegion(); CHKERRQ(ierr);
+
     this->m_Opt->Exit(__func__);
 
     PetscFunctionReturn(ierr);
@@ -308,148 +308,46 @@ PetscErrorCode CLAIREDivReg::ComputeIncBodyForce() {
 
 /********************************************************************
  * @brief apply projection to map \tilde{v} onto the manifold
- * of divergence free velocity fields
+ * of divergence free velocity fields (body force in work vec field 2)
  *******************************************************************/
 PetscErrorCode CLAIREDivReg::ApplyProjection() {
     PetscErrorCode ierr = 0;
-    ScalarType *p_x1 = NULL, *p_x2 = NULL, *p_x3 = NULL;
-    ScalarType beta[3], scale;
-    long int nx[3];
-    //IntType nalloc;
-    double applytime;
-    ComplexType x1hat, x2hat, x3hat;
-    double timer[NFFTTIMERS] = {0};
-
     PetscFunctionBegin;
     this->m_Opt->Enter(__func__);
 
-    nx[0] = static_cast<long int>(this->m_Opt->m_Domain.nx[0]);
-    nx[1] = static_cast<long int>(this->m_Opt->m_Domain.nx[1]);
-    nx[2] = static_cast<long int>(this->m_Opt->m_Domain.nx[2]);
-
-    scale = this->m_Opt->ComputeFFTScale();
+    ierr = this->SetupSpectralOperator(); CHKERRQ(ierr);
+    ierr = this->m_SpectralOperator->Reset(); CHKERRQ(ierr);
+    ierr = this->AppendProjection(this->m_SpectralOperator); CHKERRQ(ierr);
+    ierr = this->m_SpectralOperator->Apply(this->m_WorkVecField2, this->m_WorkVecField2); CHKERRQ(ierr);
 
-    // allocate spectral data
-    ierr = this->SetupSpectralData(); CHKERRQ(ierr);
+    this->m_Opt->Exit(__func__);
 
-    ierr = this->m_WorkVecField1->Copy(this->m_WorkVecField2); CHKERRQ(ierr);
-    ierr = this->m_WorkVecField1->GetArrays(p_x1, p_x2, p_x3); CHKERRQ(ierr);
+    PetscFunctionReturn(ierr);
+}
 
-    // compute forward fft
-    this->m_Opt->StartTimer(FFTSELFEXEC);
-    accfft_execute_r2c_t(this->m_Opt->m_FFT.plan, p_x1, this->m_x1hat, timer);
-    accfft_execute_r2c_t(this->m_Opt->m_FFT.plan, p_x2, this->m_x2hat, timer);
-    accfft_execute_r2c_t(this->m_Opt->m_FFT.plan, p_x3, this->m_x3hat, timer);
-    this->m_Opt->StopTimer(FFTSELFEXEC);
-    this->m_Opt->IncrementCounter(FFT, 3);
 
-    beta[0] = this->m_Opt->m_RegNorm.beta[0];
-    beta[2] = this->m_Opt->m_RegNorm.beta[2];
 
-    applytime = -MPI_Wtime();
-#pragma omp parallel
-{
-    long int x1, x2, x3, wx1, wx2, wx3;
-    ScalarType lapik, lapinvik, gradik1, gradik2, gradik3, opik;
-    long int i;
-    IntType i1, i2, i3;
-#pragma omp for
-    for (i1 = 0; i1 < this->m_Opt->m_FFT.osize[0]; ++i1) {
-        for (i2 = 0; i2 < this->m_Opt->m_FFT.osize[1]; ++i2) {
-            for (i3 = 0; i3 < this->m_Opt->m_FFT.osize[2]; ++i3) {
-                x1 = static_cast<long int>(i1 + this->m_Opt->m_FFT.ostart[0]);
-                x2 = static_cast<long int>(i2 + this->m_Opt->m_FFT.ostart[1]);
-                x3 = static_cast<long int>(i3 + this->m_Opt->m_FFT.ostart[2]);
-
-                // set wavenumber
-                wx1 = x1;
-                wx2 = x2;
-                wx3 = x3;
-
-                if (x1 > nx[0]/2) wx1 -= nx[0];
-                else if(x1 == nx[0]/2) wx1 = 0;
-                if (x2 > nx[1]/2) wx2 -= nx[1];
-                else if(x2 == nx[1]/2) wx2 = 0;
-                if (x3 > nx[2]/2) wx3 -= nx[2];
-                else if(x3 == nx[2]/2) wx3 = 0;
-
-                // compute inverse laplacian operator
-                lapik = -static_cast<ScalarType>(wx1*wx1 + wx2*wx2 + wx3*wx3);
-
-                //lapinvik = round(lapinvik) == 0.0 ? -1.0 : 1.0/lapinvik;
-                lapinvik = lapik == 0.0 ? -1.0 : 1.0/lapik;
-
-                if (x1 == nx[0]/2) wx1 = 0;
-                if (x2 == nx[1]/2) wx2 = 0;
-                if (x3 == nx[2]/2) wx3 = 0;
-
-                // compute gradient operator
-                gradik1 = static_cast<ScalarType>(wx1);
-                gradik2 = static_cast<ScalarType>(wx2);
-                gradik3 = static_cast<ScalarType>(wx3);
-
-                i = GetLinearIndex(i1, i2, i3, this->m_Opt->m_FFT.osize);
-
-                x1hat[0] = this->m_x1hat[i][0];
-                x1hat[1] = this->m_x1hat[i][1];
-
-                x2hat[0] = this->m_x2hat[i][0];
-                x2hat[1] = this->m_x2hat[i][1];
-
-                x3hat[0] = this->m_x3hat[i][0];
-                x3hat[1] = this->m_x3hat[i][1];
-
-                // compute div(b)
-                this->m_x1hat[i][0] = -scale*(gradik1*x1hat[0]
-                                            + gradik2*x2hat[0]
-                                            + gradik3*x3hat[0]);
-
-                this->m_x1hat[i][1] =  scale*(gradik1*x1hat[1]
-                                            + gradik2*x2hat[1]
-                                            + gradik3*x3hat[1]);
-
-                // compute M^{-1] = (\beta_v (\beta_w(-\ilap + 1))^{-1} + 1)^{-1}
-                opik = 1.0/(beta[2]*(-lapik + 1.0));
-                opik = 1.0/(beta[0]*opik + 1.0);
-
-                // compute lap^{-1} div(b)
-                this->m_x1hat[i][0] *= opik*lapinvik;
-                this->m_x1hat[i][1] *= opik*lapinvik;
-
-                // compute x2 gradient of lab^{-1} div(b)
-                this->m_x2hat[i][0] = -gradik2*this->m_x1hat[i][0];
-                this->m_x2hat[i][1] =  gradik2*this->m_x1hat[i][1];
-
-                // compute x3 gradient of lab^{-1} div(b)
-                this->m_x3hat[i][0] = -gradik3*this->m_x1hat[i][0];
-                this->m_x3hat[i][1] =  gradik3*this->m_x1hat[i][1];
-
-                // compute x1 gradient of lab^{-1} div(b)
-                this->m_x1hat[i][0] *= -gradik1;
-                this->m_x1hat[i][1] *=  gradik1;
-            }
-        }
-    }
-}  // pragma omp parallel
-    applytime += MPI_Wtime();
-    timer[FFTHADAMARD] += applytime;
 
-    // compute inverse fft
-    this->m_Opt->StartTimer(FFTSELFEXEC);
-    accfft_execute_c2r_t(this->m_Opt->m_FFT.plan, this->m_x1hat, p_x1, timer);
-    accfft_execute_c2r_t(this->m_Opt->m_FFT.plan, this->m_x2hat, p_x2, timer);
-    accfft_execute_c2r_t(this->m_Opt->m_FFT.plan, this->m_x3hat, p_x3, timer);
-    this->m_Opt->StopTimer(FFTSELFEXEC);
-    this->m_Opt->IncrementCounter(FFT, 3);
+/********************************************************************
+ * @brief append projection to chain of spectral operators; we use the
+ * relaxed projection M^{-1} = (\beta_v (\beta_w(-\ilap + 1))^{-1} + 1)^{-1}
+ *******************************************************************/
+PetscErrorCode CLAIREDivReg::AppendProjection(SpectralOperator* op) {
+    PetscErrorCode ierr = 0;
+    ScalarType beta[3];
+    PetscFunctionBegin;
 
-    ierr = this->m_WorkVecField1->RestoreArrays(p_x1, p_x2, p_x3); CHKERRQ(ierr);
-    ierr = this->m_WorkVecField2->AXPY(1.0, this->m_WorkVecField1); CHKERRQ(ierr);
+    ierr = Assert(op != NULL, "null pointer"); CHKERRQ(ierr);
 
-    this->m_Opt->IncreaseFFTTimers(timer);
+    beta[0] = this->m_Opt->m_RegNorm.beta[0];
+    beta[2] = this->m_Opt->m_RegNorm.beta[2];
 
-    this->m_Opt->Exit(__func__);
+    // for \beta_w = 0 the relaxation removes the projection
+    if (beta[2] != 0.0) {
+        ierr = op->AddProjection(beta[0], beta[2]); CHKERRQ(ierr);
+    }
 
-    PetscFunctionReturn(0);
+    PetscFunctionReturn(ierr);
 }
 
 
@@ -541,7 +541,10 @@ PetscErrorCode CLAIREInterface::SetupSolver() {
         ierr = reg::ThrowError(err); CHKERRQ(ierr);
     }
 
-    if (this->m_Opt->m_KrylovMethod.pctype != NOPC) {
+    // the quasi-newton method never solves the (preconditioned) newton
+    // system; the preconditioner (and its coarse grid) is not needed
+    if (this->m_Opt->m_KrylovMethod.pctype != NOPC
+        && this->m_Opt->m_OptPara.method != QUASINEWTON) {
         if (this->m_Opt->m_Verbosity > 2) {
             ierr = DbgMsg("allocating preconditioner"); CHKERRQ(ierr);
         }
@@ -907,6 +910,16 @@ PetscErrorCode CLAIREInterface::RunSolverRegParaCont() {
     ierr = this->m_Opt->ResetTimers(); CHKERRQ(ierr);
     ierr = this->m_Opt->ResetCounters(); CHKERRQ(ierr);
 
+    // search for regularization parameter on several groups
+    // of mpi tasks concurrently
+    if (this->m_Opt->m_ParaCont.ngroups > 1) {
+        ierr = this->RunSolverRegParaContParallelSearch(); CHKERRQ(ierr);
+        if (mR != NULL) {ierr = VecDestroy(&mR); CHKERRQ(ierr);}
+        if (mT != NULL) {ierr = VecDestroy(&mT); CHKERRQ(ierr);}
+        this->m_Opt->Exit(__func__);
+        PetscFunctionReturn(ierr);
+    }
+
     // switch between the different strategies for
     // doing the parameter continuation (default one
     // is binary search)
@@ -1292,6 +1305,299 @@ PetscErrorCode CLAIREInterface::RunSolverRegParaContReductSearch() {
 
 
 
+/********************************************************************
+ * @brief search for the regularization weight on several groups of
+ * mpi tasks concurrently (see SplitCommunicator); each group owns a
+ * copy of the registration problem on its own communicator (i.e.,
+ * PETSC_COMM_WORLD of the group) and evaluates a different candidate
+ * for beta; the results (convergence and bound on det(grad(y))) are
+ * exchanged between the groups after each round to narrow the
+ * bracket; the coarse search reduces beta by betascale^ngroups per
+ * round; the fine search (binary search strategy only) places
+ * ngroups equispaced candidates in the bracket
+ *******************************************************************/
+PetscErrorCode CLAIREInterface::RunSolverRegParaContParallelSearch() {
+    PetscErrorCode ierr = 0;
+    int maxsteps, level, rank, ngroups, group, valid, first, rval;
+    int *isvalid = NULL;
+    bool boundreached, converged, stop;
+    std::ofstream logwriter;
+    std::stringstream ss;
+    std::string filename;
+    ScalarType beta, betamin, betascale, betastar, betahat,
+                dbetascale, dbetamin, width;
+    MPI_Comm crosscomm;
+    Vec x = NULL;
+
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    ierr = Assert(this->m_Optimizer != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_RegProblem != NULL, "null pointer"); CHKERRQ(ierr);
+
+    MPI_Comm_rank(PETSC_COMM_WORLD, &rank);
+
+    ngroups = this->m_Opt->m_ParaCont.ngroups;
+    group = this->m_Opt->m_ParaCont.group;
+
+    // tasks with the same rank in their group share a communicator;
+    // the rank in this communicator is the group id (all groups have
+    // the same size and data distribution)
+    rval = MPI_Comm_split(MPI_COMM_WORLD, rank, group, &crosscomm);
+    ierr = Assert(rval == MPI_SUCCESS, "mpi error"); CHKERRQ(ierr);
+
+    try {isvalid = new int[ngroups];}
+    catch (std::bad_alloc&) {
+        ierr = reg::ThrowError("allocation failed"); CHKERRQ(ierr);
+    }
+
+    // get parameters
+    betamin = this->m_Opt->GetBetaMinParaCont();
+    betascale = this->m_Opt->m_ParaCont.betascale;
+    dbetascale = this->m_Opt->m_ParaCont.dbetascale;
+    maxsteps = this->m_Opt->m_ParaCont.maxsteps;
+
+    ierr = Assert(betascale < 1.0 && betascale > 0.0, "scale for beta not in (0,1)"); CHKERRQ(ierr);
+    ierr = Assert(dbetascale < 1.0 && dbetascale > 0.0, "scale for delta betav not in (0,1)"); CHKERRQ(ierr);
+    ierr = Assert(betamin > 0.0 && betamin < 1.0, "lower bound for beta in (0,1)"); CHKERRQ(ierr);
+
+    // set optimization problem
+    ierr = this->m_Optimizer->SetProblem(this->m_RegProblem); CHKERRQ(ierr);
+    ierr = this->m_Optimizer->SetInitialGuess(this->m_Solution); CHKERRQ(ierr);
+
+    // initialize parameters (can be user defined)
+    beta = this->m_Opt->m_ParaCont.beta0;
+    betastar = beta;
+    betahat = 0.0;
+
+    this->m_Opt->m_RegNorm.beta[0] = beta;
+    ierr = this->m_RegProblem->InitializeOptimization(); CHKERRQ(ierr);
+
+    if (this->m_Opt->m_Verbosity > 0) {
+        ss << "starting coarse search for regularization weight (" << ngroups << " groups)";
+        ierr = DbgMsg(ss.str()); CHKERRQ(ierr);
+        ss.str(std::string()); ss.clear();
+    }
+
+    // coarse search: group g evaluates beta*betascale^g; we stop as soon
+    // as one of the candidates breaches the bound (or does not converge)
+    stop = false; level = 0;
+    while (!stop && level < maxsteps) {
+        this->m_Opt->m_RegNorm.beta[0] = beta*pow(betascale, group);
+
+        ss << std::scientific << std::setw(3) << "level " << level
+           << " group " << group << " ( betav=" << this->m_Opt->m_RegNorm.beta[0]
+           << "; betav*=" << betastar << " )";
+        ierr = this->DispLevelMsg(ss.str(), rank); CHKERRQ(ierr);
+        ss.str(std::string()); ss.clear();
+
+        if (this->m_Opt->m_OptPara.fastsolve) {
+            ierr = this->m_RegProblem->InitializeOptimization(); CHKERRQ(ierr);
+        }
+
+        ierr = this->m_Optimizer->SetInitialGuess(this->m_Solution); CHKERRQ(ierr);
+        ierr = this->m_Optimizer->Run(); CHKERRQ(ierr);
+
+        ierr = this->m_Optimizer->GetSolutionStatus(converged); CHKERRQ(ierr);
+        ierr = this->m_Optimizer->GetSolution(x); CHKERRQ(ierr);
+
+        boundreached = false;
+        ierr = this->m_RegProblem->CheckBounds(x, boundreached); CHKERRQ(ierr);
+
+        valid = (converged && !boundreached) ? 1 : 0;
+        if (valid) {
+            ierr = this->m_Solution->SetComponents(x); CHKERRQ(ierr);
+        }
+
+        // collect results of all groups
+        rval = MPI_Allgather(&valid, 1, MPI_INT, isvalid, 1, MPI_INT, crosscomm);
+        ierr = Assert(rval == MPI_SUCCESS, "mpi error"); CHKERRQ(ierr);
+
+        // candidates are ordered by decreasing beta; find first one
+        // that is not admissible
+        first = ngroups;
+        for (int g = 0; g < ngroups; ++g) {
+            if (!isvalid[g]) {first = g; break;}
+        }
+
+        if (first == 0) {
+            if (level == 0) {
+                // bound reached for initial guess -> increase beta
+                beta /= pow(betascale, ngroups);
+            } else {
+                // bracket is [beta, betastar]
+                betahat = beta;
+                stop = true;
+            }
+        } else {
+            // smallest admissible candidate is our new best estimate
+            betastar = beta*pow(betascale, first-1);
+            ierr = this->BcastSolution(crosscomm, first-1); CHKERRQ(ierr);
+            if (first < ngroups) {
+                betahat = beta*pow(betascale, first);
+                stop = true;
+            } else {
+                beta *= pow(betascale, ngroups);
+            }
+        }
+
+        if (!stop && beta < betamin) {
+            if (this->m_Opt->m_Verbosity > 0) {
+                ss << std::scientific
+                   << "regularization parameter smaller than lower bound (betav="
+                   << beta << " < " << betamin << "=betavmin)";
+                ierr = DbgMsg(ss.str()); CHKERRQ(ierr);
+                ss.str(std::string()); ss.clear();
+            }
+            break;
+        }
+        ++level;
+    }
+
+    // fine search (binary search only): candidates are equispaced in
+    // (betahat, betastar); the bracket shrinks by 1/(ngroups+1) per round
+    if (this->m_Opt->m_ParaCont.strategy == PCONTBINSEARCH) {
+        if (this->m_Opt->m_Verbosity > 0) {
+            ierr = DbgMsg("starting fine search for regularization weight"); CHKERRQ(ierr);
+        }
+
+        // same initial bracket as for the serial binary search
+        if (betahat == 0.0) betahat = betascale*betastar;
+        dbetamin = dbetascale*betastar;
+
+        stop = (betastar - betahat)/2.0 < dbetamin;
+        while (!stop) {
+            width = (betastar - betahat)/static_cast<ScalarType>(ngroups+1);
+            this->m_Opt->m_RegNorm.beta[0] = betastar - static_cast<ScalarType>(group+1)*width;
+
+            ss << std::scientific << std::setw(3) << "level " << level
+               << " group " << group << " ( betav=" << this->m_Opt->m_RegNorm.beta[0]
+               << "; betav*=" << betastar << " )";
+            ierr = this->DispLevelMsg(ss.str(), rank); CHKERRQ(ierr);
+            ss.str(std::string()); ss.clear();
+
+            if (this->m_Opt->m_OptPara.fastsolve) {
+                ierr = this->m_RegProblem->InitializeOptimization(); CHKERRQ(ierr);
+            }
+
+            ierr = this->m_Optimizer->SetInitialGuess(this->m_Solution); CHKERRQ(ierr);
+            ierr = this->m_Optimizer->Run(); CHKERRQ(ierr);
+
+            ierr = this->m_Optimizer->GetSolutionStatus(converged); CHKERRQ(ierr);
+            boundreached = false;
+            if (converged) {
+                ierr = this->m_Optimizer->GetSolution(x); CHKERRQ(ierr);
+                ierr = this->m_RegProblem->CheckBounds(x, boundreached); CHKERRQ(ierr);
+            } else {
+                ierr = WrngMsg("solver did not converge"); CHKERRQ(ierr);
+            }
+
+            valid = (converged && !boundreached) ? 1 : 0;
+            if (valid) {
+                ierr = this->m_Solution->SetComponents(x); CHKERRQ(ierr);
+            }
+
+            rval = MPI_Allgather(&valid, 1, MPI_INT, isvalid, 1, MPI_INT, crosscomm);
+            ierr = Assert(rval == MPI_SUCCESS, "mpi error"); CHKERRQ(ierr);
+
+            first = ngroups;
+            for (int g = 0; g < ngroups; ++g) {
+                if (!isvalid[g]) {first = g; break;}
+            }
+
+            // narrow the bracket
+            if (first < ngroups) {
+                betahat = betastar - static_cast<ScalarType>(first+1)*width;
+            }
+            if (first > 0) {
+                betastar = betastar - static_cast<ScalarType>(first)*width;
+                ierr = this->BcastSolution(crosscomm, first-1); CHKERRQ(ierr);
+            }
+
+            if ((betastar - betahat)/2.0 < dbetamin) {
+                stop = true;
+                if (this->m_Opt->m_Verbosity > 0) {
+                    ss  << std::setw(3) << "update for beta too small ( dbeta="
+                        << (betastar - betahat)/2.0 << " < " << dbetamin << "=dbetamin )";
+                    ierr = DbgMsg(ss.str()); CHKERRQ(ierr);
+                    ss.str(std::string()); ss.clear();
+                }
+            }
+            ++level;
+        }
+    }
+
+    if (rank == 0) std::cout << std::string(this->m_Opt->m_LineLength, '-') << std::endl;
+    ss << std::scientific << "estimated regularization parameter betav=" << betastar;
+    ierr = Msg(ss.str()); CHKERRQ(ierr);
+    if (rank == 0) std::cout << std::string(this->m_Opt->m_LineLength, '-') << std::endl;
+    ss.str(std::string()); ss.clear();
+
+    // all groups hold the same solution; only the first group writes
+    this->m_Opt->m_RegNorm.beta[0] = betastar;
+    if (group == 0) {
+        if (!this->m_Opt->m_FileNames.xfolder.empty()) {
+            if (rank == 0) {
+                filename = this->m_Opt->m_FileNames.xfolder;
+                filename += "parameter-continuation-estimated-beta.log";
+                logwriter.open(filename.c_str(), std::ofstream::out | std::ofstream::app);
+                ierr = Assert(logwriter.is_open(), "could not open file for writing"); CHKERRQ(ierr);
+                ss << std::scientific << "betav " << std::setw(3) << std::right << betastar;
+                logwriter << ss.str() << std::endl;
+                ss.str(std::string()); ss.clear();
+            }
+        }
+        ierr = this->m_RegProblem->Finalize(this->m_Solution); CHKERRQ(ierr);
+    }
+
+    if (isvalid != NULL) {delete [] isvalid; isvalid = NULL;}
+    MPI_Comm_free(&crosscomm);
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief broadcast the solution (velocity field) of group 'root' to
+ * all other groups; the communicator connects the tasks that have
+ * the same rank in their group (i.e., own the same part of the data)
+ *******************************************************************/
+PetscErrorCode CLAIREInterface::BcastSolution(MPI_Comm crosscomm, int root) {
+    PetscErrorCode ierr = 0;
+    ScalarType *p_v1 = NULL, *p_v2 = NULL, *p_v3 = NULL;
+    IntType nl;
+    int rval;
+
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    ierr = Assert(this->m_Solution != NULL, "null pointer"); CHKERRQ(ierr);
+
+    nl = this->m_Opt->m_Domain.nl;
+
+    ierr = this->m_Solution->GetArrays(p_v1, p_v2, p_v3); CHKERRQ(ierr);
+    rval = MPI_Bcast(p_v1, nl, MPIU_SCALAR, root, crosscomm);
+    ierr = Assert(rval == MPI_SUCCESS, "mpi error"); CHKERRQ(ierr);
+    rval = MPI_Bcast(p_v2, nl, MPIU_SCALAR, root, crosscomm);
+    ierr = Assert(rval == MPI_SUCCESS, "mpi error"); CHKERRQ(ierr);
+    rval = MPI_Bcast(p_v3, nl, MPIU_SCALAR, root, crosscomm);
+    ierr = Assert(rval == MPI_SUCCESS, "mpi error"); CHKERRQ(ierr);
+    ierr = this->m_Solution->RestoreArrays(p_v1, p_v2, p_v3); CHKERRQ(ierr);
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
 /********************************************************************
  * @brief we solves the optimization problem by simply reducing
  * the regularization parameter until we have reached the
@@ -1812,6 +2118,11 @@ PetscErrorCode CLAIREInterface::Finalize() {
     // finalize optimizer (show tao output)
     ierr = this->m_Optimizer->Finalize(); CHKERRQ(ierr);
 
+    // make sure all pending output has been written
+    if (this->m_ReadWrite != NULL) {
+        ierr = this->m_ReadWrite->Flush(); CHKERRQ(ierr);
+    }
+
     // display time to solution
     ierr = this->m_Opt->DisplayTimeToSolution(); CHKERRQ(ierr);
 
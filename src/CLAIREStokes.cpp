@@ -22,6 +22,7 @@
 
 #include <math.h>
 #include "CLAIREStokes.hpp"
+#include "PointwiseKernel.hpp"
 
 
 
@@ -171,9 +172,10 @@ PetscErrorCode CLAIREStokes::SolveAdjointEquationSL() {
     IntType nl, nc, nt, ll, lm, llnext;
     ScalarType *p_l = NULL,  *p_m=NULL,
                 *p_vec1 = NULL, *p_vec2 = NULL, *p_vec3 = NULL,
-                *p_b1 = NULL, *p_b2 = NULL, *p_b3 = NULL;
-    ScalarType lambda, ht, scale;
+                *p_b1 = NULL, *p_b2 = NULL, *p_b3 = NULL, *p_lj = NULL;
+    ScalarType ht, scale, weight;
     bool fullnewton = false;
+    const std::vector<IntType>* active = NULL;
     double timer[NFFTTIMERS] = {0};
     std::bitset<3> xyz; xyz[0] = 1; xyz[1] = 1; xyz[2] = 1;
 
@@ -209,8 +211,13 @@ PetscErrorCode CLAIREStokes::SolveAdjointEquationSL() {
         }
     }
     ierr = this->m_SemiLagrangianMethod->SetWorkVecField(this->m_WorkVecField1); CHKERRQ(ierr);
+    ierr = this->m_SemiLagrangianMethod->SetActiveRegion(this->m_Mask); CHKERRQ(ierr);
     ierr = this->m_SemiLagrangianMethod->ComputeTrajectory(this->m_VelocityField, "adjoint"); CHKERRQ(ierr);
 
+    // \lambda is not transported outside of the active region (if any);
+    // the body force is only accumulated at the same points
+    ierr = this->m_SemiLagrangianMethod->GetActiveIndex(active, "adjoint"); CHKERRQ(ierr);
+
     ierr = this->m_WorkVecField2->SetValue(0.0); CHKERRQ(ierr);
     if (this->m_Opt->m_OptPara.method == FULLNEWTON) {
         fullnewton = true;
@@ -239,12 +246,14 @@ PetscErrorCode CLAIREStokes::SolveAdjointEquationSL() {
             this->m_Opt->IncrementCounter(FFT, FFTGRAD);
 
             // compute body force
-            for (IntType i = 0; i < nl; ++i) {
-                lambda = p_l[ll+k*nl+i];
-                p_b1[i] += scale*p_vec1[i]*lambda/static_cast<ScalarType>(nc);
-                p_b2[i] += scale*p_vec2[i]*lambda/static_cast<ScalarType>(nc);
-                p_b3[i] += scale*p_vec3[i]*lambda/static_cast<ScalarType>(nc);
-            }
+            weight = scale/static_cast<ScalarType>(nc);
+            p_lj = p_l + ll + k*nl;
+            PointwiseKernel(nl, active, [=] (IntType i) {
+                ScalarType wl = weight*p_lj[i];
+                p_b1[i] += wl*p_vec1[i];
+                p_b2[i] += wl*p_vec2[i];
+                p_b3[i] += wl*p_vec3[i];
+            });
 
             // compute lambda(t^j,X)
             ierr = this->m_SemiLagrangianMethod->Interpolate(p_l+llnext+k*nl, p_l+ll+k*nl, "adjoint"); CHKERRQ(ierr);
@@ -264,13 +273,15 @@ PetscErrorCode CLAIREStokes::SolveAdjointEquationSL() {
         this->m_Opt->StopTimer(FFTSELFEXEC);
         this->m_Opt->IncrementCounter(FFT, FFTGRAD);
 
-        for (IntType i = 0; i < nl; ++i) {  // for all grid points
-            lambda = p_l[ll+i];
+        weight = 0.5*scale/static_cast<ScalarType>(nc);
+        p_lj = p_l + ll;
+        PointwiseKernel(nl, active, [=] (IntType i) {  // for all active grid points
             // compute bodyforce
-            p_b1[i] += 0.5*scale*p_vec1[i]*lambda/static_cast<ScalarType>(nc);
-            p_b2[i] += 0.5*scale*p_vec2[i]*lambda/static_cast<ScalarType>(nc);
-            p_b3[i] += 0.5*scale*p_vec3[i]*lambda/static_cast<ScalarType>(nc);
-        }
+            ScalarType wl = weight*p_lj[i];
+            p_b1[i] += wl*p_vec1[i];
+            p_b2[i] += wl*p_vec2[i];
+            p_b3[i] += wl*p_vec3[i];
+        });
     }
 
     ierr = this->m_WorkVecField1->RestoreArrays(p_vec1, p_vec2, p_vec3); CHKERRQ(ierr);
@@ -299,8 +310,9 @@ PetscErrorCode CLAIREStokes::SolveIncAdjointEquationGNSL() {
     IntType nl, nt, nc, lm, ll;
     ScalarType *p_ltilde = NULL, *p_m = NULL,
                 *p_btilde1 = NULL, *p_btilde2 = NULL, *p_btilde3 = NULL,
-                *p_gradm1 = NULL, *p_gradm2 = NULL, *p_gradm3 = NULL;
-    ScalarType ht, scale, ltilde;
+                *p_gradm1 = NULL, *p_gradm2 = NULL, *p_gradm3 = NULL, *p_ltildej = NULL;
+    ScalarType ht, scale, weight;
+    const std::vector<IntType>* active = NULL;
     std::bitset<3> xyz; xyz[0] = 1; xyz[1] = 1; xyz[2] = 1;
     double timer[NFFTTIMERS] = {0};
     PetscFunctionBegin;
@@ -330,11 +342,16 @@ PetscErrorCode CLAIREStokes::SolveIncAdjointEquationGNSL() {
             ierr = reg::ThrowError(err); CHKERRQ(ierr);
         }
         ierr = this->m_SemiLagrangianMethod->SetWorkVecField(this->m_WorkVecField1); CHKERRQ(ierr);
+        ierr = this->m_SemiLagrangianMethod->SetActiveRegion(this->m_Mask); CHKERRQ(ierr);
         ierr = this->m_SemiLagrangianMethod->ComputeTrajectory(this->m_VelocityField, "adjoint"); CHKERRQ(ierr);
     }
 
     ierr = this->m_WorkVecField2->SetValue(0.0); CHKERRQ(ierr);
 
+    // \tilde{\lambda} is not transported outside of the active region
+    // (if any); the body force is only accumulated at the same points
+    ierr = this->m_SemiLagrangianMethod->GetActiveIndex(active, "adjoint"); CHKERRQ(ierr);
+
     // get variables
     ierr = VecGetArray(this->m_StateVariable, &p_m); CHKERRQ(ierr);
     ierr = VecGetArray(this->m_IncAdjointVariable, &p_ltilde); CHKERRQ(ierr);
@@ -356,12 +373,14 @@ PetscErrorCode CLAIREStokes::SolveIncAdjointEquationGNSL() {
             this->m_Opt->IncrementCounter(FFT, FFTGRAD);
 
             // compute incremental bodyforce
-            for (IntType i = 0; i < nl; ++i) {
-                ltilde = p_ltilde[ll+i];    // get \tilde{\lambda}(x)
-                p_btilde1[i] += scale*p_gradm1[i]*ltilde/static_cast<ScalarType>(nc);
-                p_btilde2[i] += scale*p_gradm2[i]*ltilde/static_cast<ScalarType>(nc);
-                p_btilde3[i] += scale*p_gradm3[i]*ltilde/static_cast<ScalarType>(nc);
-            }
+            weight = scale/static_cast<ScalarType>(nc);
+            p_ltildej = p_ltilde + ll;
+            PointwiseKernel(nl, active, [=] (IntType i) {
+                ScalarType wl = weight*p_ltildej[i];    // \tilde{\lambda}(x)
+                p_btilde1[i] += wl*p_gradm1[i];
+                p_btilde2[i] += wl*p_gradm2[i];
+                p_btilde3[i] += wl*p_gradm3[i];
+            });
             ierr = this->m_SemiLagrangianMethod->Interpolate(p_ltilde+ll, p_ltilde+ll, "adjoint"); CHKERRQ(ierr);
         }  // for all image components
         if (j == 0) scale *= 2.0;
@@ -379,12 +398,14 @@ PetscErrorCode CLAIREStokes::SolveIncAdjointEquationGNSL() {
         this->m_Opt->IncrementCounter(FFT, FFTGRAD);
 
         // compute incremental bodyforce
-        for (IntType i = 0; i < nl; ++i) {  // for all grid points
-            ltilde = p_ltilde[ll+i];
-            p_btilde1[i] += 0.5*scale*p_gradm1[i]*ltilde/static_cast<ScalarType>(nc);
-            p_btilde2[i] += 0.5*scale*p_gradm2[i]*ltilde/static_cast<ScalarType>(nc);
-            p_btilde3[i] += 0.5*scale*p_gradm3[i]*ltilde/static_cast<ScalarType>(nc);
-        }
+        weight = 0.5*scale/static_cast<ScalarType>(nc);
+        p_ltildej = p_ltilde + ll;
+        PointwiseKernel(nl, active, [=] (IntType i) {  // for all active grid points
+            ScalarType wl = weight*p_ltildej[i];
+            p_btilde1[i] += wl*p_gradm1[i];
+            p_btilde2[i] += wl*p_gradm2[i];
+            p_btilde3[i] += wl*p_gradm3[i];
+        });
     }
 
     // restore variables
@@ -402,134 +423,35 @@ PetscErrorCode CLAIREStokes::SolveIncAdjointEquationGNSL() {
 
 /********************************************************************
  * @brief apply projection to map \tilde{v} onto the manifold
- * of divergence free velocity fields
+ * of divergence free velocity fields (body force in work vec field 2)
  *******************************************************************/
 PetscErrorCode CLAIREStokes::ApplyProjection() {
     PetscErrorCode ierr = 0;
-    ScalarType *p_x1 = NULL, *p_x2 = NULL, *p_x3 = NULL, scale;
-    long int nx[3];
-    double applytime;
-    ComplexType x1hat, x2hat, x3hat;
-    double timer[NFFTTIMERS] = {0};
-
-
     PetscFunctionBegin;
     this->m_Opt->Enter(__func__);
 
-    nx[0] = static_cast<long int>(this->m_Opt->m_Domain.nx[0]);
-    nx[1] = static_cast<long int>(this->m_Opt->m_Domain.nx[1]);
-    nx[2] = static_cast<long int>(this->m_Opt->m_Domain.nx[2]);
-
-    scale = this->m_Opt->ComputeFFTScale();
-
-    // allocate fields for spectral operations
-    ierr = this->SetupSpectralData(); CHKERRQ(ierr);
-
-    // copy input
-    ierr = this->m_WorkVecField1->Copy(this->m_WorkVecField2); CHKERRQ(ierr);
-    ierr = this->m_WorkVecField1->GetArrays(p_x1, p_x2, p_x3); CHKERRQ(ierr);
-
-    // compute forward fft
-    this->m_Opt->StartTimer(FFTSELFEXEC);
-    accfft_execute_r2c_t(this->m_Opt->m_FFT.plan, p_x1, this->m_x1hat, timer);
-    accfft_execute_r2c_t(this->m_Opt->m_FFT.plan, p_x2, this->m_x2hat, timer);
-    accfft_execute_r2c_t(this->m_Opt->m_FFT.plan, p_x3, this->m_x3hat, timer);
-    this->m_Opt->StopTimer(FFTSELFEXEC);
-    this->m_Opt->IncrementCounter(FFT, 3);
-
-    applytime = -MPI_Wtime();
-#pragma omp parallel
-{
-    long int x1, x2, x3, wx1, wx2, wx3;
-    ScalarType lapinvik, gradik1, gradik2, gradik3;
-    IntType i, i1, i2, i3;
-#pragma omp for
-    for (i1 = 0; i1 < this->m_Opt->m_FFT.osize[0]; ++i1) {
-        for (i2 = 0; i2 < this->m_Opt->m_FFT.osize[1]; ++i2) {
-            for (i3 = 0; i3 < this->m_Opt->m_FFT.osize[2]; ++i3) {
-                x1 = static_cast<long int>(i1 + this->m_Opt->m_FFT.ostart[0]);
-                x2 = static_cast<long int>(i2 + this->m_Opt->m_FFT.ostart[1]);
-                x3 = static_cast<long int>(i3 + this->m_Opt->m_FFT.ostart[2]);
-
-                // set wavenumber
-                wx1 = x1;
-                wx2 = x2;
-                wx3 = x3;
-
-                if (x1 > nx[0]/2) wx1 -= nx[0];
-                if (x2 > nx[1]/2) wx2 -= nx[1];
-                if (x3 > nx[2]/2) wx3 -= nx[2];
-
-                // compute inverse laplacian operator
-                lapinvik = static_cast<ScalarType>(wx1*wx1 + wx2*wx2 + wx3*wx3);
-                //lapinvik = round(lapinvik) == 0.0 ? -1.0 : 1.0/lapinvik;
-                lapinvik = lapinvik == 0.0 ? -1.0 : -1.0/lapinvik;
-
-                if (x1 == nx[0]/2) wx1 = 0;
-                if (x2 == nx[1]/2) wx2 = 0;
-                if (x3 == nx[2]/2) wx3 = 0;
-
-                // compute gradient operator
-                gradik1 = static_cast<ScalarType>(wx1);
-                gradik2 = static_cast<ScalarType>(wx2);
-                gradik3 = static_cast<ScalarType>(wx3);
-
-                i = GetLinearIndex(i1, i2, i3, this->m_Opt->m_FFT.osize);
-
-                x1hat[0] = this->m_x1hat[i][0];
-                x1hat[1] = this->m_x1hat[i][1];
-
-                x2hat[0] = this->m_x2hat[i][0];
-                x2hat[1] = this->m_x2hat[i][1];
-
-                x3hat[0] = this->m_x3hat[i][0];
-                x3hat[1] = this->m_x3hat[i][1];
-
-                // compute div(b)
-                this->m_x1hat[i][0] = -scale*(gradik1*x1hat[0]
-                                             + gradik2*x2hat[0]
-                                             + gradik3*x3hat[0]);
-
-                this->m_x1hat[i][1] =  scale*(gradik1*x1hat[1]
-                                             + gradik2*x2hat[1]
-                                             + gradik3*x3hat[1]);
-
-                // compute lap^{-1} div(b)
-                this->m_x1hat[i][0] *= lapinvik;
-                this->m_x1hat[i][1] *= lapinvik;
-
-                // compute x2 gradient of lab^{-1} div(b)
-                this->m_x2hat[i][0] = -gradik2*this->m_x1hat[i][0];
-                this->m_x2hat[i][1] =  gradik2*this->m_x1hat[i][1];
-
-                // compute x3 gradient of lab^{-1} div(b)
-                this->m_x3hat[i][0] = -gradik3*this->m_x1hat[i][0];
-                this->m_x3hat[i][1] =  gradik3*this->m_x1hat[i][1];
-
-                // compute x1 gradient of lab^{-1} div(b)
-                this->m_x1hat[i][0] *= -gradik1;
-                this->m_x1hat[i][1] *=  gradik1;
-            }
-        }
-    }
-}  // pragma omp parallel
-    applytime += MPI_Wtime();
-    timer[FFTHADAMARD] += applytime;
+    ierr = this->SetupSpectralOperator(); CHKERRQ(ierr);
+    ierr = this->m_SpectralOperator->Reset(); CHKERRQ(ierr);
+    ierr = this->AppendProjection(this->m_SpectralOperator); CHKERRQ(ierr);
+    ierr = this->m_SpectralOperator->Apply(this->m_WorkVecField2, this->m_WorkVecField2); CHKERRQ(ierr);
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
 
-    // compute inverse fft
-    this->m_Opt->StartTimer(FFTSELFEXEC);
-    accfft_execute_c2r_t(this->m_Opt->m_FFT.plan, this->m_x1hat, p_x1, timer);
-    accfft_execute_c2r_t(this->m_Opt->m_FFT.plan, this->m_x2hat, p_x2, timer);
-    accfft_execute_c2r_t(this->m_Opt->m_FFT.plan, this->m_x3hat, p_x3, timer);
-    this->m_Opt->StopTimer(FFTSELFEXEC);
-    this->m_Opt->IncrementCounter(FFT, 3);
 
-    ierr = this->m_WorkVecField1->RestoreArrays(p_x1, p_x2, p_x3); CHKERRQ(ierr);
-    ierr = this->m_WorkVecField2->AXPY(1.0, this->m_WorkVecField1); CHKERRQ(ierr);
 
-    this->m_Opt->IncreaseFFTTimers(timer);
 
-    this->m_Opt->Exit(__func__);
+/********************************************************************
+ * @brief append projection to chain of spectral operators
+ *******************************************************************/
+PetscErrorCode CLAIREStokes::AppendProjection(SpectralOperator* op) {
+    PetscErrorCode ierr = 0;
+    PetscFunctionBegin;
+
+    ierr = Assert(op != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = op->AddProjection(); CHKERRQ(ierr);
 
     PetscFunctionReturn(ierr);
 }
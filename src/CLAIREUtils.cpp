@@ -21,6 +21,7 @@
 #define _CLAIREUTILS_CPP_
 
 #include "CLAIREUtils.hpp"
+#include "PointwiseKernel.hpp"
 
 
 
@@ -412,17 +413,84 @@ PetscErrorCode InitializeDataDistribution(int nthreads, int *c_grid, MPI_Comm& c
 
 
 
+/*! communicator of the group this task belongs to (see SplitCommunicator) */
+static MPI_Comm s_GroupComm = MPI_COMM_NULL;
+
+
+
+
+/********************************************************************
+ * @brief split MPI_COMM_WORLD into groups of equal size if the user
+ * asks for a parallel search for the regularization parameter
+ * ('-pcontgroups <int>'); each group runs its own registration on
+ * its own communicator; we do this by overwriting PETSC_COMM_WORLD,
+ * so this function has to be called before PetscInitialize; if the
+ * option is not set (or invalid) nothing is done
+ *******************************************************************/
+int SplitCommunicator(int argc, char** argv) {
+    int rval = MPI_SUCCESS, initialized, nprocs, rank, ngroups = 1;
+    MPI_Comm subcomm;
+
+    for (int i = 1; i < argc - 1; ++i) {
+        if (strcmp(argv[i], "-pcontgroups") == 0) {
+            ngroups = atoi(argv[i+1]);
+        }
+    }
+    if (ngroups < 2) return rval;
+
+    MPI_Initialized(&initialized);
+    if (!initialized) {
+        rval = MPI_Init(&argc, &argv);
+        if (rval != MPI_SUCCESS) return rval;
+    }
+
+    MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    // groups have to be of equal size (we exchange the solution
+    // between groups rank by rank; see CLAIREInterface)
+    if (nprocs % ngroups != 0) {
+        if (rank == 0) {
+            std::cout << "\x1b[33m[ number of mpi tasks (" << nprocs
+                      << ") not divisible by number of groups (" << ngroups
+                      << "); not splitting communicator ]\x1b[0m" << std::endl;
+        }
+        return rval;
+    }
+
+    // the group id of a task is rank/(nprocs/ngroups)
+    rval = MPI_Comm_split(MPI_COMM_WORLD, rank/(nprocs/ngroups), rank, &subcomm);
+    if (rval != MPI_SUCCESS) return rval;
+
+    PETSC_COMM_WORLD = subcomm;
+    s_GroupComm = subcomm;
+
+    return rval;
+}
+
+
+
+
 /********************************************************************
  * @brief view vector entries (transpose output)
  *******************************************************************/
 PetscErrorCode Finalize() {
     PetscErrorCode ierr = 0;
+    int finalized;
 
     accfft_cleanup();
 
     // clean up petsc
     ierr = PetscFinalize(); CHKERRQ(ierr);
 
+    // petsc does not finalize mpi if it has been initialized
+    // outside of petsc (see SplitCommunicator)
+    MPI_Finalized(&finalized);
+    if (!finalized) {
+        if (s_GroupComm != MPI_COMM_NULL) MPI_Comm_free(&s_GroupComm);
+        MPI_Finalize();
+    }
+
     PetscFunctionReturn(ierr);
 }
 
@@ -480,6 +548,9 @@ PetscErrorCode VecCreate(Vec& x, IntType nl, IntType ng) {
         ierr = VecSetFromOptions(x); CHKERRQ(ierr);
     #endif
 
+    // place pages with the thread that operates on them
+    ierr = FirstTouch(x); CHKERRQ(ierr);
+
     PetscFunctionReturn(ierr);
 }
 
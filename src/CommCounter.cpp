@@ -0,0 +1,56 @@
+/*************************************************************************
+ *  Copyright (c) 2018.
+ *  All rights reserved.
+ *  This file is part of the CLAIRE library.
+ *
+ *  CLAIRE is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CLAIRE is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CLAIRE.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+#ifndef _COMMCOUNTER_CPP_
+#define _COMMCOUNTER_CPP_
+
+#include "CommCounter.hpp"
+
+
+
+
+namespace reg {
+
+
+
+
+double CommCounter::s_Value[NCOMMPHASES][NCOMMVALUES] = {};
+
+
+
+
+/********************************************************************
+ * @brief reset all counters
+ *******************************************************************/
+void CommCounter::Reset(void) {
+    for (int i = 0; i < NCOMMPHASES; ++i) {
+        for (int j = 0; j < NCOMMVALUES; ++j) {
+            s_Value[i][j] = 0.0;
+        }
+    }
+}
+
+
+
+
+}  // namespace reg
+
+
+
+
+#endif  // _COMMCOUNTER_CPP_
@@ -20,6 +20,7 @@
 #ifndef _DEFORMATIONFIELDS_CPP_
 #define _DEFORMATIONFIELDS_CPP_
 
+#include <unistd.h>
 #include "DeformationFields.hpp"
 
 
@@ -82,6 +83,8 @@ PetscErrorCode DeformationFields::Initialize() {
     this->m_WorkVecField4 = NULL;
     this->m_WorkVecField5 = NULL;
 
+    this->m_InverseDeformationMap = NULL;
+
     this->m_WorkScaField1 = NULL;
     this->m_WorkScaField2 = NULL;
     this->m_WorkScaField3 = NULL;
@@ -117,6 +120,10 @@ PetscErrorCode DeformationFields::ClearMemory() {
         delete this->m_WorkTenField4;
         this->m_WorkTenField4 = NULL;
     }
+    if (this->m_InverseDeformationMap != NULL) {
+        delete this->m_InverseDeformationMap;
+        this->m_InverseDeformationMap = NULL;
+    }
 
     PetscFunctionReturn(ierr);
 }
@@ -317,7 +324,7 @@ PetscErrorCode DeformationFields::ComputeDetDefGrad() {
     ScalarType minddg, maxddg, meanddg;
     std::string filename, detstr;
     std::stringstream ss, ssnum;
-    bool inverse;
+    bool inverse, lowmem = false;
 
     PetscFunctionBegin;
 
@@ -338,7 +345,16 @@ PetscErrorCode DeformationFields::ComputeDetDefGrad() {
 
     // call the solver
     if (this->m_Opt->m_RegFlags.detdefgradfromdeffield) {
-        ierr = this->ComputeDetDefGradViaDispField(); CHKERRQ(ierr);
+        ierr = this->CheckMemoryDetDefGrad(lowmem); CHKERRQ(ierr);
+        if (lowmem && this->m_Opt->m_PDESolver.type == SL) {
+            // transport of the scalar determinant; this does neither
+            // need the displacement field nor its gradient
+            ierr = this->ComputeDetDefGradSL(); CHKERRQ(ierr);
+        } else if (lowmem) {
+            ierr = this->ComputeDetDefGradViaDispFieldLowMem(); CHKERRQ(ierr);
+        } else {
+            ierr = this->ComputeDetDefGradViaDispField(); CHKERRQ(ierr);
+        }
     } else {
         switch (this->m_Opt->m_PDESolver.type) {
             case RK2:
@@ -763,19 +779,24 @@ PetscErrorCode DeformationFields::ComputeDetDefGradViaDispField() {
     ng = this->m_Opt->m_Domain.ng;
 
     ierr = Assert(this->m_WorkScaField1 != NULL, "null pointer"); CHKERRQ(ierr);
-    ierr = Assert(this->m_WorkVecField1 != NULL, "null pointer"); CHKERRQ(ierr);
-    ierr = Assert(this->m_WorkVecField2 != NULL, "null pointer"); CHKERRQ(ierr);
-    ierr = Assert(this->m_WorkVecField3 != NULL, "null pointer"); CHKERRQ(ierr);
-    ierr = Assert(this->m_WorkVecField4 != NULL, "null pointer"); CHKERRQ(ierr);
 
     // compute deformation map (stored in work vec field one)
     ierr = this->ComputeDisplacementField(); CHKERRQ(ierr);
+    ierr = Assert(this->m_WorkVecField1 != NULL, "null pointer"); CHKERRQ(ierr);
+
+    // the nine components of the gradient are held in a tensor field
+    if (this->m_WorkTenField1 == NULL) {
+        try {this->m_WorkTenField1 = new TenField(this->m_Opt);}
+        catch (std::bad_alloc&) {
+            ierr = reg::ThrowError("allocation failed"); CHKERRQ(ierr);
+        }
+    }
 
     // compute the derivatives (jacobian matrix; deformation gradient)
     ierr = this->m_WorkVecField1->GetArrays(p_u1, p_u2, p_u3); CHKERRQ(ierr);
-    ierr = this->m_WorkVecField2->GetArrays(p_gu11, p_gu12, p_gu13); CHKERRQ(ierr);
-    ierr = this->m_WorkVecField3->GetArrays(p_gu21, p_gu22, p_gu23); CHKERRQ(ierr);
-    ierr = this->m_WorkVecField4->GetArrays(p_gu31, p_gu32, p_gu33); CHKERRQ(ierr);
+    ierr = this->m_WorkTenField1->GetArrays(p_gu11, p_gu12, p_gu13,
+                                            p_gu21, p_gu22, p_gu23,
+                                            p_gu31, p_gu32, p_gu33); CHKERRQ(ierr);
 
     // compute gradient of components of displacement field
     this->m_Opt->StartTimer(FFTSELFEXEC);
@@ -802,9 +823,9 @@ PetscErrorCode DeformationFields::ComputeDetDefGradViaDispField() {
 
     ierr = RestoreRawPointer(this->m_WorkScaField1, &p_phi); CHKERRQ(ierr);
 
-    ierr = this->m_WorkVecField4->RestoreArrays(p_gu31, p_gu32, p_gu33); CHKERRQ(ierr);
-    ierr = this->m_WorkVecField3->RestoreArrays(p_gu21, p_gu22, p_gu23); CHKERRQ(ierr);
-    ierr = this->m_WorkVecField2->RestoreArrays(p_gu11, p_gu12, p_gu13); CHKERRQ(ierr);
+    ierr = this->m_WorkTenField1->RestoreArrays(p_gu11, p_gu12, p_gu13,
+                                                p_gu21, p_gu22, p_gu23,
+                                                p_gu31, p_gu32, p_gu33); CHKERRQ(ierr);
     ierr = this->m_WorkVecField1->RestoreArrays(p_u1, p_u2, p_u3); CHKERRQ(ierr);
 
     this->m_Opt->Exit(__func__);
@@ -815,6 +836,204 @@ PetscErrorCode DeformationFields::ComputeDetDefGradViaDispField() {
 
 
 
+/********************************************************************
+ * @brief compute determinant of deformation gradient from the
+ * displacement field without storing the deformation gradient;
+ * the determinant is expanded along the first row,
+ * det(F) = sum_a F_{1a} (F_{2b} F_{3c} - F_{2c} F_{3b}),
+ * with (a,b,c) a cyclic permutation of (1,2,3); we hold the
+ * gradient of u_2 (second row) and evaluate the entries of the
+ * first and third row one partial derivative at a time; this
+ * needs five scalar fields on top of the displacement field
+ * (instead of nine for the full tensor), at the cost of nine
+ * additional (single direction) spectral derivatives
+ *******************************************************************/
+PetscErrorCode DeformationFields::ComputeDetDefGradViaDispFieldLowMem() {
+    PetscErrorCode ierr = 0;
+    IntType nl;
+    int ia, ib, ic;
+    ScalarType *p_u1 = NULL, *p_u2 = NULL, *p_u3 = NULL, *p_phi = NULL,
+               *p_gu2[3] = {NULL, NULL, NULL}, *p_cof = NULL, *p_du = NULL;
+    ScalarType m2b, m2c, s2b, s2c, m3, s3, m1, s1;
+    double timer[7] = {0};
+    std::bitset<3>XYZ = 0; XYZ[0] = 1; XYZ[1] = 1; XYZ[2] = 1;
+
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    if (this->m_Opt->m_Verbosity > 2) {
+        ierr = DbgMsg("computing det(grad(y)) row by row (low memory)"); CHKERRQ(ierr);
+    }
+
+    ierr = Assert(this->m_VelocityField != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_WorkScaField1 != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_WorkScaField2 != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_WorkScaField3 != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_WorkScaField4 != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_WorkScaField5 != NULL, "null pointer"); CHKERRQ(ierr);
+
+    nl = this->m_Opt->m_Domain.nl;
+
+    // compute displacement field (stored in work vec field one)
+    ierr = this->ComputeDisplacementField(); CHKERRQ(ierr);
+    ierr = Assert(this->m_WorkVecField1 != NULL, "null pointer"); CHKERRQ(ierr);
+
+    ierr = this->m_WorkVecField1->GetArrays(p_u1, p_u2, p_u3); CHKERRQ(ierr);
+    ierr = GetRawPointer(this->m_WorkScaField1, &p_phi); CHKERRQ(ierr);
+    ierr = GetRawPointer(this->m_WorkScaField2, &p_gu2[0]); CHKERRQ(ierr);
+    ierr = GetRawPointer(this->m_WorkScaField3, &p_gu2[1]); CHKERRQ(ierr);
+    ierr = GetRawPointer(this->m_WorkScaField4, &p_gu2[2]); CHKERRQ(ierr);
+    ierr = GetRawPointer(this->m_WorkScaField5, &p_du); CHKERRQ(ierr);
+
+    // second row: gradient of second component of displacement field
+    this->m_Opt->StartTimer(FFTSELFEXEC);
+    accfft_grad_t(p_gu2[0], p_gu2[1], p_gu2[2], p_u2, this->m_Opt->m_FFT.plan, &XYZ, timer);
+    this->m_Opt->StopTimer(FFTSELFEXEC);
+    this->m_Opt->IncrementCounter(FFT, FFTGRAD);
+
+    // u_2 is no longer needed; its memory holds the cofactors
+    p_cof = p_u2;
+
+    // entries of F are F_{ij} = 1 - du_i/dx_j for i = j and
+    // du_i/dx_j for i != j (same as ComputeDetDefGradViaDispField)
+    for (ia = 0; ia < 3; ++ia) {
+        ib = (ia + 1) % 3;
+        ic = (ia + 2) % 3;
+
+        // cofactor: F_{2b} F_{3c}
+        ierr = this->ComputePartialDerivative(p_du, p_u3, ic); CHKERRQ(ierr);
+        m3 = (ic == 2) ? 1.0 : 0.0; s3 = (ic == 2) ? -1.0 : 1.0;
+        m2b = (ib == 1) ? 1.0 : 0.0; s2b = (ib == 1) ? -1.0 : 1.0;
+#pragma omp parallel for
+        for (IntType i = 0; i < nl; ++i) {
+            p_cof[i] = (m2b + s2b*p_gu2[ib][i])*(m3 + s3*p_du[i]);
+        }
+
+        // cofactor: - F_{2c} F_{3b}
+        ierr = this->ComputePartialDerivative(p_du, p_u3, ib); CHKERRQ(ierr);
+        m3 = (ib == 2) ? 1.0 : 0.0; s3 = (ib == 2) ? -1.0 : 1.0;
+        m2c = (ic == 1) ? 1.0 : 0.0; s2c = (ic == 1) ? -1.0 : 1.0;
+#pragma omp parallel for
+        for (IntType i = 0; i < nl; ++i) {
+            p_cof[i] -= (m2c + s2c*p_gu2[ic][i])*(m3 + s3*p_du[i]);
+        }
+
+        // accumulate F_{1a} times cofactor
+        ierr = this->ComputePartialDerivative(p_du, p_u1, ia); CHKERRQ(ierr);
+        m1 = (ia == 0) ? 1.0 : 0.0; s1 = (ia == 0) ? -1.0 : 1.0;
+        if (ia == 0) {
+#pragma omp parallel for
+            for (IntType i = 0; i < nl; ++i) {
+                p_phi[i] = (m1 + s1*p_du[i])*p_cof[i];
+            }
+        } else {
+#pragma omp parallel for
+            for (IntType i = 0; i < nl; ++i) {
+                p_phi[i] += (m1 + s1*p_du[i])*p_cof[i];
+            }
+        }
+    }
+
+    ierr = RestoreRawPointer(this->m_WorkScaField5, &p_du); CHKERRQ(ierr);
+    ierr = RestoreRawPointer(this->m_WorkScaField4, &p_gu2[2]); CHKERRQ(ierr);
+    ierr = RestoreRawPointer(this->m_WorkScaField3, &p_gu2[1]); CHKERRQ(ierr);
+    ierr = RestoreRawPointer(this->m_WorkScaField2, &p_gu2[0]); CHKERRQ(ierr);
+    ierr = RestoreRawPointer(this->m_WorkScaField1, &p_phi); CHKERRQ(ierr);
+    ierr = this->m_WorkVecField1->RestoreArrays(p_u1, p_u2, p_u3); CHKERRQ(ierr);
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief compute a single partial derivative du/dx_i of a scalar
+ * field (only one inverse transform instead of three)
+ *******************************************************************/
+PetscErrorCode DeformationFields::ComputePartialDerivative(ScalarType* p_du, ScalarType* p_u, int i) {
+    PetscErrorCode ierr = 0;
+    ScalarType *p_g[3] = {NULL, NULL, NULL};
+    double timer[7] = {0};
+    std::bitset<3>XYZ = 0;
+
+    PetscFunctionBegin;
+
+    ierr = Assert(i >= 0 && i < 3, "index out of range"); CHKERRQ(ierr);
+
+    XYZ[i] = 1; p_g[i] = p_du;
+
+    this->m_Opt->StartTimer(FFTSELFEXEC);
+    accfft_grad_t(p_g[0], p_g[1], p_g[2], p_u, this->m_Opt->m_FFT.plan, &XYZ, timer);
+    this->m_Opt->StopTimer(FFTSELFEXEC);
+    this->m_Opt->IncrementCounter(FFT, 2);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief decide if we evaluate det(grad(y)) from the displacement
+ * field without storing the deformation gradient; we do so if the
+ * user asks for it, or if the memory we would have to allocate for
+ * the gradient exceeds half of the physical memory that is available
+ * per rank on the node; the decision is made collectively, since
+ * both paths call the (collective) fft
+ *******************************************************************/
+PetscErrorCode DeformationFields::CheckMemoryDetDefGrad(bool& lowmem) {
+    PetscErrorCode ierr = 0;
+    int nlocalranks, rval, lval, merr;
+    long npages, pagesize;
+    double required, available = 0.0;
+    std::stringstream ss;
+    MPI_Comm nodecomm;
+
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    lowmem = this->m_Opt->m_RegFlags.detdefgradlowmem;
+
+    // memory for the gradient is already there
+    if (!lowmem && this->m_WorkTenField1 == NULL) {
+        required = 9.0*static_cast<double>(this->m_Opt->m_Domain.nl)*sizeof(ScalarType);
+
+        // number of ranks that share the memory of this node
+        merr = MPI_Comm_split_type(PETSC_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &nodecomm); ierr = MPIERRQ(merr); CHKERRQ(ierr);
+        merr = MPI_Comm_size(nodecomm, &nlocalranks); ierr = MPIERRQ(merr); CHKERRQ(ierr);
+        merr = MPI_Comm_free(&nodecomm); ierr = MPIERRQ(merr); CHKERRQ(ierr);
+
+        npages = sysconf(_SC_AVPHYS_PAGES);
+        pagesize = sysconf(_SC_PAGESIZE);
+        if (npages > 0 && pagesize > 0) {
+            available = static_cast<double>(npages)*static_cast<double>(pagesize)/static_cast<double>(nlocalranks);
+            lowmem = required > 0.5*available;
+        }
+        if (lowmem && this->m_Opt->m_Verbosity > 1) {
+            ss << "low memory: " << required/(1024.0*1024.0) << " MB required for grad(y), "
+               << available/(1024.0*1024.0) << " MB available per rank";
+            ierr = DbgMsg(ss.str()); CHKERRQ(ierr);
+            ss.str(std::string()); ss.clear();
+        }
+    }
+
+    lval = lowmem ? 1 : 0;
+    merr = MPI_Allreduce(&lval, &rval, 1, MPI_INT, MPI_MAX, PETSC_COMM_WORLD); ierr = MPIERRQ(merr); CHKERRQ(ierr);
+    lowmem = rval == 1;
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
 /********************************************************************
  * @brief compute deformation gradient
  *******************************************************************/
@@ -1222,6 +1441,13 @@ PetscErrorCode DeformationFields::ComputeDeformationMap(bool write2file, VecFiel
         }
         case SL:
         {
+            // for a map that starts at the regular grid, we can use
+            // scaling and squaring (the velocity is stationary)
+            if (this->m_Opt->m_PDESolver.scalingsquaring && y == NULL
+                && !this->m_Opt->m_ReadWriteFlags.timeseries) {
+                ierr = this->ComputeDeformationMapSS(); CHKERRQ(ierr);
+                break;
+            }
             switch (this->m_Opt->m_PDESolver.rkorder) {
                 case 2:
                 {
@@ -1264,6 +1490,317 @@ PetscErrorCode DeformationFields::ComputeDeformationMap(bool write2file, VecFiel
 
 
 
+/********************************************************************
+ * @brief compute deformation map and its inverse in one pass; for
+ * the sl solver with rk2 we integrate the forward and backward
+ * characteristic in the same time loop; otherwise (or if requested)
+ * we invert the forward map by a fixed point iteration
+ * @param[in] write2file write both maps to file
+ * @param[out] y deformation map (optional)
+ * @param[out] yinv inverse deformation map (optional)
+ *******************************************************************/
+PetscErrorCode DeformationFields::ComputeDeformationMapAndInverse(bool write2file, VecField* y, VecField* yinv) {
+    PetscErrorCode ierr = 0;
+    std::string ext;
+    bool joint;
+
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    ierr = Assert(this->m_VelocityField != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_WorkVecField1 != NULL, "null pointer"); CHKERRQ(ierr);
+
+    if (this->m_Opt->m_Verbosity > 2) {
+        ierr = DbgMsg("computing deformation map and its inverse"); CHKERRQ(ierr);
+    }
+
+    if (this->m_InverseDeformationMap == NULL) {
+        try {this->m_InverseDeformationMap = new VecField(this->m_Opt);}
+        catch (std::bad_alloc&) {
+            ierr = reg::ThrowError("allocation failed"); CHKERRQ(ierr);
+        }
+    }
+
+    joint = this->m_Opt->m_PDESolver.type == SL
+         && this->m_Opt->m_PDESolver.rkorder == 2
+         && !this->m_Opt->m_PDESolver.scalingsquaring
+         && !this->m_Opt->m_RegFlags.invdefmapfixedpoint;
+
+    if (joint) {
+        ierr = this->ComputeRegularGrid(this->m_WorkVecField1); CHKERRQ(ierr);
+        ierr = this->m_InverseDeformationMap->Copy(this->m_WorkVecField1); CHKERRQ(ierr);
+        ierr = this->ComputeDeformationMapSLRK2Joint(); CHKERRQ(ierr);
+    } else {
+        this->m_ComputeInverseDefMap = false;
+        ierr = this->ComputeDeformationMap(false); CHKERRQ(ierr);
+        ierr = this->ComputeInverseDefMapFixedPoint(); CHKERRQ(ierr);
+    }
+
+    if (write2file) {
+        ext = this->m_Opt->m_FileNames.extension;
+        ierr = this->m_ReadWrite->Write(this->m_WorkVecField1, "deformation-map"+ext); CHKERRQ(ierr);
+        ierr = this->m_ReadWrite->Write(this->m_InverseDeformationMap, "inverse-deformation-map"+ext); CHKERRQ(ierr);
+    }
+
+    if (y != NULL) {
+        ierr = y->Copy(this->m_WorkVecField1); CHKERRQ(ierr);
+    }
+    if (yinv != NULL) {
+        ierr = yinv->Copy(this->m_InverseDeformationMap); CHKERRQ(ierr);
+    }
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief compute deformation map and its inverse (sl; rk2); the
+ * forward characteristic uses the state plan, the backward
+ * characteristic the adjoint plan; both evaluations of v share
+ * the ghost layer of v
+ *******************************************************************/
+PetscErrorCode DeformationFields::ComputeDeformationMapSLRK2Joint() {
+    PetscErrorCode ierr = 0;
+    IntType nl, nt;
+    ScalarType ht, hthalf;
+    VecField *yt = NULL, *vy = NULL;
+    ScalarType *p_v1 = NULL, *p_v2 = NULL, *p_v3 = NULL,
+                *p_y1 = NULL, *p_y2 = NULL, *p_y3 = NULL,
+                *p_vy1 = NULL, *p_vy2 = NULL, *p_vy3 = NULL,
+                *p_yt1 = NULL, *p_yt2 = NULL, *p_yt3 = NULL,
+                *p_z1 = NULL, *p_z2 = NULL, *p_z3 = NULL,
+                *p_vz1 = NULL, *p_vz2 = NULL, *p_vz3 = NULL,
+                *p_zt1 = NULL, *p_zt2 = NULL, *p_zt3 = NULL;
+
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    ierr = Assert(this->m_VelocityField != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_SemiLagrangianMethod != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_WorkVecField1 != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_WorkVecField2 != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_WorkVecField3 != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_InverseDeformationMap != NULL, "null pointer"); CHKERRQ(ierr);
+
+    // intermediate variables for backward characteristic
+    try {yt = new VecField(this->m_Opt);}
+    catch (std::bad_alloc&) {
+        ierr = reg::ThrowError("allocation failed"); CHKERRQ(ierr);
+    }
+    try {vy = new VecField(this->m_Opt);}
+    catch (std::bad_alloc&) {
+        ierr = reg::ThrowError("allocation failed"); CHKERRQ(ierr);
+    }
+
+    nt = this->m_Opt->m_Domain.nt;
+    nl = this->m_Opt->m_Domain.nl;
+    ht = this->m_Opt->GetTimeStepSize();
+    hthalf = 0.5*ht;
+
+    ierr = this->m_VelocityField->GetArrays(p_v1, p_v2, p_v3); CHKERRQ(ierr);
+
+    ierr = this->m_WorkVecField1->GetArrays(p_y1, p_y2, p_y3); CHKERRQ(ierr);
+    ierr = this->m_WorkVecField2->GetArrays(p_yt1, p_yt2, p_yt3); CHKERRQ(ierr);
+    ierr = this->m_WorkVecField3->GetArrays(p_vy1, p_vy2, p_vy3); CHKERRQ(ierr);
+    ierr = this->m_InverseDeformationMap->GetArrays(p_z1, p_z2, p_z3); CHKERRQ(ierr);
+    ierr = yt->GetArrays(p_zt1, p_zt2, p_zt3); CHKERRQ(ierr);
+    ierr = vy->GetArrays(p_vz1, p_vz2, p_vz3); CHKERRQ(ierr);
+
+    for (IntType j = 0; j < nt; ++j) {
+        // evaluate v(y) and v(z)
+        ierr = this->m_SemiLagrangianMethod->SetQueryPoints(p_y1, p_y2, p_y3, "state"); CHKERRQ(ierr);
+        ierr = this->m_SemiLagrangianMethod->SetQueryPoints(p_z1, p_z2, p_z3, "adjoint"); CHKERRQ(ierr);
+        ierr = this->m_SemiLagrangianMethod->InterpolateStateAndAdjoint(p_vy1, p_vy2, p_vy3,
+                                                                        p_vz1, p_vz2, p_vz3,
+                                                                        p_v1, p_v2, p_v3); CHKERRQ(ierr);
+
+        // first stage of rk2 (forward: -v; backward: +v)
+#pragma omp parallel
+{
+#pragma omp for
+        for (IntType i = 0; i < nl; ++i) {
+            p_yt1[i] = p_y1[i] - ht*p_vy1[i];
+            p_yt2[i] = p_y2[i] - ht*p_vy2[i];
+            p_yt3[i] = p_y3[i] - ht*p_vy3[i];
+            p_y1[i] -= hthalf*p_vy1[i];
+            p_y2[i] -= hthalf*p_vy2[i];
+            p_y3[i] -= hthalf*p_vy3[i];
+
+            p_zt1[i] = p_z1[i] + ht*p_vz1[i];
+            p_zt2[i] = p_z2[i] + ht*p_vz2[i];
+            p_zt3[i] = p_z3[i] + ht*p_vz3[i];
+            p_z1[i] += hthalf*p_vz1[i];
+            p_z2[i] += hthalf*p_vz2[i];
+            p_z3[i] += hthalf*p_vz3[i];
+        }
+}  // end of pragma omp parallel
+
+        // evaluate v(ytilde) and v(ztilde)
+        ierr = this->m_SemiLagrangianMethod->SetQueryPoints(p_yt1, p_yt2, p_yt3, "state"); CHKERRQ(ierr);
+        ierr = this->m_SemiLagrangianMethod->SetQueryPoints(p_zt1, p_zt2, p_zt3, "adjoint"); CHKERRQ(ierr);
+        ierr = this->m_SemiLagrangianMethod->InterpolateStateAndAdjoint(p_vy1, p_vy2, p_vy3,
+                                                                        p_vz1, p_vz2, p_vz3,
+                                                                        p_v1, p_v2, p_v3); CHKERRQ(ierr);
+
+        // second stage of rk2
+#pragma omp parallel
+{
+#pragma omp for
+        for (IntType i = 0; i < nl; ++i) {
+            p_y1[i] -= hthalf*p_vy1[i];
+            p_y2[i] -= hthalf*p_vy2[i];
+            p_y3[i] -= hthalf*p_vy3[i];
+
+            p_z1[i] += hthalf*p_vz1[i];
+            p_z2[i] += hthalf*p_vz2[i];
+            p_z3[i] += hthalf*p_vz3[i];
+        }
+}  // end of pragma omp parallel
+    }  // for all time points
+
+    ierr = vy->RestoreArrays(p_vz1, p_vz2, p_vz3); CHKERRQ(ierr);
+    ierr = yt->RestoreArrays(p_zt1, p_zt2, p_zt3); CHKERRQ(ierr);
+    ierr = this->m_InverseDeformationMap->RestoreArrays(p_z1, p_z2, p_z3); CHKERRQ(ierr);
+    ierr = this->m_WorkVecField3->RestoreArrays(p_vy1, p_vy2, p_vy3); CHKERRQ(ierr);
+    ierr = this->m_WorkVecField2->RestoreArrays(p_yt1, p_yt2, p_yt3); CHKERRQ(ierr);
+    ierr = this->m_WorkVecField1->RestoreArrays(p_y1, p_y2, p_y3); CHKERRQ(ierr);
+
+    ierr = this->m_VelocityField->RestoreArrays(p_v1, p_v2, p_v3); CHKERRQ(ierr);
+
+    if (yt != NULL) {delete yt; yt = NULL;}
+    if (vy != NULL) {delete vy; vy = NULL;}
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief invert the deformation map y = x + d (stored in work vec
+ * field one) by a fixed point iteration for the inverse displacement,
+ * dinv <- -d(x + dinv), warm started with dinv = -d; the iteration
+ * converges if |grad(d)| < 1
+ *******************************************************************/
+PetscErrorCode DeformationFields::ComputeInverseDefMapFixedPoint() {
+    PetscErrorCode ierr = 0;
+    IntType nl;
+    int k, maxit = 50, rval;
+    ScalarType tol, hxmin, delta, deltaloc;
+    std::stringstream ss;
+    ScalarType *p_d1 = NULL, *p_d2 = NULL, *p_d3 = NULL,
+                *p_q1 = NULL, *p_q2 = NULL, *p_q3 = NULL,
+                *p_w1 = NULL, *p_w2 = NULL, *p_w3 = NULL,
+                *p_z1 = NULL, *p_z2 = NULL, *p_z3 = NULL;
+
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    ierr = Assert(this->m_SemiLagrangianMethod != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_WorkVecField1 != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_WorkVecField2 != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_WorkVecField3 != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_InverseDeformationMap != NULL, "null pointer"); CHKERRQ(ierr);
+
+    nl = this->m_Opt->m_Domain.nl;
+
+    // stop if the update is below a hundredth of a grid cell
+    hxmin = this->m_Opt->m_Domain.hx[0];
+    hxmin = PetscMin(hxmin, this->m_Opt->m_Domain.hx[1]);
+    hxmin = PetscMin(hxmin, this->m_Opt->m_Domain.hx[2]);
+    tol = 1E-2*hxmin;
+
+    // d = y - x; initial guess dinv = -d
+    ierr = this->ComputeRegularGrid(this->m_WorkVecField2); CHKERRQ(ierr);
+    ierr = this->m_WorkVecField1->AXPY(-1.0, this->m_WorkVecField2); CHKERRQ(ierr);
+    ierr = this->m_InverseDeformationMap->Copy(this->m_WorkVecField1); CHKERRQ(ierr);
+    ierr = this->m_InverseDeformationMap->Scale(-1.0); CHKERRQ(ierr);
+
+    ierr = this->m_WorkVecField1->GetArrays(p_d1, p_d2, p_d3); CHKERRQ(ierr);
+    ierr = this->m_WorkVecField3->GetArrays(p_w1, p_w2, p_w3); CHKERRQ(ierr);
+    ierr = this->m_InverseDeformationMap->GetArrays(p_z1, p_z2, p_z3); CHKERRQ(ierr);
+
+    delta = 0.0;
+    for (k = 0; k < maxit; ++k) {
+        // query points x + dinv
+        ierr = this->ComputeRegularGrid(this->m_WorkVecField2); CHKERRQ(ierr);
+        ierr = this->m_WorkVecField2->GetArrays(p_q1, p_q2, p_q3); CHKERRQ(ierr);
+#pragma omp parallel
+{
+#pragma omp for
+        for (IntType i = 0; i < nl; ++i) {
+            p_q1[i] += p_z1[i];
+            p_q2[i] += p_z2[i];
+            p_q3[i] += p_z3[i];
+        }
+}  // end of pragma omp parallel
+        ierr = this->m_SemiLagrangianMethod->SetQueryPoints(p_q1, p_q2, p_q3, "state"); CHKERRQ(ierr);
+        ierr = this->m_WorkVecField2->RestoreArrays(p_q1, p_q2, p_q3); CHKERRQ(ierr);
+
+        // evaluate d(x + dinv)
+        ierr = this->m_SemiLagrangianMethod->Interpolate(p_w1, p_w2, p_w3, p_d1, p_d2, p_d3, "state"); CHKERRQ(ierr);
+
+        // update dinv = -d(x + dinv)
+        deltaloc = 0.0;
+#pragma omp parallel for reduction(max:deltaloc)
+        for (IntType i = 0; i < nl; ++i) {
+            ScalarType e1 = PetscAbsReal(p_z1[i] + p_w1[i]);
+            ScalarType e2 = PetscAbsReal(p_z2[i] + p_w2[i]);
+            ScalarType e3 = PetscAbsReal(p_z3[i] + p_w3[i]);
+            deltaloc = PetscMax(deltaloc, PetscMax(e1, PetscMax(e2, e3)));
+            p_z1[i] = -p_w1[i];
+            p_z2[i] = -p_w2[i];
+            p_z3[i] = -p_w3[i];
+        }
+        rval = MPI_Allreduce(&deltaloc, &delta, 1, MPIU_REAL, MPI_MAX, PETSC_COMM_WORLD);
+        ierr = Assert(rval == MPI_SUCCESS, "mpi error"); CHKERRQ(ierr);
+
+        if (this->m_Opt->m_Verbosity > 2) {
+            ss << "fixed point iteration " << std::setw(3) << k+1
+               << ": max update " << std::scientific << delta;
+            ierr = DbgMsg(ss.str()); CHKERRQ(ierr);
+            ss.str(std::string()); ss.clear();
+        }
+        if (delta < tol) break;
+    }
+
+    ierr = this->m_InverseDeformationMap->RestoreArrays(p_z1, p_z2, p_z3); CHKERRQ(ierr);
+    ierr = this->m_WorkVecField3->RestoreArrays(p_w1, p_w2, p_w3); CHKERRQ(ierr);
+    ierr = this->m_WorkVecField1->RestoreArrays(p_d1, p_d2, p_d3); CHKERRQ(ierr);
+
+    if (delta >= tol) {
+        ss << "inversion of deformation map did not converge (max update "
+           << std::scientific << delta << " after " << maxit << " iterations)";
+        ierr = WrngMsg(ss.str()); CHKERRQ(ierr);
+        ss.str(std::string()); ss.clear();
+    } else if (this->m_Opt->m_Verbosity > 1) {
+        ss << "inverse deformation map: " << k+1 << " fixed point iterations";
+        ierr = DbgMsg(ss.str()); CHKERRQ(ierr);
+        ss.str(std::string()); ss.clear();
+    }
+
+    // add regular grid to both maps
+    ierr = this->ComputeRegularGrid(this->m_WorkVecField2); CHKERRQ(ierr);
+    ierr = this->m_WorkVecField1->AXPY(1.0, this->m_WorkVecField2); CHKERRQ(ierr);
+    ierr = this->m_InverseDeformationMap->AXPY(1.0, this->m_WorkVecField2); CHKERRQ(ierr);
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
 /********************************************************************
  * @brief compute deformation map
  *******************************************************************/
@@ -1738,6 +2275,252 @@ PetscErrorCode DeformationFields::ComputeDeformationMapSLRK4() {
 
 
 
+/********************************************************************
+ * @brief compute deformation map by scaling and squaring; since the
+ * velocity is stationary, y = exp(-v); we compare against the
+ * semi-lagrangian solution if the verbosity is high
+ *******************************************************************/
+PetscErrorCode DeformationFields::ComputeDeformationMapSS() {
+    PetscErrorCode ierr = 0;
+    ScalarType sign, nerr, nref;
+    VecField* ysl = NULL;
+    std::stringstream ss;
+
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    sign = this->m_ComputeInverseDefMap ? -1.0 : 1.0;
+
+    // compute y(x) - x (stored in work vec field one)
+    ierr = this->ComputeDisplacementFieldSS(sign); CHKERRQ(ierr);
+
+    // add regular grid
+    ierr = this->ComputeRegularGrid(this->m_WorkVecField2); CHKERRQ(ierr);
+    ierr = this->m_WorkVecField1->AXPY(1.0, this->m_WorkVecField2); CHKERRQ(ierr);
+
+    // check accuracy against time integration
+    if (this->m_Opt->m_Verbosity > 2) {
+        try {ysl = new VecField(this->m_Opt);}
+        catch (std::bad_alloc&) {
+            ierr = reg::ThrowError("allocation failed"); CHKERRQ(ierr);
+        }
+        ierr = ysl->Copy(this->m_WorkVecField1); CHKERRQ(ierr);
+
+        ierr = this->ComputeRegularGrid(this->m_WorkVecField1); CHKERRQ(ierr);
+        if (this->m_Opt->m_PDESolver.rkorder == 4 && this->m_WorkVecField4 != NULL) {
+            ierr = this->ComputeDeformationMapSLRK4(); CHKERRQ(ierr);
+        } else {
+            ierr = this->ComputeDeformationMapSLRK2(); CHKERRQ(ierr);
+        }
+
+        // ||y_sl - x|| and ||y_ss - y_sl||
+        ierr = this->ComputeRegularGrid(this->m_WorkVecField2); CHKERRQ(ierr);
+        ierr = this->m_WorkVecField2->AXPY(-1.0, this->m_WorkVecField1); CHKERRQ(ierr);
+        ierr = this->m_WorkVecField2->Norm(nref); CHKERRQ(ierr);
+        ierr = this->m_WorkVecField2->WAXPY(-1.0, this->m_WorkVecField1, ysl); CHKERRQ(ierr);
+        ierr = this->m_WorkVecField2->Norm(nerr); CHKERRQ(ierr);
+
+        ss << "scaling and squaring vs sl: relative error " << std::scientific
+           << (nref > 0.0 ? nerr/nref : nerr);
+        ierr = DbgMsg(ss.str()); CHKERRQ(ierr);
+        ss.str(std::string()); ss.clear();
+
+        ierr = this->m_WorkVecField1->Copy(ysl); CHKERRQ(ierr);
+        delete ysl; ysl = NULL;
+    }
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief compute d = y(x) - x for the map y = exp(-sign*v) by
+ * scaling and squaring; we take a single rk2 step of size
+ * h = 2^{-K} (along the characteristic, as in the sl solver) and
+ * then compose the map with itself K times,
+ * d_{k+1}(x) = d_k(x) + d_k(x + d_k(x)); each composition is a
+ * single interpolation of a vector field, i.e., we need K + 2
+ * interpolations instead of 2 nt
+ *******************************************************************/
+PetscErrorCode DeformationFields::ComputeDisplacementFieldSS(ScalarType sign) {
+    PetscErrorCode ierr = 0;
+    IntType nl, nsteps;
+    int K;
+    ScalarType h, hhalf;
+    std::stringstream ss;
+    ScalarType *p_v1 = NULL, *p_v2 = NULL, *p_v3 = NULL,
+                *p_d1 = NULL, *p_d2 = NULL, *p_d3 = NULL,
+                *p_q1 = NULL, *p_q2 = NULL, *p_q3 = NULL,
+                *p_w1 = NULL, *p_w2 = NULL, *p_w3 = NULL;
+
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    ierr = Assert(this->m_VelocityField != NULL, "null pointer"); CHKERRQ(ierr);
+
+    // allocate semi-lagrangian solver
+    if (this->m_SemiLagrangianMethod == NULL) {
+        try{this->m_SemiLagrangianMethod = new SemiLagrangianType(this->m_Opt);}
+        catch (std::bad_alloc&) {
+            ierr = reg::ThrowError("allocation failed"); CHKERRQ(ierr);
+        }
+    }
+
+    if (this->m_WorkVecField1 == NULL) {
+        try{this->m_WorkVecField1 = new VecField(this->m_Opt);}
+        catch (std::bad_alloc&) {
+            ierr = reg::ThrowError("allocation failed"); CHKERRQ(ierr);
+        }
+    }
+    if (this->m_WorkVecField2 == NULL) {
+        try{this->m_WorkVecField2 = new VecField(this->m_Opt);}
+        catch (std::bad_alloc&) {
+            ierr = reg::ThrowError("allocation failed"); CHKERRQ(ierr);
+        }
+    }
+    if (this->m_WorkVecField3 == NULL) {
+        try{this->m_WorkVecField3 = new VecField(this->m_Opt);}
+        catch (std::bad_alloc&) {
+            ierr = reg::ThrowError("allocation failed"); CHKERRQ(ierr);
+        }
+    }
+
+    nl = this->m_Opt->m_Domain.nl;
+
+    ierr = this->ComputeScalingSquaringSteps(K); CHKERRQ(ierr);
+    nsteps = static_cast<IntType>(1) << K;
+    h = sign/static_cast<ScalarType>(nsteps);
+    hhalf = 0.5*h;
+
+    if (this->m_Opt->m_Verbosity > 1) {
+        ss << "scaling and squaring: " << K << " squarings (2^" << K
+           << " = " << nsteps << " steps; nt = " << this->m_Opt->m_Domain.nt << ")";
+        ierr = DbgMsg(ss.str()); CHKERRQ(ierr);
+        ss.str(std::string()); ss.clear();
+    }
+
+    // regular grid
+    ierr = this->ComputeRegularGrid(this->m_WorkVecField2); CHKERRQ(ierr);
+
+    ierr = this->m_VelocityField->GetArrays(p_v1, p_v2, p_v3); CHKERRQ(ierr);
+    ierr = this->m_WorkVecField1->GetArrays(p_d1, p_d2, p_d3); CHKERRQ(ierr);
+    ierr = this->m_WorkVecField2->GetArrays(p_q1, p_q2, p_q3); CHKERRQ(ierr);
+    ierr = this->m_WorkVecField3->GetArrays(p_w1, p_w2, p_w3); CHKERRQ(ierr);
+
+    // scaling: d_0 = -h v(x - h/2 v(x)) (rk2; midpoint rule)
+#pragma omp parallel
+{
+#pragma omp for
+    for (IntType i = 0; i < nl; ++i) {
+        p_q1[i] -= hhalf*p_v1[i];
+        p_q2[i] -= hhalf*p_v2[i];
+        p_q3[i] -= hhalf*p_v3[i];
+    }
+}  // end of pragma omp parallel
+    ierr = this->m_SemiLagrangianMethod->SetQueryPoints(p_q1, p_q2, p_q3, "state"); CHKERRQ(ierr);
+    ierr = this->m_SemiLagrangianMethod->Interpolate(p_w1, p_w2, p_w3, p_v1, p_v2, p_v3, "state"); CHKERRQ(ierr);
+#pragma omp parallel
+{
+#pragma omp for
+    for (IntType i = 0; i < nl; ++i) {
+        p_d1[i] = -h*p_w1[i];
+        p_d2[i] = -h*p_w2[i];
+        p_d3[i] = -h*p_w3[i];
+    }
+}  // end of pragma omp parallel
+
+    // squaring: y_{2h} = y_h o y_h
+    for (int k = 0; k < K; ++k) {
+        ierr = this->m_WorkVecField2->RestoreArrays(p_q1, p_q2, p_q3); CHKERRQ(ierr);
+        ierr = this->ComputeRegularGrid(this->m_WorkVecField2); CHKERRQ(ierr);
+        ierr = this->m_WorkVecField2->GetArrays(p_q1, p_q2, p_q3); CHKERRQ(ierr);
+#pragma omp parallel
+{
+#pragma omp for
+        for (IntType i = 0; i < nl; ++i) {
+            p_q1[i] += p_d1[i];
+            p_q2[i] += p_d2[i];
+            p_q3[i] += p_d3[i];
+        }
+}  // end of pragma omp parallel
+
+        // evaluate d_k(x + d_k(x))
+        ierr = this->m_SemiLagrangianMethod->SetQueryPoints(p_q1, p_q2, p_q3, "state"); CHKERRQ(ierr);
+        ierr = this->m_SemiLagrangianMethod->Interpolate(p_w1, p_w2, p_w3, p_d1, p_d2, p_d3, "state"); CHKERRQ(ierr);
+
+#pragma omp parallel
+{
+#pragma omp for
+        for (IntType i = 0; i < nl; ++i) {
+            p_d1[i] += p_w1[i];
+            p_d2[i] += p_w2[i];
+            p_d3[i] += p_w3[i];
+        }
+}  // end of pragma omp parallel
+    }
+
+    ierr = this->m_WorkVecField3->RestoreArrays(p_w1, p_w2, p_w3); CHKERRQ(ierr);
+    ierr = this->m_WorkVecField2->RestoreArrays(p_q1, p_q2, p_q3); CHKERRQ(ierr);
+    ierr = this->m_WorkVecField1->RestoreArrays(p_d1, p_d2, p_d3); CHKERRQ(ierr);
+    ierr = this->m_VelocityField->RestoreArrays(p_v1, p_v2, p_v3); CHKERRQ(ierr);
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief number of squarings K for scaling and squaring; we use at
+ * least as many steps as the time integrator (2^K >= nt) and make
+ * sure that the initial step does not move points by more than
+ * one grid cell (h*|v|_inf <= min(hx))
+ *******************************************************************/
+PetscErrorCode DeformationFields::ComputeScalingSquaringSteps(int& K) {
+    PetscErrorCode ierr = 0;
+    ScalarType vmax, vmaxi, hxmin, hstep;
+    IntType nt;
+
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    nt = this->m_Opt->m_Domain.nt;
+
+    hxmin = this->m_Opt->m_Domain.hx[0];
+    hxmin = PetscMin(hxmin, this->m_Opt->m_Domain.hx[1]);
+    hxmin = PetscMin(hxmin, this->m_Opt->m_Domain.hx[2]);
+
+    ierr = VecNorm(this->m_VelocityField->m_X1, NORM_INFINITY, &vmax); CHKERRQ(ierr);
+    ierr = VecNorm(this->m_VelocityField->m_X2, NORM_INFINITY, &vmaxi); CHKERRQ(ierr);
+    vmax = PetscMax(vmax, vmaxi);
+    ierr = VecNorm(this->m_VelocityField->m_X3, NORM_INFINITY, &vmaxi); CHKERRQ(ierr);
+    vmax = PetscMax(vmax, vmaxi);
+
+    K = 0;
+    while ((static_cast<IntType>(1) << K) < nt) ++K;
+
+    hstep = 1.0/static_cast<ScalarType>(static_cast<IntType>(1) << K);
+    while (hstep*vmax > hxmin && K < 30) {
+        ++K; hstep *= 0.5;
+    }
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
 /********************************************************************
  * @brief compute displacement field
  *******************************************************************/
@@ -1771,8 +2554,15 @@ PetscErrorCode DeformationFields::ComputeDisplacementField(bool write2file) {
         }
         case SL:
         {
-            // compute displacement field using sl time integrator
-            ierr = this->ComputeDisplacementFieldSL(); CHKERRQ(ierr);
+            if (this->m_Opt->m_PDESolver.scalingsquaring
+                && !this->m_Opt->m_ReadWriteFlags.timeseries) {
+                // u = x - y(x); scaling and squaring gives y(x) - x
+                ierr = this->ComputeDisplacementFieldSS(1.0); CHKERRQ(ierr);
+                ierr = this->m_WorkVecField1->Scale(-1.0); CHKERRQ(ierr);
+            } else {
+                // compute displacement field using sl time integrator
+                ierr = this->ComputeDisplacementFieldSL(); CHKERRQ(ierr);
+            }
             break;
         }
         default:
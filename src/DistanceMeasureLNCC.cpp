@@ -0,0 +1,720 @@
+/*************************************************************************
+ *  Copyright (c) 2018.
+ *  All rights reserved.
+ *  This file is part of the CLAIRE library.
+ *
+ *  CLAIRE is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CLAIRE is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CLAIRE.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#ifndef _DISTANCEMEASURELNCC_CPP_
+#define _DISTANCEMEASURELNCC_CPP_
+
+#include "DistanceMeasureLNCC.hpp"
+#include "interp3.hpp"
+
+
+
+
+namespace reg {
+
+
+
+
+/********************************************************************
+ * @brief default constructor
+ *******************************************************************/
+DistanceMeasureLNCC::DistanceMeasureLNCC() : SuperClass() {
+    this->Initialize();
+}
+
+
+
+
+/********************************************************************
+ * @brief default destructor
+ *******************************************************************/
+DistanceMeasureLNCC::~DistanceMeasureLNCC() {
+    this->ClearMemory();
+}
+
+
+
+
+/********************************************************************
+ * @brief constructor
+ *******************************************************************/
+DistanceMeasureLNCC::DistanceMeasureLNCC(RegOpt* opt) : SuperClass(opt) {
+    this->Initialize();
+}
+
+
+
+
+/********************************************************************
+ * @brief init variables
+ *******************************************************************/
+PetscErrorCode DistanceMeasureLNCC::Initialize() {
+    PetscFunctionBegin;
+
+    for (int i = 0; i < NWORK; ++i) {
+        this->m_Work[i] = NULL;
+    }
+    this->m_Ghost = NULL;
+    this->m_BoxSum1 = NULL;
+    this->m_BoxSum2 = NULL;
+    this->m_Radius = 0;
+
+    PetscFunctionReturn(0);
+}
+
+
+
+
+/********************************************************************
+ * @brief clean up
+ *******************************************************************/
+PetscErrorCode DistanceMeasureLNCC::ClearMemory() {
+    PetscErrorCode ierr = 0;
+    PetscFunctionBegin;
+
+    for (int i = 0; i < NWORK; ++i) {
+        if (this->m_Work[i] != NULL) {
+            delete [] this->m_Work[i];
+            this->m_Work[i] = NULL;
+        }
+    }
+    if (this->m_Ghost != NULL) {
+        accfft_free(this->m_Ghost);
+        this->m_Ghost = NULL;
+    }
+    if (this->m_BoxSum1 != NULL) {
+        delete [] this->m_BoxSum1;
+        this->m_BoxSum1 = NULL;
+    }
+    if (this->m_BoxSum2 != NULL) {
+        delete [] this->m_BoxSum2;
+        this->m_BoxSum2 = NULL;
+    }
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief allocate work arrays and buffers for box filter; the
+ * ghost layer has the width of the window radius; accfft only
+ * communicates with direct neighbors, so the radius cannot exceed
+ * the local size of any rank in x1 and x2
+ *******************************************************************/
+PetscErrorCode DistanceMeasureLNCC::AllocateMemory() {
+    PetscErrorCode ierr = 0;
+    IntType nl, isize[3], isizemin[2];
+    int isize_g[3], istart_g[3], rval;
+    size_t nalloc;
+    std::stringstream ss;
+
+    PetscFunctionBegin;
+
+    if (this->m_Ghost != NULL) {
+        PetscFunctionReturn(ierr);
+    }
+
+    this->m_Opt->Enter(__func__);
+
+    nl = this->m_Opt->m_Domain.nl;
+    for (int i = 0; i < 3; ++i) {
+        isize[i] = this->m_Opt->m_Domain.isize[i];
+    }
+    this->m_Radius = this->m_Opt->m_Distance.lnccradius;
+
+    rval = MPI_Allreduce(isize, isizemin, 2, MPIU_INT, MPI_MIN, PETSC_COMM_WORLD);
+    ierr = Assert(rval == MPI_SUCCESS, "mpi error"); CHKERRQ(ierr);
+    if (this->m_Radius > isizemin[0] || this->m_Radius > isizemin[1]
+        || 2*this->m_Radius + 1 > isize[2]) {
+        ss << "lncc window radius " << this->m_Radius << " exceeds local grid size ("
+           << isizemin[0] << "," << isizemin[1] << "," << isize[2] << ")";
+        ierr = ThrowError(ss.str()); CHKERRQ(ierr);
+    }
+
+    for (int i = 0; i < NWORK; ++i) {
+        try {this->m_Work[i] = new ScalarType[nl];}
+        catch (std::bad_alloc& err) {
+            ierr = reg::ThrowError(err); CHKERRQ(ierr);
+        }
+    }
+
+    nalloc = accfft_ghost_local_size_dft_r2c(this->m_Opt->m_FFT.plan, this->m_Radius, isize_g, istart_g);
+    this->m_Ghost = reinterpret_cast<ScalarType*>(accfft_alloc(nalloc));
+
+    try {this->m_BoxSum1 = new ScalarType[isize_g[0]*isize_g[1]*isize[2]];}
+    catch (std::bad_alloc& err) {
+        ierr = reg::ThrowError(err); CHKERRQ(ierr);
+    }
+    try {this->m_BoxSum2 = new ScalarType[isize_g[0]*isize[1]*isize[2]];}
+    catch (std::bad_alloc& err) {
+        ierr = reg::ThrowError(err); CHKERRQ(ierr);
+    }
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief apply box filter; out(x) = sum of in over the window
+ * [x-r,x+r]^3 (periodic); we communicate a ghost layer of width r
+ * in x1 and x2 (x3 is local) and compute running sums along x3,
+ * x2 and x1; the cost per grid point is independent of r
+ *******************************************************************/
+PetscErrorCode DistanceMeasureLNCC::BoxFilter(ScalarType* out, ScalarType* in) {
+    PetscErrorCode ierr = 0;
+    int isize_g[3], istart_g[3], r, w;
+    IntType n1, n2, n3, g0, g1;
+
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    ierr = this->AllocateMemory(); CHKERRQ(ierr);
+
+    r = this->m_Radius;
+    w = 2*r + 1;
+    n1 = this->m_Opt->m_Domain.isize[0];
+    n2 = this->m_Opt->m_Domain.isize[1];
+    n3 = this->m_Opt->m_Domain.isize[2];
+    g0 = n1 + 2*r;
+    g1 = n2 + 2*r;
+
+    // communicate ghost layer (x1 and x2)
+    accfft_ghost_local_size_dft_r2c(this->m_Opt->m_FFT.plan, r, isize_g, istart_g);
+    accfft_get_ghost(this->m_Opt->m_FFT.plan, r, isize_g, in, this->m_Ghost);
+
+    ScalarType* p_g = this->m_Ghost;
+    ScalarType* p_s1 = this->m_BoxSum1;
+    ScalarType* p_s2 = this->m_BoxSum2;
+
+    // running sum along x3 (periodic; all points are local)
+#pragma omp parallel for
+    for (IntType l = 0; l < g0*g1; ++l) {
+        const ScalarType* src = &p_g[l*n3];
+        ScalarType* dst = &p_s1[l*n3];
+        ScalarType s = 0.0;
+        for (int k = -r; k <= r; ++k) {
+            s += src[(k + n3) % n3];
+        }
+        dst[0] = s;
+        for (IntType i3 = 1; i3 < n3; ++i3) {
+            s += src[(i3 + r) % n3] - src[(i3 - r - 1 + n3) % n3];
+            dst[i3] = s;
+        }
+    }
+
+    // running sum along x2 (rows of length n3)
+#pragma omp parallel for
+    for (IntType i1 = 0; i1 < g0; ++i1) {
+        const ScalarType* src = &p_s1[i1*g1*n3];
+        ScalarType* dst = &p_s2[i1*n2*n3];
+        for (IntType i3 = 0; i3 < n3; ++i3) dst[i3] = 0.0;
+        for (int j = 0; j < w; ++j) {
+            for (IntType i3 = 0; i3 < n3; ++i3) dst[i3] += src[j*n3 + i3];
+        }
+        for (IntType i2 = 1; i2 < n2; ++i2) {
+            const ScalarType* add = &src[(i2 + w - 1)*n3];
+            const ScalarType* sub = &src[(i2 - 1)*n3];
+            const ScalarType* prv = &dst[(i2 - 1)*n3];
+            ScalarType* cur = &dst[i2*n3];
+            for (IntType i3 = 0; i3 < n3; ++i3) {
+                cur[i3] = prv[i3] + add[i3] - sub[i3];
+            }
+        }
+    }
+
+    // running sum along x1 (planes of size n2*n3)
+    const IntType np = n2*n3;
+#pragma omp parallel for
+    for (IntType i = 0; i < np; ++i) {
+        ScalarType s = 0.0;
+        for (int j = 0; j < w; ++j) s += p_s2[j*np + i];
+        out[i] = s;
+    }
+    for (IntType i1 = 1; i1 < n1; ++i1) {
+        const ScalarType* add = &p_s2[(i1 + w - 1)*np];
+        const ScalarType* sub = &p_s2[(i1 - 1)*np];
+        const ScalarType* prv = &out[(i1 - 1)*np];
+        ScalarType* cur = &out[i1*np];
+#pragma omp parallel for
+        for (IntType i = 0; i < np; ++i) {
+            cur[i] = prv[i] + add[i] - sub[i];
+        }
+    }
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief compute local statistics of m and mR on window W(x) with
+ * N points; on output
+ *   work[0] = mean(m), work[1] = mean(mR),
+ *   work[2] = B = sum (m - mean(m))^2,
+ *   work[3] = C = sum (mR - mean(mR))^2,
+ *   work[4] = A = sum (m - mean(m))(mR - mean(mR))
+ *******************************************************************/
+PetscErrorCode DistanceMeasureLNCC::ComputeLocalStatistics(ScalarType* p_m, ScalarType* p_mr) {
+    PetscErrorCode ierr = 0;
+    IntType nl;
+    ScalarType N;
+    ScalarType **p_w = this->m_Work;
+
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    nl = this->m_Opt->m_Domain.nl;
+    N = static_cast<ScalarType>((2*this->m_Radius + 1)*(2*this->m_Radius + 1)*(2*this->m_Radius + 1));
+
+    ierr = this->BoxFilter(p_w[0], p_m); CHKERRQ(ierr);
+    ierr = this->BoxFilter(p_w[1], p_mr); CHKERRQ(ierr);
+
+#pragma omp parallel for
+    for (IntType i = 0; i < nl; ++i) p_w[5][i] = p_m[i]*p_m[i];
+    ierr = this->BoxFilter(p_w[2], p_w[5]); CHKERRQ(ierr);
+
+#pragma omp parallel for
+    for (IntType i = 0; i < nl; ++i) p_w[5][i] = p_mr[i]*p_mr[i];
+    ierr = this->BoxFilter(p_w[3], p_w[5]); CHKERRQ(ierr);
+
+#pragma omp parallel for
+    for (IntType i = 0; i < nl; ++i) p_w[5][i] = p_m[i]*p_mr[i];
+    ierr = this->BoxFilter(p_w[4], p_w[5]); CHKERRQ(ierr);
+
+#pragma omp parallel for
+    for (IntType i = 0; i < nl; ++i) {
+        ScalarType mum = p_w[0][i]/N, mur = p_w[1][i]/N;
+        p_w[0][i] = mum;
+        p_w[1][i] = mur;
+        p_w[2][i] -= N*mum*mum;
+        p_w[3][i] -= N*mur*mur;
+        p_w[4][i] -= N*mum*mur;
+    }
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief compute local correlation cc = A^2/(B C) and return the
+ * (local part of the) weighted sum; points with (almost) constant
+ * intensities in their window do not contribute
+ *******************************************************************/
+PetscErrorCode DistanceMeasureLNCC::ComputeCorrelation(ScalarType* p_m, ScalarType* p_mr,
+                                                       ScalarType* p_mask, ScalarType& sum) {
+    PetscErrorCode ierr = 0;
+    IntType nl;
+    ScalarType N, eps, value = 0.0;
+    ScalarType **p_w = this->m_Work;
+
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    nl = this->m_Opt->m_Domain.nl;
+    N = static_cast<ScalarType>((2*this->m_Radius + 1)*(2*this->m_Radius + 1)*(2*this->m_Radius + 1));
+    eps = N*1E-5;
+
+    ierr = this->ComputeLocalStatistics(p_m, p_mr); CHKERRQ(ierr);
+
+#pragma omp parallel for reduction(+:value)
+    for (IntType i = 0; i < nl; ++i) {
+        ScalarType A = p_w[4][i], B = p_w[2][i], C = p_w[3][i];
+        if (B > eps && C > eps) {
+            value += (p_mask != NULL ? p_mask[i] : 1.0)*A*A/(B*C);
+        }
+    }
+    sum = value;
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief set up scale for LNCC measure given by
+ * scale = D_SL2(mR,mT)/D_LNCC(mR,mT)
+ *******************************************************************/
+PetscErrorCode DistanceMeasureLNCC::SetupScale() {
+    PetscErrorCode ierr = 0;
+    ScalarType *p_mr = NULL, *p_mt = NULL, *p_w = NULL;
+    IntType nc, nl, ng;
+    ScalarType value[2], valueloc[2], cc, hd, l2distance, lnccdistance;
+    int rval;
+
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    ierr = Assert(this->m_TemplateImage != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_ReferenceImage != NULL, "null pointer"); CHKERRQ(ierr);
+
+    nc = this->m_Opt->m_Domain.nc;
+    nl = this->m_Opt->m_Domain.nl;
+    ng = this->m_Opt->m_Domain.ng;
+    hd = this->m_Opt->GetLebesgueMeasure();
+
+    ierr = GetRawPointer(this->m_TemplateImage, &p_mt); CHKERRQ(ierr);
+    ierr = GetRawPointer(this->m_ReferenceImage, &p_mr); CHKERRQ(ierr);
+    if (this->m_Mask != NULL) {
+        ierr = GetRawPointer(this->m_Mask, &p_w); CHKERRQ(ierr);
+    }
+
+    valueloc[0] = 0.0; valueloc[1] = 0.0;
+    for (IntType k = 0; k < nc; ++k) {
+        for (IntType i = 0; i < nl; ++i) {
+            ScalarType d = p_mt[k*nl+i] - p_mr[k*nl+i];
+            valueloc[0] += (p_w != NULL ? p_w[i] : 1.0)*d*d;
+        }
+        ierr = this->ComputeCorrelation(&p_mt[k*nl], &p_mr[k*nl], p_w, cc); CHKERRQ(ierr);
+        valueloc[1] += cc;
+    }
+
+    if (this->m_Mask != NULL) {
+        ierr = RestoreRawPointer(this->m_Mask, &p_w); CHKERRQ(ierr);
+    }
+    ierr = RestoreRawPointer(this->m_ReferenceImage, &p_mr); CHKERRQ(ierr);
+    ierr = RestoreRawPointer(this->m_TemplateImage, &p_mt); CHKERRQ(ierr);
+
+    rval = MPI_Allreduce(valueloc, value, 2, MPIU_REAL, MPI_SUM, PETSC_COMM_WORLD);
+    ierr = Assert(rval == MPI_SUCCESS, "mpi error"); CHKERRQ(ierr);
+
+    l2distance = 0.5*hd*value[0]/static_cast<ScalarType>(nc);
+    lnccdistance = 0.5 - 0.5*value[1]/static_cast<ScalarType>(nc*ng);
+    this->m_Opt->m_Distance.scale = lnccdistance > 0.0 ? l2distance/lnccdistance : 1.0;
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief evaluate the functional (i.e., the distance measure)
+ * D = 0.5 - 0.5/|Omega| int A(x)^2/(B(x) C(x)) dx, where A, B and C
+ * are the local covariance of m1 and mR and the local variances of
+ * m1 and mR on a window of (2r+1)^3 grid points
+ *******************************************************************/
+PetscErrorCode DistanceMeasureLNCC::EvaluateFunctional(ScalarType* D) {
+    PetscErrorCode ierr = 0;
+    ScalarType *p_mr = NULL, *p_m = NULL, *p_w = NULL;
+    IntType nt, nc, nl, ng, l;
+    ScalarType cc, valueloc, scale;
+
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    ierr = Assert(this->m_StateVariable != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_ReferenceImage != NULL, "null pointer"); CHKERRQ(ierr);
+
+    nt = this->m_Opt->m_Domain.nt;
+    nc = this->m_Opt->m_Domain.nc;
+    nl = this->m_Opt->m_Domain.nl;
+    ng = this->m_Opt->m_Domain.ng;
+    scale = this->m_Opt->m_Distance.scale;
+
+    ierr = GetRawPointer(this->m_StateVariable, &p_m); CHKERRQ(ierr);
+    ierr = GetRawPointer(this->m_ReferenceImage, &p_mr); CHKERRQ(ierr);
+    if (this->m_Mask != NULL) {
+        ierr = GetRawPointer(this->m_Mask, &p_w); CHKERRQ(ierr);
+    }
+
+    l = nt*nl*nc;
+    valueloc = 0.0;
+    for (IntType k = 0; k < nc; ++k) {
+        ierr = this->ComputeCorrelation(&p_m[l+k*nl], &p_mr[k*nl], p_w, cc); CHKERRQ(ierr);
+        valueloc += cc;
+    }
+
+    if (this->m_Mask != NULL) {
+        ierr = RestoreRawPointer(this->m_Mask, &p_w); CHKERRQ(ierr);
+    }
+    ierr = RestoreRawPointer(this->m_ReferenceImage, &p_mr); CHKERRQ(ierr);
+    ierr = RestoreRawPointer(this->m_StateVariable, &p_m); CHKERRQ(ierr);
+
+    // D = scale*(0.5 - 0.5*sum/(nc*ng)); all reduce
+    ierr = this->m_Opt->m_Reduction.Add(valueloc, D, -0.5*scale/static_cast<ScalarType>(nc*ng), 0.5*scale); CHKERRQ(ierr);
+    ierr = this->m_Opt->m_Reduction.Flush(); CHKERRQ(ierr);
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief set final condition for adjoint equation; with
+ * alpha = 2 A/(B C) and beta = alpha A/B the derivative of the sum
+ * of cc over all windows is
+ * g = mR box(alpha) - box(alpha mean(mR)) - m1 box(beta) + box(beta mean(m1))
+ * and lambda = scale/(2 nc ng hd) g
+ *******************************************************************/
+PetscErrorCode DistanceMeasureLNCC::SetFinalConditionAE() {
+    PetscErrorCode ierr = 0;
+    IntType nl, nc, nt, ng, l, ll;
+    ScalarType *p_mr = NULL, *p_m = NULL, *p_l = NULL, *p_mask = NULL;
+    ScalarType **p_w = this->m_Work;
+    ScalarType hd, scale, c, N, eps;
+
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    ierr = Assert(this->m_ReferenceImage != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_StateVariable != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_AdjointVariable != NULL, "null pointer"); CHKERRQ(ierr);
+
+    nt = this->m_Opt->m_Domain.nt;
+    nc = this->m_Opt->m_Domain.nc;
+    nl = this->m_Opt->m_Domain.nl;
+    ng = this->m_Opt->m_Domain.ng;
+    hd = this->m_Opt->GetLebesgueMeasure();
+    scale = this->m_Opt->m_Distance.scale;
+
+    // index for final condition
+    if (this->m_Opt->m_OptPara.method == FULLNEWTON) {
+        ll = nt*nc*nl;
+    } else {
+        ll = 0;
+    }
+    l = nt*nc*nl;
+
+    ierr = this->AllocateMemory(); CHKERRQ(ierr);
+    N = static_cast<ScalarType>((2*this->m_Radius + 1)*(2*this->m_Radius + 1)*(2*this->m_Radius + 1));
+    eps = N*1E-5;
+    c = scale/(2.0*static_cast<ScalarType>(nc*ng)*hd);
+
+    ierr = GetRawPointer(this->m_StateVariable, &p_m); CHKERRQ(ierr);
+    ierr = GetRawPointer(this->m_ReferenceImage, &p_mr); CHKERRQ(ierr);
+    ierr = GetRawPointer(this->m_AdjointVariable, &p_l); CHKERRQ(ierr);
+    if (this->m_Mask != NULL) {
+        ierr = GetRawPointer(this->m_Mask, &p_mask); CHKERRQ(ierr);
+    }
+
+    for (IntType k = 0; k < nc; ++k) {
+        ScalarType *p_m1 = &p_m[l+k*nl], *p_r = &p_mr[k*nl], *p_lk = &p_l[ll+k*nl];
+
+        ierr = this->ComputeLocalStatistics(p_m1, p_r); CHKERRQ(ierr);
+
+        // alpha, beta, alpha*mean(mR), beta*mean(m1)
+#pragma omp parallel for
+        for (IntType i = 0; i < nl; ++i) {
+            ScalarType A = p_w[4][i], B = p_w[2][i], C = p_w[3][i], alpha = 0.0, beta = 0.0;
+            if (B > eps && C > eps) {
+                alpha = 2.0*(p_mask != NULL ? p_mask[i] : 1.0)*A/(B*C);
+                beta = alpha*A/B;
+            }
+            p_w[5][i] = alpha;
+            p_w[6][i] = beta;
+            p_w[7][i] = alpha*p_w[1][i];
+            p_w[8][i] = beta*p_w[0][i];
+        }
+
+        // A, B and C are no longer needed
+        ierr = this->BoxFilter(p_w[2], p_w[5]); CHKERRQ(ierr);
+        ierr = this->BoxFilter(p_w[3], p_w[6]); CHKERRQ(ierr);
+        ierr = this->BoxFilter(p_w[4], p_w[7]); CHKERRQ(ierr);
+        ierr = this->BoxFilter(p_w[9], p_w[8]); CHKERRQ(ierr);
+
+#pragma omp parallel for
+        for (IntType i = 0; i < nl; ++i) {
+            p_lk[i] = c*(p_r[i]*p_w[2][i] - p_w[4][i] - p_m1[i]*p_w[3][i] + p_w[9][i]);
+        }
+    }
+
+    if (this->m_Mask != NULL) {
+        ierr = RestoreRawPointer(this->m_Mask, &p_mask); CHKERRQ(ierr);
+    }
+    ierr = RestoreRawPointer(this->m_AdjointVariable, &p_l); CHKERRQ(ierr);
+    ierr = RestoreRawPointer(this->m_ReferenceImage, &p_mr); CHKERRQ(ierr);
+    ierr = RestoreRawPointer(this->m_StateVariable, &p_m); CHKERRQ(ierr);
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief set final condition for incremental adjoint equation; this
+ * is the directional derivative of g (see SetFinalConditionAE) in
+ * direction mtilde,
+ * dg = mR box(dalpha) - box(dalpha mean(mR)) - mtilde box(beta)
+ *    - m1 box(dbeta) + box(dbeta mean(m1)) + box(beta mean(mtilde)),
+ * with dA = box(mtilde mR) - N mean(mtilde) mean(mR) and
+ * dB = 2 (box(m1 mtilde) - N mean(m1) mean(mtilde))
+ *******************************************************************/
+PetscErrorCode DistanceMeasureLNCC::SetFinalConditionIAE() {
+    PetscErrorCode ierr = 0;
+    IntType nt, nc, nl, ng, ll, l;
+    ScalarType *p_m = NULL, *p_mr = NULL, *p_mtilde = NULL,
+                *p_ltilde = NULL, *p_mask = NULL;
+    ScalarType **p_w = this->m_Work;
+    ScalarType hd, scale, c, N, eps;
+
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    ierr = Assert(this->m_IncAdjointVariable != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_IncStateVariable != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_StateVariable != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_ReferenceImage != NULL, "null pointer"); CHKERRQ(ierr);
+
+    nt = this->m_Opt->m_Domain.nt;
+    nc = this->m_Opt->m_Domain.nc;
+    nl = this->m_Opt->m_Domain.nl;
+    ng = this->m_Opt->m_Domain.ng;
+    hd = this->m_Opt->GetLebesgueMeasure();
+    scale = this->m_Opt->m_Distance.scale;
+
+    // index for final condition
+    if (this->m_Opt->m_OptPara.method == FULLNEWTON) {
+        ll = nt*nc*nl;
+    } else {
+        ll = 0;
+    }
+    l = nt*nc*nl;
+
+    ierr = this->AllocateMemory(); CHKERRQ(ierr);
+    N = static_cast<ScalarType>((2*this->m_Radius + 1)*(2*this->m_Radius + 1)*(2*this->m_Radius + 1));
+    eps = N*1E-5;
+    c = scale/(2.0*static_cast<ScalarType>(nc*ng)*hd);
+
+    ierr = GetRawPointer(this->m_IncStateVariable, &p_mtilde); CHKERRQ(ierr);
+    ierr = GetRawPointer(this->m_IncAdjointVariable, &p_ltilde); CHKERRQ(ierr);
+    ierr = GetRawPointer(this->m_StateVariable, &p_m); CHKERRQ(ierr);
+    ierr = GetRawPointer(this->m_ReferenceImage, &p_mr); CHKERRQ(ierr);
+    if (this->m_Mask != NULL) {
+        ierr = GetRawPointer(this->m_Mask, &p_mask); CHKERRQ(ierr);
+    }
+
+    for (IntType k = 0; k < nc; ++k) {
+        ScalarType *p_m1 = &p_m[l+k*nl], *p_r = &p_mr[k*nl],
+                   *p_mt = &p_mtilde[ll+k*nl], *p_lk = &p_ltilde[ll+k*nl];
+
+        // work[0..4]: mean(m1), mean(mR), B, C, A
+        ierr = this->ComputeLocalStatistics(p_m1, p_r); CHKERRQ(ierr);
+
+        // work[5]: mean(mtilde); work[6]: box(mtilde mR); work[7]: box(m1 mtilde)
+        ierr = this->BoxFilter(p_w[5], p_mt); CHKERRQ(ierr);
+#pragma omp parallel for
+        for (IntType i = 0; i < nl; ++i) p_w[9][i] = p_mt[i]*p_r[i];
+        ierr = this->BoxFilter(p_w[6], p_w[9]); CHKERRQ(ierr);
+#pragma omp parallel for
+        for (IntType i = 0; i < nl; ++i) p_w[9][i] = p_m1[i]*p_mt[i];
+        ierr = this->BoxFilter(p_w[7], p_w[9]); CHKERRQ(ierr);
+
+        // work[6]: dalpha; work[7]: dbeta; work[8]: beta
+#pragma omp parallel for
+        for (IntType i = 0; i < nl; ++i) {
+            ScalarType A = p_w[4][i], B = p_w[2][i], C = p_w[3][i];
+            ScalarType mum = p_w[0][i], mur = p_w[1][i], mut = p_w[5][i]/N;
+            ScalarType dA = p_w[6][i] - N*mut*mur;
+            ScalarType dB = 2.0*(p_w[7][i] - N*mum*mut);
+            ScalarType wi = p_mask != NULL ? p_mask[i] : 1.0;
+            ScalarType dalpha = 0.0, dbeta = 0.0, beta = 0.0;
+            if (B > eps && C > eps) {
+                dalpha = wi*(2.0*dA/(B*C) - 2.0*A*dB/(B*B*C));
+                dbeta  = wi*(4.0*A*dA/(B*B*C) - 4.0*A*A*dB/(B*B*B*C));
+                beta   = wi*2.0*A*A/(B*B*C);
+            }
+            p_w[5][i] = mut;
+            p_w[6][i] = dalpha;
+            p_w[7][i] = dbeta;
+            p_w[8][i] = beta;
+        }
+
+        // mR box(dalpha) - box(dalpha mean(mR))
+        ierr = this->BoxFilter(p_w[2], p_w[6]); CHKERRQ(ierr);
+#pragma omp parallel for
+        for (IntType i = 0; i < nl; ++i) {
+            p_lk[i] = p_r[i]*p_w[2][i];
+            p_w[9][i] = p_w[6][i]*p_w[1][i];
+        }
+        ierr = this->BoxFilter(p_w[2], p_w[9]); CHKERRQ(ierr);
+
+        // - mtilde box(beta) - m1 box(dbeta)
+        ierr = this->BoxFilter(p_w[3], p_w[8]); CHKERRQ(ierr);
+        ierr = this->BoxFilter(p_w[4], p_w[7]); CHKERRQ(ierr);
+#pragma omp parallel for
+        for (IntType i = 0; i < nl; ++i) {
+            p_lk[i] -= p_w[2][i] + p_mt[i]*p_w[3][i] + p_m1[i]*p_w[4][i];
+            p_w[9][i] = p_w[7][i]*p_w[0][i];
+        }
+
+        // + box(dbeta mean(m1)) + box(beta mean(mtilde))
+        ierr = this->BoxFilter(p_w[2], p_w[9]); CHKERRQ(ierr);
+#pragma omp parallel for
+        for (IntType i = 0; i < nl; ++i) p_w[9][i] = p_w[8][i]*p_w[5][i];
+        ierr = this->BoxFilter(p_w[3], p_w[9]); CHKERRQ(ierr);
+
+#pragma omp parallel for
+        for (IntType i = 0; i < nl; ++i) {
+            p_lk[i] = c*(p_lk[i] + p_w[2][i] + p_w[3][i]);
+        }
+    }
+
+    if (this->m_Mask != NULL) {
+        ierr = RestoreRawPointer(this->m_Mask, &p_mask); CHKERRQ(ierr);
+    }
+    ierr = RestoreRawPointer(this->m_ReferenceImage, &p_mr); CHKERRQ(ierr);
+    ierr = RestoreRawPointer(this->m_StateVariable, &p_m); CHKERRQ(ierr);
+    ierr = RestoreRawPointer(this->m_IncAdjointVariable, &p_ltilde); CHKERRQ(ierr);
+    ierr = RestoreRawPointer(this->m_IncStateVariable, &p_mtilde); CHKERRQ(ierr);
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+}  // namespace reg
+
+
+
+
+#endif  // _DISTANCEMEASURELNCC_CPP_
@@ -0,0 +1,749 @@
+/*************************************************************************
+ *  Copyright (c) 2018.
+ *  All rights reserved.
+ *  This file is part of the CLAIRE library.
+ *
+ *  CLAIRE is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CLAIRE is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CLAIRE.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#ifndef _DISTANCEMEASUREMI_CPP_
+#define _DISTANCEMEASUREMI_CPP_
+
+#include "DistanceMeasureMI.hpp"
+
+
+
+
+namespace reg {
+
+
+
+
+/********************************************************************
+ * @brief evaluate cubic B-spline Parzen window for intensity v;
+ * the bin coordinate is t = 2 + (v - lo)/dv (two bins of padding
+ * on either side); with dv = range/(nb - 4) the range [lo, hi] maps
+ * to t in [2, nb - 2]; on output, w[j], dw[j] and ddw[j] hold the
+ * kernel and its first and second derivative with respect to v for
+ * bins i0,...,i0+3; returns false if v is outside of the range (in
+ * which case the derivatives vanish)
+ *******************************************************************/
+bool DistanceMeasureMI::ParzenWindow(ScalarType v, ScalarType lo, ScalarType dv, int nb,
+                                     int& i0, ScalarType* w, ScalarType* dw, ScalarType* ddw) {
+    ScalarType t, u, a;
+    bool inside = true;
+
+    t = 2.0 + (v - lo)/dv;
+    if (t < 2.0) {t = 2.0; inside = false;}
+    if (t > static_cast<ScalarType>(nb - 2)) {t = static_cast<ScalarType>(nb - 2); inside = false;}
+
+    // for t = nb - 2 the weight of bin i0 vanishes
+    i0 = PetscMin(static_cast<int>(t) - 1, nb - 4);
+    for (int j = 0; j < 4; ++j) {
+        u = static_cast<ScalarType>(i0 + j) - t;
+        a = PetscAbsReal(u);
+        if (a < 1.0) {
+            w[j] = 2.0/3.0 - a*a + 0.5*a*a*a;
+            if (dw != NULL) dw[j] = (2.0*u - 1.5*u*a)/dv;
+            if (ddw != NULL) ddw[j] = (3.0*a - 2.0)/(dv*dv);
+        } else if (a < 2.0) {
+            w[j] = (2.0 - a)*(2.0 - a)*(2.0 - a)/6.0;
+            if (dw != NULL) dw[j] = (u > 0.0 ? 0.5 : -0.5)*(2.0 - a)*(2.0 - a)/dv;
+            if (ddw != NULL) ddw[j] = (2.0 - a)/(dv*dv);
+        } else {
+            w[j] = 0.0;
+            if (dw != NULL) dw[j] = 0.0;
+            if (ddw != NULL) ddw[j] = 0.0;
+        }
+        if (!inside) {
+            if (dw != NULL) dw[j] = 0.0;
+            if (ddw != NULL) ddw[j] = 0.0;
+        }
+    }
+
+    return inside;
+}
+
+
+
+
+/********************************************************************
+ * @brief default constructor
+ *******************************************************************/
+DistanceMeasureMI::DistanceMeasureMI() : SuperClass() {
+    this->Initialize();
+}
+
+
+
+
+/********************************************************************
+ * @brief default destructor
+ *******************************************************************/
+DistanceMeasureMI::~DistanceMeasureMI() {
+    this->ClearMemory();
+}
+
+
+
+
+/********************************************************************
+ * @brief constructor
+ *******************************************************************/
+DistanceMeasureMI::DistanceMeasureMI(RegOpt* opt) : SuperClass(opt) {
+    this->Initialize();
+}
+
+
+
+
+/********************************************************************
+ * @brief init variables
+ *******************************************************************/
+PetscErrorCode DistanceMeasureMI::Initialize() {
+    PetscFunctionBegin;
+
+    this->m_NumBins = 0;
+    this->m_NumThreads = 0;
+    this->m_ThreadHistogram = NULL;
+    this->m_JointPDF = NULL;
+    this->m_JointPDFTilde = NULL;
+    this->m_LogRatio = NULL;
+    for (int i = 0; i < 4; ++i) {
+        this->m_Range[i] = 0.0;
+    }
+    this->m_RangeSet = false;
+
+    PetscFunctionReturn(0);
+}
+
+
+
+
+/********************************************************************
+ * @brief clean up
+ *******************************************************************/
+PetscErrorCode DistanceMeasureMI::ClearMemory() {
+    PetscErrorCode ierr = 0;
+    PetscFunctionBegin;
+
+    if (this->m_ThreadHistogram != NULL) {
+        delete [] this->m_ThreadHistogram;
+        this->m_ThreadHistogram = NULL;
+    }
+    if (this->m_JointPDF != NULL) {
+        delete [] this->m_JointPDF;
+        this->m_JointPDF = NULL;
+    }
+    if (this->m_JointPDFTilde != NULL) {
+        delete [] this->m_JointPDFTilde;
+        this->m_JointPDFTilde = NULL;
+    }
+    if (this->m_LogRatio != NULL) {
+        delete [] this->m_LogRatio;
+        this->m_LogRatio = NULL;
+    }
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief allocate histograms; each histogram has nb*nb entries plus
+ * one entry for the sum of the weights (normalization)
+ *******************************************************************/
+PetscErrorCode DistanceMeasureMI::AllocateMemory() {
+    PetscErrorCode ierr = 0;
+    IntType nc, nb2;
+
+    PetscFunctionBegin;
+
+    if (this->m_JointPDF != NULL) {
+        PetscFunctionReturn(ierr);
+    }
+
+    this->m_Opt->Enter(__func__);
+
+    nc = this->m_Opt->m_Domain.nc;
+    this->m_NumBins = this->m_Opt->m_Distance.mibins;
+    this->m_NumThreads = omp_get_max_threads();
+    nb2 = this->m_NumBins*this->m_NumBins + 1;
+
+    try {this->m_ThreadHistogram = new double[this->m_NumThreads*nb2];}
+    catch (std::bad_alloc& err) {
+        ierr = reg::ThrowError(err); CHKERRQ(ierr);
+    }
+    try {this->m_JointPDF = new double[nc*nb2];}
+    catch (std::bad_alloc& err) {
+        ierr = reg::ThrowError(err); CHKERRQ(ierr);
+    }
+    try {this->m_JointPDFTilde = new double[nc*nb2];}
+    catch (std::bad_alloc& err) {
+        ierr = reg::ThrowError(err); CHKERRQ(ierr);
+    }
+    try {this->m_LogRatio = new double[nc*nb2];}
+    catch (std::bad_alloc& err) {
+        ierr = reg::ThrowError(err); CHKERRQ(ierr);
+    }
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief compute intensity range of the images; the deformed
+ * template is a transport of the template image, so we use the
+ * range of the template (if available); values outside of the
+ * range are clamped
+ *******************************************************************/
+PetscErrorCode DistanceMeasureMI::ComputeIntensityRange() {
+    PetscErrorCode ierr = 0;
+    ScalarType minval, maxval;
+
+    PetscFunctionBegin;
+
+    if (this->m_RangeSet) {
+        PetscFunctionReturn(ierr);
+    }
+
+    this->m_Opt->Enter(__func__);
+
+    ierr = Assert(this->m_ReferenceImage != NULL, "null pointer"); CHKERRQ(ierr);
+
+    if (this->m_TemplateImage != NULL) {
+        ierr = VecMin(this->m_TemplateImage, NULL, &minval); CHKERRQ(ierr);
+        ierr = VecMax(this->m_TemplateImage, NULL, &maxval); CHKERRQ(ierr);
+    } else {
+        ierr = Assert(this->m_StateVariable != NULL, "null pointer"); CHKERRQ(ierr);
+        ierr = VecMin(this->m_StateVariable, NULL, &minval); CHKERRQ(ierr);
+        ierr = VecMax(this->m_StateVariable, NULL, &maxval); CHKERRQ(ierr);
+    }
+    this->m_Range[0] = minval;
+    this->m_Range[1] = maxval > minval ? maxval : minval + 1.0;
+
+    ierr = VecMin(this->m_ReferenceImage, NULL, &minval); CHKERRQ(ierr);
+    ierr = VecMax(this->m_ReferenceImage, NULL, &maxval); CHKERRQ(ierr);
+    this->m_Range[2] = minval;
+    this->m_Range[3] = maxval > minval ? maxval : minval + 1.0;
+
+    this->m_RangeSet = true;
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief compute joint histogram (normalized) for all components;
+ * if p_mt is NULL we compute p(a,b); otherwise we compute the
+ * directional derivative of p(a,b) with respect to m1 in direction
+ * mtilde; each thread accumulates into a private histogram (small
+ * enough to stay in cache), the histograms are merged and we
+ * combine the histograms of all components across ranks in a
+ * single reduction
+ *******************************************************************/
+PetscErrorCode DistanceMeasureMI::ComputeJointHistogram(double* hist, const ScalarType* p_m,
+                                                        const ScalarType* p_mr, const ScalarType* p_w,
+                                                        const ScalarType* p_mt) {
+    PetscErrorCode ierr = 0;
+    IntType nc, nl, nb2;
+    int nb, rval;
+    ScalarType lom, dvm, lor, dvr;
+
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    ierr = this->AllocateMemory(); CHKERRQ(ierr);
+    ierr = this->ComputeIntensityRange(); CHKERRQ(ierr);
+
+    nc = this->m_Opt->m_Domain.nc;
+    nl = this->m_Opt->m_Domain.nl;
+    nb = this->m_NumBins;
+    nb2 = nb*nb + 1;
+
+    lom = this->m_Range[0];
+    dvm = (this->m_Range[1] - this->m_Range[0])/static_cast<ScalarType>(nb - 4);
+    lor = this->m_Range[2];
+    dvr = (this->m_Range[3] - this->m_Range[2])/static_cast<ScalarType>(nb - 4);
+
+    for (IntType k = 0; k < nc; ++k) {
+        const ScalarType* p_mk = &p_m[k*nl];
+        const ScalarType* p_rk = &p_mr[k*nl];
+        const ScalarType* p_tk = p_mt != NULL ? &p_mt[k*nl] : NULL;
+        double* histk = &hist[k*nb2];
+
+#pragma omp parallel
+{
+        int tid = omp_get_thread_num(), im, ir;
+        double* h = &this->m_ThreadHistogram[tid*nb2];
+        ScalarType wm[4], dwm[4], wr[4], wi, s;
+
+        for (IntType j = 0; j < nb2; ++j) h[j] = 0.0;
+
+#pragma omp for
+        for (IntType i = 0; i < nl; ++i) {
+            wi = p_w != NULL ? p_w[i] : 1.0;
+            ParzenWindow(p_mk[i], lom, dvm, nb, im, wm, dwm, NULL);
+            ParzenWindow(p_rk[i], lor, dvr, nb, ir, wr, NULL, NULL);
+            if (p_tk != NULL) {
+                s = wi*p_tk[i];
+                for (int a = 0; a < 4; ++a) wm[a] = s*dwm[a];
+            } else {
+                for (int a = 0; a < 4; ++a) wm[a] *= wi;
+            }
+            for (int a = 0; a < 4; ++a) {
+                double* row = &h[(im + a)*nb + ir];
+                for (int b = 0; b < 4; ++b) {
+                    row[b] += wm[a]*wr[b];
+                }
+            }
+            h[nb2-1] += wi;
+        }
+
+        // merge thread private histograms (implicit barrier above)
+#pragma omp for
+        for (IntType j = 0; j < nb2; ++j) {
+            double sum = 0.0;
+            for (int t = 0; t < omp_get_num_threads(); ++t) {
+                sum += this->m_ThreadHistogram[t*nb2 + j];
+            }
+            histk[j] = sum;
+        }
+}  // omp parallel
+    }
+
+    rval = MPI_Allreduce(MPI_IN_PLACE, hist, static_cast<int>(nc*nb2), MPI_DOUBLE, MPI_SUM, PETSC_COMM_WORLD);
+    ierr = Assert(rval == MPI_SUCCESS, "mpi error"); CHKERRQ(ierr);
+
+    // normalize
+    for (IntType k = 0; k < nc; ++k) {
+        double z = hist[k*nb2 + nb2 - 1];
+        ierr = Assert(z > 0.0, "empty joint histogram"); CHKERRQ(ierr);
+        for (IntType j = 0; j < nb2 - 1; ++j) hist[k*nb2 + j] /= z;
+    }
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief compute log(p(a,b)/p(a)) from joint pdf (p(a) is the
+ * marginal of m1); empty bins do not contribute
+ *******************************************************************/
+PetscErrorCode DistanceMeasureMI::ComputeLogRatio() {
+    PetscErrorCode ierr = 0;
+    IntType nc, nb2;
+    int nb;
+    double pa, pab;
+    const double eps = 1E-12;
+
+    PetscFunctionBegin;
+
+    nc = this->m_Opt->m_Domain.nc;
+    nb = this->m_NumBins;
+    nb2 = nb*nb + 1;
+
+    for (IntType k = 0; k < nc; ++k) {
+        const double* p = &this->m_JointPDF[k*nb2];
+        double* logr = &this->m_LogRatio[k*nb2];
+        for (int a = 0; a < nb; ++a) {
+            pa = 0.0;
+            for (int b = 0; b < nb; ++b) pa += p[a*nb + b];
+            for (int b = 0; b < nb; ++b) {
+                pab = p[a*nb + b];
+                logr[a*nb + b] = (pab > eps && pa > eps) ? std::log(pab/pa) : 0.0;
+            }
+        }
+    }
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief evaluate conditional entropy H(mR|m1) = H(m1,mR) - H(m1)
+ * = -sum p(a,b) log(p(a,b)/p(a))
+ * (averaged over all components); also sets up joint pdf and log
+ * ratio for the given image
+ *******************************************************************/
+PetscErrorCode DistanceMeasureMI::EvaluateConditionalEntropy(ScalarType* D, const ScalarType* p_m) {
+    PetscErrorCode ierr = 0;
+    ScalarType *p_mr = NULL, *p_w = NULL;
+    IntType nc, nb2;
+    double value = 0.0;
+
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    nc = this->m_Opt->m_Domain.nc;
+
+    ierr = this->AllocateMemory(); CHKERRQ(ierr);
+
+    ierr = GetRawPointer(this->m_ReferenceImage, &p_mr); CHKERRQ(ierr);
+    if (this->m_Mask != NULL) {
+        ierr = GetRawPointer(this->m_Mask, &p_w); CHKERRQ(ierr);
+    }
+
+    ierr = this->ComputeJointHistogram(this->m_JointPDF, p_m, p_mr, p_w, NULL); CHKERRQ(ierr);
+    ierr = this->ComputeLogRatio(); CHKERRQ(ierr);
+
+    if (this->m_Mask != NULL) {
+        ierr = RestoreRawPointer(this->m_Mask, &p_w); CHKERRQ(ierr);
+    }
+    ierr = RestoreRawPointer(this->m_ReferenceImage, &p_mr); CHKERRQ(ierr);
+
+    nb2 = this->m_NumBins*this->m_NumBins + 1;
+    for (IntType k = 0; k < nc; ++k) {
+        for (IntType j = 0; j < nb2 - 1; ++j) {
+            value -= this->m_JointPDF[k*nb2 + j]*this->m_LogRatio[k*nb2 + j];
+        }
+    }
+    *D = static_cast<ScalarType>(value/static_cast<double>(nc));
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief set up scale for MI measure given by
+ * scale = D_SL2(mR,mT)/D_MI(mR,mT)
+ *******************************************************************/
+PetscErrorCode DistanceMeasureMI::SetupScale() {
+    PetscErrorCode ierr = 0;
+    ScalarType *p_mr = NULL, *p_mt = NULL, *p_w = NULL;
+    IntType nc, nl;
+    ScalarType l2distance, midistance, value, valueloc, hd;
+    int rval;
+
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    ierr = Assert(this->m_TemplateImage != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_ReferenceImage != NULL, "null pointer"); CHKERRQ(ierr);
+
+    nc = this->m_Opt->m_Domain.nc;
+    nl = this->m_Opt->m_Domain.nl;
+    hd = this->m_Opt->GetLebesgueMeasure();
+
+    ierr = GetRawPointer(this->m_TemplateImage, &p_mt); CHKERRQ(ierr);
+    ierr = GetRawPointer(this->m_ReferenceImage, &p_mr); CHKERRQ(ierr);
+    if (this->m_Mask != NULL) {
+        ierr = GetRawPointer(this->m_Mask, &p_w); CHKERRQ(ierr);
+    }
+    valueloc = 0.0;
+    for (IntType k = 0; k < nc; ++k) {
+        for (IntType i = 0; i < nl; ++i) {
+            ScalarType d = p_mt[k*nl+i] - p_mr[k*nl+i];
+            valueloc += (p_w != NULL ? p_w[i] : 1.0)*d*d;
+        }
+    }
+    if (this->m_Mask != NULL) {
+        ierr = RestoreRawPointer(this->m_Mask, &p_w); CHKERRQ(ierr);
+    }
+    ierr = RestoreRawPointer(this->m_ReferenceImage, &p_mr); CHKERRQ(ierr);
+
+    rval = MPI_Allreduce(&valueloc, &value, 1, MPIU_REAL, MPI_SUM, PETSC_COMM_WORLD);
+    ierr = Assert(rval == MPI_SUCCESS, "mpi error"); CHKERRQ(ierr);
+    l2distance = 0.5*hd*value/static_cast<ScalarType>(nc);
+
+    ierr = this->EvaluateConditionalEntropy(&midistance, p_mt); CHKERRQ(ierr);
+    ierr = RestoreRawPointer(this->m_TemplateImage, &p_mt); CHKERRQ(ierr);
+
+    this->m_Opt->m_Distance.scale = midistance > 0.0 ? l2distance/midistance : 1.0;
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief evaluate the functional (i.e., the distance measure)
+ * D = scale (H(m1,mR) - H(m1)) = scale (H(mR) - MI(m1,mR))
+ *******************************************************************/
+PetscErrorCode DistanceMeasureMI::EvaluateFunctional(ScalarType* D) {
+    PetscErrorCode ierr = 0;
+    ScalarType *p_m = NULL;
+    IntType nt, nc, nl;
+    ScalarType value;
+
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    ierr = Assert(this->m_StateVariable != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_ReferenceImage != NULL, "null pointer"); CHKERRQ(ierr);
+
+    nt = this->m_Opt->m_Domain.nt;
+    nc = this->m_Opt->m_Domain.nc;
+    nl = this->m_Opt->m_Domain.nl;
+
+    ierr = GetRawPointer(this->m_StateVariable, &p_m); CHKERRQ(ierr);
+    ierr = this->EvaluateConditionalEntropy(&value, &p_m[nt*nc*nl]); CHKERRQ(ierr);
+    ierr = RestoreRawPointer(this->m_StateVariable, &p_m); CHKERRQ(ierr);
+
+    *D = this->m_Opt->m_Distance.scale*value;
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief set final condition for adjoint equation
+ * lambda = -(1/hd) dD/dm1 = scale/(nc hd) dMI/dm1 with
+ * dMI/dm1(x) = w(x)/Z sum_ab d_m K(a - t(m1(x))) K(b - t(mR(x))) log(p(a,b)/p(a))
+ *******************************************************************/
+PetscErrorCode DistanceMeasureMI::SetFinalConditionAE() {
+    PetscErrorCode ierr = 0;
+    IntType nl, nc, nt, l, ll, nb2;
+    ScalarType *p_mr = NULL, *p_m = NULL, *p_l = NULL, *p_w = NULL;
+    ScalarType hd, scale, c, value, lom, dvm, lor, dvr;
+    int nb;
+
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    ierr = Assert(this->m_ReferenceImage != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_StateVariable != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_AdjointVariable != NULL, "null pointer"); CHKERRQ(ierr);
+
+    nt = this->m_Opt->m_Domain.nt;
+    nc = this->m_Opt->m_Domain.nc;
+    nl = this->m_Opt->m_Domain.nl;
+    hd = this->m_Opt->GetLebesgueMeasure();
+    scale = this->m_Opt->m_Distance.scale;
+
+    // index for final condition
+    if (this->m_Opt->m_OptPara.method == FULLNEWTON) {
+        ll = nt*nc*nl;
+    } else {
+        ll = 0;
+    }
+    l = nt*nc*nl;
+
+    ierr = GetRawPointer(this->m_StateVariable, &p_m); CHKERRQ(ierr);
+
+    // set up joint pdf and log ratio for current state
+    ierr = this->EvaluateConditionalEntropy(&value, &p_m[l]); CHKERRQ(ierr);
+
+    nb = this->m_NumBins;
+    nb2 = nb*nb + 1;
+    lom = this->m_Range[0];
+    dvm = (this->m_Range[1] - this->m_Range[0])/static_cast<ScalarType>(nb - 4);
+    lor = this->m_Range[2];
+    dvr = (this->m_Range[3] - this->m_Range[2])/static_cast<ScalarType>(nb - 4);
+    c = scale/(static_cast<ScalarType>(nc)*hd);
+
+    ierr = GetRawPointer(this->m_ReferenceImage, &p_mr); CHKERRQ(ierr);
+    ierr = GetRawPointer(this->m_AdjointVariable, &p_l); CHKERRQ(ierr);
+    if (this->m_Mask != NULL) {
+        ierr = GetRawPointer(this->m_Mask, &p_w); CHKERRQ(ierr);
+    }
+
+    for (IntType k = 0; k < nc; ++k) {
+        const double* logr = &this->m_LogRatio[k*nb2];
+        const double z = 1.0/this->m_JointPDF[k*nb2 + nb2 - 1];
+#pragma omp parallel for
+        for (IntType i = 0; i < nl; ++i) {
+            int im, ir;
+            ScalarType wm[4], dwm[4], wr[4];
+            double g = 0.0;
+            ParzenWindow(p_m[l+k*nl+i], lom, dvm, nb, im, wm, dwm, NULL);
+            ParzenWindow(p_mr[k*nl+i], lor, dvr, nb, ir, wr, NULL, NULL);
+            for (int a = 0; a < 4; ++a) {
+                const double* row = &logr[(im + a)*nb + ir];
+                for (int b = 0; b < 4; ++b) {
+                    g += dwm[a]*wr[b]*row[b];
+                }
+            }
+            p_l[ll+k*nl+i] = c*(p_w != NULL ? p_w[i] : 1.0)*static_cast<ScalarType>(z*g);
+        }
+    }
+
+    if (this->m_Mask != NULL) {
+        ierr = RestoreRawPointer(this->m_Mask, &p_w); CHKERRQ(ierr);
+    }
+    ierr = RestoreRawPointer(this->m_AdjointVariable, &p_l); CHKERRQ(ierr);
+    ierr = RestoreRawPointer(this->m_ReferenceImage, &p_mr); CHKERRQ(ierr);
+    ierr = RestoreRawPointer(this->m_StateVariable, &p_m); CHKERRQ(ierr);
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief set final condition for incremental adjoint equation;
+ * the second variation of MI consists of a pointwise term h mtilde,
+ * h = w/Z sum_ab d_mm K(a - t(m1)) K(b - t(mR)) log(p(a,b)/p(a)),
+ * and a coupling term through the histogram,
+ * w/Z sum_ab d_m K(a - t(m1)) K(b - t(mR)) (ptilde(a,b)/p(a,b) - ptilde(a)/p(a)),
+ * where ptilde is the directional derivative of p; the conditional
+ * entropy is concave in p, i.e., the coupling term is negative
+ * definite; for the Gauss-Newton approximation we drop it and only
+ * keep the non-negative part of the pointwise curvature
+ *******************************************************************/
+PetscErrorCode DistanceMeasureMI::SetFinalConditionIAE() {
+    PetscErrorCode ierr = 0;
+    IntType nt, nc, nl, ll, l, nb2;
+    ScalarType *p_m = NULL, *p_mr = NULL, *p_mtilde = NULL,
+                *p_ltilde = NULL, *p_w = NULL;
+    ScalarType hd, scale, c, value, lom, dvm, lor, dvr;
+    bool fullnewton;
+    int nb;
+    const double eps = 1E-12;
+
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    ierr = Assert(this->m_IncAdjointVariable != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_IncStateVariable != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_StateVariable != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_ReferenceImage != NULL, "null pointer"); CHKERRQ(ierr);
+
+    nt = this->m_Opt->m_Domain.nt;
+    nc = this->m_Opt->m_Domain.nc;
+    nl = this->m_Opt->m_Domain.nl;
+    hd = this->m_Opt->GetLebesgueMeasure();
+    scale = this->m_Opt->m_Distance.scale;
+
+    // index for final condition
+    fullnewton = this->m_Opt->m_OptPara.method == FULLNEWTON;
+    if (fullnewton) {
+        ll = nt*nc*nl;
+    } else {
+        ll = 0;
+    }
+    l = nt*nc*nl;
+
+    ierr = GetRawPointer(this->m_StateVariable, &p_m); CHKERRQ(ierr);
+    ierr = GetRawPointer(this->m_ReferenceImage, &p_mr); CHKERRQ(ierr);
+    ierr = GetRawPointer(this->m_IncStateVariable, &p_mtilde); CHKERRQ(ierr);
+    ierr = GetRawPointer(this->m_IncAdjointVariable, &p_ltilde); CHKERRQ(ierr);
+    if (this->m_Mask != NULL) {
+        ierr = GetRawPointer(this->m_Mask, &p_w); CHKERRQ(ierr);
+    }
+
+    // joint pdf and log ratio for current state
+    ierr = this->EvaluateConditionalEntropy(&value, &p_m[l]); CHKERRQ(ierr);
+
+    nb = this->m_NumBins;
+    nb2 = nb*nb + 1;
+
+    if (fullnewton) {
+        // histogram of directional derivative; overwrite with
+        // ptilde(a,b)/p(a,b) - ptilde(a)/p(a)
+        ierr = this->ComputeJointHistogram(this->m_JointPDFTilde, &p_m[l], p_mr, p_w, &p_mtilde[ll]); CHKERRQ(ierr);
+        for (IntType k = 0; k < nc; ++k) {
+            const double* p = &this->m_JointPDF[k*nb2];
+            double* pt = &this->m_JointPDFTilde[k*nb2];
+            for (int a = 0; a < nb; ++a) {
+                double pa = 0.0, pta = 0.0;
+                for (int b = 0; b < nb; ++b) {
+                    pa += p[a*nb + b];
+                    pta += pt[a*nb + b];
+                }
+                for (int b = 0; b < nb; ++b) {
+                    double pab = p[a*nb + b];
+                    pt[a*nb + b] = (pab > eps && pa > eps) ? pt[a*nb + b]/pab - pta/pa : 0.0;
+                }
+            }
+        }
+    }
+
+    lom = this->m_Range[0];
+    dvm = (this->m_Range[1] - this->m_Range[0])/static_cast<ScalarType>(nb - 4);
+    lor = this->m_Range[2];
+    dvr = (this->m_Range[3] - this->m_Range[2])/static_cast<ScalarType>(nb - 4);
+    c = scale/(static_cast<ScalarType>(nc)*hd);
+
+    for (IntType k = 0; k < nc; ++k) {
+        const double* logr = &this->m_LogRatio[k*nb2];
+        const double* dlogr = &this->m_JointPDFTilde[k*nb2];
+        const double z = 1.0/this->m_JointPDF[k*nb2 + nb2 - 1];
+#pragma omp parallel for
+        for (IntType i = 0; i < nl; ++i) {
+            int im, ir;
+            ScalarType wm[4], dwm[4], ddwm[4], wr[4];
+            double h = 0.0, dg = 0.0;
+            ParzenWindow(p_m[l+k*nl+i], lom, dvm, nb, im, wm, dwm, ddwm);
+            ParzenWindow(p_mr[k*nl+i], lor, dvr, nb, ir, wr, NULL, NULL);
+            for (int a = 0; a < 4; ++a) {
+                const IntType j = (im + a)*nb + ir;
+                for (int b = 0; b < 4; ++b) {
+                    h += ddwm[a]*wr[b]*logr[j + b];
+                    if (fullnewton) dg += dwm[a]*wr[b]*dlogr[j + b];
+                }
+            }
+            if (!fullnewton) h = PetscMin(h, 0.0);
+            p_ltilde[ll+k*nl+i] = c*(p_w != NULL ? p_w[i] : 1.0)
+                                * static_cast<ScalarType>(z*(h*p_mtilde[ll+k*nl+i] + dg));
+        }
+    }
+
+    if (this->m_Mask != NULL) {
+        ierr = RestoreRawPointer(this->m_Mask, &p_w); CHKERRQ(ierr);
+    }
+    ierr = RestoreRawPointer(this->m_IncAdjointVariable, &p_ltilde); CHKERRQ(ierr);
+    ierr = RestoreRawPointer(this->m_IncStateVariable, &p_mtilde); CHKERRQ(ierr);
+    ierr = RestoreRawPointer(this->m_ReferenceImage, &p_mr); CHKERRQ(ierr);
+    ierr = RestoreRawPointer(this->m_StateVariable, &p_m); CHKERRQ(ierr);
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+}  // namespace reg
+
+
+
+
+#endif  // _DISTANCEMEASUREMI_CPP_
@@ -34,6 +34,7 @@ namespace reg {
  * @brief default constructor
  *******************************************************************/
 DistanceMeasureNCC::DistanceMeasureNCC() : SuperClass() {
+    this->m_Value = NULL;
 }
 
 
@@ -53,6 +54,7 @@ DistanceMeasureNCC::~DistanceMeasureNCC() {
  * @brief constructor
  *******************************************************************/
 DistanceMeasureNCC::DistanceMeasureNCC(RegOpt* opt) : SuperClass(opt) {
+    this->m_Value = NULL;
 }
 
 
@@ -81,7 +83,6 @@ PetscErrorCode DistanceMeasureNCC::SetupScale(){
     IntType nt, nc, nl, l;
     ScalarType norm_l2_loc, norm_mT_loc, norm_mR_loc, inpr_mT_mR_loc, 
 	       norm_l2, norm_mT, norm_mR, inpr_mT_mR, mTi, mRi;
-    int rval;
     ScalarType l2distance, nccdistance, hd;
 
     PetscFunctionBegin;
@@ -138,17 +139,11 @@ PetscErrorCode DistanceMeasureNCC::SetupScale(){
         }
     }
     // All reduce the pieces
-    rval = MPI_Allreduce(&norm_l2_loc, &norm_l2, 1, MPIU_REAL, MPI_SUM, PETSC_COMM_WORLD);
-    ierr = Assert(rval == MPI_SUCCESS, "mpi error"); CHKERRQ(ierr);
-
-    rval = MPI_Allreduce(&norm_mT_loc, &norm_mT, 1, MPIU_REAL, MPI_SUM, PETSC_COMM_WORLD);
-    ierr = Assert(rval == MPI_SUCCESS, "mpi error"); CHKERRQ(ierr);
-
-    rval = MPI_Allreduce(&norm_mR_loc, &norm_mR, 1, MPIU_REAL, MPI_SUM, PETSC_COMM_WORLD);
-    ierr = Assert(rval == MPI_SUCCESS, "mpi error"); CHKERRQ(ierr);
-
-    rval = MPI_Allreduce(&inpr_mT_mR_loc, &inpr_mT_mR, 1, MPIU_REAL, MPI_SUM, PETSC_COMM_WORLD);
-    ierr = Assert(rval == MPI_SUCCESS, "mpi error"); CHKERRQ(ierr);
+    ierr = this->m_Opt->m_Reduction.Add(norm_l2_loc, &norm_l2); CHKERRQ(ierr);
+    ierr = this->m_Opt->m_Reduction.Add(norm_mT_loc, &norm_mT); CHKERRQ(ierr);
+    ierr = this->m_Opt->m_Reduction.Add(norm_mR_loc, &norm_mR); CHKERRQ(ierr);
+    ierr = this->m_Opt->m_Reduction.Add(inpr_mT_mR_loc, &inpr_mT_mR); CHKERRQ(ierr);
+    ierr = this->m_Opt->m_Reduction.Reduce(); CHKERRQ(ierr);
     
     ierr = RestoreRawPointer(this->m_ReferenceImage, &p_mr); CHKERRQ(ierr);
     ierr = RestoreRawPointer(this->m_TemplateImage, &p_mt); CHKERRQ(ierr);
@@ -172,10 +167,7 @@ PetscErrorCode DistanceMeasureNCC::EvaluateFunctional(ScalarType* D) {
     PetscErrorCode ierr = 0;
     ScalarType *p_mr = NULL, *p_m = NULL, *p_w = NULL;
     IntType nt, nc, nl, l;
-    ScalarType norm_m1_loc, norm_mR_loc, inpr_m1_mR_loc, 
-	       norm_m1, norm_mR, inpr_m1_mR,
-               m1i, mRi, scale;
-    int rval;
+    ScalarType norm_m1_loc, norm_mR_loc, inpr_m1_mR_loc, m1i, mRi;
 
     PetscFunctionBegin;
 
@@ -188,7 +180,6 @@ PetscErrorCode DistanceMeasureNCC::EvaluateFunctional(ScalarType* D) {
     nt = this->m_Opt->m_Domain.nt;
     nc = this->m_Opt->m_Domain.nc;
     nl = this->m_Opt->m_Domain.nl;
-    scale = this->m_Opt->m_Distance.scale;
 
     ierr = GetRawPointer(this->m_StateVariable, &p_m); CHKERRQ(ierr);
     ierr = GetRawPointer(this->m_ReferenceImage, &p_mr); CHKERRQ(ierr);
@@ -219,22 +210,17 @@ PetscErrorCode DistanceMeasureNCC::EvaluateFunctional(ScalarType* D) {
                 inpr_m1_mR_loc += (m1i*mRi);
         }
     }
-    // All reduce various pieces
-    rval = MPI_Allreduce(&norm_m1_loc, &norm_m1, 1, MPIU_REAL, MPI_SUM, PETSC_COMM_WORLD);
-    ierr = Assert(rval == MPI_SUCCESS, "mpi error"); CHKERRQ(ierr);
-
-    rval = MPI_Allreduce(&norm_mR_loc, &norm_mR, 1, MPIU_REAL, MPI_SUM, PETSC_COMM_WORLD);
-    ierr = Assert(rval == MPI_SUCCESS, "mpi error"); CHKERRQ(ierr);
-
-    rval = MPI_Allreduce(&inpr_m1_mR_loc, &inpr_m1_mR, 1, MPIU_REAL, MPI_SUM, PETSC_COMM_WORLD);
-    ierr = Assert(rval == MPI_SUCCESS, "mpi error"); CHKERRQ(ierr);
-
     ierr = RestoreRawPointer(this->m_ReferenceImage, &p_mr); CHKERRQ(ierr);
     ierr = RestoreRawPointer(this->m_StateVariable, &p_m); CHKERRQ(ierr);
 
-    // Objective value
-    *D = scale*(0.5 - 0.5*(inpr_m1_mR*inpr_m1_mR)/(norm_m1*norm_mR));
-//    printf("scale = %f \n", *D);
+    // All reduce various pieces in one go; the objective value is set
+    // in FinalizeReduction
+    this->m_Value = D;
+    ierr = this->m_Opt->m_Reduction.Add(norm_m1_loc, &this->m_Sum[0]); CHKERRQ(ierr);
+    ierr = this->m_Opt->m_Reduction.Add(norm_mR_loc, &this->m_Sum[1]); CHKERRQ(ierr);
+    ierr = this->m_Opt->m_Reduction.Add(inpr_m1_mR_loc, &this->m_Sum[2]); CHKERRQ(ierr);
+    ierr = this->m_Opt->m_Reduction.AddCallback(this); CHKERRQ(ierr);
+    ierr = this->m_Opt->m_Reduction.Flush(); CHKERRQ(ierr);
 
     this->m_Opt->Exit(__func__);
 
@@ -244,6 +230,30 @@ PetscErrorCode DistanceMeasureNCC::EvaluateFunctional(ScalarType* D) {
 
 
 
+/********************************************************************
+ * @brief evaluate the functional from the reduced sums
+ * D = scale*(0.5 - 0.5*<m1,mR>^2/(||m1||^2 ||mR||^2))
+ *******************************************************************/
+PetscErrorCode DistanceMeasureNCC::FinalizeReduction() {
+    PetscErrorCode ierr = 0;
+    ScalarType scale;
+
+    PetscFunctionBegin;
+
+    ierr = Assert(this->m_Value != NULL, "null pointer"); CHKERRQ(ierr);
+
+    scale = this->m_Opt->m_Distance.scale;
+
+    // Objective value
+    *this->m_Value = scale*(0.5 - 0.5*(this->m_Sum[2]*this->m_Sum[2])/(this->m_Sum[0]*this->m_Sum[1]));
+    this->m_Value = NULL;
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
 /********************************************************************
  * @brief set final condition for adjoint equation
  * (varies for different distance measures)
@@ -251,7 +261,6 @@ PetscErrorCode DistanceMeasureNCC::EvaluateFunctional(ScalarType* D) {
 PetscErrorCode DistanceMeasureNCC::SetFinalConditionAE() {
     PetscErrorCode ierr = 0;
     IntType nl, nc, nt, l, ll;
-    int rval;
     ScalarType *p_mr = NULL, *p_m = NULL, *p_l = NULL, *p_w = NULL;
     ScalarType norm_m1_loc, norm_mR_loc, inpr_m1_mR_loc, norm_m1, norm_mR, inpr_m1_mR;
     ScalarType const1, const2, m1i, mRi, hd, scale;
@@ -314,14 +323,10 @@ PetscErrorCode DistanceMeasureNCC::SetFinalConditionAE() {
     }
 
     // All reduce for full inner products
-    rval = MPI_Allreduce(&norm_m1_loc, &norm_m1, 1, MPIU_REAL, MPI_SUM, PETSC_COMM_WORLD);
-    ierr = Assert(rval == MPI_SUCCESS, "mpi error"); CHKERRQ(ierr);
-
-    rval = MPI_Allreduce(&norm_mR_loc, &norm_mR, 1, MPIU_REAL, MPI_SUM, PETSC_COMM_WORLD);
-    ierr = Assert(rval == MPI_SUCCESS, "mpi error"); CHKERRQ(ierr);
-
-    rval = MPI_Allreduce(&inpr_m1_mR_loc, &inpr_m1_mR, 1, MPIU_REAL, MPI_SUM, PETSC_COMM_WORLD);
-    ierr = Assert(rval == MPI_SUCCESS, "mpi error"); CHKERRQ(ierr);
+    ierr = this->m_Opt->m_Reduction.Add(norm_m1_loc, &norm_m1); CHKERRQ(ierr);
+    ierr = this->m_Opt->m_Reduction.Add(norm_mR_loc, &norm_mR); CHKERRQ(ierr);
+    ierr = this->m_Opt->m_Reduction.Add(inpr_m1_mR_loc, &inpr_m1_mR); CHKERRQ(ierr);
+    ierr = this->m_Opt->m_Reduction.Reduce(); CHKERRQ(ierr);
 
     // Now, write the terminal condition to lambda
     const1 = scale*inpr_m1_mR/(hd*norm_m1*norm_mR);
@@ -368,7 +373,6 @@ PetscErrorCode DistanceMeasureNCC::SetFinalConditionAE() {
 PetscErrorCode DistanceMeasureNCC::SetFinalConditionIAE() {
     PetscErrorCode ierr = 0;
     IntType nt, nc, nl, ll, l;
-    int rval;
     ScalarType *p_m = NULL, *p_mr = NULL, *p_mtilde = NULL,
                 *p_ltilde = NULL, *p_w = NULL;
     ScalarType const1, const2, const3, const4, const5, hd, scale;
@@ -447,20 +451,12 @@ PetscErrorCode DistanceMeasureNCC::SetFinalConditionIAE() {
     }
 
     // All reduce for full inner products
-    rval = MPI_Allreduce(&norm_m1_loc, &norm_m1, 1, MPIU_REAL, MPI_SUM, PETSC_COMM_WORLD);
-    ierr = Assert(rval == MPI_SUCCESS, "mpi error"); CHKERRQ(ierr);
-
-    rval = MPI_Allreduce(&norm_mR_loc, &norm_mR, 1, MPIU_REAL, MPI_SUM, PETSC_COMM_WORLD);
-    ierr = Assert(rval == MPI_SUCCESS, "mpi error"); CHKERRQ(ierr);
-
-    rval = MPI_Allreduce(&inpr_m1_mR_loc, &inpr_m1_mR, 1, MPIU_REAL, MPI_SUM, PETSC_COMM_WORLD);
-    ierr = Assert(rval == MPI_SUCCESS, "mpi error"); CHKERRQ(ierr);
-
-    rval = MPI_Allreduce(&inpr_m1_mtilde_loc, &inpr_m1_mtilde, 1, MPIU_REAL, MPI_SUM, PETSC_COMM_WORLD);
-    ierr = Assert(rval == MPI_SUCCESS, "mpi error"); CHKERRQ(ierr);
-
-    rval = MPI_Allreduce(&inpr_mR_mtilde_loc, &inpr_mR_mtilde, 1, MPIU_REAL, MPI_SUM, PETSC_COMM_WORLD);
-    ierr = Assert(rval == MPI_SUCCESS, "mpi error"); CHKERRQ(ierr);
+    ierr = this->m_Opt->m_Reduction.Add(norm_m1_loc, &norm_m1); CHKERRQ(ierr);
+    ierr = this->m_Opt->m_Reduction.Add(norm_mR_loc, &norm_mR); CHKERRQ(ierr);
+    ierr = this->m_Opt->m_Reduction.Add(inpr_m1_mR_loc, &inpr_m1_mR); CHKERRQ(ierr);
+    ierr = this->m_Opt->m_Reduction.Add(inpr_m1_mtilde_loc, &inpr_m1_mtilde); CHKERRQ(ierr);
+    ierr = this->m_Opt->m_Reduction.Add(inpr_mR_mtilde_loc, &inpr_mR_mtilde); CHKERRQ(ierr);
+    ierr = this->m_Opt->m_Reduction.Reduce(); CHKERRQ(ierr);
 
     // Now, write the terminal condition to lambda tilde
     const1 = scale*inpr_mR_mtilde/(hd*norm_m1*norm_mR);
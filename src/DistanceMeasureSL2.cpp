@@ -94,8 +94,7 @@ PetscErrorCode DistanceMeasureSL2::EvaluateFunctional(ScalarType* D) {
     PetscErrorCode ierr = 0;
     ScalarType *p_mr = NULL, *p_m = NULL, *p_w = NULL;
     IntType nt, nc, nl, l;
-    int rval;
-    ScalarType dr, value, l2distance, hx;
+    ScalarType dr, value, hx;
 
     PetscFunctionBegin;
 
@@ -131,15 +130,12 @@ PetscErrorCode DistanceMeasureSL2::EvaluateFunctional(ScalarType* D) {
             value += dr*dr;
         }
     }
-    // all reduce
-    rval = MPI_Allreduce(&value, &l2distance, 1, MPIU_REAL, MPI_SUM, PETSC_COMM_WORLD);
-    ierr = Assert(rval == MPI_SUCCESS, "mpi error"); CHKERRQ(ierr);
-
     ierr = RestoreRawPointer(this->m_ReferenceImage, &p_mr); CHKERRQ(ierr);
     ierr = RestoreRawPointer(this->m_StateVariable, &p_m); CHKERRQ(ierr);
 
-    // objective value
-    *D = 0.5*hx*l2distance/static_cast<ScalarType>(nc);
+    // objective value; all reduce
+    ierr = this->m_Opt->m_Reduction.Add(value, D, 0.5*hx/static_cast<ScalarType>(nc)); CHKERRQ(ierr);
+    ierr = this->m_Opt->m_Reduction.Flush(); CHKERRQ(ierr);
 
     this->m_Opt->Exit(__func__);
 
@@ -80,8 +80,7 @@ PetscErrorCode DistanceMeasureSL2aux::EvaluateFunctional(ScalarType* D) {
     PetscErrorCode ierr = 0;
     ScalarType *p_mr = NULL, *p_m = NULL, *p_q = NULL, *p_c = NULL;
     IntType nt, nc, nl, l;
-    int rval;
-    ScalarType dr, value, val1, val2, l2distance, hx;
+    ScalarType dr, val1, val2, hx;
 
     PetscFunctionBegin;
 
@@ -102,7 +101,7 @@ PetscErrorCode DistanceMeasureSL2aux::EvaluateFunctional(ScalarType* D) {
     ierr = VecGetArray(this->m_ReferenceImage, &p_mr); CHKERRQ(ierr);
 
     l = nt*nl*nc;
-    value = 0.0, val1 = 0.0, val2 = 0.0;
+    val1 = 0.0, val2 = 0.0;
     ierr = VecGetArray(this->m_AuxVar1, &p_c); CHKERRQ(ierr);
     ierr = VecGetArray(this->m_AuxVar2, &p_q); CHKERRQ(ierr);
     for (IntType k = 0; k < nc; ++k) {  // for all image components
@@ -117,22 +116,14 @@ PetscErrorCode DistanceMeasureSL2aux::EvaluateFunctional(ScalarType* D) {
     ierr = VecRestoreArray(this->m_AuxVar2, &p_q); CHKERRQ(ierr);
     ierr = VecRestoreArray(this->m_AuxVar1, &p_c); CHKERRQ(ierr);
 
-    // all reduce
-    rval = MPI_Allreduce(&val1, &value, 1, MPIU_REAL, MPI_SUM, PETSC_COMM_WORLD);
-    ierr = Assert(rval == MPI_SUCCESS, "mpi error"); CHKERRQ(ierr);
-    l2distance  = value;
-
-    rval = MPI_Allreduce(&val2, &value, 1, MPIU_REAL, MPI_SUM, PETSC_COMM_WORLD);
-    ierr = Assert(rval == MPI_SUCCESS, "mpi error"); CHKERRQ(ierr);
-    l2distance += value;
-    // parse value to registration monitor for display
-    this->m_Opt->m_Monitor.qmval = value;
-
     ierr = VecRestoreArray(this->m_ReferenceImage, &p_mr); CHKERRQ(ierr);
     ierr = VecRestoreArray(this->m_StateVariable, &p_m); CHKERRQ(ierr);
 
-    // objective value
-    *D = 0.5*hx*l2distance/static_cast<ScalarType>(nc);
+    // objective value; all reduce;
+    // parse q^k*m^k to registration monitor for display
+    ierr = this->m_Opt->m_Reduction.Add(val1 + val2, D, 0.5*hx/static_cast<ScalarType>(nc)); CHKERRQ(ierr);
+    ierr = this->m_Opt->m_Reduction.Add(val2, &this->m_Opt->m_Monitor.qmval); CHKERRQ(ierr);
+    ierr = this->m_Opt->m_Reduction.Flush(); CHKERRQ(ierr);
 
     this->m_Opt->Exit(__func__);
 
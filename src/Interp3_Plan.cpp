@@ -1,6 +1,8 @@
 
 
 #include <interp3.hpp>
+#include "CommCounter.hpp"
+#include "PerfCounter.hpp"
 #include <string.h>
 #include <stdlib.h>
 #include <vector>
@@ -621,6 +623,25 @@ void Interp3_Plan::fast_scatter(int* N_reg, int * isize, int* istart,
 				if (s_request[proc] != MPI_REQUEST_NULL)
 					MPI_Wait(&s_request[proc], MPI_STATUS_IGNORE);
      }
+			{
+				double nsent = 0, nrecv = 0;
+				int nsend = 0, nrecvmsg = 0;
+				std::set<int> peers;
+				for (int i = 0; i < procs_i_send_to_size_; ++i) {
+					int proc = procs_i_send_to_[i];
+					if (proc == procid) continue;
+					nsent += f_index_procs_self_sizes[proc];
+					++nsend; peers.insert(proc);
+				}
+				for (int i = 0; i < procs_i_recv_from_size_; ++i) {
+					int proc = procs_i_recv_from_[i];
+					if (proc == procid) continue;
+					nrecv += f_index_procs_others_sizes[proc];
+					++nrecvmsg; peers.insert(proc);
+				}
+				reg::CommCounter::Add(reg::COMMSCATTER, nsent * COORD_DIM * sizeof(Real),
+						nrecv * COORD_DIM * sizeof(Real), nsend, nrecvmsg, static_cast<int>(peers.size()));
+			}
 			//for (int i = 0; i < nprocs; ++i) {
 			//	dst_r = i;    //(procid+i)%nprocs;
 			//	dst_s = i;    //(procid-i+nprocs)%nprocs;
@@ -698,7 +719,8 @@ void Interp3_Plan::fast_scatter(int* N_reg, int * isize, int* istart,
  */
 void Interp3_Plan::interpolate(Real* __restrict ghost_reg_grid_vals,
 		int*__restrict N_reg, int *__restrict isize, int*__restrict istart, const int N_pts, const int g_size,
-		Real*__restrict query_values, int*__restrict c_dims, MPI_Comm c_comm, double *__restrict timings, int version) {
+		Real*__restrict query_values, int*__restrict c_dims, MPI_Comm c_comm, double *__restrict timings, int version,
+		int interp_order) {
 	int nprocs, procid;
 	MPI_Comm_rank(c_comm, &procid);
 	MPI_Comm_size(c_comm, &nprocs);
@@ -717,6 +739,22 @@ void Interp3_Plan::interpolate(Real* __restrict ghost_reg_grid_vals,
 	}
 
 	timings[1] += -MPI_Wtime();
+  reg::PerfCounter::Start(reg::PERFINTERP);
+  bool use_linear = (interp_order == 1);
+#ifdef INTERP_USE_MORE_MEM_L1
+  // query points are stored with precomputed cubic stencil offsets
+  use_linear = false;
+#endif
+  if (use_linear) {
+    // linear interpolation (cheap, low accuracy; the ghost layer
+    // is the same as for the cubic kernel)
+    const int N_reg3 = isize_g[0] * isize_g[1] * isize_g[2];
+    if(total_query_points!=0)
+      for (int k = 0; k < data_dofs_[version]; ++k)
+        lin_interp3_ghost_xyz_p(&ghost_reg_grid_vals[k*N_reg3], 1, N_reg, N_reg_g, isize_g,
+            istart, total_query_points, g_size, &all_query_points[0], &all_f_cubic[k*total_query_points],
+            true);
+  } else {
 #ifdef FAST_INTERP
 #ifdef FAST_INTERPV
   const int N_reg3 = isize_g[0] * isize_g[1] * isize_g[2];
@@ -747,6 +785,8 @@ void Interp3_Plan::interpolate(Real* __restrict ghost_reg_grid_vals,
 			istart, total_query_points, g_size, &all_query_points[0], &all_f_cubic[0],
 			true);
 #endif
+  }
+  reg::PerfCounter::Stop(reg::PERFINTERP);
 	timings[1] += +MPI_Wtime();
 
 	// Now we have to do an alltoall to distribute the interpolated data from all_f_cubic to
@@ -800,6 +840,26 @@ void Interp3_Plan::interpolate(Real* __restrict ghost_reg_grid_vals,
 				if (s_request[proc] != MPI_REQUEST_NULL)
 					MPI_Wait(&s_request[proc], MPI_STATUS_IGNORE);
      }
+		{
+			// values flow in the opposite direction of the query points
+			double nsent = 0, nrecv = 0;
+			int nsend = 0, nrecvmsg = 0;
+			std::set<int> peers;
+			for (int i = 0; i < procs_i_recv_from_size_; ++i) {
+				int proc = procs_i_recv_from_[i];
+				if (proc == procid) continue;
+				nsent += f_index_procs_others_sizes[proc];
+				++nsend; peers.insert(proc);
+			}
+			for (int i = 0; i < procs_i_send_to_size_; ++i) {
+				int proc = procs_i_send_to_[i];
+				if (proc == procid) continue;
+				nrecv += f_index_procs_self_sizes[proc];
+				++nrecvmsg; peers.insert(proc);
+			}
+			reg::CommCounter::Add(reg::COMMVALUES, nsent * data_dofs_[version] * sizeof(Real),
+					nrecv * data_dofs_[version] * sizeof(Real), nsend, nrecvmsg, static_cast<int>(peers.size()));
+		}
 
 		// for (int i = 0; i < nprocs; ++i) {
 		//	dst_r = (procid+i)%nprocs;
@@ -1191,6 +1251,18 @@ void Interp3_Plan::scatter(int* N_reg, int * isize, int* istart,
 			}
 		}
 		timings[0] += +MPI_Wtime();
+		{
+			double nsent = 0, nrecv = 0;
+			int nsend = 0, nrecvmsg = 0, npeers = 0;
+			for (int proc = 0; proc < nprocs; ++proc) {
+				if (proc == procid) continue;
+				if (f_index_procs_self_sizes[proc] != 0) {nsent += f_index_procs_self_sizes[proc]; ++nsend;}
+				if (f_index_procs_others_sizes[proc] != 0) {nrecv += f_index_procs_others_sizes[proc]; ++nrecvmsg;}
+				if (f_index_procs_self_sizes[proc] != 0 || f_index_procs_others_sizes[proc] != 0) ++npeers;
+			}
+			reg::CommCounter::Add(reg::COMMSCATTER, nsent * COORD_DIM * sizeof(Real),
+					nrecv * COORD_DIM * sizeof(Real), nsend, nrecvmsg, npeers);
+		}
 	}
 
   for(int ver = 0; ver < nplans_; ++ver){
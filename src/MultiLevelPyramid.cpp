@@ -396,7 +396,8 @@ PetscErrorCode MultiLevelPyramid::DoSetup(Vec x) {
         // get pointer to level
         ierr = this->GetData(&xlevel, l); CHKERRQ(ierr);
         ierr = Assert(*xlevel != NULL, "null pointer"); CHKERRQ(ierr);
-        // restrict data
+        // restrict data (the spectrum of x is only computed once and
+        // reused for all levels; so is the fft plan on the fine grid)
         ierr = this->m_PreProc->Restrict(xlevel, x, nxlevel, nx); CHKERRQ(ierr);
     }
 
@@ -83,6 +83,20 @@ PetscErrorCode Optimizer::Initialize(void) {
     this->m_KrylovMethod = NULL;
     this->m_OptimizationProblem = NULL;
 
+    this->m_LBFGS.m = 0;
+    this->m_LBFGS.n = 0;
+    this->m_LBFGS.head = 0;
+    this->m_LBFGS.iter = -1;
+    this->m_LBFGS.gamma = 1.0;
+    this->m_LBFGS.rho = NULL;
+    this->m_LBFGS.alpha = NULL;
+    this->m_LBFGS.s = NULL;
+    this->m_LBFGS.y = NULL;
+    this->m_LBFGS.xold = NULL;
+    this->m_LBFGS.gold = NULL;
+    this->m_LBFGS.q = NULL;
+    this->m_LBFGS.work = NULL;
+
     PetscFunctionReturn(ierr);
 }
 
@@ -113,6 +127,42 @@ PetscErrorCode Optimizer::ClearMemory(void) {
         this->m_MatVec = NULL;
     }
 
+    // limited memory bfgs
+    for (int i = 0; i < this->m_LBFGS.m; ++i) {
+        if (this->m_LBFGS.s[i] != NULL) {
+            delete this->m_LBFGS.s[i]; this->m_LBFGS.s[i] = NULL;
+        }
+        if (this->m_LBFGS.y[i] != NULL) {
+            delete this->m_LBFGS.y[i]; this->m_LBFGS.y[i] = NULL;
+        }
+    }
+    if (this->m_LBFGS.s != NULL) {
+        delete [] this->m_LBFGS.s; this->m_LBFGS.s = NULL;
+    }
+    if (this->m_LBFGS.y != NULL) {
+        delete [] this->m_LBFGS.y; this->m_LBFGS.y = NULL;
+    }
+    if (this->m_LBFGS.rho != NULL) {
+        delete [] this->m_LBFGS.rho; this->m_LBFGS.rho = NULL;
+    }
+    if (this->m_LBFGS.alpha != NULL) {
+        delete [] this->m_LBFGS.alpha; this->m_LBFGS.alpha = NULL;
+    }
+    if (this->m_LBFGS.xold != NULL) {
+        delete this->m_LBFGS.xold; this->m_LBFGS.xold = NULL;
+    }
+    if (this->m_LBFGS.gold != NULL) {
+        delete this->m_LBFGS.gold; this->m_LBFGS.gold = NULL;
+    }
+    if (this->m_LBFGS.q != NULL) {
+        delete this->m_LBFGS.q; this->m_LBFGS.q = NULL;
+    }
+    if (this->m_LBFGS.work != NULL) {
+        ierr = VecDestroy(&this->m_LBFGS.work); CHKERRQ(ierr);
+        this->m_LBFGS.work = NULL;
+    }
+    this->m_LBFGS.m = 0;
+
     PetscFunctionReturn(ierr);
 }
 
@@ -314,8 +364,11 @@ PetscErrorCode Optimizer::SetupTao() {
 //        ierr = KSPSetNormType(this->m_KrylovMethod,KSP_NORM_PRECONDITIONED); CHKERRQ(ierr);
 //        ierr = KSPSetNormType(this->m_KrylovMethod,KSP_NORM_NATURAL); CHKERRQ(ierr);
 
-        // set the kylov method
-        if (this->m_Opt->m_KrylovMethod.solver == GMRES) {
+        // set the kylov method (for the quasi-newton method we only
+        // apply the approximation of the inverse hessian once)
+        if (this->m_Opt->m_OptPara.method == QUASINEWTON) {
+            ierr = KSPSetType(this->m_KrylovMethod, KSPPREONLY); CHKERRQ(ierr);
+        } else if (this->m_Opt->m_KrylovMethod.solver == GMRES) {
             ierr = KSPSetType(this->m_KrylovMethod, KSPGMRES); CHKERRQ(ierr);
         } else if (this->m_Opt->m_KrylovMethod.solver == PCG) {
             ierr = KSPSetType(this->m_KrylovMethod, KSPCG); CHKERRQ(ierr);
@@ -327,14 +380,16 @@ PetscErrorCode Optimizer::SetupTao() {
             ierr = ThrowError("interface for solver not provided"); CHKERRQ(ierr);
         }
 
-        // apply projection operator to gradient and
-        // solution if needed (two-level preconditioner)
-        ierr = KSPSetPostSolve(this->m_KrylovMethod, PostKrylovSolve, this->m_OptimizationProblem); CHKERRQ(ierr);
-        ierr = KSPSetPreSolve(this->m_KrylovMethod, PreKrylovSolve, this->m_OptimizationProblem); CHKERRQ(ierr);
+        if (this->m_Opt->m_OptPara.method != QUASINEWTON) {
+            // apply projection operator to gradient and
+            // solution if needed (two-level preconditioner)
+            ierr = KSPSetPostSolve(this->m_KrylovMethod, PostKrylovSolve, this->m_OptimizationProblem); CHKERRQ(ierr);
+            ierr = KSPSetPreSolve(this->m_KrylovMethod, PreKrylovSolve, this->m_OptimizationProblem); CHKERRQ(ierr);
 
-        // set krylov monitor
-        if (this->m_Opt->m_Verbosity > 0) {  /// || (this->m_Opt->GetLogger()->IsEnabled(LOGKSPRES))) {
-            ierr = KSPMonitorSet(this->m_KrylovMethod, KrylovMonitor, this->m_OptimizationProblem, NULL); CHKERRQ(ierr);
+            // set krylov monitor
+            if (this->m_Opt->m_Verbosity > 0) {  /// || (this->m_Opt->GetLogger()->IsEnabled(LOGKSPRES))) {
+                ierr = KSPMonitorSet(this->m_KrylovMethod, KrylovMonitor, this->m_OptimizationProblem, NULL); CHKERRQ(ierr);
+            }
         }
 
         // set the preconditioner
@@ -342,7 +397,15 @@ PetscErrorCode Optimizer::SetupTao() {
         ierr = KSPSetFromOptions(this->m_KrylovMethod); CHKERRQ(ierr);
 
         // switch between different preconditioners
-        if (this->m_Opt->m_KrylovMethod.pctype == NOPC) {
+        if (this->m_Opt->m_OptPara.method == QUASINEWTON) {
+            // the "preconditioner" is the limited memory bfgs approximation
+            // of the inverse hessian; the initial hessian is the inverse
+            // of the regularization operator
+            ierr = this->SetupLBFGS(); CHKERRQ(ierr);
+            ierr = PCSetType(preconditioner, PCSHELL); CHKERRQ(ierr);
+            ierr = PCShellSetApply(preconditioner, LBFGSMatVec); CHKERRQ(ierr);
+            ierr = PCShellSetContext(preconditioner, this); CHKERRQ(ierr);
+        } else if (this->m_Opt->m_KrylovMethod.pctype == NOPC) {
             ierr = PCSetType(preconditioner, PCNONE); CHKERRQ(ierr);
         } else {
             ierr = Assert(this->m_Precond != NULL, "null pointer"); CHKERRQ(ierr);
@@ -443,6 +506,255 @@ PetscErrorCode Optimizer::SetupTao() {
 
 
 
+/********************************************************************
+ * @brief allocate memory for limited memory bfgs method; the update
+ * pairs are stored as vector fields
+ *******************************************************************/
+PetscErrorCode Optimizer::SetupLBFGS() {
+    PetscErrorCode ierr = 0;
+    IntType nlu, ngu;
+    int m;
+    PetscFunctionBegin;
+    this->m_Opt->Enter(__func__);
+
+    m = this->m_Opt->m_OptPara.lbfgsmem;
+    ierr = Assert(m > 0, "lbfgs memory < 1"); CHKERRQ(ierr);
+
+    // memory already allocated
+    if (this->m_LBFGS.m == m) {
+        ierr = this->ResetLBFGS(); CHKERRQ(ierr);
+        this->m_Opt->Exit(__func__);
+        PetscFunctionReturn(ierr);
+    }
+    ierr = Assert(this->m_LBFGS.m == 0, "lbfgs memory already allocated"); CHKERRQ(ierr);
+
+    try {
+        this->m_LBFGS.s = new VecField*[m];
+        this->m_LBFGS.y = new VecField*[m];
+        this->m_LBFGS.rho = new ScalarType[m];
+        this->m_LBFGS.alpha = new ScalarType[m];
+    } catch (std::bad_alloc& err) {
+        ierr = reg::ThrowError(err); CHKERRQ(ierr);
+    }
+    for (int i = 0; i < m; ++i) {
+        this->m_LBFGS.s[i] = NULL;
+        this->m_LBFGS.y[i] = NULL;
+    }
+    this->m_LBFGS.m = m;
+
+    for (int i = 0; i < m; ++i) {
+        try {this->m_LBFGS.s[i] = new VecField(this->m_Opt);}
+        catch (std::bad_alloc& err) {
+            ierr = reg::ThrowError(err); CHKERRQ(ierr);
+        }
+        try {this->m_LBFGS.y[i] = new VecField(this->m_Opt);}
+        catch (std::bad_alloc& err) {
+            ierr = reg::ThrowError(err); CHKERRQ(ierr);
+        }
+    }
+    try {this->m_LBFGS.xold = new VecField(this->m_Opt);}
+    catch (std::bad_alloc& err) {
+        ierr = reg::ThrowError(err); CHKERRQ(ierr);
+    }
+    try {this->m_LBFGS.gold = new VecField(this->m_Opt);}
+    catch (std::bad_alloc& err) {
+        ierr = reg::ThrowError(err); CHKERRQ(ierr);
+    }
+    try {this->m_LBFGS.q = new VecField(this->m_Opt);}
+    catch (std::bad_alloc& err) {
+        ierr = reg::ThrowError(err); CHKERRQ(ierr);
+    }
+
+    nlu = 3*this->m_Opt->m_Domain.nl;
+    ngu = 3*this->m_Opt->m_Domain.ng;
+    ierr = VecCreate(this->m_LBFGS.work, nlu, ngu); CHKERRQ(ierr);
+
+    ierr = this->ResetLBFGS(); CHKERRQ(ierr);
+
+    this->m_Opt->Exit(__func__);
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief discard all update pairs stored in the memory of the
+ * limited memory bfgs method
+ *******************************************************************/
+PetscErrorCode Optimizer::ResetLBFGS() {
+    PetscErrorCode ierr = 0;
+    PetscFunctionBegin;
+
+    this->m_LBFGS.n = 0;
+    this->m_LBFGS.head = 0;
+    this->m_LBFGS.iter = -1;
+    this->m_LBFGS.gamma = 1.0;
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief compute inner product of two vector fields; the
+ * reductions for the three components are merged into a
+ * single global reduction
+ *******************************************************************/
+PetscErrorCode Optimizer::Dot(VecField* a, VecField* b, ScalarType& value) {
+    PetscErrorCode ierr = 0;
+    ScalarType value1, value2, value3;
+    PetscFunctionBegin;
+
+    ierr = VecDotBegin(a->m_X1, b->m_X1, &value1); CHKERRQ(ierr);
+    ierr = VecDotBegin(a->m_X2, b->m_X2, &value2); CHKERRQ(ierr);
+    ierr = VecDotBegin(a->m_X3, b->m_X3, &value3); CHKERRQ(ierr);
+    ierr = VecDotEnd(a->m_X1, b->m_X1, &value1); CHKERRQ(ierr);
+    ierr = VecDotEnd(a->m_X2, b->m_X2, &value2); CHKERRQ(ierr);
+    ierr = VecDotEnd(a->m_X3, b->m_X3, &value3); CHKERRQ(ierr);
+
+    value = value1 + value2 + value3;
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief update memory of limited memory bfgs method; we add the
+ * pair (s_k, y_k) once per outer iteration (the iterate and gradient
+ * are taken from tao); pairs that violate the curvature condition
+ * are skipped
+ *******************************************************************/
+PetscErrorCode Optimizer::UpdateLBFGS() {
+    PetscErrorCode ierr = 0;
+    IntType iter;
+    int k;
+    ScalarType sy, yhy;
+    std::stringstream ss;
+    Vec x = NULL, g = NULL;
+    PetscFunctionBegin;
+    this->m_Opt->Enter(__func__);
+
+    ierr = Assert(this->m_Tao != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_LBFGS.m > 0, "lbfgs not set up"); CHKERRQ(ierr);
+
+    ierr = TaoGetSolutionStatus(this->m_Tao, &iter, NULL, NULL, NULL, NULL, NULL); CHKERRQ(ierr);
+
+    // we already updated the memory for this iterate
+    if (iter == this->m_LBFGS.iter) {
+        this->m_Opt->Exit(__func__);
+        PetscFunctionReturn(ierr);
+    }
+
+    ierr = TaoGetSolutionVector(this->m_Tao, &x); CHKERRQ(ierr);
+    ierr = TaoGetGradientVector(this->m_Tao, &g); CHKERRQ(ierr);
+
+    if (this->m_LBFGS.iter != -1) {
+        k = (this->m_LBFGS.head + 1) % this->m_LBFGS.m;
+
+        // s_k = x_{k+1} - x_k and y_k = g_{k+1} - g_k
+        ierr = this->m_LBFGS.s[k]->SetComponents(x); CHKERRQ(ierr);
+        ierr = this->m_LBFGS.s[k]->AXPY(-1.0, this->m_LBFGS.xold); CHKERRQ(ierr);
+        ierr = this->m_LBFGS.y[k]->SetComponents(g); CHKERRQ(ierr);
+        ierr = this->m_LBFGS.y[k]->AXPY(-1.0, this->m_LBFGS.gold); CHKERRQ(ierr);
+
+        ierr = this->Dot(this->m_LBFGS.s[k], this->m_LBFGS.y[k], sy); CHKERRQ(ierr);
+
+        if (sy > 0.0) {
+            // scaling of initial hessian: gamma = s^T y / y^T H0 y
+            ierr = this->m_LBFGS.y[k]->GetComponents(this->m_LBFGS.work); CHKERRQ(ierr);
+            ierr = this->m_OptimizationProblem->ApplyInvRegularizationOperator(this->m_LBFGS.work, this->m_LBFGS.work, false); CHKERRQ(ierr);
+            ierr = this->m_LBFGS.q->SetComponents(this->m_LBFGS.work); CHKERRQ(ierr);
+            ierr = this->Dot(this->m_LBFGS.y[k], this->m_LBFGS.q, yhy); CHKERRQ(ierr);
+            if (yhy > 0.0) this->m_LBFGS.gamma = sy/yhy;
+
+            this->m_LBFGS.rho[k] = 1.0/sy;
+            this->m_LBFGS.head = k;
+            this->m_LBFGS.n = std::min(this->m_LBFGS.n + 1, this->m_LBFGS.m);
+        } else if (this->m_Opt->m_Verbosity > 1) {
+            ss << "lbfgs: curvature condition violated (s^T y = "
+               << std::scientific << sy << "); skipping update";
+            ierr = DbgMsg(ss.str()); CHKERRQ(ierr);
+            ss.str(std::string()); ss.clear();
+        }
+    }
+
+    // store current iterate and gradient
+    ierr = this->m_LBFGS.xold->SetComponents(x); CHKERRQ(ierr);
+    ierr = this->m_LBFGS.gold->SetComponents(g); CHKERRQ(ierr);
+    this->m_LBFGS.iter = iter;
+
+    this->m_Opt->Exit(__func__);
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief apply limited memory bfgs approximation of the inverse
+ * hessian (two loop recursion); the initial hessian is the (scaled)
+ * inverse of the regularization operator, i.e., the first step is
+ * a preconditioned gradient descent step
+ * @param[out] hx approximation of inverse hessian applied to x
+ * @param[in] x input vector (gradient)
+ *******************************************************************/
+PetscErrorCode Optimizer::ApplyLBFGS(Vec hx, Vec x) {
+    PetscErrorCode ierr = 0;
+    int i, k, m, n, head;
+    ScalarType beta;
+    PetscFunctionBegin;
+    this->m_Opt->Enter(__func__);
+
+    ierr = Assert(this->m_OptimizationProblem != NULL, "null pointer"); CHKERRQ(ierr);
+
+    ierr = this->UpdateLBFGS(); CHKERRQ(ierr);
+
+    m = this->m_LBFGS.m;
+    n = this->m_LBFGS.n;
+    head = this->m_LBFGS.head;
+
+    ierr = this->m_LBFGS.q->SetComponents(x); CHKERRQ(ierr);
+
+    // first loop: newest to oldest pair
+    for (i = 0; i < n; ++i) {
+        k = (head - i + m) % m;
+        ierr = this->Dot(this->m_LBFGS.s[k], this->m_LBFGS.q, this->m_LBFGS.alpha[k]); CHKERRQ(ierr);
+        this->m_LBFGS.alpha[k] *= this->m_LBFGS.rho[k];
+        ierr = this->m_LBFGS.q->AXPY(-this->m_LBFGS.alpha[k], this->m_LBFGS.y[k]); CHKERRQ(ierr);
+    }
+
+    // apply initial hessian
+    ierr = this->m_LBFGS.q->GetComponents(hx); CHKERRQ(ierr);
+    ierr = this->m_OptimizationProblem->ApplyInvRegularizationOperator(hx, hx, false); CHKERRQ(ierr);
+    if (this->m_LBFGS.gamma != 1.0) {
+        ierr = VecScale(hx, this->m_LBFGS.gamma); CHKERRQ(ierr);
+    }
+
+    if (n > 0) {
+        ierr = this->m_LBFGS.q->SetComponents(hx); CHKERRQ(ierr);
+
+        // second loop: oldest to newest pair
+        for (i = n-1; i >= 0; --i) {
+            k = (head - i + m) % m;
+            ierr = this->Dot(this->m_LBFGS.y[k], this->m_LBFGS.q, beta); CHKERRQ(ierr);
+            beta *= this->m_LBFGS.rho[k];
+            ierr = this->m_LBFGS.q->AXPY(this->m_LBFGS.alpha[k] - beta, this->m_LBFGS.s[k]); CHKERRQ(ierr);
+        }
+
+        ierr = this->m_LBFGS.q->GetComponents(hx); CHKERRQ(ierr);
+    }
+
+    this->m_Opt->Exit(__func__);
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
 /********************************************************************
  * @brief run the optimizer (main interface; calls specific functions
  * according to user settings (parameter continuation, grid
@@ -451,7 +763,8 @@ PetscErrorCode Optimizer::SetupTao() {
 PetscErrorCode Optimizer::Run(bool presolve) {
     PetscErrorCode ierr;
     ScalarType gtol;
-    IntType maxit;
+    IntType maxit, iter;
+    bool accuracychanged = false;
     std::stringstream ss;
     Vec x = NULL;
     PetscFunctionBegin;
@@ -494,17 +807,58 @@ PetscErrorCode Optimizer::Run(bool presolve) {
     ierr = this->SetInitialGuess(); CHKERRQ(ierr);
     ierr = TaoSetUp(this->m_Tao); CHKERRQ(ierr);
 
-    if (this->m_Opt->m_KrylovMethod.pctype != NOPC) {
+    if (this->m_Opt->m_OptPara.method == QUASINEWTON) {
+        // the regularization operator (initial hessian) might have
+        // changed (e.g., parameter continuation); discard the memory
+        ierr = this->ResetLBFGS(); CHKERRQ(ierr);
+    } else if (this->m_Opt->m_KrylovMethod.pctype != NOPC) {
         // in case we call the optimizer/solver several times
         // we have to make sure that the preconditioner is reset
         ierr = this->m_Precond->Reset(); CHKERRQ(ierr);
     }
 
+    // start with low accuracy pde solves (accuracy is increased
+    // in the monitor as the gradient decreases)
+    if (this->m_Opt->m_PDESolver.adaptaccuracy) {
+        ierr = this->m_OptimizationProblem->AdaptAccuracy(this->m_Solution, 1.0, accuracychanged); CHKERRQ(ierr);
+    }
+
     // solve optimization problem
+    this->m_Opt->m_Monitor.accuracychanged = false;
+    this->m_Opt->m_Monitor.iteroffset = 0;
     ierr = this->m_Opt->StartTimer(T2SEXEC); CHKERRQ(ierr);
     ierr = TaoSolve(this->m_Tao); CHKERRQ(ierr);
+
+    // the accuracy of the pde solves changed in the monitor; tao stored
+    // objective and gradient for the old discretization, so we restart
+    // the solve at the current iterate (tao re-evaluates objective and
+    // gradient on the new discretization before the next line search);
+    // tao counts from zero again, so we carry the iterations of the
+    // former solves (iteration limits and monitor use the total count;
+    // the initial gradient norm is kept)
+    while (this->m_Opt->m_Monitor.accuracychanged) {
+        this->m_Opt->m_Monitor.accuracychanged = false;
+        ierr = TaoGetSolutionStatus(this->m_Tao, &iter, NULL, NULL, NULL, NULL, NULL); CHKERRQ(ierr);
+        this->m_Opt->m_Monitor.iteroffset += iter;
+        maxit -= iter;
+        if (maxit <= 1) {
+            ierr = TaoSetConvergedReason(this->m_Tao, TAO_DIVERGED_MAXITS); CHKERRQ(ierr);
+            break;
+        }
+        ierr = TaoSetMaximumIterations(this->m_Tao, maxit-1); CHKERRQ(ierr);
+        if (this->m_Opt->m_OptPara.method == QUASINEWTON) {
+            // update pairs belong to the old discretization
+            ierr = this->ResetLBFGS(); CHKERRQ(ierr);
+        }
+        ierr = TaoSolve(this->m_Tao); CHKERRQ(ierr);
+    }
     ierr = this->m_Opt->StopTimer(T2SEXEC); CHKERRQ(ierr);
 
+    // outputs and subsequent solves use full accuracy
+    if (this->m_Opt->m_PDESolver.adaptaccuracy) {
+        ierr = this->m_OptimizationProblem->RestoreAccuracy(); CHKERRQ(ierr);
+    }
+
     // get solution
     ierr = TaoGetSolutionVector(this->m_Tao, &x); CHKERRQ(ierr);
 
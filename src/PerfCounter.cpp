@@ -0,0 +1,230 @@
+/*************************************************************************
+ *  Copyright (c) 2018.
+ *  All rights reserved.
+ *  This file is part of the CLAIRE library.
+ *
+ *  CLAIRE is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CLAIRE is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CLAIRE.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+#ifndef _PERFCOUNTER_CPP_
+#define _PERFCOUNTER_CPP_
+
+#include <omp.h>
+#include <cstring>
+#ifdef REG_HAS_PERF
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+#include "PerfCounter.hpp"
+
+
+
+
+namespace reg {
+
+
+
+
+std::vector<int> PerfCounter::s_Leader;
+std::vector<int> PerfCounter::s_FD;
+int PerfCounter::s_NumEvents = 0;
+int PerfCounter::s_EventID[NPERFEVENTS] = {};
+bool PerfCounter::s_Enabled = false;
+bool PerfCounter::s_HasRaw = false;
+int PerfCounter::s_Depth[NPERFREGIONS] = {};
+double PerfCounter::s_Start[NPERFREGIONS][NPERFEVENTS] = {};
+double PerfCounter::s_Value[NPERFREGIONS][NPERFEVENTS] = {};
+double PerfCounter::s_Calls[NPERFREGIONS] = {};
+
+
+
+
+#ifdef REG_HAS_PERF
+/********************************************************************
+ * @brief open event for calling thread (user space only)
+ *******************************************************************/
+static int OpenEvent(unsigned int type, unsigned long config, int leader) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = (leader == -1) ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED
+                     | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, leader, 0));
+}
+#endif
+
+
+
+
+/********************************************************************
+ * @brief open a counter group for each openmp thread; events the
+ * hardware (or the kernel settings; see perf_event_paranoid) do not
+ * support are skipped
+ *******************************************************************/
+bool PerfCounter::Initialize(unsigned long rawconfig) {
+#ifdef REG_HAS_PERF
+    unsigned int type[NPERFEVENTS];
+    unsigned long config[NPERFEVENTS];
+    int nthreads, fd;
+    bool success = true;
+
+    if (s_Enabled) return true;
+
+    type[PERFCYCLES]  = PERF_TYPE_HARDWARE; config[PERFCYCLES]  = PERF_COUNT_HW_CPU_CYCLES;
+    type[PERFINSTR]   = PERF_TYPE_HARDWARE; config[PERFINSTR]   = PERF_COUNT_HW_INSTRUCTIONS;
+    type[PERFLLCREF]  = PERF_TYPE_HARDWARE; config[PERFLLCREF]  = PERF_COUNT_HW_CACHE_REFERENCES;
+    type[PERFLLCMISS] = PERF_TYPE_HARDWARE; config[PERFLLCMISS] = PERF_COUNT_HW_CACHE_MISSES;
+    type[PERFRAW]     = PERF_TYPE_RAW;      config[PERFRAW]     = rawconfig;
+
+    // probe which events are available (cycles lead the group)
+    s_NumEvents = 0;
+    for (int i = 0; i < NPERFEVENTS; ++i) {
+        s_EventID[i] = -1;
+        if (i == PERFRAW && rawconfig == 0) continue;
+        fd = OpenEvent(type[i], config[i], -1);
+        if (fd == -1) {
+            if (i == PERFCYCLES) return false;
+            continue;
+        }
+        close(fd);
+        s_EventID[i] = s_NumEvents++;
+    }
+    s_HasRaw = s_EventID[PERFRAW] != -1;
+
+    // counters are per thread; so every thread opens its own group
+    nthreads = omp_get_max_threads();
+    s_Leader.assign(nthreads, -1);
+    std::vector< std::vector<int> > fds(nthreads);
+#pragma omp parallel num_threads(nthreads) reduction(&&:success)
+{
+    int tid = omp_get_thread_num(), leader = -1, f;
+    for (int i = 0; i < NPERFEVENTS; ++i) {
+        if (s_EventID[i] == -1) continue;
+        f = OpenEvent(type[i], config[i], leader);
+        if (f == -1) {success = false; break;}
+        if (leader == -1) leader = f;
+        fds[tid].push_back(f);
+    }
+    s_Leader[tid] = leader;
+    if (leader != -1) {
+        ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+}  // omp parallel
+
+    s_FD.clear();
+    for (int i = 0; i < nthreads; ++i) {
+        s_FD.insert(s_FD.end(), fds[i].begin(), fds[i].end());
+    }
+    s_Enabled = true;
+
+    if (!success) {
+        Finalize();
+        return false;
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+
+
+/********************************************************************
+ * @brief close all counters
+ *******************************************************************/
+void PerfCounter::Finalize() {
+#ifdef REG_HAS_PERF
+    for (size_t i = 0; i < s_FD.size(); ++i) {
+        close(s_FD[i]);
+    }
+#endif
+    s_FD.clear();
+    s_Leader.clear();
+    s_Enabled = false;
+    s_HasRaw = false;
+}
+
+
+
+
+/********************************************************************
+ * @brief read counters of all threads; we scale by enabled/running
+ * time in case the kernel had to multiplex the counters
+ *******************************************************************/
+void PerfCounter::Read(double* value) {
+    for (int i = 0; i < NPERFEVENTS; ++i) value[i] = 0.0;
+#ifdef REG_HAS_PERF
+    // nr, time enabled, time running, values
+    unsigned long long buffer[3 + NPERFEVENTS];
+    for (size_t t = 0; t < s_Leader.size(); ++t) {
+        ssize_t n = read(s_Leader[t], buffer, sizeof(buffer));
+        if (n < static_cast<ssize_t>(3*sizeof(unsigned long long)) || buffer[2] == 0) continue;
+        double scale = static_cast<double>(buffer[1])/static_cast<double>(buffer[2]);
+        for (int i = 0; i < NPERFEVENTS; ++i) {
+            if (s_EventID[i] != -1) {
+                value[i] += scale*static_cast<double>(buffer[3 + s_EventID[i]]);
+            }
+        }
+    }
+#endif
+}
+
+
+
+
+/********************************************************************
+ * @brief enter region (nested calls of the same region are counted
+ * once)
+ *******************************************************************/
+void PerfCounter::Start(PerfRegion region) {
+    if (!s_Enabled || omp_in_parallel()) return;
+    if (s_Depth[region]++ > 0) return;
+    Read(s_Start[region]);
+}
+
+
+
+
+/********************************************************************
+ * @brief leave region and accumulate counts
+ *******************************************************************/
+void PerfCounter::Stop(PerfRegion region) {
+    double value[NPERFEVENTS];
+    if (!s_Enabled || omp_in_parallel()) return;
+    if (s_Depth[region] == 0 || --s_Depth[region] > 0) return;
+    Read(value);
+    for (int i = 0; i < NPERFEVENTS; ++i) {
+        s_Value[region][i] += value[i] - s_Start[region][i];
+    }
+    s_Calls[region] += 1.0;
+}
+
+
+
+
+}  // namespace reg
+
+
+
+
+#endif  // _PERFCOUNTER_CPP_
@@ -620,8 +620,11 @@ PetscErrorCode Preconditioner::Apply2LevelPrecond(Vec Px, Vec x) {
         pct = value > pct ? value : pct;
     }
 
-    // set components
+    // set components (copy; the input is filtered in place below);
+    // the fine grid result is assembled in the output directly
     ierr = this->m_WorkVecField->SetComponents(x); CHKERRQ(ierr);
+    ierr = this->m_IncControlVariable->PlaceComponents(Px); CHKERRQ(ierr);
+    ierr = this->m_CoarseGrid->m_IncControlVariable->PlaceComponents(this->m_CoarseGrid->x); CHKERRQ(ierr);
 
     // apply low pass filter before we restrict
     // incremental control variable to coarse grid
@@ -632,8 +635,8 @@ PetscErrorCode Preconditioner::Apply2LevelPrecond(Vec Px, Vec x) {
     ierr = this->m_PreProc->Restrict(this->m_CoarseGrid->m_IncControlVariable,
                                      this->m_IncControlVariable, nxc, nx); CHKERRQ(ierr);
 
-    // get the components to interface hessian mat vec
-    ierr = this->m_CoarseGrid->m_IncControlVariable->GetComponents(this->m_CoarseGrid->x); CHKERRQ(ierr);
+    // release coarse grid view (interface to hessian mat vec)
+    ierr = this->m_CoarseGrid->m_IncControlVariable->ResetComponents(); CHKERRQ(ierr);
 
 
     // invert preconditioner
@@ -648,11 +651,12 @@ PetscErrorCode Preconditioner::Apply2LevelPrecond(Vec Px, Vec x) {
 
 
     // get components (for interface of hessian matvec)
-    ierr = this->m_CoarseGrid->m_IncControlVariable->SetComponents(this->m_CoarseGrid->y); CHKERRQ(ierr);
+    ierr = this->m_CoarseGrid->m_IncControlVariable->PlaceComponents(this->m_CoarseGrid->y, true); CHKERRQ(ierr);
 
     // apply prolongation operator
     ierr = this->m_PreProc->Prolong(this->m_IncControlVariable,
                                     this->m_CoarseGrid->m_IncControlVariable, nx, nxc); CHKERRQ(ierr);
+    ierr = this->m_CoarseGrid->m_IncControlVariable->ResetComponents(); CHKERRQ(ierr);
 
     // apply low pass filter to output of hessian matvec
     ierr = this->m_PreProc->ApplyRectFreqFilter(this->m_IncControlVariable,
@@ -665,8 +669,8 @@ PetscErrorCode Preconditioner::Apply2LevelPrecond(Vec Px, Vec x) {
     // add up high and low frequency components
     this->m_IncControlVariable->AXPY(1.0, this->m_WorkVecField); CHKERRQ(ierr);
 
-    // parse to output
-    ierr = this->m_IncControlVariable->GetComponents(Px); CHKERRQ(ierr);
+    // release view on output
+    ierr = this->m_IncControlVariable->ResetComponents(); CHKERRQ(ierr);
 
 
     this->m_Opt->Exit(__func__);
@@ -22,6 +22,7 @@
 
 #include "Preprocessing.hpp"
 #include <time.h>
+#include <algorithm>
 
 
 
@@ -31,6 +32,19 @@ namespace reg {
 
 
 
+/*! process-wide cache of grid transfer operators (shared by all
+    instances; most recently used first) */
+static std::list<FFTGridOps*> s_FFTGridCache;
+static std::list<GridChangeOps*> s_GridChangeCache;
+static int s_NumInstances = 0;
+
+static inline bool SameGrid(const IntType* a, const IntType* b) {
+    return a[0] == b[0] && a[1] == b[1] && a[2] == b[2];
+}
+
+
+
+
 /********************************************************************
  * @brief default constructor
  *******************************************************************/
@@ -57,6 +71,12 @@ Preprocessing::Preprocessing(RegOpt* opt) {
  *******************************************************************/
 Preprocessing::~Preprocessing() {
     this->ClearMemory();
+
+    // free cached grid transfer operators with the last instance
+    s_NumInstances--;
+    if (s_NumInstances == 0) {
+        this->TrimGridChangeCache(true);
+    }
 }
 
 
@@ -80,6 +100,7 @@ PetscErrorCode Preprocessing::Initialize() {
     this->m_XHatCoarse = NULL;
     this->m_FFTFinePlan = NULL;
     this->m_FFTCoarsePlan = NULL;
+    this->m_GridChangeOps = NULL;
 
     this->m_FourierCoeffSendF = NULL;
     this->m_FourierCoeffSendC = NULL;
@@ -112,6 +133,7 @@ PetscErrorCode Preprocessing::Initialize() {
     this->m_xhat = NULL;
     this->m_yhat = NULL;
 
+    s_NumInstances++;
 
     PetscFunctionReturn(ierr);
 }
@@ -134,82 +156,8 @@ PetscErrorCode Preprocessing::ClearMemory() {
         this->m_yhat = NULL;
     }
 
-    if (this->m_XHatFine != NULL) {
-        accfft_free(this->m_XHatFine);
-        this->m_XHatFine = NULL;
-    }
-    if (this->m_XHatCoarse != NULL) {
-        accfft_free(this->m_XHatCoarse);
-        this->m_XHatCoarse = NULL;
-    }
-
-    if (this->m_FFTFinePlan != NULL) {
-        accfft_destroy_plan(this->m_FFTFinePlan);
-        this->m_FFTFinePlan = NULL;
-    }
-    if (this->m_FFTCoarsePlan != NULL) {
-        accfft_destroy_plan(this->m_FFTCoarsePlan);
-        this->m_FFTCoarsePlan = NULL;
-    }
-
-
-    if (this->m_FourierCoeffSendF != NULL) {
-        delete [] this->m_FourierCoeffSendF;
-        this->m_FourierCoeffSendF = NULL;
-    }
-
-    if (this->m_FourierCoeffSendC != NULL) {
-        delete [] this->m_FourierCoeffSendC;
-        this->m_FourierCoeffSendC = NULL;
-    }
-
-    if (this->m_FourierCoeffRecvF != NULL) {
-        delete [] this->m_FourierCoeffRecvF;
-        this->m_FourierCoeffRecvF = NULL;
-    }
-
-    if (this->m_FourierCoeffRecvC != NULL) {
-        delete [] this->m_FourierCoeffRecvC;
-        this->m_FourierCoeffRecvC = NULL;
-    }
-
-    if (this->m_FourierIndicesRecvF != NULL) {
-        delete [] this->m_FourierIndicesRecvF;
-        this->m_FourierIndicesRecvF = NULL;
-    }
-
-    if (this->m_FourierIndicesRecvC != NULL) {
-        delete [] this->m_FourierIndicesRecvC;
-        this->m_FourierIndicesRecvC = NULL;
-    }
-
-    if (this->m_FourierIndicesSendF != NULL) {
-        delete [] this->m_FourierIndicesSendF;
-        this->m_FourierIndicesSendF = NULL;
-    }
-
-    if (this->m_FourierIndicesSendC != NULL) {
-        delete [] this->m_FourierIndicesSendC;
-        this->m_FourierIndicesSendC = NULL;
-    }
-
-    if (this->m_NumSend != NULL) {
-        delete [] this->m_NumSend;
-        this->m_NumSend = NULL;
-    }
-    if (this->m_NumRecv != NULL) {
-        delete [] this->m_NumRecv;
-        this->m_NumRecv = NULL;
-    }
-
-    if (this->m_OffsetSend != NULL) {
-        delete [] this->m_OffsetSend;
-        this->m_OffsetSend = NULL;
-    }
-    if (this->m_OffsetRecv != NULL) {
-        delete [] this->m_OffsetRecv;
-        this->m_OffsetRecv = NULL;
-    }
+    // the grid transfer operators are owned by the cache
+    this->ReleaseGridChangeOps();
 
     if (this->m_SendRequest != NULL) {
         delete [] this->m_SendRequest;
@@ -256,17 +204,17 @@ PetscErrorCode Preprocessing::SetReadWrite(Preprocessing::ReadWriteType* readwri
 
 /********************************************************************
  * @brief do setup for applying prolongation and restriction
- * operators
+ * operators; operators are cached (process-wide) per pair of grids,
+ * so that alternating between the same grids (grid continuation,
+ * two-level preconditioner) does not set up fft plans and index maps
+ * (including the all to all communication) over and over again
  * @param nx_f grid size on fine grid
  * @param nx_c grid size on coarse grid
  *******************************************************************/
 PetscErrorCode Preprocessing::SetupGridChangeOps(IntType* nx_f, IntType* nx_c) {
     PetscErrorCode ierr = 0;
-    IntType nalloc_c, nalloc_f;
-    int _nx_f[3], _ostart_f[3], _osize_f[3], _isize_f[3], _istart_f[3],
-        _nx_c[3], _ostart_c[3], _osize_c[3], _isize_c[3], _istart_c[3];
-    ScalarType *p_xfd = NULL, *p_xcd = NULL;
-    ComplexType *p_xfdhat = NULL, *p_xcdhat = NULL;
+    GridChangeOps* ops = NULL;
+    std::list<GridChangeOps*>::iterator it;
     std::stringstream ss;
     MPI_Comm mpicomm;
 
@@ -274,8 +222,32 @@ PetscErrorCode Preprocessing::SetupGridChangeOps(IntType* nx_f, IntType* nx_c) {
 
     this->m_Opt->Enter(__func__);
 
+    mpicomm = this->m_Opt->m_FFT.mpicomm;
+
+    // operators for this pair of grids are already active
+    ops = this->m_GridChangeOps;
+    if (ops != NULL && SameGrid(ops->nx_f, nx_f) && SameGrid(ops->nx_c, nx_c)
+                    && ops->fine->mpicomm == mpicomm) {
+        this->m_GridChangeOpsSet = true;
+        this->m_Opt->Exit(__func__);
+        PetscFunctionReturn(ierr);
+    }
+
+    ierr = this->ReleaseGridChangeOps(); CHKERRQ(ierr);
+
+    // look up operators in cache
+    ops = NULL;
+    for (it = s_GridChangeCache.begin(); it != s_GridChangeCache.end(); ++it) {
+        if (SameGrid((*it)->nx_f, nx_f) && SameGrid((*it)->nx_c, nx_c)
+                                       && (*it)->fine->mpicomm == mpicomm) {
+            ops = *it;
+            s_GridChangeCache.erase(it);
+            break;
+        }
+    }
+
     if (this->m_Opt->m_Verbosity > 2) {
-        ss  << "setup gridchange operator ( (" << nx_c[0]
+        ss  << (ops == NULL ? "setup" : "reuse") << " gridchange operator ( (" << nx_c[0]
             << "," << nx_c[1] << "," << nx_c[2]
             << ") <=> (" << nx_f[0] << "," << nx_f[1]
             << "," << nx_f[2] << ") )";
@@ -283,135 +255,291 @@ PetscErrorCode Preprocessing::SetupGridChangeOps(IntType* nx_f, IntType* nx_c) {
         ss.clear(); ss.str(std::string());
     }
 
-    if (this->m_XHatCoarse !=  NULL) {
-        accfft_free(this->m_XHatCoarse);
-        this->m_XHatCoarse = NULL;
-    }
-    if (this->m_XHatFine !=  NULL) {
-        accfft_free(this->m_XHatFine);
-        this->m_XHatFine = NULL;
-    }
-    if (this->m_FFTFinePlan !=  NULL) {
-        accfft_destroy_plan(this->m_FFTFinePlan);
-        this->m_FFTFinePlan = NULL;
-    }
-    if (this->m_FFTCoarsePlan !=  NULL) {
-        accfft_destroy_plan(this->m_FFTCoarsePlan);
-        this->m_FFTCoarsePlan = NULL;
-    }
-
-    // parse input sizes
+    if (ops == NULL) {
+        try {ops = new GridChangeOps;}
+        catch (std::bad_alloc&) {
+            ierr = reg::ThrowError("allocation failed"); CHKERRQ(ierr);
+        }
+        for (int i = 0; i < 3; ++i) {
+            ops->nx_f[i] = nx_f[i];
+            ops->nx_c[i] = nx_c[i];
+        }
+        ops->fine = NULL;
+        ops->coarse = NULL;
+        ops->indicescomputed = false;
+        ops->numsend = NULL;
+        ops->numrecv = NULL;
+        ops->offsetsend = NULL;
+        ops->offsetrecv = NULL;
+        ops->nallocsend = 0;
+        ops->nallocrecv = 0;
+        ops->indicessendf = NULL;
+        ops->indicessendc = NULL;
+        ops->indicesrecvf = NULL;
+        ops->indicesrecvc = NULL;
+        ops->coeffsendf = NULL;
+        ops->coeffsendc = NULL;
+        ops->coeffrecvf = NULL;
+        ops->coeffrecvc = NULL;
+        ops->refs = 0;
+        ops->bytes = 0;
+
+        ierr = this->GetFFTGridOps(&ops->fine, nx_f); CHKERRQ(ierr);
+        ops->fine->refs++;
+        ierr = this->GetFFTGridOps(&ops->coarse, nx_c); CHKERRQ(ierr);
+        ops->coarse->refs++;
+    }
+
+    // most recently used operators go first
+    s_GridChangeCache.push_front(ops);
+    ops->refs++;
+    this->m_GridChangeOps = ops;
+
+    // bind operators
+    this->m_FFTFinePlan = ops->fine->plan;
+    this->m_FFTCoarsePlan = ops->coarse->plan;
+    this->m_XHatFine = ops->fine->xhat;
+    this->m_XHatCoarse = ops->coarse->xhat;
+    this->m_FFTFineScale = ops->fine->scale;
+    this->m_FFTCoarseScale = ops->coarse->scale;
     for (int i = 0; i < 3; ++i) {
-        _nx_f[i] = static_cast<int>(nx_f[i]);
-        _nx_c[i] = static_cast<int>(nx_c[i]);
-    }
+        this->m_osizeF[i] = ops->fine->osize[i];
+        this->m_ostartF[i] = ops->fine->ostart[i];
+        this->m_osizeC[i] = ops->coarse->osize[i];
+        this->m_ostartC[i] = ops->coarse->ostart[i];
+    }
+
+    this->m_NumSend = ops->numsend;
+    this->m_NumRecv = ops->numrecv;
+    this->m_OffsetSend = ops->offsetsend;
+    this->m_OffsetRecv = ops->offsetrecv;
+    this->m_nAllocSend = ops->nallocsend;
+    this->m_nAllocRecv = ops->nallocrecv;
+    this->m_FourierIndicesSendF = ops->indicessendf;
+    this->m_FourierIndicesSendC = ops->indicessendc;
+    this->m_FourierIndicesRecvF = ops->indicesrecvf;
+    this->m_FourierIndicesRecvC = ops->indicesrecvc;
+    this->m_FourierCoeffSendF = ops->coeffsendf;
+    this->m_FourierCoeffSendC = ops->coeffsendc;
+    this->m_FourierCoeffRecvF = ops->coeffrecvf;
+    this->m_FourierCoeffRecvC = ops->coeffrecvc;
+    this->m_GridChangeIndicesComputed = ops->indicescomputed;
+
+    ierr = this->TrimGridChangeCache(); CHKERRQ(ierr);
 
-    this->m_FFTFineScale = 1.0;
-    this->m_FFTCoarseScale = 1.0;
-    for (int i = 0; i < 3; ++i) {
-        this->m_FFTFineScale *= static_cast<ScalarType>(nx_f[i]);
-        this->m_FFTCoarseScale *= static_cast<ScalarType>(nx_c[i]);
-    }
-    this->m_FFTFineScale = 1.0/this->m_FFTFineScale;
-    this->m_FFTCoarseScale = 1.0/this->m_FFTCoarseScale;
+    // set flag
+    this->m_GridChangeOpsSet = true;
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief get fft plan and spectral buffer for a given grid size
+ * from the cache (set up if not cached)
+ * @param grid fft operators for grid
+ * @param nx grid size
+ *******************************************************************/
+PetscErrorCode Preprocessing::GetFFTGridOps(FFTGridOps** grid, IntType* nx) {
+    PetscErrorCode ierr = 0;
+    IntType nalloc;
+    int _nx[3], _ostart[3], _osize[3], _isize[3], _istart[3];
+    ScalarType *p_xd = NULL;
+    ComplexType *p_xdhat = NULL;
+    bool wisdomfound = false;
+    std::list<FFTGridOps*>::iterator it;
+    MPI_Comm mpicomm;
+
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
 
-    // get communicator
     mpicomm = this->m_Opt->m_FFT.mpicomm;
 
-    nalloc_c = accfft_local_size_dft_r2c_t<ScalarType>(_nx_c, _isize_c, _istart_c, _osize_c, _ostart_c, mpicomm);
-    nalloc_f = accfft_local_size_dft_r2c_t<ScalarType>(_nx_f, _isize_f, _istart_f, _osize_f, _ostart_f, mpicomm);
-    if (this->m_Opt->m_Verbosity > 2) {
-        ss << "sizes on coarse grid: isize=("
-           << _isize_c[0] << "," << _isize_c[1] << "," << _isize_c[2]
-           << ") istart=(" << _istart_c[0] << "," << _istart_c[1]
-           << "," << _istart_c[2] << ")";
-        ierr = DbgMsg(ss.str()); CHKERRQ(ierr);
-        ss.clear(); ss.str(std::string());
+    *grid = NULL;
+    for (it = s_FFTGridCache.begin(); it != s_FFTGridCache.end(); ++it) {
+        if (SameGrid((*it)->nx, nx) && (*it)->mpicomm == mpicomm) {
+            *grid = *it;
+            s_FFTGridCache.erase(it);
+            break;
+        }
     }
-    //ierr = Assert(nalloc_c > 0, "alloc problems 1"); CHKERRQ(ierr);
-    //ierr = Assert(nalloc_f > 0, "alloc problems 2"); CHKERRQ(ierr);
 
-    for (int i = 0; i < 3; ++i) {
-        this->m_osizeC[i] = static_cast<IntType>(_osize_c[i]);
-        this->m_osizeF[i] = static_cast<IntType>(_osize_f[i]);
-        this->m_ostartC[i] = static_cast<IntType>(_ostart_c[i]);
-        this->m_ostartF[i] = static_cast<IntType>(_ostart_f[i]);
-    }
+    if (*grid == NULL) {
+        if (this->m_Opt->m_Verbosity > 2) {
+            ierr = DbgMsg("initializing fft plan (grid change)"); CHKERRQ(ierr);
+        }
 
-    if (this->m_Opt->m_Verbosity > 2) {
-        ss  << "coarse: osize=(" << this->m_osizeC[0]
-            << "," << this->m_osizeC[1]
-            << "," << this->m_osizeC[2]
-            << "); ostart=(" << this->m_ostartC[0]
-            << "," << this->m_ostartC[1]
-            << "," << this->m_ostartC[2]
-            << "); n=" << nalloc_c;
-        ierr = DbgMsg(ss.str()); CHKERRQ(ierr);
-        ss.clear(); ss.str(std::string());
-        ss  << "fine: osize=(" << this->m_osizeF[0]
-            << "," << this->m_osizeF[1]
-            << "," << this->m_osizeF[2]
-            << "); ostart=(" << this->m_ostartF[0]
-            << "," << this->m_ostartF[1]
-            << "," << this->m_ostartF[2]
-            << "); n=" << nalloc_f;
-        ierr = DbgMsg(ss.str()); CHKERRQ(ierr);
-        ss.clear(); ss.str(std::string());
-    }
+        try {*grid = new FFTGridOps;}
+        catch (std::bad_alloc&) {
+            ierr = reg::ThrowError("allocation failed"); CHKERRQ(ierr);
+        }
+
+        (*grid)->scale = 1.0;
+        for (int i = 0; i < 3; ++i) {
+            _nx[i] = static_cast<int>(nx[i]);
+            (*grid)->nx[i] = nx[i];
+            (*grid)->scale *= static_cast<ScalarType>(nx[i]);
+        }
+        (*grid)->scale = 1.0/(*grid)->scale;
+        (*grid)->mpicomm = mpicomm;
+        (*grid)->xhatvalid = false;
+        (*grid)->xhatid = 0;
+        (*grid)->xhatstate = 0;
+        (*grid)->refs = 0;
+
+        nalloc = accfft_local_size_dft_r2c_t<ScalarType>(_nx, _isize, _istart, _osize, _ostart, mpicomm);
+        for (int i = 0; i < 3; ++i) {
+            (*grid)->osize[i] = static_cast<IntType>(_osize[i]);
+            (*grid)->ostart[i] = static_cast<IntType>(_ostart[i]);
+        }
 
-    if (this->m_XHatCoarse == NULL) {
-        this->m_XHatCoarse = reinterpret_cast<ComplexType*>(accfft_alloc(nalloc_c));
+        (*grid)->xhat = reinterpret_cast<ComplexType*>(accfft_alloc(nalloc));
+        ierr = Assert((*grid)->xhat != NULL, "allocation failed"); CHKERRQ(ierr);
+
+        p_xd = reinterpret_cast<ScalarType*>(accfft_alloc(nalloc));
+        ierr = Assert(p_xd != NULL, "allocation failed"); CHKERRQ(ierr);
+
+        p_xdhat = reinterpret_cast<ComplexType*>(accfft_alloc(nalloc));
+        ierr = Assert(p_xdhat != NULL, "allocation failed"); CHKERRQ(ierr);
+
+        ierr = this->m_Opt->ImportFFTWisdom(_nx, mpicomm, wisdomfound); CHKERRQ(ierr);
+        (*grid)->plan = accfft_plan_dft_3d_r2c(_nx, p_xd, reinterpret_cast<ScalarType*>(p_xdhat),
+                                               mpicomm, ACCFFT_MEASURE);
+        ierr = Assert((*grid)->plan != NULL, "allocation failed"); CHKERRQ(ierr);
+        if (!wisdomfound) {
+            ierr = this->m_Opt->ExportFFTWisdom(_nx, mpicomm); CHKERRQ(ierr);
+        }
+
+        if (p_xd != NULL) {accfft_free(p_xd); p_xd = NULL;}
+        if (p_xdhat != NULL) {accfft_free(p_xdhat); p_xdhat = NULL;}
+
+        // spectral buffer plus (roughly) the work space of the plan
+        (*grid)->bytes = 3*static_cast<size_t>(nalloc);
     }
-    ierr = Assert(this->m_XHatCoarse != NULL,"allocation failed"); CHKERRQ(ierr);
 
-    if (this->m_XHatFine == NULL) {
-        this->m_XHatFine = reinterpret_cast<ComplexType*>(accfft_alloc(nalloc_f));
+    s_FFTGridCache.push_front(*grid);
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief release the active grid transfer operators (they stay in
+ * the cache)
+ *******************************************************************/
+PetscErrorCode Preprocessing::ReleaseGridChangeOps() {
+    PetscErrorCode ierr = 0;
+
+    PetscFunctionBegin;
+
+    if (this->m_GridChangeOps != NULL) {
+        this->m_GridChangeOps->refs--;
+        this->m_GridChangeOps = NULL;
     }
-    ierr = Assert(this->m_XHatFine != NULL,"allocation failed"); CHKERRQ(ierr);
 
-    // allocate plan for fine grid
-    if (this->m_FFTFinePlan == NULL) {
-        if (this->m_Opt->m_Verbosity > 2) {
-            ierr = DbgMsg("initializing fft plan (fine grid)"); CHKERRQ(ierr);
-        }
+    this->m_FFTFinePlan = NULL;
+    this->m_FFTCoarsePlan = NULL;
+    this->m_XHatFine = NULL;
+    this->m_XHatCoarse = NULL;
+    this->m_NumSend = NULL;
+    this->m_NumRecv = NULL;
+    this->m_OffsetSend = NULL;
+    this->m_OffsetRecv = NULL;
+    this->m_nAllocSend = 0;
+    this->m_nAllocRecv = 0;
+    this->m_FourierIndicesSendF = NULL;
+    this->m_FourierIndicesSendC = NULL;
+    this->m_FourierIndicesRecvF = NULL;
+    this->m_FourierIndicesRecvC = NULL;
+    this->m_FourierCoeffSendF = NULL;
+    this->m_FourierCoeffSendC = NULL;
+    this->m_FourierCoeffRecvF = NULL;
+    this->m_FourierCoeffRecvC = NULL;
 
-        p_xfd = reinterpret_cast<ScalarType*>(accfft_alloc(nalloc_f));
-        ierr = Assert(p_xfd != NULL, "allocation failed"); CHKERRQ(ierr);
+    this->m_GridChangeOpsSet = false;
+    this->m_GridChangeIndicesComputed = false;
 
-        p_xfdhat = reinterpret_cast<ComplexType*>(accfft_alloc(nalloc_f));
-        ierr = Assert(p_xfdhat != NULL, "malloc failed"); CHKERRQ(ierr);
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief evict least recently used grid transfer operators until the
+ * cache fits into the memory budget set by the user; operators that
+ * are in use are never evicted
+ * @param clear evict all operators (that are not in use)
+ *******************************************************************/
+PetscErrorCode Preprocessing::TrimGridChangeCache(bool clear) {
+    PetscErrorCode ierr = 0;
+    size_t bytes = 0, maxbytes = 0;
+    std::list<GridChangeOps*>::iterator it;
+    std::list<FFTGridOps*>::iterator jt;
 
-        this->m_FFTFinePlan = accfft_plan_dft_3d_r2c(_nx_f, p_xfd, reinterpret_cast<ScalarType*>(p_xfdhat),
-                                                     this->m_Opt->m_FFT.mpicomm, ACCFFT_MEASURE);
-        ierr = Assert(this->m_FFTFinePlan != NULL, "malloc failed"); CHKERRQ(ierr);
+    PetscFunctionBegin;
 
-        if (p_xfd != NULL) {accfft_free(p_xfd); p_xfd = NULL;}
-        if (p_xfdhat != NULL) {accfft_free(p_xfdhat); p_xfdhat = NULL;}
+    if (!clear && this->m_Opt != NULL) {
+        maxbytes = static_cast<size_t>(this->m_Opt->m_FFT.gridopscache)*1024*1024;
     }
 
-    // allocate plan for coarse grid
-    if (this->m_FFTCoarsePlan == NULL) {
-        if (this->m_Opt->m_Verbosity > 2) {
-            ierr = DbgMsg("initializing fft plan (coarse grid)"); CHKERRQ(ierr);
-        }
-        p_xcd = reinterpret_cast<ScalarType*>(accfft_alloc(nalloc_c));
-        ierr = Assert(p_xcd != NULL, "malloc failed"); CHKERRQ(ierr);
+    for (it = s_GridChangeCache.begin(); it != s_GridChangeCache.end(); ++it) {
+        bytes += (*it)->bytes;
+    }
+    for (jt = s_FFTGridCache.begin(); jt != s_FFTGridCache.end(); ++jt) {
+        bytes += (*jt)->bytes;
+    }
 
-        p_xcdhat = reinterpret_cast<ComplexType*>(accfft_alloc(nalloc_c));
-        ierr = Assert(p_xcdhat != NULL, "malloc failed"); CHKERRQ(ierr);
+    // index maps (least recently used first)
+    it = s_GridChangeCache.end();
+    while (bytes > maxbytes && it != s_GridChangeCache.begin()) {
+        --it;
+        GridChangeOps* ops = *it;
+        if (ops->refs > 0) continue;
 
-        this->m_FFTCoarsePlan = accfft_plan_dft_3d_r2c(_nx_c, p_xcd, reinterpret_cast<ScalarType*>(p_xcdhat),
-                                                       this->m_Opt->m_FFT.mpicomm, ACCFFT_MEASURE);
-        ierr = Assert(this->m_FFTCoarsePlan != NULL, "malloc failed"); CHKERRQ(ierr);
+        if (ops->numsend != NULL) delete [] ops->numsend;
+        if (ops->numrecv != NULL) delete [] ops->numrecv;
+        if (ops->offsetsend != NULL) delete [] ops->offsetsend;
+        if (ops->offsetrecv != NULL) delete [] ops->offsetrecv;
+        if (ops->indicessendf != NULL) delete [] ops->indicessendf;
+        if (ops->indicessendc != NULL) delete [] ops->indicessendc;
+        if (ops->indicesrecvf != NULL) delete [] ops->indicesrecvf;
+        if (ops->indicesrecvc != NULL) delete [] ops->indicesrecvc;
+        if (ops->coeffsendf != NULL) delete [] ops->coeffsendf;
+        if (ops->coeffsendc != NULL) delete [] ops->coeffsendc;
+        if (ops->coeffrecvf != NULL) delete [] ops->coeffrecvf;
+        if (ops->coeffrecvc != NULL) delete [] ops->coeffrecvc;
+        ops->fine->refs--;
+        ops->coarse->refs--;
 
-        if (p_xcd != NULL) {accfft_free(p_xcd); p_xcd = NULL;}
-        if (p_xcdhat != NULL) {accfft_free(p_xcdhat); p_xcdhat = NULL;}
+        bytes -= ops->bytes;
+        delete ops;
+        it = s_GridChangeCache.erase(it);
     }
 
-    // set flag
-    this->m_GridChangeOpsSet = true;
+    // fft plans that are no longer referenced
+    jt = s_FFTGridCache.end();
+    while (bytes > maxbytes && jt != s_FFTGridCache.begin()) {
+        --jt;
+        FFTGridOps* grid = *jt;
+        if (grid->refs > 0) continue;
 
-    this->m_Opt->Exit(__func__);
+        if (grid->xhat != NULL) accfft_free(grid->xhat);
+        if (grid->plan != NULL) accfft_destroy_plan(grid->plan);
+
+        bytes -= grid->bytes;
+        delete grid;
+        jt = s_FFTGridCache.erase(jt);
+    }
 
     PetscFunctionReturn(ierr);
 }
@@ -634,6 +762,298 @@ PetscErrorCode Preprocessing::MultiCompImage2Labels(Vec labelim, Vec m) {
 
     PetscFunctionReturn(ierr);
 }
+
+
+
+
+/********************************************************************
+ * @brief assign the labels to a small number of colors, such that
+ * labels that are close to one another have different colors; close
+ * means that the smoothed indicator functions of two labels (widened
+ * by the interpolation stencil in every time step) may overlap during
+ * transport; to keep this cheap, we
+ * sort the labels into blocks of the size of this band and consider
+ * all labels in the same or in neighboring blocks to be close (this is
+ * conservative); the coloring is computed redundantly on all ranks
+ * @param[in] labelmap label image
+ * @param[out] color color of individual labels (order of m_LabelIDs)
+ * @param[out] ncolors number of colors
+ *******************************************************************/
+PetscErrorCode Preprocessing::ColorLabels(Vec labelmap, std::vector<int>& color, int& ncolors) {
+    PetscErrorCode ierr = 0;
+    IntType nb[3], band, b[3], n[3], blockid;
+    ScalarType sigma = 0.0;
+    int nlabels, nprocs, nlocal, rval, l, c;
+    long long key, lastkey = -1;
+    const ScalarType *p_labelmap = NULL;
+    std::map<int, int> labelindex;
+    std::map<int, int>::iterator label;
+    std::map<IntType, std::vector<int> > blocks;
+    std::map<IntType, std::vector<int> >::iterator block, neighbor;
+    std::vector<long long> localkeys, globalkeys;
+    std::vector<int> count, offset, degree, order;
+    std::vector<bool> conflict, used;
+    std::stringstream ss;
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    ierr = Assert(labelmap != NULL, "null pointer"); CHKERRQ(ierr);
+
+    nlabels = static_cast<int>(this->m_Opt->m_LabelIDs.size());
+    ierr = Assert(nlabels > 0, "number of labels is zero"); CHKERRQ(ierr);
+    for (l = 0; l < nlabels; ++l) {
+        labelindex[this->m_Opt->m_LabelIDs[l]] = l;
+    }
+
+    // width of band (in grid points): support of gaussian smoothing
+    // kernel on either side plus the spread of the support during
+    // transport; every sl step may widen the support by one
+    // interpolation stencil (we neglect the change in volume due to
+    // the deformation within a single step)
+    for (int i = 0; i < 3; ++i) {
+        sigma = PetscMax(sigma, this->m_Opt->m_Sigma[i]);
+    }
+    band = 2*static_cast<IntType>(std::ceil(3.0*sigma))
+         + this->m_Opt->m_Domain.nt*(this->m_Opt->m_PDESolver.iporder + 1);
+
+    // the remainder is merged into the last block, so that all
+    // blocks (also across the periodic boundary) are at least as
+    // wide as the band
+    for (int i = 0; i < 3; ++i) {
+        n[i] = this->m_Opt->m_Domain.nx[i];
+        nb[i] = PetscMax(n[i]/band, static_cast<IntType>(1));
+    }
+
+    // collect (block, label) pairs on this rank
+    ierr = VecGetArrayRead(labelmap, &p_labelmap); CHKERRQ(ierr);
+    for (IntType i1 = 0; i1 < this->m_Opt->m_Domain.isize[0]; ++i1) {
+        b[0] = PetscMin((i1 + this->m_Opt->m_Domain.istart[0])/band, nb[0] - 1);
+        for (IntType i2 = 0; i2 < this->m_Opt->m_Domain.isize[1]; ++i2) {
+            b[1] = PetscMin((i2 + this->m_Opt->m_Domain.istart[1])/band, nb[1] - 1);
+            for (IntType i3 = 0; i3 < this->m_Opt->m_Domain.isize[2]; ++i3) {
+                b[2] = PetscMin((i3 + this->m_Opt->m_Domain.istart[2])/band, nb[2] - 1);
+
+                IntType i = GetLinearIndex(i1, i2, i3, this->m_Opt->m_Domain.isize);
+                label = labelindex.find(static_cast<int>(std::round(p_labelmap[i])));
+                if (label == labelindex.end()) continue;
+
+                blockid = (b[0]*nb[1] + b[1])*nb[2] + b[2];
+                key = static_cast<long long>(blockid)*nlabels + label->second;
+                if (key != lastkey) localkeys.push_back(key);
+                lastkey = key;
+            }
+        }
+    }
+    ierr = VecRestoreArrayRead(labelmap, &p_labelmap); CHKERRQ(ierr);
+    std::sort(localkeys.begin(), localkeys.end());
+    localkeys.erase(std::unique(localkeys.begin(), localkeys.end()), localkeys.end());
+
+    // gather pairs on all ranks
+    rval = MPI_Comm_size(PETSC_COMM_WORLD, &nprocs); ierr = MPIERRQ(rval); CHKERRQ(ierr);
+    count.resize(nprocs); offset.resize(nprocs);
+    nlocal = static_cast<int>(localkeys.size());
+    rval = MPI_Allgather(&nlocal, 1, MPI_INT, &count[0], 1, MPI_INT, PETSC_COMM_WORLD);
+    ierr = MPIERRQ(rval); CHKERRQ(ierr);
+    offset[0] = 0;
+    for (int p = 1; p < nprocs; ++p) offset[p] = offset[p-1] + count[p-1];
+    globalkeys.resize(offset[nprocs-1] + count[nprocs-1] + 1);
+    rval = MPI_Allgatherv(nlocal > 0 ? &localkeys[0] : NULL, nlocal, MPI_LONG_LONG,
+                          &globalkeys[0], &count[0], &offset[0], MPI_LONG_LONG, PETSC_COMM_WORLD);
+    ierr = MPIERRQ(rval); CHKERRQ(ierr);
+    globalkeys.pop_back();
+
+    for (size_t k = 0; k < globalkeys.size(); ++k) {
+        blocks[globalkeys[k]/nlabels].push_back(static_cast<int>(globalkeys[k]%nlabels));
+    }
+
+    // labels in the same or in neighboring blocks (periodic domain) are in conflict
+    conflict.assign(nlabels*nlabels, false);
+    for (block = blocks.begin(); block != blocks.end(); ++block) {
+        b[2] = block->first%nb[2];
+        b[1] = (block->first/nb[2])%nb[1];
+        b[0] = block->first/(nb[1]*nb[2]);
+        for (int d1 = -1; d1 <= 1; ++d1) {
+            for (int d2 = -1; d2 <= 1; ++d2) {
+                for (int d3 = -1; d3 <= 1; ++d3) {
+                    blockid = (((b[0] + d1 + nb[0])%nb[0])*nb[1]
+                             + ((b[1] + d2 + nb[1])%nb[1]))*nb[2]
+                             + ((b[2] + d3 + nb[2])%nb[2]);
+                    neighbor = blocks.find(blockid);
+                    if (neighbor == blocks.end()) continue;
+                    for (size_t j = 0; j < block->second.size(); ++j) {
+                        for (size_t k = 0; k < neighbor->second.size(); ++k) {
+                            l = block->second[j]; c = neighbor->second[k];
+                            if (l != c) {
+                                conflict[l*nlabels + c] = true;
+                                conflict[c*nlabels + l] = true;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // greedy coloring (largest degree first)
+    degree.assign(nlabels, 0);
+    order.resize(nlabels);
+    for (l = 0; l < nlabels; ++l) {
+        order[l] = l;
+        for (c = 0; c < nlabels; ++c) {
+            if (conflict[l*nlabels + c]) degree[l]++;
+        }
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&degree](int a, int b) {return degree[a] > degree[b];});
+
+    color.assign(nlabels, -1);
+    ncolors = 0;
+    for (int k = 0; k < nlabels; ++k) {
+        l = order[k];
+        used.assign(nlabels, false);
+        for (c = 0; c < nlabels; ++c) {
+            if (conflict[l*nlabels + c] && color[c] >= 0) used[color[c]] = true;
+        }
+        c = 0;
+        while (used[c]) ++c;
+        color[l] = c;
+        ncolors = std::max(ncolors, c + 1);
+    }
+
+    if (this->m_Opt->m_Verbosity > 1) {
+        ss << "mapped " << nlabels << " labels to " << ncolors
+           << " colors (band width " << band << ")";
+        ierr = DbgMsg(ss.str()); CHKERRQ(ierr);
+    }
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief convert sharp label image to a multi-component image with two
+ * components per color; the first ncolors components are indicator
+ * functions of all labels with a given color; the second ncolors
+ * components are the same indicator functions weighted by the index of
+ * the label (plus one); since labels with the same color are far apart,
+ * the ratio of the two (smoothed and transported) components recovers
+ * the index of the label wherever the label probability is not small
+ * @param[out] m multi-component image (2*ncolors components)
+ * @param[in] labelmap label image
+ * @param[in] color color of individual labels (see ColorLabels)
+ * @param[in] ncolors number of colors
+ *******************************************************************/
+PetscErrorCode Preprocessing::Labels2ColorCompImage(Vec m, Vec labelmap,
+                                                    const std::vector<int>& color, int ncolors) {
+    PetscErrorCode ierr = 0;
+    IntType nl;
+    int nlabels;
+    const ScalarType *p_labelmap = NULL;
+    ScalarType *p_m = NULL;
+    std::map<int, int> labelindex;
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    nl = this->m_Opt->m_Domain.nl;
+    nlabels = static_cast<int>(this->m_Opt->m_LabelIDs.size());
+    ierr = Assert(color.size() == static_cast<unsigned int>(nlabels), "size mismatch"); CHKERRQ(ierr);
+    for (int l = 0; l < nlabels; ++l) {
+        labelindex[this->m_Opt->m_LabelIDs[l]] = l;
+    }
+
+    ierr = VecGetArray(m, &p_m); CHKERRQ(ierr);
+    ierr = VecGetArrayRead(labelmap, &p_labelmap); CHKERRQ(ierr);
+    for (IntType i = 0; i < nl; ++i) {
+        for (int c = 0; c < 2*ncolors; ++c) {
+            p_m[c*nl + i] = 0.0;
+        }
+        std::map<int, int>::const_iterator label
+            = labelindex.find(static_cast<int>(std::round(p_labelmap[i])));
+        if (label != labelindex.end()) {
+            int c = color[label->second];
+            p_m[c*nl + i] = 1.0;
+            p_m[(ncolors + c)*nl + i] = static_cast<ScalarType>(label->second + 1);
+        }
+    }
+    ierr = VecRestoreArrayRead(labelmap, &p_labelmap); CHKERRQ(ierr);
+    ierr = VecRestoreArray(m, &p_m); CHKERRQ(ierr);
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief convert (smoothed and transported) color image back to sharp
+ * label image (see Labels2ColorCompImage); majority vote among colors
+ * and background, the label is recovered from the weighted component
+ * @param[out] labelmap label image
+ * @param[in] m multi-component image (2*ncolors components)
+ * @param[in] color color of individual labels (see ColorLabels)
+ * @param[in] ncolors number of colors
+ *******************************************************************/
+PetscErrorCode Preprocessing::ColorCompImage2Labels(Vec labelmap, Vec m,
+                                                    const std::vector<int>& color, int ncolors) {
+    PetscErrorCode ierr = 0;
+    IntType nl;
+    int nlabels;
+    const ScalarType *p_m = NULL;
+    ScalarType *p_labelmap = NULL;
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    nl = this->m_Opt->m_Domain.nl;
+    nlabels = static_cast<int>(this->m_Opt->m_LabelIDs.size());
+    ierr = Assert(color.size() == static_cast<unsigned int>(nlabels), "size mismatch"); CHKERRQ(ierr);
+
+    ierr = VecGetArrayRead(m, &p_m); CHKERRQ(ierr);
+    ierr = VecGetArray(labelmap, &p_labelmap); CHKERRQ(ierr);
+#pragma omp parallel for
+    for (IntType i = 0; i < nl; ++i) {
+        ScalarType background = 1.0, majorityvote;
+        int majoritycolor = -1, l;
+
+        for (int c = 0; c < ncolors; ++c) {
+            background -= p_m[c*nl + i];
+        }
+        majorityvote = PetscMax(background, 0.0);
+
+        for (int c = 0; c < ncolors; ++c) {
+            if (p_m[c*nl + i] > majorityvote) {
+                majorityvote  = p_m[c*nl + i];
+                majoritycolor = c;
+            }
+        }
+
+        if (majoritycolor == -1) {
+            p_labelmap[i] = 0;
+        } else {
+            l = static_cast<int>(std::round(p_m[(ncolors + majoritycolor)*nl + i]/majorityvote)) - 1;
+            l = std::min(std::max(l, 0), nlabels - 1);
+            p_labelmap[i] = this->m_Opt->m_LabelIDs[l];
+        }
+    }
+    ierr = VecRestoreArray(labelmap, &p_labelmap); CHKERRQ(ierr);
+    ierr = VecRestoreArrayRead(m, &p_m); CHKERRQ(ierr);
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
 /*
 PetscErrorCode Preprocessing::MultiCompImage2Labels(Vec labelim, Vec m) {
     PetscErrorCode ierr = 0;
@@ -766,6 +1186,10 @@ PetscErrorCode Preprocessing::Restrict(Vec* x_c, Vec x_f, IntType* nx_c, IntType
     PetscErrorCode ierr = 0;
     ScalarType *p_xf = NULL, *p_xc = NULL, scale, coeff[2], value;
     IntType n, l, k_c[3], i_c[3], nr, os_recv, nyqfreqid[3];
+    PetscObjectId id;
+    PetscObjectState state;
+    FFTGridOps* fine = NULL;
+    int nfft = 0;
     std::stringstream ss;
     int rank, nprocs;
     double timer[NFFTTIMERS] = {0};
@@ -803,14 +1227,8 @@ PetscErrorCode Preprocessing::Restrict(Vec* x_c, Vec x_f, IntType* nx_c, IntType
 //        nxhalf_c[i] = static_cast<IntType>(std::ceil(value));
 //    }
 
-    // set up fft operators
-    if (this->m_ResetGridChangeOps) {
-        this->m_GridChangeOpsSet = false;
-        this->m_GridChangeIndicesComputed = false;
-    }
-    if (!this->m_GridChangeOpsSet) {
-        ierr = this->SetupGridChangeOps(nx_f, nx_c); CHKERRQ(ierr);
-    }
+    // set up fft operators (cheap if cached)
+    ierr = this->SetupGridChangeOps(nx_f, nx_c); CHKERRQ(ierr);
 
     ierr = Assert(this->m_FFTFinePlan != NULL, "null pointer"); CHKERRQ(ierr);
 
@@ -828,10 +1246,25 @@ PetscErrorCode Preprocessing::Restrict(Vec* x_c, Vec x_f, IntType* nx_c, IntType
     }
 } // #pragma omp parallel
 
-    // compute fft of data on fine grid
-    ierr = VecGetArray(x_f, &p_xf); CHKERRQ(ierr);
-    accfft_execute_r2c_t(this->m_FFTFinePlan, p_xf, this->m_XHatFine, timer);
-    ierr = VecRestoreArray(x_f, &p_xf); CHKERRQ(ierr);
+    // compute fft of data on fine grid; if we restrict the same data
+    // to several coarse grids (e.g., to build a multi-level pyramid),
+    // we reuse the spectrum computed in the first call
+    ierr = PetscObjectGetId(reinterpret_cast<PetscObject>(x_f), &id); CHKERRQ(ierr);
+    ierr = PetscObjectStateGet(reinterpret_cast<PetscObject>(x_f), &state); CHKERRQ(ierr);
+    fine = this->m_GridChangeOps->fine;
+    if (!fine->xhatvalid || id != fine->xhatid || state != fine->xhatstate) {
+        ierr = VecGetArray(x_f, &p_xf); CHKERRQ(ierr);
+        accfft_execute_r2c_t(this->m_FFTFinePlan, p_xf, this->m_XHatFine, timer);
+        ierr = VecRestoreArray(x_f, &p_xf); CHKERRQ(ierr);
+        nfft++;
+
+        // restoring the array increases the state of x_f
+        ierr = PetscObjectStateGet(reinterpret_cast<PetscObject>(x_f), &state); CHKERRQ(ierr);
+        fine->xhatid = id;
+        fine->xhatstate = state;
+        fine->xhatvalid = true;
+    }
+    this->m_GridChangeOps->coarse->xhatvalid = false;
 
     // compute indices
     if (!this->m_GridChangeIndicesComputed) {
@@ -896,12 +1329,13 @@ PetscErrorCode Preprocessing::Restrict(Vec* x_c, Vec x_f, IntType* nx_c, IntType
     ierr = VecGetArray(*x_c, &p_xc); CHKERRQ(ierr);
     accfft_execute_c2r_t(this->m_FFTCoarsePlan, this->m_XHatCoarse, p_xc, timer);
     ierr = VecRestoreArray(*x_c, &p_xc); CHKERRQ(ierr);
+    nfft++;
 
     // set fft timers
     this->m_Opt->IncreaseFFTTimers(timer);
 
     // increment counter
-    this->m_Opt->IncrementCounter(FFT, 2);
+    this->m_Opt->IncrementCounter(FFT, nfft);
 
     this->m_Opt->Exit(__func__);
 
@@ -921,6 +1355,7 @@ PetscErrorCode Preprocessing::ComputeGridChangeIndices(IntType* nx_f, IntType* n
     IntType oend_c[3], osc_x2, osc_x3, i_f[3], k_f[3], k_c[3], nxhalf_c[3];
     ScalarType nc[2];
     bool locallyowned,oncoarsegrid;
+    GridChangeOps* ops = NULL;
 
     PetscFunctionBegin;
 
@@ -929,6 +1364,8 @@ PetscErrorCode Preprocessing::ComputeGridChangeIndices(IntType* nx_f, IntType* n
     MPI_Comm_rank(PETSC_COMM_WORLD,&rank);
     MPI_Comm_size(PETSC_COMM_WORLD,&nprocs);
 
+    ierr = Assert(this->m_GridChangeOps != NULL, "null pointer"); CHKERRQ(ierr);
+
     ierr = Assert(nx_c[0] <= nx_f[0], "grid size in restriction wrong"); CHKERRQ(ierr);
     ierr = Assert(nx_c[1] <= nx_f[1], "grid size in restriction wrong"); CHKERRQ(ierr);
     ierr = Assert(nx_c[2] <= nx_f[2], "grid size in restriction wrong"); CHKERRQ(ierr);
@@ -1042,8 +1479,59 @@ PetscErrorCode Preprocessing::ComputeGridChangeIndices(IntType* nx_f, IntType* n
     // do the communication
     ierr = this->GridChangeCommIndices(); CHKERRQ(ierr);
 
+    // allocate buffers for fourier coefficients
+    if (this->m_nAllocSend > 0) {
+        try{this->m_FourierCoeffSendF = new ScalarType[this->m_nAllocSend*2];}
+        catch (std::bad_alloc&) {
+            ierr = reg::ThrowError("allocation failed"); CHKERRQ(ierr);
+        }
+        try{this->m_FourierCoeffRecvC = new ScalarType[this->m_nAllocSend*2];}
+        catch (std::bad_alloc&) {
+            ierr = reg::ThrowError("allocation failed"); CHKERRQ(ierr);
+        }
+    }
+    if (this->m_nAllocRecv > 0) {
+        try{this->m_FourierCoeffRecvF = new ScalarType[this->m_nAllocRecv*2];}
+        catch (std::bad_alloc&) {
+            ierr = reg::ThrowError("allocation failed"); CHKERRQ(ierr);
+        }
+        try{this->m_FourierCoeffSendC = new ScalarType[this->m_nAllocRecv*2];}
+        catch (std::bad_alloc&) {
+            ierr = reg::ThrowError("allocation failed"); CHKERRQ(ierr);
+        }
+    }
+
+    // hand index maps and buffers over to the cache
+    ops = this->m_GridChangeOps;
+    ops->numsend = this->m_NumSend;
+    ops->numrecv = this->m_NumRecv;
+    ops->offsetsend = this->m_OffsetSend;
+    ops->offsetrecv = this->m_OffsetRecv;
+    ops->nallocsend = this->m_nAllocSend;
+    ops->nallocrecv = this->m_nAllocRecv;
+    ops->indicessendf = this->m_FourierIndicesSendF;
+    ops->indicessendc = this->m_FourierIndicesSendC;
+    ops->indicesrecvf = this->m_FourierIndicesRecvF;
+    ops->indicesrecvc = this->m_FourierIndicesRecvC;
+    ops->coeffsendf = this->m_FourierCoeffSendF;
+    ops->coeffsendc = this->m_FourierCoeffSendC;
+    ops->coeffrecvf = this->m_FourierCoeffRecvF;
+    ops->coeffrecvc = this->m_FourierCoeffRecvC;
+    ops->indicescomputed = true;
+    ops->bytes = 4*nprocs*sizeof(IntType)
+               + 6*(ops->nallocsend + ops->nallocrecv)*sizeof(IntType)
+               + 4*(ops->nallocsend + ops->nallocrecv)*sizeof(ScalarType);
+
+    // the index lists are no longer needed
+    for (int p = 0; p < nprocs; ++p) {
+        this->m_IndicesC[p].clear();
+        this->m_IndicesF[p].clear();
+    }
+
     this->m_GridChangeIndicesComputed = true;
 
+    ierr = this->TrimGridChangeCache(); CHKERRQ(ierr);
+
     this->m_Opt->Exit(__func__);
 
     PetscFunctionReturn(ierr);
@@ -1141,17 +1629,6 @@ PetscErrorCode Preprocessing::GridChangeCommIndices() {
 
     // if we actually need to allocate something
     if (this->m_nAllocSend > 0) {
-        if (this->m_ResetGridChangeOps) {
-            if (this->m_FourierIndicesSendF != NULL) {
-                delete [] this->m_FourierIndicesSendF;
-                this->m_FourierIndicesSendF=NULL;
-            }
-            if (this->m_FourierIndicesSendC != NULL) {
-                delete [] this->m_FourierIndicesSendC;
-                this->m_FourierIndicesSendC=NULL;
-            }
-        }
-
         if (this->m_FourierIndicesSendF==NULL) {
             try{this->m_FourierIndicesSendF = new IntType[this->m_nAllocSend*3];}
             catch (std::bad_alloc&) {
@@ -1204,18 +1681,6 @@ PetscErrorCode Preprocessing::GridChangeCommIndices() {
 
     // allocate receiving array
     if (this->m_nAllocRecv > 0) {
-        if (this->m_ResetGridChangeOps) {
-            if (this->m_FourierIndicesRecvF != NULL) {
-                delete [] this->m_FourierIndicesRecvF;
-                this->m_FourierIndicesRecvF = NULL;
-            }
-
-            if (this->m_FourierIndicesRecvC != NULL) {
-                delete [] this->m_FourierIndicesRecvC;
-                this->m_FourierIndicesRecvC = NULL;
-            }
-        }
-
         if (this->m_FourierIndicesRecvF == NULL) {
             try{this->m_FourierIndicesRecvF = new IntType[this->m_nAllocRecv*3];}
             catch (std::bad_alloc&) {
@@ -1268,6 +1733,10 @@ PetscErrorCode Preprocessing::GridChangeCommIndices() {
         }
     }
 
+    // fine grid indices (3 per entry)
+    ierr = this->CountGridChangeComm(this->m_NumSend, this->m_NumRecv,
+                                     3*sizeof(this->m_FourierIndicesSendF[0])); CHKERRQ(ierr);
+
     // for all procs, send indices
     for (int i = 0; i < nprocs; ++i) {
         i_send = i; i_recv = i;
@@ -1304,6 +1773,10 @@ PetscErrorCode Preprocessing::GridChangeCommIndices() {
         }
     }
 
+    // coarse grid indices (3 per entry)
+    ierr = this->CountGridChangeComm(this->m_NumSend, this->m_NumRecv,
+                                     3*sizeof(this->m_FourierIndicesSendC[0])); CHKERRQ(ierr);
+
     // we only have to communicate these indices once
     this->m_IndicesCommunicated = true;
 
@@ -1315,6 +1788,43 @@ PetscErrorCode Preprocessing::GridChangeCommIndices() {
 
 
 
+/********************************************************************
+ * @brief account for communication volume of grid change; messages
+ * to the rank itself are not counted
+ * @param nsend number of entries sent to each rank
+ * @param nrecv number of entries received from each rank
+ * @param size size of an entry in bytes
+ *******************************************************************/
+PetscErrorCode Preprocessing::CountGridChangeComm(IntType* nsend, IntType* nrecv, size_t size) {
+    PetscErrorCode ierr = 0;
+    int nprocs, rank, nsendmsg = 0, nrecvmsg = 0, npeers = 0;
+    double bytessent = 0.0, bytesrecv = 0.0;
+
+    PetscFunctionBegin;
+
+    MPI_Comm_rank(PETSC_COMM_WORLD, &rank);
+    MPI_Comm_size(PETSC_COMM_WORLD, &nprocs);
+
+    for (int i = 0; i < nprocs; ++i) {
+        if (i == rank) continue;
+        if (nsend[i] > 0) {
+            bytessent += static_cast<double>(nsend[i])*size;
+            ++nsendmsg;
+        }
+        if (nrecv[i] > 0) {
+            bytesrecv += static_cast<double>(nrecv[i])*size;
+            ++nrecvmsg;
+        }
+        if (nsend[i] > 0 || nrecv[i] > 0) ++npeers;
+    }
+    CommCounter::Add(COMMGRIDCHANGE, bytessent, bytesrecv, nsendmsg, nrecvmsg, npeers);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
 /********************************************************************
  * @brief do setup for applying restriction operator
  * @param nx_c grid size on coarse grid
@@ -1354,19 +1864,7 @@ PetscErrorCode Preprocessing::GridChangeCommDataRestrict() {
 
     // if we actually need to allocate something
     if (this->m_nAllocSend > 0) {
-        if (this->m_ResetGridChangeOps) {
-            if (this->m_FourierCoeffSendF != NULL) {
-                delete [] this->m_FourierCoeffSendF;
-                this->m_FourierCoeffSendF = NULL;
-            }
-        }
-
-        if (this->m_FourierCoeffSendF == NULL) {
-            try{this->m_FourierCoeffSendF = new ScalarType[this->m_nAllocSend*2];}
-            catch (std::bad_alloc&) {
-                ierr = reg::ThrowError("allocation failed"); CHKERRQ(ierr);
-            }
-        }
+        ierr = Assert(this->m_FourierCoeffSendF != NULL, "error in setup"); CHKERRQ(ierr);
 
         for (int p = 0; p < nprocs; ++p) {
             n = this->m_NumSend[p];
@@ -1398,18 +1896,7 @@ PetscErrorCode Preprocessing::GridChangeCommDataRestrict() {
     }
 
     if (this->m_nAllocRecv > 0) {
-        if (this->m_ResetGridChangeOps) {
-            if (this->m_FourierCoeffRecvF != NULL) {
-                delete [] this->m_FourierCoeffRecvF;
-                this->m_FourierCoeffRecvF=NULL;
-            }
-        }
-        if (this->m_FourierCoeffRecvF == NULL) {
-            try{this->m_FourierCoeffRecvF = new ScalarType[this->m_nAllocRecv*2];}
-            catch (std::bad_alloc&) {
-                ierr = reg::ThrowError("allocation failed"); CHKERRQ(ierr);
-            }
-        }
+        ierr = Assert(this->m_FourierCoeffRecvF != NULL, "error in setup"); CHKERRQ(ierr);
     }
 
 
@@ -1447,6 +1934,8 @@ PetscErrorCode Preprocessing::GridChangeCommDataRestrict() {
         }
     }
 
+    ierr = this->CountGridChangeComm(this->m_NumSend, this->m_NumRecv, 2*sizeof(ScalarType)); CHKERRQ(ierr);
+
     this->m_Opt->Exit(__func__);
 
     PetscFunctionReturn(0);
@@ -1497,18 +1986,7 @@ PetscErrorCode Preprocessing::GridChangeCommDataProlong() {
 
     // if we actually need to allocate something
     if (this->m_nAllocRecv > 0) {
-        if (this->m_ResetGridChangeOps) {
-            if (this->m_FourierCoeffSendC != NULL) {
-                delete [] this->m_FourierCoeffSendC;
-                this->m_FourierCoeffSendC = NULL;
-            }
-        }
-        if (this->m_FourierCoeffSendC == NULL) {
-            try{this->m_FourierCoeffSendC = new ScalarType[this->m_nAllocRecv*2];}
-            catch (std::bad_alloc&) {
-                ierr = reg::ThrowError("allocation failed"); CHKERRQ(ierr);
-            }
-        }
+        ierr = Assert(this->m_FourierCoeffSendC != NULL, "error in setup"); CHKERRQ(ierr);
 
         for (int p = 0; p < nprocs; ++p) {
             n = this->m_NumRecv[p];
@@ -1540,19 +2018,7 @@ PetscErrorCode Preprocessing::GridChangeCommDataProlong() {
     }
 
     if (this->m_nAllocSend > 0) {
-        if (this->m_ResetGridChangeOps) {
-            if (this->m_FourierCoeffRecvC != NULL) {
-                delete [] this->m_FourierCoeffRecvC;
-                this->m_FourierCoeffRecvC = NULL;
-            }
-        }
-
-        if (this->m_FourierCoeffRecvC == NULL) {
-            try{this->m_FourierCoeffRecvC = new ScalarType[this->m_nAllocSend*2];}
-            catch (std::bad_alloc&) {
-                ierr = reg::ThrowError("allocation failed"); CHKERRQ(ierr);
-            }
-        }
+        ierr = Assert(this->m_FourierCoeffRecvC != NULL, "error in setup"); CHKERRQ(ierr);
     }
 
     // send and recv fourier coefficients on fine grid
@@ -1589,6 +2055,9 @@ PetscErrorCode Preprocessing::GridChangeCommDataProlong() {
         }
     }
 
+    // prolongation is the adjoint of the restriction
+    ierr = this->CountGridChangeComm(this->m_NumRecv, this->m_NumSend, 2*sizeof(ScalarType)); CHKERRQ(ierr);
+
     this->m_Opt->Exit(__func__);
 
     PetscFunctionReturn(0);
@@ -1669,20 +2138,17 @@ PetscErrorCode Preprocessing::Prolong(Vec* x_f, Vec x_c, IntType* nx_f, IntType*
         nyqfreqid[i] = static_cast<IntType>(std::ceil(value));
     }
 
-    if (this->m_ResetGridChangeOps) {
-        this->m_GridChangeOpsSet = false;
-        this->m_GridChangeIndicesComputed = false;
-    }
-
-    // set up fft operators
-    if (!this->m_GridChangeOpsSet) {
-        ierr = this->SetupGridChangeOps(nx_f, nx_c); CHKERRQ(ierr);
-    }
+    // set up fft operators (cheap if cached)
+    ierr = this->SetupGridChangeOps(nx_f, nx_c); CHKERRQ(ierr);
 
     n  = this->m_osizeF[0];
     n *= this->m_osizeF[1];
     n *= this->m_osizeF[2];
 
+    // the buffers for the spectra are overwritten
+    this->m_GridChangeOps->fine->xhatvalid = false;
+    this->m_GridChangeOps->coarse->xhatvalid = false;
+
 #pragma omp parallel
 {
     IntType l;
@@ -1932,6 +2398,9 @@ PetscErrorCode Preprocessing::ApplyRectFreqFilter(Vec xflt, Vec x, ScalarType pc
  *******************************************************************/
 PetscErrorCode Preprocessing::Smooth(Vec xs, Vec x, IntType nc) {
     PetscErrorCode ierr = 0;
+    Vec xref = NULL;
+    ScalarType nref, nerr;
+    std::stringstream ss;
 
     PetscFunctionBegin;
 
@@ -1940,7 +2409,25 @@ PetscErrorCode Preprocessing::Smooth(Vec xs, Vec x, IntType nc) {
     ierr = Assert(x != NULL, "null pointer"); CHKERRQ(ierr);
     ierr = Assert(xs != NULL, "null pointer"); CHKERRQ(ierr);
 
-    ierr = this->GaussianSmoothing(xs, x, nc); CHKERRQ(ierr);
+    if (this->m_Opt->m_RegFlags.recursivesmoothing) {
+        if (this->m_Opt->m_Verbosity > 2) {
+            // check accuracy against spectral smoothing
+            ierr = VecDuplicate(xs, &xref); CHKERRQ(ierr);
+            ierr = this->GaussianSmoothing(xref, x, nc); CHKERRQ(ierr);
+        }
+        ierr = this->RecursiveGaussianSmoothing(xs, x, nc); CHKERRQ(ierr);
+        if (xref != NULL) {
+            ierr = VecNorm(xref, NORM_2, &nref); CHKERRQ(ierr);
+            ierr = VecAXPY(xref, -1.0, xs); CHKERRQ(ierr);
+            ierr = VecNorm(xref, NORM_2, &nerr); CHKERRQ(ierr);
+            ss << "recursive smoothing: rel. difference to spectral smoothing "
+               << std::scientific << (nref > 0.0 ? nerr/nref : nerr);
+            ierr = DbgMsg(ss.str()); CHKERRQ(ierr);
+            ierr = VecDestroy(&xref); CHKERRQ(ierr);
+        }
+    } else {
+        ierr = this->GaussianSmoothing(xs, x, nc); CHKERRQ(ierr);
+    }
 
     this->m_Opt->Exit(__func__);
 
@@ -2048,6 +2535,256 @@ PetscErrorCode Preprocessing::GaussianSmoothing(Vec xs, Vec x, IntType nc) {
 
 
 
+/********************************************************************
+ * @brief apply gaussian smoothing operator to input data using
+ * separable recursive filters (young and van vliet, signal processing
+ * 44:139-151, 1995) in real space; this avoids the forward and inverse
+ * distributed fft (i.e., the transposes); lines along the distributed
+ * directions are filtered in a pipelined sweep across the ranks that
+ * share these lines; boundary conditions are periodic (as for the
+ * spectral implementation)
+ *******************************************************************/
+PetscErrorCode Preprocessing::RecursiveGaussianSmoothing(Vec xs, Vec x, IntType nc) {
+    PetscErrorCode ierr = 0;
+    IntType nl, nx[3];
+    ScalarType *p_xs = NULL;
+    MPI_Comm linecomm[3];
+    int color, key, merr;
+    std::stringstream ss;
+
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    ierr = Assert(x != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(xs != NULL, "null pointer"); CHKERRQ(ierr);
+
+    nl = this->m_Opt->m_Domain.nl;
+    for (int i = 0; i < 3; ++i) {
+        nx[i] = this->m_Opt->m_Domain.nx[i];
+    }
+
+    if (this->m_Opt->m_Verbosity > 1) {
+        ss << "applying recursive smoothing: ("
+           << this->m_Opt->m_Sigma[0]
+           << ", " << this->m_Opt->m_Sigma[1]
+           << ", " << this->m_Opt->m_Sigma[2] << ")";
+        ierr = DbgMsg(ss.str()); CHKERRQ(ierr);
+        ss.clear(); ss.str(std::string());
+    }
+
+    if (xs != x) {
+        ierr = VecCopy(x, xs); CHKERRQ(ierr);
+    }
+
+    // ranks that share lines along direction i (ordered along the line)
+    for (int i = 0; i < 3; ++i) {
+        int j = (i + 1) % 3, k = (i + 2) % 3;
+        color = static_cast<int>(this->m_Opt->m_Domain.istart[j]*nx[k] + this->m_Opt->m_Domain.istart[k]);
+        key   = static_cast<int>(this->m_Opt->m_Domain.istart[i]);
+        merr = MPI_Comm_split(PETSC_COMM_WORLD, color, key, &linecomm[i]);
+        ierr = MPIERRQ(merr); CHKERRQ(ierr);
+    }
+
+    ierr = VecGetArray(xs, &p_xs); CHKERRQ(ierr);
+    for (IntType k = 0; k < nc; ++k) {
+        for (int i = 0; i < 3; ++i) {
+            ierr = this->RecursiveGaussianFilter(p_xs + k*nl, i, linecomm[i]); CHKERRQ(ierr);
+        }
+    }
+    ierr = VecRestoreArray(xs, &p_xs); CHKERRQ(ierr);
+
+    for (int i = 0; i < 3; ++i) {
+        MPI_Comm_free(&linecomm[i]);
+    }
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief apply recursive gaussian filter (causal and anti-causal
+ * pass) along one direction; the filter state is passed along the
+ * line from rank to rank (in chunks of lines, so that ranks work
+ * concurrently on different chunks); the periodic boundary condition
+ * is enforced exactly: the state at the end of a zero-initialized
+ * pass s0 gives the periodic state s = (I - A^N)^{-1} s0 (A is the
+ * companion matrix of the filter), whose homogeneous response is
+ * added to the zero-initialized result
+ * @param p_x data (filtered in place)
+ * @param dim direction
+ * @param comm ranks that share lines along dim
+ *******************************************************************/
+PetscErrorCode Preprocessing::RecursiveGaussianFilter(ScalarType* p_x, int dim, MPI_Comm comm) {
+    PetscErrorCode ierr = 0;
+    int rank, nprocs, merr, nchunks, o1, o2;
+    IntType n, nn, start, nlines, stride[3], isize[3];
+    double sigma, q, b0, b1, b2, b3, A[9], AN[9], Ao[9], M[9], T[9], det;
+    ScalarType a[3], B;
+    std::vector<ScalarType> state;
+    std::vector<MPI_Request> request;
+
+    PetscFunctionBegin;
+
+    sigma = static_cast<double>(this->m_Opt->m_Sigma[dim]);
+
+    // the filter is not defined for small kernels (close to identity)
+    if (sigma < 0.5) {
+        PetscFunctionReturn(ierr);
+    }
+
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &nprocs);
+
+    // filter coefficients (young and van vliet, 1995)
+    if (sigma >= 2.5) {
+        q = 0.98711*sigma - 0.96330;
+    } else {
+        q = 3.97156 - 4.14554*sqrt(1.0 - 0.26891*sigma);
+    }
+    b0 = 1.57825 + 2.44413*q + 1.4281*q*q + 0.422205*q*q*q;
+    b1 = 2.44413*q + 2.85619*q*q + 1.26661*q*q*q;
+    b2 = -(1.4281*q*q + 1.26661*q*q*q);
+    b3 = 0.422205*q*q*q;
+    a[0] = static_cast<ScalarType>(b1/b0);
+    a[1] = static_cast<ScalarType>(b2/b0);
+    a[2] = static_cast<ScalarType>(b3/b0);
+    B = static_cast<ScalarType>(1.0 - (b1 + b2 + b3)/b0);
+
+    // companion matrix (row major)
+    A[0] = b1/b0; A[1] = b2/b0; A[2] = b3/b0;
+    A[3] = 1.0;   A[4] = 0.0;   A[5] = 0.0;
+    A[6] = 0.0;   A[7] = 1.0;   A[8] = 0.0;
+
+    // T = A^m (by repeated multiplication; m is at most the grid size)
+    auto matpow = [&A](double* P, IntType m) {
+        double R[9];
+        for (int i = 0; i < 9; ++i) P[i] = (i % 4 == 0) ? 1.0 : 0.0;
+        for (IntType l = 0; l < m; ++l) {
+            for (int i = 0; i < 3; ++i) {
+                for (int j = 0; j < 3; ++j) {
+                    R[3*i+j] = A[3*i]*P[j] + A[3*i+1]*P[3+j] + A[3*i+2]*P[6+j];
+                }
+            }
+            for (int i = 0; i < 9; ++i) P[i] = R[i];
+        }
+    };
+
+    for (int i = 0; i < 3; ++i) {
+        isize[i] = this->m_Opt->m_Domain.isize[i];
+    }
+    stride[0] = isize[1]*isize[2];
+    stride[1] = isize[2];
+    stride[2] = 1;
+    o1 = (dim + 1) % 3;
+    o2 = (dim + 2) % 3;
+    n      = isize[dim];
+    nn     = this->m_Opt->m_Domain.nx[dim];
+    start  = this->m_Opt->m_Domain.istart[dim];
+    nlines = isize[o1]*isize[o2];
+
+    // M = (I - A^N)^{-1}
+    matpow(AN, nn);
+    for (int i = 0; i < 9; ++i) T[i] = ((i % 4 == 0) ? 1.0 : 0.0) - AN[i];
+    det = T[0]*(T[4]*T[8] - T[5]*T[7]) - T[1]*(T[3]*T[8] - T[5]*T[6]) + T[2]*(T[3]*T[7] - T[4]*T[6]);
+    ierr = Assert(det != 0.0, "recursive filter: singular matrix"); CHKERRQ(ierr);
+    M[0] =  (T[4]*T[8] - T[5]*T[7])/det;
+    M[1] = -(T[1]*T[8] - T[2]*T[7])/det;
+    M[2] =  (T[1]*T[5] - T[2]*T[4])/det;
+    M[3] = -(T[3]*T[8] - T[5]*T[6])/det;
+    M[4] =  (T[0]*T[8] - T[2]*T[6])/det;
+    M[5] = -(T[0]*T[5] - T[2]*T[3])/det;
+    M[6] =  (T[3]*T[7] - T[4]*T[6])/det;
+    M[7] = -(T[0]*T[7] - T[1]*T[6])/det;
+    M[8] =  (T[0]*T[4] - T[1]*T[3])/det;
+
+    nchunks = nprocs > 1 ? static_cast<int>(PetscMin(nlines, 4*nprocs)) : 1;
+    state.resize(3*nlines);
+    request.resize(nchunks);
+
+    // causal (forward) and anti-causal (backward) pass
+    for (int pass = 0; pass < 2; ++pass) {
+        bool backward = (pass == 1);
+        int prev = backward ? rank + 1 : rank - 1;
+        int next = backward ? rank - 1 : rank + 1;
+        int root = backward ? 0 : nprocs - 1;
+        IntType offset = backward ? nn - start - n : start;
+
+        for (int c = 0; c < nchunks; ++c) {
+            IntType lo = (c*nlines)/nchunks, hi = ((c + 1)*nlines)/nchunks;
+
+            // state at the beginning of local segment (zero at the first rank)
+            if (prev >= 0 && prev < nprocs) {
+                merr = MPI_Recv(&state[3*lo], 3*(hi - lo), MPIU_REAL, prev, c, comm, MPI_STATUS_IGNORE);
+                ierr = MPIERRQ(merr); CHKERRQ(ierr);
+            } else {
+                for (IntType l = 3*lo; l < 3*hi; ++l) state[l] = 0.0;
+            }
+
+#pragma omp parallel for
+            for (IntType l = lo; l < hi; ++l) {
+                IntType base = (l / isize[o2])*stride[o1] + (l % isize[o2])*stride[o2];
+                ScalarType w, s0 = state[3*l], s1 = state[3*l+1], s2 = state[3*l+2];
+                for (IntType i = 0; i < n; ++i) {
+                    IntType li = base + (backward ? n - 1 - i : i)*stride[dim];
+                    w = B*p_x[li] + a[0]*s0 + a[1]*s1 + a[2]*s2;
+                    p_x[li] = w;
+                    s2 = s1; s1 = s0; s0 = w;
+                }
+                state[3*l] = s0; state[3*l+1] = s1; state[3*l+2] = s2;
+            }
+
+            request[c] = MPI_REQUEST_NULL;
+            if (next >= 0 && next < nprocs) {
+                merr = MPI_Isend(&state[3*lo], 3*(hi - lo), MPIU_REAL, next, c, comm, &request[c]);
+                ierr = MPIERRQ(merr); CHKERRQ(ierr);
+            }
+        }
+        merr = MPI_Waitall(nchunks, &request[0], MPI_STATUSES_IGNORE);
+        ierr = MPIERRQ(merr); CHKERRQ(ierr);
+
+        // periodic state (computed on the last rank along the sweep)
+        if (rank == root) {
+            for (IntType l = 0; l < nlines; ++l) {
+                double s[3] = {state[3*l], state[3*l+1], state[3*l+2]};
+                for (int i = 0; i < 3; ++i) {
+                    state[3*l+i] = static_cast<ScalarType>(M[3*i]*s[0] + M[3*i+1]*s[1] + M[3*i+2]*s[2]);
+                }
+            }
+        }
+        if (nprocs > 1) {
+            merr = MPI_Bcast(&state[0], 3*nlines, MPIU_REAL, root, comm);
+            ierr = MPIERRQ(merr); CHKERRQ(ierr);
+        }
+
+        // add homogeneous response to periodic state
+        matpow(Ao, offset);
+#pragma omp parallel for
+        for (IntType l = 0; l < nlines; ++l) {
+            IntType base = (l / isize[o2])*stride[o1] + (l % isize[o2])*stride[o2];
+            ScalarType h, h0, h1, h2;
+            h0 = static_cast<ScalarType>(Ao[0]*state[3*l] + Ao[1]*state[3*l+1] + Ao[2]*state[3*l+2]);
+            h1 = static_cast<ScalarType>(Ao[3]*state[3*l] + Ao[4]*state[3*l+1] + Ao[5]*state[3*l+2]);
+            h2 = static_cast<ScalarType>(Ao[6]*state[3*l] + Ao[7]*state[3*l+1] + Ao[8]*state[3*l+2]);
+            for (IntType i = 0; i < n; ++i) {
+                IntType li = base + (backward ? n - 1 - i : i)*stride[dim];
+                h = a[0]*h0 + a[1]*h1 + a[2]*h2;
+                p_x[li] += h;
+                h2 = h1; h1 = h0; h0 = h;
+            }
+        }
+    }
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
 }  // namespace reg
 
 
@@ -33,6 +33,20 @@ namespace reg {
 
 
 
+#ifdef REG_HAS_NIFTI
+/*! nifti_clib is not thread safe (global options and state); calls
+ *  that read files or set up and free images are serialized with this
+ *  mutex; the pure string helpers (file extension, base, header and
+ *  image names) are reentrant and are called without the lock; the
+ *  background writers (see WriterLoop) own a deep copy of the image
+ *  with the file names already set and do not take the lock, so that
+ *  enqueueing an image never waits for the write in flight */
+static std::mutex s_NIfTIMutex;
+#endif
+
+
+
+
 /********************************************************************
  * @brief default constructor
  *******************************************************************/
@@ -100,6 +114,7 @@ PetscErrorCode ReadWriteReg::Initialize() {
 
 #ifdef REG_HAS_NIFTI
     this->m_ImageData = NULL;
+    this->m_StopWriter = false;
 #endif
 
     this->m_NumProcs = 0;
@@ -113,6 +128,14 @@ PetscErrorCode ReadWriteReg::Initialize() {
     this->m_nx[1] = -1;
     this->m_nx[2] = -1;
 
+    this->m_TimeSeriesNC = 0;
+    this->m_TimeSeriesRecord = 0;
+    this->m_TimeSeriesSlice = NULL;
+#ifdef REG_HAS_PNETCDF
+    this->m_TimeSeriesFile = -1;
+    this->m_TimeSeriesVar = -1;
+#endif
+
     PetscFunctionReturn(ierr);
 }
 
@@ -126,6 +149,18 @@ PetscErrorCode ReadWriteReg::ClearMemory() {
     PetscErrorCode ierr = 0;
     PetscFunctionBegin;
 
+#ifdef REG_HAS_NIFTI
+    // write pending output and stop background writer
+    if (this->m_Writer.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(this->m_WriteQueueMutex);
+            this->m_StopWriter = true;
+        }
+        this->m_WriteQueueCond.notify_all();
+        this->m_Writer.join();
+    }
+#endif
+
     if (this->m_Data != NULL) {
         delete [] this->m_Data;
         this->m_Data = NULL;
@@ -147,19 +182,33 @@ PetscErrorCode ReadWriteReg::ClearMemory() {
         this->m_nSend = NULL;
     }
 
-#ifdef REG_HAS_NIFTI
-    if (this->m_ReferenceImage.data != NULL) {
-        nifti_image_free(this->m_ReferenceImage.data);
-        this->m_ReferenceImage.data = NULL;
+#ifdef REG_HAS_PNETCDF
+    if (this->m_TimeSeriesFile != -1) {
+        ncmpi_close(this->m_TimeSeriesFile);
+        this->m_TimeSeriesFile = -1;
     }
-    if (this->m_TemplateImage.data != NULL) {
-        nifti_image_free(this->m_TemplateImage.data);
-        this->m_TemplateImage.data = NULL;
+#endif
+    if (this->m_TimeSeriesSlice != NULL) {
+        ierr = VecDestroy(&this->m_TimeSeriesSlice); CHKERRQ(ierr);
+        this->m_TimeSeriesSlice = NULL;
     }
 
-    if (this->m_ImageData != NULL) {
-        nifti_image_free(this->m_ImageData);
-        this->m_ImageData = NULL;
+#ifdef REG_HAS_NIFTI
+    {
+        std::lock_guard<std::mutex> lock(s_NIfTIMutex);
+        if (this->m_ReferenceImage.data != NULL) {
+            nifti_image_free(this->m_ReferenceImage.data);
+            this->m_ReferenceImage.data = NULL;
+        }
+        if (this->m_TemplateImage.data != NULL) {
+            nifti_image_free(this->m_TemplateImage.data);
+            this->m_TemplateImage.data = NULL;
+        }
+
+        if (this->m_ImageData != NULL) {
+            nifti_image_free(this->m_ImageData);
+            this->m_ImageData = NULL;
+        }
     }
 #endif
 
@@ -263,6 +312,7 @@ PetscErrorCode ReadWriteReg::ReadR(Vec* x, std::vector< std::string > filenames)
 
 #ifdef REG_HAS_NIFTI
     if (this->m_ReferenceImage.data != NULL) {
+        std::lock_guard<std::mutex> lock(s_NIfTIMutex);
         nifti_image_free(this->m_ReferenceImage.data);
         this->m_ReferenceImage.data = NULL;
     }
@@ -298,6 +348,7 @@ PetscErrorCode ReadWriteReg::ReadT(Vec* x, std::vector< std::string > filenames)
 
 #ifdef REG_HAS_NIFTI
     if (this->m_TemplateImage.data != NULL) {
+        std::lock_guard<std::mutex> lock(s_NIfTIMutex);
         nifti_image_free(this->m_TemplateImage.data);
         this->m_TemplateImage.data = NULL;
     }
@@ -462,6 +513,12 @@ PetscErrorCode ReadWriteReg::Read(Vec* x) {
         ierr = this->ReadNII(x); CHKERRQ(ierr);
 #else
         ierr = ThrowError("install nifit library/enable nifti support"); CHKERRQ(ierr);
+#endif
+    } else if (this->m_FileName.find(".clr") != std::string::npos) {
+#ifdef REG_HAS_ZLIB
+        ierr = this->ReadCLR(x); CHKERRQ(ierr);
+#else
+        ierr = ThrowError("install zlib library/enable zlib support"); CHKERRQ(ierr);
 #endif
     } else if (this->m_FileName.find(".bin") != std::string::npos) {
         ierr = this->ReadBIN(x); CHKERRQ(ierr);
@@ -730,6 +787,12 @@ PetscErrorCode ReadWriteReg::Write(Vec x) {
         ierr = this->WriteNII(x); CHKERRQ(ierr);
 #else
         ierr = ThrowError("install nifit library/enable nifti support"); CHKERRQ(ierr);
+#endif
+    } else if (this->m_FileName.find(".clr") != std::string::npos) {
+#ifdef REG_HAS_ZLIB
+        ierr = this->WriteCLR(x); CHKERRQ(ierr);
+#else
+        ierr = ThrowError("install zlib library/enable zlib support"); CHKERRQ(ierr);
 #endif
     } else if (this->m_FileName.find(".bin") != std::string::npos) {
         ierr = this->WriteBIN(x); CHKERRQ(ierr);
@@ -751,6 +814,212 @@ PetscErrorCode ReadWriteReg::Write(Vec x) {
 
 
 
+/********************************************************************
+ * @brief open time series for streaming output; the time points are
+ * appended one by one (see AppendTimeSeries), so that the caller does
+ * not have to keep the entire space-time field in memory; for netcdf
+ * output (*.nc) all time points are stored in a single file (record
+ * dimension t); for all other formats we write one file per time point
+ * @param[in] filename name of time series (without extension; the
+ * extension is taken from the output format set by the user)
+ * @param[in] nc number of components per time point
+ *******************************************************************/
+PetscErrorCode ReadWriteReg::OpenTimeSeries(std::string filename, IntType nc) {
+    PetscErrorCode ierr = 0;
+#ifdef REG_HAS_PNETCDF
+    int ncerr, mode, dims[5], nx[3], iscdf5;
+    std::string name;
+#endif
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    ierr = Assert(!filename.empty(), "filename not set"); CHKERRQ(ierr);
+    ierr = Assert(nc > 0, "nc <= 0"); CHKERRQ(ierr);
+
+    // close time series that is still open
+    ierr = this->CloseTimeSeries(); CHKERRQ(ierr);
+
+    this->m_TimeSeriesName = filename;
+    this->m_TimeSeriesExt = this->m_Opt->m_FileNames.extension;
+    this->m_TimeSeriesNC = nc;
+    this->m_TimeSeriesRecord = 0;
+
+    if (this->m_TimeSeriesExt.find(".nc") != std::string::npos) {
+#ifdef REG_HAS_PNETCDF
+        name = this->m_Opt->m_FileNames.xfolder + filename + this->m_TimeSeriesExt;
+        if (this->m_Opt->m_Verbosity > 2) {
+            ierr = DbgMsg("opening time series " + filename + this->m_TimeSeriesExt); CHKERRQ(ierr);
+        }
+
+        mode = NC_CLOBBER | NC_64BIT_OFFSET;
+        ncerr = ncmpi_create(this->m_Opt->m_FFT.mpicomm, name.c_str(), mode,
+                             MPI_INFO_NULL, &this->m_TimeSeriesFile);
+        ierr = NCERRQ(ncerr); CHKERRQ(ierr);
+
+        nx[0] = static_cast<int>(this->m_Opt->m_Domain.nx[0]);
+        nx[1] = static_cast<int>(this->m_Opt->m_Domain.nx[1]);
+        nx[2] = static_cast<int>(this->m_Opt->m_Domain.nx[2]);
+
+        // time is the record (unlimited) dimension
+        ncerr = ncmpi_def_dim(this->m_TimeSeriesFile, "t", NC_UNLIMITED, &dims[0]);
+        ierr = NCERRQ(ncerr); CHKERRQ(ierr);
+        ncerr = ncmpi_def_dim(this->m_TimeSeriesFile, "c", static_cast<int>(nc), &dims[1]);
+        ierr = NCERRQ(ncerr); CHKERRQ(ierr);
+        ncerr = ncmpi_def_dim(this->m_TimeSeriesFile, "x", nx[0], &dims[2]);
+        ierr = NCERRQ(ncerr); CHKERRQ(ierr);
+        ncerr = ncmpi_def_dim(this->m_TimeSeriesFile, "y", nx[1], &dims[3]);
+        ierr = NCERRQ(ncerr); CHKERRQ(ierr);
+        ncerr = ncmpi_def_dim(this->m_TimeSeriesFile, "z", nx[2], &dims[4]);
+        ierr = NCERRQ(ncerr); CHKERRQ(ierr);
+
+#if defined(PETSC_USE_REAL_SINGLE)
+        ncerr = ncmpi_def_var(this->m_TimeSeriesFile, "data", NC_FLOAT, 5, dims, &this->m_TimeSeriesVar);
+#else
+        ncerr = ncmpi_def_var(this->m_TimeSeriesFile, "data", NC_DOUBLE, 5, dims, &this->m_TimeSeriesVar);
+#endif
+        ierr = NCERRQ(ncerr); CHKERRQ(ierr);
+
+        iscdf5 = 0;
+        ncerr = ncmpi_put_att_int(this->m_TimeSeriesFile, NC_GLOBAL, "CDF-5 mode", NC_INT, 1, &iscdf5);
+        ierr = NCERRQ(ncerr); CHKERRQ(ierr);
+        ncerr = ncmpi_enddef(this->m_TimeSeriesFile);
+        ierr = NCERRQ(ncerr); CHKERRQ(ierr);
+#else
+        ierr = ThrowError("install pnetcdf library/enable pnetcdf support"); CHKERRQ(ierr);
+#endif
+    } else if (this->m_TimeSeriesSlice == NULL) {
+        ierr = VecCreate(this->m_TimeSeriesSlice, this->m_Opt->m_Domain.nl,
+                                                  this->m_Opt->m_Domain.ng); CHKERRQ(ierr);
+    }
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief append time point to time series opened with OpenTimeSeries
+ * @param[in] x vector that contains the time point
+ * @param[in] j index of time point in x (x is either a single time
+ * point of size nc*nl or the entire space-time field)
+ *******************************************************************/
+PetscErrorCode ReadWriteReg::AppendTimeSeries(Vec x, IntType j) {
+    PetscErrorCode ierr = 0;
+    IntType nl, nc, offset;
+    const ScalarType *p_x = NULL;
+    ScalarType *p_xk = NULL;
+    std::stringstream ss;
+    bool written = false;
+#ifdef REG_HAS_PNETCDF
+    int ncerr;
+    MPI_Offset istart[5], isize[5];
+#endif
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    ierr = Assert(x != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(!this->m_TimeSeriesName.empty(), "time series not open"); CHKERRQ(ierr);
+
+    nl = this->m_Opt->m_Domain.nl;
+    nc = this->m_TimeSeriesNC;
+    offset = j*nc*nl;
+
+    ierr = VecGetArrayRead(x, &p_x); CHKERRQ(ierr);
+#ifdef REG_HAS_PNETCDF
+    if (this->m_TimeSeriesFile != -1) {
+        istart[0] = static_cast<MPI_Offset>(this->m_TimeSeriesRecord);
+        istart[1] = 0;
+        istart[2] = static_cast<MPI_Offset>(this->m_Opt->m_Domain.istart[0]);
+        istart[3] = static_cast<MPI_Offset>(this->m_Opt->m_Domain.istart[1]);
+        istart[4] = static_cast<MPI_Offset>(this->m_Opt->m_Domain.istart[2]);
+
+        isize[0] = 1;
+        isize[1] = static_cast<MPI_Offset>(nc);
+        isize[2] = static_cast<MPI_Offset>(this->m_Opt->m_Domain.isize[0]);
+        isize[3] = static_cast<MPI_Offset>(this->m_Opt->m_Domain.isize[1]);
+        isize[4] = static_cast<MPI_Offset>(this->m_Opt->m_Domain.isize[2]);
+
+        // components are stored one after another; this matches the
+        // layout of the (c,x,y,z) block of one record
+        ncerr = ncmpi_put_vara_all(this->m_TimeSeriesFile, this->m_TimeSeriesVar,
+                                   istart, isize, p_x + offset, nc*nl, MPIU_SCALAR);
+        ierr = NCERRQ(ncerr); CHKERRQ(ierr);
+        written = true;
+    }
+#endif
+    if (!written) {
+        ierr = Assert(this->m_TimeSeriesSlice != NULL, "null pointer"); CHKERRQ(ierr);
+        // one file per time point and component
+        for (IntType k = 0; k < nc; ++k) {
+            ierr = VecGetArray(this->m_TimeSeriesSlice, &p_xk); CHKERRQ(ierr);
+            try {std::copy(p_x+offset+k*nl, p_x+offset+(k+1)*nl, p_xk);}
+            catch (std::exception& err) {
+                ierr = ThrowError(err); CHKERRQ(ierr);
+            }
+            ierr = VecRestoreArray(this->m_TimeSeriesSlice, &p_xk); CHKERRQ(ierr);
+
+            ss.str(std::string()); ss.clear();
+            if (nc > 1) {
+                ss << this->m_TimeSeriesName
+                   << "-k=" << std::setw(3) << std::setfill('0') << k
+                   << "-j=" << std::setw(3) << std::setfill('0') << this->m_TimeSeriesRecord
+                   << this->m_TimeSeriesExt;
+            } else {
+                ss << this->m_TimeSeriesName
+                   << "-j=" << std::setw(3) << std::setfill('0') << this->m_TimeSeriesRecord
+                   << this->m_TimeSeriesExt;
+            }
+            ierr = this->Write(this->m_TimeSeriesSlice, ss.str()); CHKERRQ(ierr);
+        }
+    }
+    ierr = VecRestoreArrayRead(x, &p_x); CHKERRQ(ierr);
+
+    this->m_TimeSeriesRecord++;
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief close time series (does nothing if no time series is open)
+ *******************************************************************/
+PetscErrorCode ReadWriteReg::CloseTimeSeries() {
+    PetscErrorCode ierr = 0;
+#ifdef REG_HAS_PNETCDF
+    int ncerr;
+#endif
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+#ifdef REG_HAS_PNETCDF
+    if (this->m_TimeSeriesFile != -1) {
+        ncerr = ncmpi_close(this->m_TimeSeriesFile);
+        this->m_TimeSeriesFile = -1;
+        ierr = NCERRQ(ncerr); CHKERRQ(ierr);
+    }
+#endif
+
+    this->m_TimeSeriesName.clear();
+    this->m_TimeSeriesRecord = 0;
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
 /********************************************************************
  * @brief write data to file
  *******************************************************************/
@@ -795,25 +1064,18 @@ PetscErrorCode ReadWriteReg::ReadNII(Vec* x) {
     PetscErrorCode ierr = 0;
     std::string file;
     std::stringstream ss;
-    int rank, rval;
     IntType ng, nl, nglobal, nx[3];
-    ScalarType *p_x = NULL;
     nifti_image *image = NULL;
 
     PetscFunctionBegin;
 
     this->m_Opt->Enter(__func__);
 
-    MPI_Comm_rank(PETSC_COMM_WORLD, &rank);
-
     // get file name without path
     ierr = GetFileName(file, this->m_FileName); CHKERRQ(ierr);
 
-    // read header file
-    image = nifti_image_read(this->m_FileName.c_str(), false);
-    ss << "could not read image " + file;
-    ierr = Assert(image != NULL, ss.str()); CHKERRQ(ierr);
-    ss.clear(); ss.str(std::string());
+    // read header file (parsed on master rank and broadcast)
+    ierr = this->ReadNIIHeader(&image); CHKERRQ(ierr);
 
     // get number of grid points
 //    nx[0] = static_cast<IntType>(image->nx);
@@ -911,17 +1173,11 @@ PetscErrorCode ReadWriteReg::ReadNII(Vec* x) {
     ierr = this->CollectSizes(); CHKERRQ(ierr);
 
     // read the image data
-    if (rank == 0) {
-        ierr = this->ReadNII(image); CHKERRQ(ierr);
-    }
-
-    ierr = VecGetArray(*x, &p_x); CHKERRQ(ierr);
-    rval = MPI_Scatterv(this->m_Data, this->m_nSend, this->m_nOffset, MPIU_SCALAR, p_x, nl, MPIU_SCALAR, 0, PETSC_COMM_WORLD);
-    ierr = MPIERRQ(rval); CHKERRQ(ierr);
-    ierr = VecRestoreArray(*x, &p_x); CHKERRQ(ierr);
+    ierr = this->ReadNII(image, *x); CHKERRQ(ierr);
 
     if (!this->m_ReferenceImage.read && !this->m_TemplateImage.read) {
         if (image != NULL) {
+            std::lock_guard<std::mutex> lock(s_NIfTIMutex);
             nifti_image_free(image); image = NULL;
         }
     }
@@ -935,24 +1191,104 @@ PetscErrorCode ReadWriteReg::ReadNII(Vec* x) {
 
 
 
+/********************************************************************
+ * @brief read header of nifti image on master rank and broadcast it
+ * (including file names and offset of the image data), so that the
+ * file system is not hit by all ranks; the data itself is not read
+ *******************************************************************/
+#ifdef REG_HAS_NIFTI
+PetscErrorCode ReadWriteReg::ReadNIIHeader(nifti_image** image) {
+    PetscErrorCode ierr = 0;
+    int rank, rval, valid = 0;
+    int64_t info[5];
+    struct nifti_1_header hdr;
+    char* names = NULL;
+    std::string file, msg;
+
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    MPI_Comm_rank(PETSC_COMM_WORLD, &rank);
+
+    // get file name without path
+    ierr = GetFileName(file, this->m_FileName); CHKERRQ(ierr);
+
+    if (rank == 0) {
+        std::lock_guard<std::mutex> lock(s_NIfTIMutex);
+        *image = nifti_image_read(this->m_FileName.c_str(), false);
+        valid = (*image != NULL) ? 1 : 0;
+    }
+
+    // fail on all ranks together
+    rval = MPI_Bcast(&valid, 1, MPI_INT, 0, PETSC_COMM_WORLD);
+    ierr = MPIERRQ(rval); CHKERRQ(ierr);
+    msg = "could not read image " + file;
+    ierr = Assert(valid == 1, msg); CHKERRQ(ierr);
+
+    // the header does not store the file names, the byte order
+    // and the file type; we broadcast them separately
+    if (rank == 0) {
+        std::lock_guard<std::mutex> lock(s_NIfTIMutex);
+        hdr = nifti_convert_nim2nhdr(*image);
+        info[0] = static_cast<int64_t>((*image)->byte_order);
+        info[1] = static_cast<int64_t>((*image)->iname_offset);
+        info[2] = static_cast<int64_t>((*image)->nifti_type);
+        info[3] = static_cast<int64_t>(strlen((*image)->fname) + 1);
+        info[4] = static_cast<int64_t>(strlen((*image)->iname) + 1);
+    }
+    rval = MPI_Bcast(&hdr, sizeof(hdr), MPI_BYTE, 0, PETSC_COMM_WORLD);
+    ierr = MPIERRQ(rval); CHKERRQ(ierr);
+    rval = MPI_Bcast(info, 5, MPI_INT64_T, 0, PETSC_COMM_WORLD);
+    ierr = MPIERRQ(rval); CHKERRQ(ierr);
+
+    try {names = new char[info[3] + info[4]];}
+    catch (std::bad_alloc&) {
+        ierr = ThrowError("allocation failed"); CHKERRQ(ierr);
+    }
+    if (rank == 0) {
+        strcpy(names, (*image)->fname);
+        strcpy(names + info[3], (*image)->iname);
+    }
+    rval = MPI_Bcast(names, static_cast<int>(info[3] + info[4]), MPI_CHAR, 0, PETSC_COMM_WORLD);
+    ierr = MPIERRQ(rval); CHKERRQ(ierr);
+
+    if (rank != 0) {
+        std::lock_guard<std::mutex> lock(s_NIfTIMutex);
+        *image = nifti_convert_nhdr2nim(hdr, names);
+        ierr = Assert(*image != NULL, msg); CHKERRQ(ierr);
+        (*image)->byte_order = static_cast<int>(info[0]);
+        (*image)->iname_offset = static_cast<int>(info[1]);
+        (*image)->nifti_type = static_cast<int>(info[2]);
+        if ((*image)->fname != NULL) free((*image)->fname);
+        if ((*image)->iname != NULL) free((*image)->iname);
+        (*image)->fname = nifti_strdup(names);
+        (*image)->iname = nifti_strdup(names + info[3]);
+    }
+
+    if (names != NULL) {delete [] names; names = NULL;}
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+#endif
+
+
+
+
 /********************************************************************
  * @brief read nifty image with right component type
  *******************************************************************/
 #ifdef REG_HAS_NIFTI
-PetscErrorCode ReadWriteReg::ReadNII(nifti_image* image) {
+PetscErrorCode ReadWriteReg::ReadNII(nifti_image* image, Vec x) {
     PetscErrorCode ierr;
     DataType datatype = DOUBLE;
-    std::string msg;
-    int rank;
 
     PetscFunctionBegin;
 
     this->m_Opt->Enter(__func__);
 
-    MPI_Comm_rank(PETSC_COMM_WORLD, &rank);
-    msg = "should only be called on master/root rank";
-    ierr = Assert(rank == 0, msg); CHKERRQ(ierr);
-
     switch (image->datatype) {
         case NIFTI_TYPE_UINT8:
         {
@@ -960,7 +1296,7 @@ PetscErrorCode ReadWriteReg::ReadNII(nifti_image* image) {
                 ierr = DbgMsg("reading data of type uint8 (uchar)"); CHKERRQ(ierr);
             }
             datatype = UCHAR;
-            ierr = this->ReadNII<unsigned char>(image); CHKERRQ(ierr);
+            ierr = this->ReadNII<unsigned char>(image, x); CHKERRQ(ierr);
             break;
         }
         case NIFTI_TYPE_INT8:
@@ -969,7 +1305,7 @@ PetscErrorCode ReadWriteReg::ReadNII(nifti_image* image) {
                 ierr = DbgMsg("reading data of type int8 (char)"); CHKERRQ(ierr);
             }
             datatype = CHAR;
-            ierr = this->ReadNII<char>(image); CHKERRQ(ierr);
+            ierr = this->ReadNII<char>(image, x); CHKERRQ(ierr);
             break;
         }
         case NIFTI_TYPE_UINT16:
@@ -978,7 +1314,7 @@ PetscErrorCode ReadWriteReg::ReadNII(nifti_image* image) {
                 ierr = DbgMsg("reading data of type uint16 (unsigned short)"); CHKERRQ(ierr);
             }
             datatype = USHORT;
-            ierr = this->ReadNII<unsigned short>(image); CHKERRQ(ierr);
+            ierr = this->ReadNII<unsigned short>(image, x); CHKERRQ(ierr);
             break;
         }
         case NIFTI_TYPE_INT16:
@@ -987,7 +1323,7 @@ PetscErrorCode ReadWriteReg::ReadNII(nifti_image* image) {
                 ierr = DbgMsg("reading data of type int16 (short)"); CHKERRQ(ierr);
             }
             datatype = SHORT;
-            ierr = this->ReadNII<short>(image); CHKERRQ(ierr);
+            ierr = this->ReadNII<short>(image, x); CHKERRQ(ierr);
             break;
         }
         case NIFTI_TYPE_UINT32:
@@ -996,7 +1332,7 @@ PetscErrorCode ReadWriteReg::ReadNII(nifti_image* image) {
                 ierr = DbgMsg("reading data of type uint32 (unsigned int)"); CHKERRQ(ierr);
             }
             datatype = UINT;
-            ierr = this->ReadNII<unsigned int>(image); CHKERRQ(ierr);
+            ierr = this->ReadNII<unsigned int>(image, x); CHKERRQ(ierr);
             break;
         }
         case NIFTI_TYPE_INT32:
@@ -1005,7 +1341,7 @@ PetscErrorCode ReadWriteReg::ReadNII(nifti_image* image) {
                 ierr = DbgMsg("reading data of type int32 (int)"); CHKERRQ(ierr);
             }
             datatype = INT;
-            ierr = this->ReadNII<int>(image); CHKERRQ(ierr);
+            ierr = this->ReadNII<int>(image, x); CHKERRQ(ierr);
             break;
         }
         case NIFTI_TYPE_FLOAT32:
@@ -1014,7 +1350,7 @@ PetscErrorCode ReadWriteReg::ReadNII(nifti_image* image) {
                 ierr = DbgMsg("reading data of type float32 (float)"); CHKERRQ(ierr);
             }
             datatype = FLOAT;
-            ierr = this->ReadNII<float>(image); CHKERRQ(ierr);
+            ierr = this->ReadNII<float>(image, x); CHKERRQ(ierr);
             break;
         }
         case NIFTI_TYPE_FLOAT64:
@@ -1023,7 +1359,7 @@ PetscErrorCode ReadWriteReg::ReadNII(nifti_image* image) {
                 ierr = DbgMsg("reading data of type float64 (double)"); CHKERRQ(ierr);
             }
             datatype = DOUBLE;
-            ierr = this->ReadNII<double>(image); CHKERRQ(ierr);
+            ierr = this->ReadNII<double>(image, x); CHKERRQ(ierr);
             break;
         }
         default:
@@ -1053,15 +1389,19 @@ PetscErrorCode ReadWriteReg::ReadNII(nifti_image* image) {
 
 
 /********************************************************************
- * @brief get component type of NII images
+ * @brief read image data of given component type; uncompressed files
+ * are read in parallel (every rank reads its own block); compressed
+ * files are read on the master rank and scattered
  *******************************************************************/
 #ifdef REG_HAS_NIFTI
-template <typename T> PetscErrorCode ReadWriteReg::ReadNII(nifti_image* image) {
+template <typename T> PetscErrorCode ReadWriteReg::ReadNII(nifti_image* image, Vec x) {
     PetscErrorCode ierr = 0;
     T *data = NULL;
+    ScalarType *p_x = NULL;
     std::string msg;
-    IntType ng, nx[3];
-    int rank, master = 0;
+    IntType ng, nl, nx[3];
+    int rank, rval, master = 0;
+    bool mpiio;
     std::stringstream ss;
 
     PetscFunctionBegin;
@@ -1069,50 +1409,71 @@ template <typename T> PetscErrorCode ReadWriteReg::ReadNII(nifti_image* image) {
     this->m_Opt->Enter(__func__);
 
     MPI_Comm_rank(PETSC_COMM_WORLD, &rank);
-    msg = "should only be called on master/root rank";
-    ierr = Assert(rank == master, msg); CHKERRQ(ierr);
+
+    {
+        std::lock_guard<std::mutex> lock(s_NIfTIMutex);
+        mpiio = !nifti_is_gzfile(image->iname) && image->nifti_type != NIFTI_FTYPE_ASCII;
+    }
+
+    // uncompressed binary files are read with mpi io
+    if (mpiio) {
+        ierr = this->ReadBlockNII<T>(image, x); CHKERRQ(ierr);
+        this->m_Opt->Exit(__func__);
+        PetscFunctionReturn(ierr);
+    }
 
     // get number of grid points
     ng = this->m_Opt->m_Domain.ng;
+    nl = this->m_Opt->m_Domain.nl;
 
     // allocate data buffer
-    if (this->m_Data == NULL) {
+    if (rank == master && this->m_Data == NULL) {
         try {this->m_Data = new ScalarType[ng];}
         catch (std::bad_alloc&) {
             ierr = ThrowError("allocation failed"); CHKERRQ(ierr);
         }
     }
 
-    // load the image
-    if (nifti_image_load(image) == -1) {
-        msg = "could not read image " + this->m_FileName;
-        ierr = ThrowError(msg); CHKERRQ(ierr);
-    }
+    if (rank == master) {
+        // load the image
+        {
+            std::lock_guard<std::mutex> lock(s_NIfTIMutex);
+            rval = nifti_image_load(image);
+        }
+        if (rval == -1) {
+            msg = "could not read image " + this->m_FileName;
+            ierr = ThrowError(msg); CHKERRQ(ierr);
+        }
 
-    // assign data
-    data = static_cast<T*>(image->data);
-    ierr = Assert(data != NULL, "null pointer"); CHKERRQ(ierr);
+        // assign data
+        data = static_cast<T*>(image->data);
+        ierr = Assert(data != NULL, "null pointer"); CHKERRQ(ierr);
 
-    // get global number of points
-    ng = this->m_Opt->m_Domain.ng;
-    nx[0] = this->m_Opt->m_Domain.nx[0];
-    nx[1] = this->m_Opt->m_Domain.nx[1];
-    nx[2] = this->m_Opt->m_Domain.nx[2];
+        // get global number of points
+        nx[0] = this->m_Opt->m_Domain.nx[0];
+        nx[1] = this->m_Opt->m_Domain.nx[1];
+        nx[2] = this->m_Opt->m_Domain.nx[2];
+
+        IntType k = 0;
+        for (int p = 0; p < this->m_NumProcs; ++p) {
+            for (IntType i1 = 0; i1 < this->m_iSizeC[3*p+0]; ++i1) {  // x1
+                for (IntType i2 = 0; i2 < this->m_iSizeC[3*p+1]; ++i2) {  // x2
+                    for (IntType i3 = 0; i3 < this->m_iSizeC[3*p+2]; ++i3) {  // x3
+                        IntType j1 = i1 + this->m_iStartC[3*p+0];
+                        IntType j2 = i2 + this->m_iStartC[3*p+1];
+                        IntType j3 = i3 + this->m_iStartC[3*p+2];
+                        IntType l = GetLinearIndex(j1, j2, j3, nx);
+                        this->m_Data[k++] = static_cast<ScalarType>(data[l]);
+                    }  // for i1
+                }  // for i2
+            }  // for i3
+        }  // for all procs
+    }
 
-    IntType k = 0;
-    for (int p = 0; p < this->m_NumProcs; ++p) {
-        for (IntType i1 = 0; i1 < this->m_iSizeC[3*p+0]; ++i1) {  // x1
-            for (IntType i2 = 0; i2 < this->m_iSizeC[3*p+1]; ++i2) {  // x2
-                for (IntType i3 = 0; i3 < this->m_iSizeC[3*p+2]; ++i3) {  // x3
-                    IntType j1 = i1 + this->m_iStartC[3*p+0];
-                    IntType j2 = i2 + this->m_iStartC[3*p+1];
-                    IntType j3 = i3 + this->m_iStartC[3*p+2];
-                    IntType l = GetLinearIndex(j1, j2, j3, nx);
-                    this->m_Data[k++] = static_cast<ScalarType>(data[l]);
-                }  // for i1
-            }  // for i2
-        }  // for i3
-    }  // for all procs
+    ierr = VecGetArray(x, &p_x); CHKERRQ(ierr);
+    rval = MPI_Scatterv(this->m_Data, this->m_nSend, this->m_nOffset, MPIU_SCALAR, p_x, nl, MPIU_SCALAR, master, PETSC_COMM_WORLD);
+    ierr = MPIERRQ(rval); CHKERRQ(ierr);
+    ierr = VecRestoreArray(x, &p_x); CHKERRQ(ierr);
 
     this->m_Opt->Exit(__func__);
 
@@ -1124,61 +1485,345 @@ template <typename T> PetscErrorCode ReadWriteReg::ReadNII(nifti_image* image) {
 
 
 /********************************************************************
- * @brief write buffer to nii files
+ * @brief read local block of uncompressed nifti image with collective
+ * mpi io (subarray view of the global grid starting at the offset of
+ * the image data)
  *******************************************************************/
 #ifdef REG_HAS_NIFTI
-PetscErrorCode ReadWriteReg::WriteNII(Vec x) {
-    PetscErrorCode ierr;
-    nifti_image* image = NULL;
+template <typename T> PetscErrorCode ReadWriteReg::ReadBlockNII(nifti_image* image, Vec x) {
+    PetscErrorCode ierr = 0;
+    int rval, gsize[3], lsize[3], lstart[3];
+    IntType nl;
+    T* data = NULL;
+    ScalarType* p_x = NULL;
+    MPI_Datatype etype, filetype;
+    MPI_File fh;
+    MPI_Status status;
+
     PetscFunctionBegin;
 
     this->m_Opt->Enter(__func__);
 
-    // if we write the template or refernence image to file,
-    // we'll use the data we have read in; if this data has not
-    // been read, we'll pass a NULL pointer resulting in an image
-    // being allocated
-    if (this->m_TemplateImage.write) {
-        image = this->m_TemplateImage.data;
-    } else if (this->m_ReferenceImage.write) {
-        image = this->m_ReferenceImage.data;
-    } else {
-        // now we have to deal with the case that a reference
-        // image might have been read, so we want to use
-        // all the information within its header (including the
-        // orientation), but write out the data using the
-        // datatype we have used for our computations
-        if (this->m_ImageData == NULL) {   // only do this once
-            // if we have read the reference image
-            // note: the following will only be true
-            // on the master rank, because we allocate
-            // image data only there
-            if (this->m_ReferenceImage.data != NULL) {
-                this->m_ImageData = nifti_copy_nim_info(this->m_ReferenceImage.data);
-            } else {
-                if (this->m_TemplateImage.data != NULL) {
-                    this->m_ImageData = nifti_copy_nim_info(this->m_TemplateImage.data);
-                }
-            }
-            if (this->m_ImageData != NULL) {
-                // switch precision in io
-#if defined(PETSC_USE_REAL_SINGLE)
-                this->m_ImageData->datatype = NIFTI_TYPE_FLOAT32; // single precision
-#else
-                this->m_ImageData->datatype = NIFTI_TYPE_FLOAT64; // double precision
-#endif
-                this->m_ImageData->nbyper = sizeof(ScalarType);
-                // allocate image buffer
-                try {this->m_ImageData->data = new ScalarType[this->m_ImageData->nvox];}
-                catch (std::bad_alloc&) {
-                    ierr = ThrowError("allocation failed"); CHKERRQ(ierr);
-                }
-            }
-        }
-        image = this->m_ImageData;
+    nl = this->m_Opt->m_Domain.nl;
+    for (int i = 0; i < 3; ++i) {
+        gsize[i]  = static_cast<int>(this->m_Opt->m_Domain.nx[i]);
+        lsize[i]  = static_cast<int>(this->m_Opt->m_Domain.isize[i]);
+        lstart[i] = static_cast<int>(this->m_Opt->m_Domain.istart[i]);
     }
 
-    // if nifty image is null pointer default to double
+    try {data = new T[nl];}
+    catch (std::bad_alloc&) {
+        ierr = ThrowError("allocation failed"); CHKERRQ(ierr);
+    }
+
+    rval = MPI_Type_contiguous(sizeof(T), MPI_BYTE, &etype);
+    ierr = MPIERRQ(rval); CHKERRQ(ierr);
+    rval = MPI_Type_commit(&etype);
+    ierr = MPIERRQ(rval); CHKERRQ(ierr);
+    rval = MPI_Type_create_subarray(3, gsize, lsize, lstart, MPI_ORDER_C, etype, &filetype);
+    ierr = MPIERRQ(rval); CHKERRQ(ierr);
+    rval = MPI_Type_commit(&filetype);
+    ierr = MPIERRQ(rval); CHKERRQ(ierr);
+
+    rval = MPI_File_open(PETSC_COMM_WORLD, image->iname, MPI_MODE_RDONLY, MPI_INFO_NULL, &fh);
+    ierr = MPIERRQ(rval); CHKERRQ(ierr);
+    rval = MPI_File_set_view(fh, static_cast<MPI_Offset>(image->iname_offset), etype, filetype,
+                             const_cast<char*>("native"), MPI_INFO_NULL);
+    ierr = MPIERRQ(rval); CHKERRQ(ierr);
+    rval = MPI_File_read_all(fh, data, static_cast<int>(nl), etype, &status);
+    ierr = MPIERRQ(rval); CHKERRQ(ierr);
+    rval = MPI_File_close(&fh);
+    ierr = MPIERRQ(rval); CHKERRQ(ierr);
+
+    MPI_Type_free(&filetype);
+    MPI_Type_free(&etype);
+
+    // data is stored in byte order of the machine that wrote the file
+    if (image->byte_order != nifti_short_order() && sizeof(T) > 1) {
+        std::lock_guard<std::mutex> lock(s_NIfTIMutex);
+        nifti_swap_Nbytes(static_cast<size_t>(nl), sizeof(T), data);
+    }
+
+    ierr = VecGetArray(x, &p_x); CHKERRQ(ierr);
+    for (IntType i = 0; i < nl; ++i) {
+        p_x[i] = static_cast<ScalarType>(data[i]);
+    }
+    ierr = VecRestoreArray(x, &p_x); CHKERRQ(ierr);
+
+    if (data != NULL) {delete [] data; data = NULL;}
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+#endif
+
+
+
+
+/********************************************************************
+ * @brief write uncompressed nifti image in parallel; the master rank
+ * writes the header, every rank writes its local block with collective
+ * mpi io (the data is not gathered; this is always synchronous)
+ *******************************************************************/
+#ifdef REG_HAS_NIFTI
+template <typename T> PetscErrorCode ReadWriteReg::WriteBlockNII(nifti_image* image, Vec x) {
+    PetscErrorCode ierr = 0;
+    int rank, rval, gsize[3], lsize[3], lstart[3];
+    int64_t offset = 0;
+    IntType nl;
+    T* data = NULL;
+    const ScalarType* p_x = NULL;
+    MPI_Datatype etype, filetype;
+    MPI_File fh;
+    MPI_Status status;
+
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    MPI_Comm_rank(PETSC_COMM_WORLD, &rank);
+
+    // write header only (this truncates the file and sets the
+    // offset of the image data)
+    if (rank == 0) {
+        std::lock_guard<std::mutex> lock(s_NIfTIMutex);
+        nifti_image_write_hdr_img(image, 0, "wb");
+        offset = static_cast<int64_t>(image->iname_offset);
+    }
+    // header has to be written before anybody opens the file
+    rval = MPI_Bcast(&offset, 1, MPI_INT64_T, 0, PETSC_COMM_WORLD);
+    ierr = MPIERRQ(rval); CHKERRQ(ierr);
+    ierr = Assert(offset > 0, "could not write header"); CHKERRQ(ierr);
+
+    nl = this->m_Opt->m_Domain.nl;
+    for (int i = 0; i < 3; ++i) {
+        gsize[i]  = static_cast<int>(this->m_Opt->m_Domain.nx[i]);
+        lsize[i]  = static_cast<int>(this->m_Opt->m_Domain.isize[i]);
+        lstart[i] = static_cast<int>(this->m_Opt->m_Domain.istart[i]);
+    }
+
+    // convert to data type of image
+    try {data = new T[nl];}
+    catch (std::bad_alloc&) {
+        ierr = ThrowError("allocation failed"); CHKERRQ(ierr);
+    }
+    ierr = VecGetArrayRead(x, &p_x); CHKERRQ(ierr);
+    for (IntType i = 0; i < nl; ++i) {
+        data[i] = static_cast<T>(p_x[i]);
+    }
+    ierr = VecRestoreArrayRead(x, &p_x); CHKERRQ(ierr);
+
+    rval = MPI_Type_contiguous(sizeof(T), MPI_BYTE, &etype);
+    ierr = MPIERRQ(rval); CHKERRQ(ierr);
+    rval = MPI_Type_commit(&etype);
+    ierr = MPIERRQ(rval); CHKERRQ(ierr);
+    rval = MPI_Type_create_subarray(3, gsize, lsize, lstart, MPI_ORDER_C, etype, &filetype);
+    ierr = MPIERRQ(rval); CHKERRQ(ierr);
+    rval = MPI_Type_commit(&filetype);
+    ierr = MPIERRQ(rval); CHKERRQ(ierr);
+
+    rval = MPI_File_open(PETSC_COMM_WORLD, this->m_FileName.c_str(), MPI_MODE_WRONLY | MPI_MODE_CREATE, MPI_INFO_NULL, &fh);
+    ierr = MPIERRQ(rval); CHKERRQ(ierr);
+    rval = MPI_File_set_view(fh, static_cast<MPI_Offset>(offset), etype, filetype,
+                             const_cast<char*>("native"), MPI_INFO_NULL);
+    ierr = MPIERRQ(rval); CHKERRQ(ierr);
+    rval = MPI_File_write_all(fh, data, static_cast<int>(nl), etype, &status);
+    ierr = MPIERRQ(rval); CHKERRQ(ierr);
+    rval = MPI_File_close(&fh);
+    ierr = MPIERRQ(rval); CHKERRQ(ierr);
+
+    MPI_Type_free(&filetype);
+    MPI_Type_free(&etype);
+
+    if (data != NULL) {delete [] data; data = NULL;}
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+#endif
+
+
+
+
+/********************************************************************
+ * @brief wait until all pending (asynchronous) output has been
+ * written to file
+ *******************************************************************/
+PetscErrorCode ReadWriteReg::Flush() {
+    PetscErrorCode ierr = 0;
+    PetscFunctionBegin;
+
+#ifdef REG_HAS_NIFTI
+    if (this->m_Writer.joinable()) {
+        std::unique_lock<std::mutex> lock(this->m_WriteQueueMutex);
+        this->m_WriteQueueCond.wait(lock, [this]{return this->m_WriteQueue.empty();});
+    }
+#endif
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief hand a deep copy of the (gathered) image to the background
+ * writer (write-behind); the caller can reuse its buffers right away;
+ * we block if the number of pending images exceeds the queue depth
+ * set by the user (bounds the memory on the master rank); only called
+ * on the master rank and the writer thread does not call mpi
+ *******************************************************************/
+#ifdef REG_HAS_NIFTI
+PetscErrorCode ReadWriteReg::EnqueueNII(nifti_image* image) {
+    PetscErrorCode ierr = 0;
+    nifti_image* copy = NULL;
+    size_t nbytes, depth;
+
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    ierr = Assert(image != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(image->data != NULL, "null pointer"); CHKERRQ(ierr);
+
+    depth = static_cast<size_t>(this->m_Opt->m_ReadWriteFlags.asyncdepth);
+
+    // copy header (including file names) and data; the data is
+    // freed by nifti_image_free in the writer thread
+    {
+        std::lock_guard<std::mutex> lock(s_NIfTIMutex);
+        copy = nifti_copy_nim_info(image);
+    }
+    ierr = Assert(copy != NULL, "could not copy image"); CHKERRQ(ierr);
+    nbytes = static_cast<size_t>(image->nvox)*static_cast<size_t>(image->nbyper);
+    copy->data = malloc(nbytes);
+    ierr = Assert(copy->data != NULL, "allocation failed"); CHKERRQ(ierr);
+    memcpy(copy->data, image->data, nbytes);
+
+    {
+        std::unique_lock<std::mutex> lock(this->m_WriteQueueMutex);
+
+        // start writer thread on first use
+        if (!this->m_Writer.joinable()) {
+            this->m_StopWriter = false;
+            try {this->m_Writer = std::thread(&ReadWriteReg::WriterLoop, this);}
+            catch (std::exception& err) {
+                ierr = ThrowError(err); CHKERRQ(ierr);
+            }
+        }
+
+        // bound number of pending images
+        this->m_WriteQueueCond.wait(lock, [this, depth]{return this->m_WriteQueue.size() < depth;});
+        this->m_WriteQueue.push_back(copy);
+    }
+    this->m_WriteQueueCond.notify_all();
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+#endif
+
+
+
+
+/********************************************************************
+ * @brief background writer; an image stays at the front of the queue
+ * until it has been written, so that the queue length is the number
+ * of pending images; returns once stopped and the queue is empty
+ *******************************************************************/
+#ifdef REG_HAS_NIFTI
+void ReadWriteReg::WriterLoop() {
+    nifti_image* image = NULL;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(this->m_WriteQueueMutex);
+            this->m_WriteQueueCond.wait(lock, [this]{
+                return this->m_StopWriter || !this->m_WriteQueue.empty();
+            });
+            if (this->m_WriteQueue.empty()) return;
+            image = this->m_WriteQueue.front();
+        }
+
+        // compression and file io happen here (the image is a
+        // private copy; no lock, see s_NIfTIMutex)
+        nifti_image_write(image);
+        nifti_image_free(image);
+
+        {
+            std::lock_guard<std::mutex> lock(this->m_WriteQueueMutex);
+            this->m_WriteQueue.pop_front();
+        }
+        this->m_WriteQueueCond.notify_all();
+    }
+}
+#endif
+
+
+
+
+/********************************************************************
+ * @brief write buffer to nii files
+ *******************************************************************/
+#ifdef REG_HAS_NIFTI
+PetscErrorCode ReadWriteReg::WriteNII(Vec x) {
+    PetscErrorCode ierr;
+    nifti_image* image = NULL;
+    int rank;
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    MPI_Comm_rank(PETSC_COMM_WORLD, &rank);
+
+    // if we write the template or refernence image to file,
+    // we'll use the data we have read in; if this data has not
+    // been read, we'll pass a NULL pointer resulting in an image
+    // being allocated
+    if (this->m_TemplateImage.write) {
+        image = this->m_TemplateImage.data;
+    } else if (this->m_ReferenceImage.write) {
+        image = this->m_ReferenceImage.data;
+    } else {
+        // now we have to deal with the case that a reference
+        // image might have been read, so we want to use
+        // all the information within its header (including the
+        // orientation), but write out the data using the
+        // datatype we have used for our computations
+        if (this->m_ImageData == NULL) {   // only do this once
+            // if we have read the reference image (the header
+            // is available on all ranks; see ReadNIIHeader)
+            if (this->m_ReferenceImage.data != NULL) {
+                std::lock_guard<std::mutex> lock(s_NIfTIMutex);
+                this->m_ImageData = nifti_copy_nim_info(this->m_ReferenceImage.data);
+            } else if (this->m_TemplateImage.data != NULL) {
+                std::lock_guard<std::mutex> lock(s_NIfTIMutex);
+                this->m_ImageData = nifti_copy_nim_info(this->m_TemplateImage.data);
+            }
+            if (this->m_ImageData != NULL) {
+                // switch precision in io
+#if defined(PETSC_USE_REAL_SINGLE)
+                this->m_ImageData->datatype = NIFTI_TYPE_FLOAT32; // single precision
+#else
+                this->m_ImageData->datatype = NIFTI_TYPE_FLOAT64; // double precision
+#endif
+                this->m_ImageData->nbyper = sizeof(ScalarType);
+                // allocate image buffer (only needed on master rank)
+                if (rank == 0) {
+                    try {this->m_ImageData->data = new ScalarType[this->m_ImageData->nvox];}
+                    catch (std::bad_alloc&) {
+                        ierr = ThrowError("allocation failed"); CHKERRQ(ierr);
+                    }
+                }
+            }
+        }
+        image = this->m_ImageData;
+    }
+
+    // if nifty image is null pointer default to double
     if (image == NULL) {
         ierr = this->WriteNII<ScalarType>(&image, x); CHKERRQ(ierr);
     } else {
@@ -1265,6 +1910,21 @@ PetscErrorCode ReadWriteReg::WriteNII(nifti_image** image, Vec x) {
     ng = this->m_Opt->m_Domain.ng;
     nl = this->m_Opt->m_Domain.nl;
 
+    // construct file name
+    std::string file(this->m_FileName);
+
+    // get extension
+    std::string ext(".nii");
+    const char* exttemp = nifti_find_file_extension(file.c_str());
+    if (exttemp != NULL) {ext = exttemp;}
+
+    // is file compressed
+    const std::string::size_type sep = ext.rfind(".gz");
+    const bool iscompressed = (sep == std::string::npos) ? false : true;
+
+    // uncompressed single file images are written in parallel
+    const bool mpiio = (ext == ".nii");
+
     // allocate the index buffers on master rank
     if (rank == master) {
         // we need to allocate the image if it's a zero pointer; this
@@ -1279,25 +1939,11 @@ PetscErrorCode ReadWriteReg::WriteNII(nifti_image** image, Vec x) {
         }
         ierr = Assert((*image) != NULL, "null pointer"); CHKERRQ(ierr);
 
-        // construct file name
-        std::string file(this->m_FileName);
-
-        // get temp extension
-        const char* exttemp = nifti_find_file_extension(file.c_str());
-        if (exttemp == NULL) {exttemp = ".nii";}
-
-        // set extension
-        const std::string ext(exttemp);
-
         // get base file name
         char* bnametemp = nifti_makebasename(file.c_str());
-        const std::string bname(bnametemp);
+        std::string bname(bnametemp);
         free(bnametemp);
 
-        // is file compressed
-        const std::string::size_type sep = ext.rfind(".gz");
-        const bool iscompressed = (sep == std::string::npos) ? false : true;
-
         if ((ext == ".nii") || (ext == ".nii.gz")) {
             (*image)->nifti_type = NIFTI_FTYPE_NIFTI1_1;
         } else if (ext == ".nia") {
@@ -1308,10 +1954,22 @@ PetscErrorCode ReadWriteReg::WriteNII(nifti_image** image, Vec x) {
             ierr = ThrowError("file extension not supported"); CHKERRQ(ierr);
         }
 
+        // the file names are set before the image is handed to the
+        // background writer
         (*image)->fname = nifti_makehdrname(bname.c_str(), (*image)->nifti_type, false, iscompressed);
         (*image)->iname = nifti_makeimgname(bname.c_str(), (*image)->nifti_type, false, iscompressed);
     }
 
+    if (mpiio) {
+        ierr = this->WriteBlockNII<T>(*image, x); CHKERRQ(ierr);
+        if (deleteimage) {
+            std::lock_guard<std::mutex> lock(s_NIfTIMutex);
+            nifti_image_free(*image); *image = NULL;
+        }
+        this->m_Opt->Exit(__func__);
+        PetscFunctionReturn(ierr);
+    }
+
     // allocate data buffer
     if (this->m_Data == NULL) {
         try {this->m_Data = new ScalarType[ng];}
@@ -1334,6 +1992,12 @@ PetscErrorCode ReadWriteReg::WriteNII(nifti_image** image, Vec x) {
     nx[2] = this->m_Opt->m_Domain.nx[2];
 
     if (rank == master) {
+        // image data is not loaded if the image was read in parallel
+        if ((*image)->data == NULL) {
+            (*image)->data = calloc((*image)->nvox, (*image)->nbyper);
+            ierr = Assert((*image)->data != NULL, "allocation failed"); CHKERRQ(ierr);
+        }
+
         // cast pointer of nifti image data
         data = reinterpret_cast<T*>((*image)->data);
 
@@ -1352,8 +2016,13 @@ PetscErrorCode ReadWriteReg::WriteNII(nifti_image** image, Vec x) {
             }  // for i3
         }  // for all procs
 
-        // write image to file
-        nifti_image_write(*image);
+        // write image to file (in background if enabled)
+        if (this->m_Opt->m_ReadWriteFlags.asyncdepth > 0) {
+            ierr = this->EnqueueNII(*image); CHKERRQ(ierr);
+        } else {
+            std::lock_guard<std::mutex> lock(s_NIfTIMutex);
+            nifti_image_write(*image);
+        }
     }  // if on master
 
 
@@ -1361,6 +2030,7 @@ PetscErrorCode ReadWriteReg::WriteNII(nifti_image** image, Vec x) {
         if (this->m_Opt->m_Verbosity > 2) {
             ierr = DbgMsg("deleting nifti image buffer"); CHKERRQ(ierr);
         }
+        std::lock_guard<std::mutex> lock(s_NIfTIMutex);
         nifti_image_free(*image); *image = NULL;
     }
 
@@ -1391,7 +2061,10 @@ PetscErrorCode ReadWriteReg::AllocateImage(nifti_image** image, Vec x) {
     nl = this->m_Opt->m_Domain.nl;
 
     // init nifty image
-    *image = nifti_simple_init_nim();
+    {
+        std::lock_guard<std::mutex> lock(s_NIfTIMutex);
+        *image = nifti_simple_init_nim();
+    }
 
     // dimensionalty of data: default is 5 (space, time, components)
     (*image)->dim[0] = (*image)->ndim = 5;
@@ -1532,6 +2205,302 @@ PetscErrorCode ReadWriteReg::WriteBIN(Vec x) {
 
 
 
+/********************************************************************
+ * @brief read chunked, compressed claire volume (*.clr); the file
+ * consists of a header (8 byte magic + 7 int64: version, bytes per
+ * value, nx[0], nx[1], nx[2], number of chunks, reserved), an index
+ * (8 int64 per chunk: istart[3], isize[3], offset, compressed size)
+ * and the chunks (one zlib stream per pencil of the writing
+ * decomposition); every rank reads and decompresses only the chunks
+ * that overlap with its own pencil, i.e., the data can be read with a
+ * different number of tasks than it was written with
+ *******************************************************************/
+#ifdef REG_HAS_ZLIB
+PetscErrorCode ReadWriteReg::ReadCLR(Vec* x) {
+    PetscErrorCode ierr = 0;
+    int rank, rval, zerr, valid = 0;
+    bool samepencil;
+    char magic[8];
+    int64_t header[7], *index = NULL, nchunks, elsize, cn, cs[3], ce[3];
+    IntType nl, ng, nx[3], istart[3], isize[3], lo[3], hi[3];
+    std::stringstream ss;
+    ScalarType *p_x = NULL;
+    Bytef *cbuffer = NULL, *buffer = NULL;
+    uLongf nbytes;
+    MPI_File fh;
+    MPI_Status status;
+
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    MPI_Comm_rank(PETSC_COMM_WORLD, &rank);
+
+    rval = MPI_File_open(PETSC_COMM_WORLD, this->m_FileName.c_str(), MPI_MODE_RDONLY, MPI_INFO_NULL, &fh);
+    ierr = MPIERRQ(rval); CHKERRQ(ierr);
+
+    // read header on master rank and broadcast it together with a
+    // status flag, so that all ranks fail together
+    if (rank == 0) {
+        valid = 0;
+        rval = MPI_File_read_at(fh, 0, magic, 8, MPI_CHAR, &status);
+        if (rval == MPI_SUCCESS && strncmp(magic, "CLAIREV1", 8) == 0) {
+            rval = MPI_File_read_at(fh, 8, header, 7, MPI_INT64_T, &status);
+            if (rval == MPI_SUCCESS) valid = 1;
+        }
+    }
+    rval = MPI_Bcast(&valid, 1, MPI_INT, 0, PETSC_COMM_WORLD);
+    ierr = MPIERRQ(rval); CHKERRQ(ierr);
+    ierr = Assert(valid == 1, "not a claire volume"); CHKERRQ(ierr);
+
+    rval = MPI_Bcast(header, 7, MPI_INT64_T, 0, PETSC_COMM_WORLD);
+    ierr = MPIERRQ(rval); CHKERRQ(ierr);
+
+    elsize = header[1];
+    nchunks = header[5];
+    ierr = Assert(elsize == sizeof(float) || elsize == sizeof(double), "unknown data type"); CHKERRQ(ierr);
+    ierr = Assert(nchunks > 0, "no data in file"); CHKERRQ(ierr);
+
+    try {index = new int64_t[8*nchunks];}
+    catch (std::bad_alloc&) {
+        ierr = ThrowError("allocation failed"); CHKERRQ(ierr);
+    }
+    if (rank == 0) {
+        rval = MPI_File_read_at(fh, 64, index, static_cast<int>(8*nchunks), MPI_INT64_T, &status);
+        valid = (rval == MPI_SUCCESS) ? 1 : 0;
+    }
+    rval = MPI_Bcast(&valid, 1, MPI_INT, 0, PETSC_COMM_WORLD);
+    ierr = MPIERRQ(rval); CHKERRQ(ierr);
+    ierr = Assert(valid == 1, "could not read index of claire volume"); CHKERRQ(ierr);
+
+    rval = MPI_Bcast(index, static_cast<int>(8*nchunks), MPI_INT64_T, 0, PETSC_COMM_WORLD);
+    ierr = MPIERRQ(rval); CHKERRQ(ierr);
+
+    for (int i = 0; i < 3; ++i) {
+        nx[i] = static_cast<IntType>(header[2+i]);
+    }
+
+    // if we read images, we want to make sure that they have the same size
+    if ((this->m_nx[0] == -1) && (this->m_nx[1] == -1) && (this->m_nx[2] == -1)) {
+        for (int i = 0; i < 3; ++i) {
+            this->m_nx[i] = nx[i];
+        }
+    } else {
+        ss << "grid size of input images varies: perform affine registration first";
+        for (int i = 0; i < 3; ++i) {
+            ierr = Assert(this->m_nx[i] == nx[i], ss.str()); CHKERRQ(ierr);
+        }
+        ss.clear(); ss.str(std::string());
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        this->m_Opt->m_Domain.nx[i] = nx[i];
+    }
+    if (!this->m_Opt->m_SetupDone) {
+        ierr = this->m_Opt->DoSetup(); CHKERRQ(ierr);
+    }
+
+    nl = this->m_Opt->m_Domain.nl;
+    ng = this->m_Opt->m_Domain.ng;
+    for (int i = 0; i < 3; ++i) {
+        istart[i] = this->m_Opt->m_Domain.istart[i];
+        isize[i] = this->m_Opt->m_Domain.isize[i];
+    }
+
+    if (*x != NULL) {
+        ierr = VecDestroy(x); CHKERRQ(ierr); *x = NULL;
+    }
+    ierr = VecCreate(*x, nl, ng); CHKERRQ(ierr);
+    ierr = VecGetArray(*x, &p_x); CHKERRQ(ierr);
+
+    for (int64_t c = 0; c < nchunks; ++c) {
+        // compute overlap of chunk with local pencil
+        cn = 1;
+        bool overlap = true;
+        for (int i = 0; i < 3; ++i) {
+            cs[i] = index[8*c+i];
+            ce[i] = index[8*c+i] + index[8*c+3+i];
+            cn *= index[8*c+3+i];
+            lo[i] = PetscMax(static_cast<IntType>(cs[i]), istart[i]);
+            hi[i] = PetscMin(static_cast<IntType>(ce[i]), istart[i] + isize[i]);
+            if (lo[i] >= hi[i]) overlap = false;
+        }
+        if (!overlap) continue;
+
+        // read compressed chunk (independent; the number of chunks
+        // varies between ranks)
+        try {cbuffer = new Bytef[index[8*c+7]];}
+        catch (std::bad_alloc&) {
+            ierr = ThrowError("allocation failed"); CHKERRQ(ierr);
+        }
+        rval = MPI_File_read_at(fh, static_cast<MPI_Offset>(index[8*c+6]), cbuffer,
+                                static_cast<int>(index[8*c+7]), MPI_BYTE, &status);
+        ierr = MPIERRQ(rval); CHKERRQ(ierr);
+
+        // same decomposition (start and shape of chunk match the
+        // local pencil): decompress directly into vector
+        samepencil = elsize == sizeof(ScalarType);
+        for (int i = 0; i < 3; ++i) {
+            samepencil = samepencil && cs[i] == istart[i] && index[8*c+3+i] == isize[i];
+        }
+
+        nbytes = static_cast<uLongf>(cn*elsize);
+        if (samepencil) {
+            zerr = uncompress(reinterpret_cast<Bytef*>(p_x), &nbytes, cbuffer, static_cast<uLong>(index[8*c+7]));
+            ierr = Assert(zerr == Z_OK, "decompression failed"); CHKERRQ(ierr);
+            ierr = Assert(nbytes == static_cast<uLongf>(cn*elsize), "size of chunk does not match index"); CHKERRQ(ierr);
+        } else {
+            try {buffer = new Bytef[nbytes];}
+            catch (std::bad_alloc&) {
+                ierr = ThrowError("allocation failed"); CHKERRQ(ierr);
+            }
+            zerr = uncompress(buffer, &nbytes, cbuffer, static_cast<uLong>(index[8*c+7]));
+            ierr = Assert(zerr == Z_OK, "decompression failed"); CHKERRQ(ierr);
+            ierr = Assert(nbytes == static_cast<uLongf>(cn*elsize), "size of chunk does not match index"); CHKERRQ(ierr);
+
+            // copy overlapping block (and convert precision)
+            for (IntType i1 = lo[0]; i1 < hi[0]; ++i1) {
+                for (IntType i2 = lo[1]; i2 < hi[1]; ++i2) {
+                    for (IntType i3 = lo[2]; i3 < hi[2]; ++i3) {
+                        int64_t k = ((i1-cs[0])*(ce[1]-cs[1]) + (i2-cs[1]))*(ce[2]-cs[2]) + (i3-cs[2]);
+                        IntType l = ((i1-istart[0])*isize[1] + (i2-istart[1]))*isize[2] + (i3-istart[2]);
+                        if (elsize == sizeof(float)) {
+                            p_x[l] = static_cast<ScalarType>(reinterpret_cast<float*>(buffer)[k]);
+                        } else {
+                            p_x[l] = static_cast<ScalarType>(reinterpret_cast<double*>(buffer)[k]);
+                        }
+                    }
+                }
+            }
+            delete [] buffer; buffer = NULL;
+        }
+        delete [] cbuffer; cbuffer = NULL;
+    }
+
+    ierr = VecRestoreArray(*x, &p_x); CHKERRQ(ierr);
+
+    rval = MPI_File_close(&fh);
+    ierr = MPIERRQ(rval); CHKERRQ(ierr);
+
+    if (index != NULL) {delete [] index; index = NULL;}
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+#endif
+
+
+
+
+/********************************************************************
+ * @brief write chunked, compressed claire volume (*.clr); every rank
+ * compresses its own pencil and writes it at an offset determined by
+ * a prefix sum over the compressed sizes (see ReadCLR for layout)
+ *******************************************************************/
+#ifdef REG_HAS_ZLIB
+PetscErrorCode ReadWriteReg::WriteCLR(Vec x) {
+    PetscErrorCode ierr = 0;
+    int rank, nprocs, rval, zerr;
+    const char magic[8] = {'C', 'L', 'A', 'I', 'R', 'E', 'V', '1'};
+    int64_t header[7], entry[8], *index = NULL, csize, offset;
+    IntType nl;
+    const ScalarType *p_x = NULL;
+    Bytef *buffer = NULL;
+    uLongf nbytes;
+    MPI_File fh;
+    MPI_Status status;
+
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    ierr = Assert(x != NULL, "null pointer"); CHKERRQ(ierr);
+
+    MPI_Comm_rank(PETSC_COMM_WORLD, &rank);
+    MPI_Comm_size(PETSC_COMM_WORLD, &nprocs);
+
+    nl = this->m_Opt->m_Domain.nl;
+
+    // compress local pencil
+    nbytes = compressBound(static_cast<uLong>(nl*sizeof(ScalarType)));
+    try {buffer = new Bytef[nbytes];}
+    catch (std::bad_alloc&) {
+        ierr = ThrowError("allocation failed"); CHKERRQ(ierr);
+    }
+    ierr = VecGetArrayRead(x, &p_x); CHKERRQ(ierr);
+    zerr = compress2(buffer, &nbytes, reinterpret_cast<const Bytef*>(p_x),
+                     static_cast<uLong>(nl*sizeof(ScalarType)), Z_BEST_SPEED);
+    ierr = VecRestoreArrayRead(x, &p_x); CHKERRQ(ierr);
+    ierr = Assert(zerr == Z_OK, "compression failed"); CHKERRQ(ierr);
+    csize = static_cast<int64_t>(nbytes);
+
+    // offset of chunk: header (64 bytes) + index + preceding chunks
+    offset = 0;
+    rval = MPI_Exscan(&csize, &offset, 1, MPI_INT64_T, MPI_SUM, PETSC_COMM_WORLD);
+    ierr = MPIERRQ(rval); CHKERRQ(ierr);
+    if (rank == 0) offset = 0;
+    offset += 64 + 64*static_cast<int64_t>(nprocs);
+
+    for (int i = 0; i < 3; ++i) {
+        entry[i] = static_cast<int64_t>(this->m_Opt->m_Domain.istart[i]);
+        entry[3+i] = static_cast<int64_t>(this->m_Opt->m_Domain.isize[i]);
+    }
+    entry[6] = offset;
+    entry[7] = csize;
+
+    if (rank == 0) {
+        try {index = new int64_t[8*nprocs];}
+        catch (std::bad_alloc&) {
+            ierr = ThrowError("allocation failed"); CHKERRQ(ierr);
+        }
+    }
+    rval = MPI_Gather(entry, 8, MPI_INT64_T, index, 8, MPI_INT64_T, 0, PETSC_COMM_WORLD);
+    ierr = MPIERRQ(rval); CHKERRQ(ierr);
+
+    rval = MPI_File_open(PETSC_COMM_WORLD, this->m_FileName.c_str(),
+                         MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &fh);
+    ierr = MPIERRQ(rval); CHKERRQ(ierr);
+    rval = MPI_File_set_size(fh, 0);
+    ierr = MPIERRQ(rval); CHKERRQ(ierr);
+
+    // master writes header and index
+    if (rank == 0) {
+        header[0] = 1;
+        header[1] = static_cast<int64_t>(sizeof(ScalarType));
+        header[2] = static_cast<int64_t>(this->m_Opt->m_Domain.nx[0]);
+        header[3] = static_cast<int64_t>(this->m_Opt->m_Domain.nx[1]);
+        header[4] = static_cast<int64_t>(this->m_Opt->m_Domain.nx[2]);
+        header[5] = static_cast<int64_t>(nprocs);
+        header[6] = 0;
+        rval = MPI_File_write_at(fh, 0, const_cast<char*>(magic), 8, MPI_CHAR, &status);
+        ierr = MPIERRQ(rval); CHKERRQ(ierr);
+        rval = MPI_File_write_at(fh, 8, header, 7, MPI_INT64_T, &status);
+        ierr = MPIERRQ(rval); CHKERRQ(ierr);
+        rval = MPI_File_write_at(fh, 64, index, 8*nprocs, MPI_INT64_T, &status);
+        ierr = MPIERRQ(rval); CHKERRQ(ierr);
+    }
+
+    // all ranks write their chunk
+    rval = MPI_File_write_at_all(fh, static_cast<MPI_Offset>(offset), buffer,
+                                 static_cast<int>(csize), MPI_BYTE, &status);
+    ierr = MPIERRQ(rval); CHKERRQ(ierr);
+
+    rval = MPI_File_close(&fh);
+    ierr = MPIERRQ(rval); CHKERRQ(ierr);
+
+    if (index != NULL) {delete [] index; index = NULL;}
+    if (buffer != NULL) {delete [] buffer; buffer = NULL;}
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+#endif
+
+
+
+
 /********************************************************************
  * @brief write netcdf to file
  *******************************************************************/
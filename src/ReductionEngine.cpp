@@ -0,0 +1,335 @@
+/*************************************************************************
+ *  Copyright (c) 2018.
+ *  All rights reserved.
+ *  This file is part of the CLAIRE library.
+ *
+ *  CLAIRE is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CLAIRE is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CLAIRE.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#ifndef _REDUCTIONENGINE_CPP_
+#define _REDUCTIONENGINE_CPP_
+
+#include "ReductionEngine.hpp"
+#include "CommCounter.hpp"
+
+
+
+
+namespace reg {
+
+
+
+
+/********************************************************************
+ * @brief default constructor
+ *******************************************************************/
+ReductionEngine::ReductionEngine() {
+    this->m_Request = MPI_REQUEST_NULL;
+    this->m_NumPosted = 0;
+    this->m_Posted = false;
+    this->m_Depth = 0;
+    this->m_NumReductions = 0;
+}
+
+
+
+
+/********************************************************************
+ * @brief default destructor; we do not wait for outstanding
+ * requests here (MPI might already be finalized)
+ *******************************************************************/
+ReductionEngine::~ReductionEngine() {
+}
+
+
+
+
+/********************************************************************
+ * @brief start deferring reductions
+ *******************************************************************/
+PetscErrorCode ReductionEngine::Begin() {
+    PetscFunctionBegin;
+    ++this->m_Depth;
+    PetscFunctionReturn(0);
+}
+
+
+
+
+/********************************************************************
+ * @brief stop deferring reductions; if this closes the outermost
+ * block we resolve everything that is pending
+ *******************************************************************/
+PetscErrorCode ReductionEngine::End() {
+    PetscErrorCode ierr = 0;
+    PetscFunctionBegin;
+
+    ierr = Assert(this->m_Depth > 0, "unbalanced reduction block"); CHKERRQ(ierr);
+    --this->m_Depth;
+    ierr = this->Flush(); CHKERRQ(ierr);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief close block without resolving the pending reductions (no
+ * communication; other ranks might not get here); the result
+ * pointers of the pending and posted entries might be invalid on
+ * error paths, so we discard them once the outermost block is closed;
+ * a request still in flight is completed by the next Wait() without
+ * setting any results
+ *******************************************************************/
+void ReductionEngine::Abort() {
+    if (this->m_Depth > 0) --this->m_Depth;
+    if (this->m_Depth == 0) {
+        this->m_Entries.clear();
+        this->m_NumPosted = 0;
+    }
+}
+
+
+
+
+/********************************************************************
+ * @brief register a local partial sum
+ *******************************************************************/
+PetscErrorCode ReductionEngine::Add(ScalarType value, ScalarType* result,
+                                    ScalarType scale, ScalarType shift) {
+    PetscErrorCode ierr = 0;
+    Entry entry;
+    PetscFunctionBegin;
+
+    ierr = Assert(result != NULL, "null pointer"); CHKERRQ(ierr);
+
+    entry.value = value;
+    entry.result = result;
+    entry.scale = scale;
+    entry.shift = shift;
+    entry.callback = NULL;
+    this->m_Entries.push_back(entry);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief register a callback
+ *******************************************************************/
+PetscErrorCode ReductionEngine::AddCallback(ReductionCallback* callback) {
+    PetscErrorCode ierr = 0;
+    Entry entry;
+    PetscFunctionBegin;
+
+    ierr = Assert(callback != NULL, "null pointer"); CHKERRQ(ierr);
+
+    entry.value = 0.0;
+    entry.result = NULL;
+    entry.scale = 0.0;
+    entry.shift = 0.0;
+    entry.callback = callback;
+    this->m_Entries.push_back(entry);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief resolve all pending entries (unless we are deferring)
+ *******************************************************************/
+PetscErrorCode ReductionEngine::Flush() {
+    PetscErrorCode ierr = 0;
+    PetscFunctionBegin;
+
+    if (!this->IsDeferred()) {
+        ierr = this->Reduce(); CHKERRQ(ierr);
+    }
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief resolve all pending entries now; entries deferred by other
+ * components are resolved early (their results are just available
+ * sooner)
+ *******************************************************************/
+PetscErrorCode ReductionEngine::Reduce() {
+    PetscErrorCode ierr = 0;
+    PetscFunctionBegin;
+
+    // complete outstanding request first
+    ierr = this->Wait(); CHKERRQ(ierr);
+
+    if (!this->m_Entries.empty()) {
+        ierr = this->Post(); CHKERRQ(ierr);
+        ierr = this->Wait(); CHKERRQ(ierr);
+    }
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief pack pending entries and post non-blocking allreduce
+ *******************************************************************/
+PetscErrorCode ReductionEngine::Post() {
+    PetscErrorCode ierr = 0;
+    int rval;
+    PetscFunctionBegin;
+
+    // only one request in flight
+    ierr = this->Wait(); CHKERRQ(ierr);
+
+    this->m_SendBuffer.clear();
+    for (size_t i = 0; i < this->m_Entries.size(); ++i) {
+        if (this->m_Entries[i].callback == NULL) {
+            this->m_SendBuffer.push_back(this->m_Entries[i].value);
+        }
+    }
+    this->m_RecvBuffer.resize(this->m_SendBuffer.size());
+    this->m_NumPosted = this->m_Entries.size();
+    this->m_Posted = true;
+
+    if (!this->m_SendBuffer.empty()) {
+        rval = MPI_Iallreduce(this->m_SendBuffer.data(), this->m_RecvBuffer.data(),
+                              static_cast<int>(this->m_SendBuffer.size()),
+                              MPIU_REAL, MPI_SUM, PETSC_COMM_WORLD, &this->m_Request);
+        ierr = Assert(rval == MPI_SUCCESS, "mpi error"); CHKERRQ(ierr);
+        ++this->m_NumReductions;
+
+        // payload of collective (actual volume depends on mpi algorithm)
+        double nbytes = static_cast<double>(this->m_SendBuffer.size()*sizeof(ScalarType));
+        CommCounter::Add(COMMREDUCE, nbytes, nbytes, 1, 1, 0);
+    }
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief wait for posted reduction, set results and execute
+ * callbacks (in the order they were registered)
+ *******************************************************************/
+PetscErrorCode ReductionEngine::Wait() {
+    PetscErrorCode ierr = 0;
+    int rval;
+    size_t j = 0;
+    PetscFunctionBegin;
+
+    if (!this->m_Posted) {
+        PetscFunctionReturn(ierr);
+    }
+
+    if (this->m_Request != MPI_REQUEST_NULL) {
+        rval = MPI_Wait(&this->m_Request, MPI_STATUS_IGNORE);
+        ierr = Assert(rval == MPI_SUCCESS, "mpi error"); CHKERRQ(ierr);
+    }
+    this->m_Posted = false;
+
+    for (size_t i = 0; i < this->m_NumPosted; ++i) {
+        Entry& entry = this->m_Entries[i];
+        if (entry.callback != NULL) {
+            ierr = entry.callback->FinalizeReduction(); CHKERRQ(ierr);
+        } else {
+            *entry.result = entry.shift + entry.scale*this->m_RecvBuffer[j++];
+        }
+    }
+
+    // entries added after Post() remain pending
+    this->m_Entries.erase(this->m_Entries.begin(), this->m_Entries.begin() + this->m_NumPosted);
+    this->m_NumPosted = 0;
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief constructor
+ *******************************************************************/
+ReductionBlock::ReductionBlock(ReductionEngine* engine) {
+    this->m_Engine = engine;
+    this->m_Open = false;
+}
+
+
+
+
+/********************************************************************
+ * @brief destructor; aborts the block if it is still open
+ *******************************************************************/
+ReductionBlock::~ReductionBlock() {
+    if (this->m_Open) {
+        this->m_Engine->Abort();
+        this->m_Open = false;
+    }
+}
+
+
+
+
+/********************************************************************
+ * @brief start deferring reductions
+ *******************************************************************/
+PetscErrorCode ReductionBlock::Begin() {
+    PetscErrorCode ierr = 0;
+    PetscFunctionBegin;
+
+    ierr = Assert(!this->m_Open, "reduction block already open"); CHKERRQ(ierr);
+    ierr = this->m_Engine->Begin(); CHKERRQ(ierr);
+    this->m_Open = true;
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief close block and resolve the reductions
+ *******************************************************************/
+PetscErrorCode ReductionBlock::End() {
+    PetscErrorCode ierr = 0;
+    PetscFunctionBegin;
+
+    ierr = Assert(this->m_Open, "reduction block not open"); CHKERRQ(ierr);
+    this->m_Open = false;
+    ierr = this->m_Engine->End(); CHKERRQ(ierr);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+}  // namespace reg
+
+
+
+
+#endif  // _REDUCTIONENGINE_CPP_
@@ -21,6 +21,11 @@
 #define _REGOPT_CPP_
 
 #include "RegOpt.hpp"
+#include <algorithm>
+#include <set>
+#include <cstring>
+#include <cstdio>
+#include <unistd.h>
 
 
 
@@ -79,6 +84,8 @@ void RegOpt::Copy(const RegOpt& opt) {
     this->m_FFT.ostart[0] = opt.m_FFT.ostart[0];
     this->m_FFT.ostart[1] = opt.m_FFT.ostart[1];
     this->m_FFT.ostart[2] = opt.m_FFT.ostart[2];
+    this->m_FFT.gridopscache = opt.m_FFT.gridopscache;
+    this->m_FFT.wisdomdir = opt.m_FFT.wisdomdir;
 
     this->m_Domain.nl = opt.m_Domain.nl;
     this->m_Domain.ng = opt.m_Domain.ng;
@@ -102,6 +109,8 @@ void RegOpt::Copy(const RegOpt& opt) {
     this->m_Distance.type = opt.m_Distance.type;
     this->m_Distance.reset = opt.m_Distance.reset;
     this->m_Distance.scale = opt.m_Distance.scale;
+    this->m_Distance.lnccradius = opt.m_Distance.lnccradius;
+    this->m_Distance.mibins = opt.m_Distance.mibins;
 
     this->m_RegNorm.type = opt.m_RegNorm.type;
     this->m_RegNorm.beta[0] = opt.m_RegNorm.beta[0];  // weight for regularization operator A[v]
@@ -115,6 +124,9 @@ void RegOpt::Copy(const RegOpt& opt) {
     this->m_PDESolver.cflnumber = opt.m_PDESolver.cflnumber;
     this->m_PDESolver.monitorcflnumber = opt.m_PDESolver.monitorcflnumber;
     this->m_PDESolver.adapttimestep = opt.m_PDESolver.adapttimestep;
+    this->m_PDESolver.adaptaccuracy = opt.m_PDESolver.adaptaccuracy;
+    this->m_PDESolver.iplinear = opt.m_PDESolver.iplinear;
+    this->m_PDESolver.scalingsquaring = opt.m_PDESolver.scalingsquaring;
     this->m_PDESolver.pdetype = opt.m_PDESolver.pdetype;
 
     this->m_RegModel = opt.m_RegModel;
@@ -151,6 +163,8 @@ void RegOpt::Copy(const RegOpt& opt) {
     this->m_OptPara.fastsolve = opt.m_OptPara.fastsolve;
     this->m_OptPara.fastpresolve = opt.m_OptPara.fastpresolve;
     this->m_OptPara.method = opt.m_OptPara.method;
+    this->m_OptPara.methodset = opt.m_OptPara.methodset;
+    this->m_OptPara.lbfgsmem = opt.m_OptPara.lbfgsmem;
     this->m_OptPara.usezeroinitialguess = opt.m_OptPara.usezeroinitialguess;
     this->m_OptPara.derivativecheckenabled = opt.m_OptPara.derivativecheckenabled;
     this->m_OptPara.glmethod = opt.m_OptPara.glmethod;
@@ -167,6 +181,7 @@ void RegOpt::Copy(const RegOpt& opt) {
     this->m_ReadWriteFlags.iterates = opt.m_ReadWriteFlags.iterates;
     this->m_ReadWriteFlags.velocity = opt.m_ReadWriteFlags.velocity;
     this->m_ReadWriteFlags.defmap = opt.m_ReadWriteFlags.defmap;
+    this->m_ReadWriteFlags.invdefmap = opt.m_ReadWriteFlags.invdefmap;
     this->m_ReadWriteFlags.defgrad = opt.m_ReadWriteFlags.defgrad;
     this->m_ReadWriteFlags.detdefgrad = opt.m_ReadWriteFlags.detdefgrad;
     this->m_ReadWriteFlags.deffield = opt.m_ReadWriteFlags.deffield;
@@ -174,6 +189,7 @@ void RegOpt::Copy(const RegOpt& opt) {
     this->m_ReadWriteFlags.invresidual = opt.m_ReadWriteFlags.invresidual;
     this->m_ReadWriteFlags.velnorm = opt.m_ReadWriteFlags.velnorm;
     this->m_ReadWriteFlags.deftemplate = opt.m_ReadWriteFlags.deftemplate;
+    this->m_ReadWriteFlags.asyncdepth = opt.m_ReadWriteFlags.asyncdepth;
 
     this->m_FileNames.mr = opt.m_FileNames.mr;
     this->m_FileNames.mt = opt.m_FileNames.mt;
@@ -192,7 +208,11 @@ void RegOpt::Copy(const RegOpt& opt) {
 
     this->m_RegFlags.applysmoothing = opt.m_RegFlags.applysmoothing;
     this->m_RegFlags.applyrescaling = opt.m_RegFlags.applyrescaling;
+    this->m_RegFlags.recursivesmoothing = opt.m_RegFlags.recursivesmoothing;
+    this->m_RegFlags.activeregion = opt.m_RegFlags.activeregion;
     this->m_RegFlags.detdefgradfromdeffield = opt.m_RegFlags.detdefgradfromdeffield;
+    this->m_RegFlags.detdefgradlowmem = opt.m_RegFlags.detdefgradlowmem;
+    this->m_RegFlags.invdefmapfixedpoint = opt.m_RegFlags.invdefmapfixedpoint;
     this->m_RegFlags.invdefgrad = opt.m_RegFlags.invdefgrad;
     this->m_RegFlags.checkdefmapsolve = opt.m_RegFlags.checkdefmapsolve;
     this->m_RegFlags.registerprobmaps = opt.m_RegFlags.registerprobmaps;
@@ -202,6 +222,8 @@ void RegOpt::Copy(const RegOpt& opt) {
     this->m_ParaCont.enabled = opt.m_ParaCont.enabled;
     this->m_ParaCont.targetbeta = opt.m_ParaCont.targetbeta;
     this->m_ParaCont.beta0 = opt.m_ParaCont.beta0;
+    this->m_ParaCont.ngroups = opt.m_ParaCont.ngroups;
+    this->m_ParaCont.group = opt.m_ParaCont.group;
 
     // grid continuation
     this->m_GridCont.nxmin = opt.m_GridCont.nxmin;
@@ -230,6 +252,8 @@ void RegOpt::Copy(const RegOpt& opt) {
     this->m_Monitor.rval = opt.m_Monitor.rval;
     this->m_Monitor.gradnorm = opt.m_Monitor.gradnorm;
     this->m_Monitor.gradnorm0 = opt.m_Monitor.gradnorm0;
+    this->m_Monitor.accuracychanged = opt.m_Monitor.accuracychanged;
+    this->m_Monitor.iteroffset = opt.m_Monitor.iteroffset;
 
     this->m_Log.finalresidual[0] = 0;
     this->m_Log.finalresidual[1] = 0;
@@ -246,6 +270,8 @@ void RegOpt::Copy(const RegOpt& opt) {
     for (IntType i = 0; i < NLOGFLAGS; ++i) {
         this->m_Log.enabled[i] = opt.m_Log.enabled[i];
     }
+    this->m_Log.tracebuffer = opt.m_Log.tracebuffer;
+    this->m_Log.perfrawevent = opt.m_Log.perfrawevent;
 
     this->m_Verbosity = opt.m_Verbosity;
     this->m_Indent = opt.m_Indent;
@@ -325,6 +351,8 @@ PetscErrorCode RegOpt::ParseArguments(int argc, char** argv) {
             values.clear();
         } else if (strcmp(argv[1], "-disablesmoothing") == 0) {
             this->m_RegFlags.applysmoothing = false;
+        } else if (strcmp(argv[1], "-recursivesmoothing") == 0) {
+            this->m_RegFlags.recursivesmoothing = true;
         } else if (strcmp(argv[1], "-disablerescaling") == 0) {
             this->m_RegFlags.applyrescaling = false;
         } else if (strcmp(argv[1], "-probmaps") == 0) {
@@ -332,6 +360,12 @@ PetscErrorCode RegOpt::ParseArguments(int argc, char** argv) {
         } else if (strcmp(argv[1], "-nthreads") == 0) {
             argc--; argv++;
             this->m_NumThreads = atoi(argv[1]);
+        } else if (strcmp(argv[1], "-gridopscache") == 0) {
+            argc--; argv++;
+            this->m_FFT.gridopscache = atoi(argv[1]);
+        } else if (strcmp(argv[1], "-fftwisdom") == 0) {
+            argc--; argv++;
+            this->m_FFT.wisdomdir = argv[1];
         } else if (strcmp(argv[1], "-np") == 0) {
             argc--; argv++;
             const std::string npinput(argv[1]);
@@ -388,6 +422,8 @@ PetscErrorCode RegOpt::ParseArguments(int argc, char** argv) {
         } else if (strcmp(argv[1], "-mask") == 0) {
             argc--; argv++;
             this->m_FileNames.mask = argv[1];
+        } else if (strcmp(argv[1], "-activeregion") == 0) {
+            this->m_RegFlags.activeregion = true;
         } else if (strcmp(argv[1], "-v1") == 0) {
             argc--; argv++;
             this->m_FileNames.iv1 = argv[1];
@@ -413,6 +449,8 @@ PetscErrorCode RegOpt::ParseArguments(int argc, char** argv) {
                 this->m_FileNames.extension = ".hdf5";
             } else if (strcmp(argv[1], "binary") == 0) {
                 this->m_FileNames.extension = ".bin";
+            } else if (strcmp(argv[1], "claire") == 0) {
+                this->m_FileNames.extension = ".clr";
             } else {
                 msg = "\n\x1b[31m output format not supported: %s\x1b[0m\n";
                 ierr = PetscPrintf(PETSC_COMM_WORLD, msg.c_str(), argv[1]); CHKERRQ(ierr);
@@ -440,10 +478,18 @@ PetscErrorCode RegOpt::ParseArguments(int argc, char** argv) {
             this->m_ReadWriteFlags.deffield = true;
         } else if (strcmp(argv[1], "-defmap") == 0) {
             this->m_ReadWriteFlags.defmap = true;
+        } else if (strcmp(argv[1], "-invdefmap") == 0) {
+            this->m_ReadWriteFlags.defmap = true;
+            this->m_ReadWriteFlags.invdefmap = true;
+        } else if (strcmp(argv[1], "-invdefmapfixedpoint") == 0) {
+            this->m_RegFlags.invdefmapfixedpoint = true;
         } else if (strcmp(argv[1], "-iterates") == 0) {
             this->m_ReadWriteFlags.iterates = true;
         } else if (strcmp(argv[1], "-timeseries") == 0) {
             this->m_ReadWriteFlags.timeseries = true;
+        } else if (strcmp(argv[1], "-asyncio") == 0) {
+            argc--; argv++;
+            this->m_ReadWriteFlags.asyncdepth = atoi(argv[1]);
         } else if (strcmp(argv[1], "-checkpoints") == 0) {
             this->m_StoreCheckPoints = true;
         } else if (strcmp(argv[1], "-logjacobian") == 0) {
@@ -458,8 +504,20 @@ PetscErrorCode RegOpt::ParseArguments(int argc, char** argv) {
             this->m_Log.enabled[LOGDIST] = true;
         } else if (strcmp(argv[1], "-loggradient") == 0) {
             this->m_Log.enabled[LOGGRAD] = true;
+        } else if (strcmp(argv[1], "-logtrace") == 0) {
+            this->m_Log.enabled[LOGTRACE] = true;
+        } else if (strcmp(argv[1], "-tracebuffer") == 0) {
+            argc--; argv++;
+            this->m_Log.tracebuffer = static_cast<IntType>(atoi(argv[1]));
+        } else if (strcmp(argv[1], "-logperf") == 0) {
+            this->m_Log.enabled[LOGPERF] = true;
+        } else if (strcmp(argv[1], "-perfrawevent") == 0) {
+            argc--; argv++;
+            this->m_Log.perfrawevent = strtoul(argv[1], NULL, 0);
         } else if (strcmp(argv[1], "-detdefgradfromdeffield") == 0) {
             this->m_RegFlags.detdefgradfromdeffield = true;
+        } else if (strcmp(argv[1], "-detdefgradlowmem") == 0) {
+            this->m_RegFlags.detdefgradlowmem = true;
         } else if (strcmp(argv[1], "-preset") == 0) {
             argc--; argv++;
             if (strcmp(argv[1], "fast-aggressive") == 0) {
@@ -487,11 +545,17 @@ PetscErrorCode RegOpt::ParseArguments(int argc, char** argv) {
                 this->m_OptPara.method = FULLNEWTON;
             } else if (strcmp(argv[1], "gn") == 0) {
                 this->m_OptPara.method = GAUSSNEWTON;
+            } else if (strcmp(argv[1], "lbfgs") == 0) {
+                this->m_OptPara.method = QUASINEWTON;
             } else {
                 msg = "\n\x1b[31m optimization method not defined: %s\x1b[0m\n";
                 ierr = PetscPrintf(PETSC_COMM_WORLD, msg.c_str(), argv[1]); CHKERRQ(ierr);
                 ierr = this->Usage(true); CHKERRQ(ierr);
             }
+            this->m_OptPara.methodset = true;
+        } else if (strcmp(argv[1], "-lbfgsmem") == 0) {
+            argc--; argv++;
+            this->m_OptPara.lbfgsmem = atoi(argv[1]);
         } else if (strcmp(argv[1], "-maxit") == 0) {
             argc--; argv++;
             const std::string iterations = argv[1];
@@ -668,12 +732,16 @@ PetscErrorCode RegOpt::ParseArguments(int argc, char** argv) {
             this->m_PDESolver.monitorcflnumber = true;
         } else if (strcmp(argv[1], "-adapttimestep") == 0) {
             this->m_PDESolver.adapttimestep = true;
+        } else if (strcmp(argv[1], "-adaptaccuracy") == 0) {
+            this->m_PDESolver.adaptaccuracy = true;
         } else if (strcmp(argv[1], "-iporder") == 0) {
             argc--; argv++;
             this->m_PDESolver.iporder = atoi(argv[1]);
         } else if (strcmp(argv[1], "-rkorder") == 0) {
             argc--; argv++;
             this->m_PDESolver.rkorder = atoi(argv[1]);
+        } else if (strcmp(argv[1], "-scalingsquaring") == 0) {
+            this->m_PDESolver.scalingsquaring = true;
         } else if (strcmp(argv[1], "-hessshift") == 0) {
             argc--; argv++;
             this->m_KrylovMethod.hessshift = atof(argv[1]);
@@ -683,11 +751,21 @@ PetscErrorCode RegOpt::ParseArguments(int argc, char** argv) {
                 this->m_Distance.type = SL2;
 	    } else if (strcmp(argv[1], "ncc") == 0) {
                 this->m_Distance.type = NCC;
+            } else if (strcmp(argv[1], "lncc") == 0) {
+                this->m_Distance.type = LNCC;
+            } else if (strcmp(argv[1], "mi") == 0) {
+                this->m_Distance.type = MI;
             } else {
                 msg = "\n\x1b[31m distance measure not available: %s\x1b[0m\n";
                 ierr = PetscPrintf(PETSC_COMM_WORLD, msg.c_str(), argv[1]); CHKERRQ(ierr);
                 ierr = this->Usage(true); CHKERRQ(ierr);
             }
+        } else if (strcmp(argv[1], "-lnccradius") == 0) {
+            argc--; argv++;
+            this->m_Distance.lnccradius = atoi(argv[1]);
+        } else if (strcmp(argv[1], "-mibins") == 0) {
+            argc--; argv++;
+            this->m_Distance.mibins = atoi(argv[1]);
         } else if (strcmp(argv[1], "-regnorm") == 0) {
             argc--; argv++;
             if (strcmp(argv[1], "h1s") == 0) {
@@ -767,6 +845,23 @@ PetscErrorCode RegOpt::ParseArguments(int argc, char** argv) {
         } else if (strcmp(argv[1], "-betainit") == 0) {
             argc--; argv++;
             this->m_ParaCont.beta0 = atof(argv[1]);
+        } else if (strcmp(argv[1], "-pcontgroups") == 0) {
+            argc--; argv++;
+            this->m_ParaCont.ngroups = atoi(argv[1]);
+            if (this->m_ParaCont.ngroups > 1) {
+                int nprocs, nprocsworld, rankworld;
+                MPI_Comm_size(PETSC_COMM_WORLD, &nprocs);
+                MPI_Comm_size(MPI_COMM_WORLD, &nprocsworld);
+                MPI_Comm_rank(MPI_COMM_WORLD, &rankworld);
+                // the communicator has been split before petsc was
+                // initialized (see SplitCommunicator); if this did
+                // not happen we run the serial search
+                if (nprocs*this->m_ParaCont.ngroups == nprocsworld) {
+                    this->m_ParaCont.group = rankworld/nprocs;
+                } else {
+                    this->m_ParaCont.ngroups = 1;
+                }
+            }
         } else if (strcmp(argv[1], "-scalecont") == 0) {
             this->m_ScaleCont.enabled = true;
         } else if (strcmp(argv[1], "-gridcont") == 0) {
@@ -808,6 +903,19 @@ PetscErrorCode RegOpt::ParseArguments(int argc, char** argv) {
         }
     }
 
+    // the groups of the parallel search for the regularization parameter
+    // run concurrently; all but the first group (which writes the final
+    // results) use their own prefix for output files and write their
+    // console output to a file
+    if (this->m_ParaCont.ngroups > 1 && this->m_ParaCont.group > 0) {
+        this->m_FileNames.xfolder += "group" + std::to_string(this->m_ParaCont.group) + "-";
+        MPI_Comm_rank(PETSC_COMM_WORLD, &flag);
+        if (flag == 0) {
+            msg = this->m_FileNames.xfolder + "stdout.log";
+            ierr = Assert(freopen(msg.c_str(), "w", stdout) != NULL, "could not redirect output"); CHKERRQ(ierr);
+        }
+    }
+
     this->m_Timer[FFTSETUP][LOG] = 0.0;
     // set number of threads
     ierr = InitializeDataDistribution(this->m_NumThreads, this->m_CartGridDims,
@@ -910,6 +1018,7 @@ PetscErrorCode RegOpt::InitializeFFT() {
     ScalarType *u = NULL;
     ScalarType fftsetuptime;
     ComplexType *uk = NULL;
+    bool wisdomfound = false;
 
     PetscFunctionBegin;
 
@@ -990,10 +1099,14 @@ PetscErrorCode RegOpt::InitializeFFT() {
         ierr = DbgMsg("allocating fft plan"); CHKERRQ(ierr);
     }
     fftsetuptime = -MPI_Wtime();
+    ierr = this->ImportFFTWisdom(nx, this->m_FFT.mpicomm, wisdomfound); CHKERRQ(ierr);
     this->m_FFT.plan = accfft_plan_dft_3d_r2c(nx, u, reinterpret_cast<ScalarType*>(uk),
                                               this->m_FFT.mpicomm, ACCFFT_MEASURE);
     fftsetuptime += MPI_Wtime();
     ierr = Assert(this->m_FFT.plan != NULL, "allocation failed"); CHKERRQ(ierr);
+    if (!wisdomfound) {
+        ierr = this->ExportFFTWisdom(nx, this->m_FFT.mpicomm); CHKERRQ(ierr);
+    }
 
     // set the fft setup time
     this->m_Timer[FFTSETUP][LOG] += fftsetuptime;
@@ -1026,6 +1139,222 @@ PetscErrorCode RegOpt::InitializeFFT() {
 
 
 
+/********************************************************************
+ * @brief file that holds the fftw wisdom for a given grid, data
+ * distribution, precision and number of threads (wisdom is only
+ * valid for the exact same setup)
+ *******************************************************************/
+static std::string FFTWisdomFile(const std::string& dir, int* nx, int* np, int nthreads) {
+    std::stringstream ss;
+#if defined(PETSC_USE_REAL_SINGLE)
+    ss << dir << "/fftw-wisdom-float";
+#else
+    ss << dir << "/fftw-wisdom-double";
+#endif
+    ss << "-nx-" << nx[0] << "x" << nx[1] << "x" << nx[2]
+       << "-np-" << np[0] << "x" << np[1]
+       << "-nt-" << nthreads << ".txt";
+    return ss.str();
+}
+
+
+
+
+/********************************************************************
+ * @brief import fftw wisdom for a given grid size; the file is read
+ * by rank zero and broadcasted, so that all ranks use the same
+ * plans; the file holds the (distinct) wisdom of all ranks; each
+ * record is stored as "<nbytes>\n<wisdom>"
+ * @param nx grid size
+ * @param comm communicator of the fft
+ * @param found true if wisdom was found and imported
+ *******************************************************************/
+PetscErrorCode RegOpt::ImportFFTWisdom(int* nx, MPI_Comm comm, bool& found) {
+    PetscErrorCode ierr = 0;
+    int rank, merr, np[2], nbytes = 0;
+    std::string filename, buffer;
+    std::stringstream ss;
+    std::ifstream ifile;
+    size_t pos = 0, len, eol;
+
+    PetscFunctionBegin;
+
+    found = false;
+    if (this->m_FFT.wisdomdir.empty()) {
+        PetscFunctionReturn(ierr);
+    }
+
+    this->Enter(__func__);
+
+    MPI_Comm_rank(comm, &rank);
+
+    np[0] = static_cast<int>(this->m_CartGridDims[0]);
+    np[1] = static_cast<int>(this->m_CartGridDims[1]);
+    filename = FFTWisdomFile(this->m_FFT.wisdomdir, nx, np, this->m_NumThreads);
+
+    if (rank == 0) {
+        ifile.open(filename.c_str(), std::ios::in | std::ios::binary);
+        if (ifile.is_open()) {
+            ss << ifile.rdbuf();
+            buffer = ss.str();
+            ss.clear(); ss.str(std::string());
+            ifile.close();
+            nbytes = static_cast<int>(buffer.size());
+        }
+    }
+
+    merr = MPI_Bcast(&nbytes, 1, MPI_INT, 0, comm);
+    ierr = MPIERRQ(merr); CHKERRQ(ierr);
+    if (nbytes == 0) {
+        if (this->m_Verbosity > 1) {
+            ierr = DbgMsg("no fftw wisdom found (" + filename + ")"); CHKERRQ(ierr);
+        }
+        this->Exit(__func__);
+        PetscFunctionReturn(ierr);
+    }
+
+    buffer.resize(nbytes);
+    merr = MPI_Bcast(&buffer[0], nbytes, MPI_CHAR, 0, comm);
+    ierr = MPIERRQ(merr); CHKERRQ(ierr);
+
+    // import all records (fftw accumulates wisdom)
+    found = true;
+    while (pos < buffer.size()) {
+        eol = buffer.find('\n', pos);
+        if (eol == std::string::npos) {found = false; break;}
+        len = static_cast<size_t>(atol(buffer.substr(pos, eol - pos).c_str()));
+        pos = eol + 1;
+        if (len == 0 || pos + len > buffer.size()) {found = false; break;}
+#if defined(PETSC_USE_REAL_SINGLE)
+        if (!fftwf_import_wisdom_from_string(buffer.substr(pos, len).c_str())) found = false;
+#else
+        if (!fftw_import_wisdom_from_string(buffer.substr(pos, len).c_str())) found = false;
+#endif
+        pos += len;
+    }
+
+    if (!found) {
+        ierr = WrngMsg("corrupted fftw wisdom (" + filename + ")"); CHKERRQ(ierr);
+    } else if (this->m_Verbosity > 1) {
+        ierr = DbgMsg("imported fftw wisdom (" + filename + ")"); CHKERRQ(ierr);
+    }
+
+    this->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief export fftw wisdom for a given grid size; the wisdom of all
+ * ranks is gathered on rank zero (local pencils can differ in size)
+ * and written to file
+ * @param nx grid size
+ * @param comm communicator of the fft
+ *******************************************************************/
+PetscErrorCode RegOpt::ExportFFTWisdom(int* nx, MPI_Comm comm) {
+    PetscErrorCode ierr = 0;
+    int rank, nprocs, merr, np[2], nbytes;
+    int *nbytesall = NULL, *offset = NULL;
+    char *wisdom = NULL, *wisdomall = NULL;
+    std::string filename, tmpname;
+    std::set<std::string> records;
+    std::set<std::string>::iterator it;
+    std::ofstream ofile;
+    std::stringstream ss;
+
+    PetscFunctionBegin;
+
+    if (this->m_FFT.wisdomdir.empty()) {
+        PetscFunctionReturn(ierr);
+    }
+
+    this->Enter(__func__);
+
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &nprocs);
+
+#if defined(PETSC_USE_REAL_SINGLE)
+    wisdom = fftwf_export_wisdom_to_string();
+#else
+    wisdom = fftw_export_wisdom_to_string();
+#endif
+    nbytes = wisdom != NULL ? static_cast<int>(strlen(wisdom)) : 0;
+
+    if (rank == 0) {
+        try {nbytesall = new int[nprocs];}
+        catch (std::bad_alloc&) {
+            ierr = reg::ThrowError("allocation failed"); CHKERRQ(ierr);
+        }
+        try {offset = new int[nprocs];}
+        catch (std::bad_alloc&) {
+            ierr = reg::ThrowError("allocation failed"); CHKERRQ(ierr);
+        }
+    }
+    merr = MPI_Gather(&nbytes, 1, MPI_INT, nbytesall, 1, MPI_INT, 0, comm);
+    ierr = MPIERRQ(merr); CHKERRQ(ierr);
+
+    if (rank == 0) {
+        offset[0] = 0;
+        for (int p = 1; p < nprocs; ++p) {
+            offset[p] = offset[p-1] + nbytesall[p-1];
+        }
+        try {wisdomall = new char[offset[nprocs-1] + nbytesall[nprocs-1] + 1];}
+        catch (std::bad_alloc&) {
+            ierr = reg::ThrowError("allocation failed"); CHKERRQ(ierr);
+        }
+    }
+    merr = MPI_Gatherv(wisdom, nbytes, MPI_CHAR, wisdomall, nbytesall, offset, MPI_CHAR, 0, comm);
+    ierr = MPIERRQ(merr); CHKERRQ(ierr);
+
+    if (rank == 0) {
+        // ranks with the same pencil size have the same wisdom
+        for (int p = 0; p < nprocs; ++p) {
+            if (nbytesall[p] > 0) {
+                records.insert(std::string(wisdomall + offset[p], nbytesall[p]));
+            }
+        }
+
+        np[0] = static_cast<int>(this->m_CartGridDims[0]);
+        np[1] = static_cast<int>(this->m_CartGridDims[1]);
+        filename = FFTWisdomFile(this->m_FFT.wisdomdir, nx, np, this->m_NumThreads);
+
+        // write to temporary file first, so that concurrent runs never
+        // see a partially written file
+        ss << filename << "." << getpid();
+        tmpname = ss.str();
+        ofile.open(tmpname.c_str(), std::ios::out | std::ios::binary);
+        if (ofile.is_open()) {
+            for (it = records.begin(); it != records.end(); ++it) {
+                ofile << it->size() << "\n" << *it;
+            }
+            ofile.close();
+            if (rename(tmpname.c_str(), filename.c_str()) != 0) {
+                remove(tmpname.c_str());
+                ierr = WrngMsg("could not write fftw wisdom (" + filename + ")"); CHKERRQ(ierr);
+            } else if (this->m_Verbosity > 1) {
+                ierr = DbgMsg("exported fftw wisdom (" + filename + ")"); CHKERRQ(ierr);
+            }
+        } else {
+            ierr = WrngMsg("could not write fftw wisdom (" + filename + ")"); CHKERRQ(ierr);
+        }
+    }
+
+    if (wisdom != NULL) free(wisdom);
+    if (wisdomall != NULL) delete [] wisdomall;
+    if (nbytesall != NULL) delete [] nbytesall;
+    if (offset != NULL) delete [] offset;
+
+    this->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
 /********************************************************************
  * @brief initialize class variables
  *******************************************************************/
@@ -1045,6 +1374,8 @@ PetscErrorCode RegOpt::Initialize() {
     this->m_FFT.ostart[0] = 0;
     this->m_FFT.ostart[1] = 0;
     this->m_FFT.ostart[2] = 0;
+    this->m_FFT.gridopscache = 1024;    ///< 1GB for cached grid transfer operators
+    this->m_FFT.wisdomdir = "";         ///< no persistent fftw wisdom
 
     this->m_Domain = {};
     this->m_Domain.nl = 0;
@@ -1078,12 +1409,17 @@ PetscErrorCode RegOpt::Initialize() {
     this->m_Distance.type = SL2;                        ///< default distance measure (squared l2 distance)
     this->m_Distance.reset = false;                     ///< re-allocate distance measure
     this->m_Distance.scale = 0; 			///< set default scale for distance measure
+    this->m_Distance.lnccradius = 2;                    ///< window radius for local ncc (5x5x5 window)
+    this->m_Distance.mibins = 32;                       ///< number of histogram bins for mutual information
 
     this->m_PDESolver = {};
     this->m_PDESolver.type = SL;                    ///< PDE solver (semi-lagrangian or rk2)
     this->m_PDESolver.cflnumber = 0.5;              ///< CFL number used for adaptive time stepping
     this->m_PDESolver.monitorcflnumber = false;     ///< show CFL number during solve
     this->m_PDESolver.adapttimestep = false;        ///< use adaptive time stepping (based on CFL number)
+    this->m_PDESolver.adaptaccuracy = false;        ///< adapt accuracy of pde solves to progress of optimizer
+    this->m_PDESolver.iplinear = false;             ///< use linear interpolation (accuracy adaptive solver)
+    this->m_PDESolver.scalingsquaring = false;      ///< integrate deformation map in time
     this->m_PDESolver.rkorder = 2;                  ///< order of RK method
     this->m_PDESolver.iporder = 3;                  ///< order of interpolation model
     this->m_PDESolver.pdetype = TRANSPORTEQ;        ///< PDE constraint type (transport or continuity equation)
@@ -1158,6 +1494,8 @@ PetscErrorCode RegOpt::Initialize() {
     this->m_OptPara.miniter = 0;                      ///< min number of iterations (used for inaccurate presolves)
     this->m_OptPara.gtolbound = 0.8;                  ///< min relative change of gradient (for loose stopping conditions)
     this->m_OptPara.method = GAUSSNEWTON;             ///< optmization method
+    this->m_OptPara.methodset = false;                ///< optimization method set by user
+    this->m_OptPara.lbfgsmem = 5;                     ///< number of stored update pairs (limited memory BFGS)
     this->m_OptPara.gradtype = L2GRAD;                ///< gradient type
     this->m_OptPara.fastsolve = false;                ///< switch on fast solver (less accurate)
     this->m_OptPara.fastpresolve = true;              ///< enable fast (inaccurate) solve for first steps
@@ -1188,9 +1526,11 @@ PetscErrorCode RegOpt::Initialize() {
     this->m_ReadWriteFlags.residual = false;        ///< write residual images to file
     this->m_ReadWriteFlags.invresidual = false;     ///< write inverse of residual images to file
     this->m_ReadWriteFlags.defmap = false;          ///< write deformation map to file
+    this->m_ReadWriteFlags.invdefmap = false;       ///< write inverse deformation map to file
     this->m_ReadWriteFlags.deffield = false;        ///< write deformation field / displacement field to file
     this->m_ReadWriteFlags.velnorm = false;         ///< write norm of velocity field to file
     this->m_ReadWriteFlags.deftemplate = false;     ///< write deformed template image to file
+    this->m_ReadWriteFlags.asyncdepth = 0;          ///< synchronous io
 
     this->m_FileNames = {};
     this->m_FileNames.mr.clear();
@@ -1212,7 +1552,11 @@ PetscErrorCode RegOpt::Initialize() {
     this->m_RegFlags = {};
     this->m_RegFlags.applysmoothing = true;             ///< enable/disable image smoothing
     this->m_RegFlags.applyrescaling = true;             ///< enable/disable image rescaling (for output)
+    this->m_RegFlags.recursivesmoothing = false;        ///< spectral gaussian smoothing
+    this->m_RegFlags.activeregion = false;              ///< solve on entire domain
     this->m_RegFlags.detdefgradfromdeffield = false;    ///< compute det(grad(y)) via displacement field u
+    this->m_RegFlags.detdefgradlowmem = false;          ///< store grad(y) if there is enough memory
+    this->m_RegFlags.invdefmapfixedpoint = false;       ///< integrate inverse deformation map in time
     this->m_RegFlags.invdefgrad = false;                ///< compute inverse of det(grad(y))^{-1}
     this->m_RegFlags.checkdefmapsolve = false;          ///< check computation of deformation map y; error = x - (y^-1 \circ y)(x)
     this->m_RegFlags.runinversion = true;               ///< flag indicating that we run the inversion (switches on storage of m)
@@ -1226,6 +1570,8 @@ PetscErrorCode RegOpt::Initialize() {
     this->m_ParaCont.enabled = false;         ///< flag for parameter continuation
     this->m_ParaCont.targetbeta = 0.0;        ///< has to be set by user
     this->m_ParaCont.beta0 = 1.0;             ///< default initial parameter for parameter continuation
+    this->m_ParaCont.ngroups = 1;             ///< number of groups for parallel search (serial search)
+    this->m_ParaCont.group = 0;               ///< id of group of this task
 
     // grid continuation
     //this->m_GridCont = {};
@@ -1261,11 +1607,15 @@ PetscErrorCode RegOpt::Initialize() {
     this->m_Monitor.qmval = -1.0;
     this->m_Monitor.gradnorm = 0.0;
     this->m_Monitor.gradnorm0 = 0.0;
+    this->m_Monitor.accuracychanged = false;
+    this->m_Monitor.iteroffset = 0;
 
     this->m_Log = {};
     for (int i = 0; i < NLOGFLAGS; ++i) {
         this->m_Log.enabled[i] = false;
     }
+    this->m_Log.tracebuffer = 1 << 18;
+    this->m_Log.perfrawevent = 0;
     this->m_Log.memoryusage = false;
 
     this->m_Indent = 0;
@@ -1321,10 +1671,15 @@ PetscErrorCode RegOpt::Usage(bool advanced) {
         std::cout << "                             is the number of images for (registration of vector valued data)" << std::endl;
         std::cout << " -mask <file>                file that contains an indicator function to mask the evaluation" << std::endl;
         std::cout << "                             of the distance measure; the mask should be smooth" << std::endl;
+        std::cout << " -activeregion               flag: only compute characteristics and interpolation in a box around" << std::endl;
+        std::cout << "                             the mask (dilated by the max. displacement); fields outside of the" << std::endl;
+        std::cout << "                             box are not transported (requires -mask and the sl solver)" << std::endl;
         std::cout << "                             (*.nii, *.nii.gz, *.hdr, *.nc)" << std::endl;
         std::cout << " -sigma <int>x<int>x<int>    size of gaussian smoothing kernel applied to input images" << std::endl;
         std::cout << "                             (e.g., 1x2x1; units: voxel size; if only one value is set" << std::endl;
         std::cout << "                             (i.e., -sigma 2) uniform smoothing is assumed; default: 1x1x1)" << std::endl;
+        std::cout << " -recursivesmoothing         flag: apply gaussian smoothing with recursive filters in real space" << std::endl;
+        std::cout << "                             (avoids the fft; periodic boundary conditions are preserved)" << std::endl;
         std::cout << " -nc <int>                   number of image components" << std::endl;
         std::cout << " -disablesmoothing           flag: switch off smoothing of image data" << std::endl;
         std::cout << " -disablerescaling           flag: switch off rescaling of intensities of image data to [0,1]" << std::endl;
@@ -1341,7 +1696,11 @@ PetscErrorCode RegOpt::Usage(bool advanced) {
         std::cout << " -defgrad                   write deformation gradient to file (full tensor t_ij; each file" << std::endl;
         std::cout << "                            contains one component of the tensor field)" << std::endl;
         std::cout << " -detdefgrad                write determinant of deformation gradient to file" << std::endl;
+        std::cout << " -detdefgradlowmem          compute determinant of deformation gradient without storing the" << std::endl;
+        std::cout << "                            gradient (selected automatically if memory is tight)" << std::endl;
         std::cout << " -defmap                    write deformation map to file" << std::endl;
+        std::cout << " -invdefmap                 write deformation map and its inverse to file (computed in one pass)" << std::endl;
+        std::cout << " -invdefmapfixedpoint       compute inverse deformation map by fixed point iteration" << std::endl;
         std::cout << " -deffield                  write deformation field/displacement field to file" << std::endl;
         std::cout << " -deftemplate               write deformed/transported template image to file" << std::endl;
         std::cout << " -residual                  write pointwise residual (before and after registration)" << std::endl;
@@ -1355,6 +1714,8 @@ PetscErrorCode RegOpt::Usage(bool advanced) {
         std::cout << "                             <type> is one of the following" << std::endl;
         std::cout << "                                 gn           Gauss-Newton (default)" << std::endl;
         std::cout << "                                 fn           full Newton" << std::endl;
+        std::cout << "                                 lbfgs        limited memory BFGS (no inner krylov solve)" << std::endl;
+        std::cout << " -lbfgsmem <int>             number of update pairs stored for lbfgs (default: 5)" << std::endl;
         std::cout << " -opttol <dbl>               tolerance for optimization (default: 1E-2)" << std::endl;
         std::cout << " -gabs <dbl>                 tolerance for optimization (default: 1E-6)" << std::endl;
         std::cout << "                                 lower bound for gradient" << std::endl;
@@ -1392,6 +1753,7 @@ PetscErrorCode RegOpt::Usage(bool advanced) {
         std::cout << "                                 invreg       inverse regularization operator (default)" << std::endl;
         std::cout << "                                 2level       2-level preconditioner" << std::endl;
         std::cout << " -gridscale <dbl>            grid scale for 2-level preconditioner (default: 2)" << std::endl;
+        std::cout << " -mibins <int>               number of histogram bins for mutual information (default: 32)" << std::endl;
         std::cout << " -pcsolver <type>            solver for inversion of preconditioner (in case" << std::endl;
         std::cout << "                             the 2-level preconditioner is used)" << std::endl;
         std::cout << "                             <type> is one of the following" << std::endl;
@@ -1423,6 +1785,9 @@ PetscErrorCode RegOpt::Usage(bool advanced) {
         std::cout << "                             <type> is one of the following" << std::endl;
         std::cout << "                                 sl2          squared l2-distance (default)" << std::endl;
         std::cout << "                                 ncc          normalized cross correlation" << std::endl;
+        std::cout << "                                 lncc         local normalized cross correlation" << std::endl;
+        std::cout << "                                 mi           mutual information (multimodal registration)" << std::endl;
+        std::cout << " -lnccradius <int>           radius of window for local ncc in grid points (default: 2)" << std::endl;
         std::cout << line << std::endl;
         std::cout << " regularization/constraints" << std::endl;
         std::cout << line << std::endl;
@@ -1453,7 +1818,8 @@ PetscErrorCode RegOpt::Usage(bool advanced) {
         }
         // ####################### advanced options #######################
         std::cout << " -fastsolve                  switch on fast solve (preset number of iterations and tolerances to" << std::endl;
-        std::cout << "                             reduce the time to solution; inaccurate solve)" << std::endl;
+        std::cout << "                             reduce the time to solution; inaccurate solve; uses lbfgs unless" << std::endl;
+        std::cout << "                             '-optmeth' is set)" << std::endl;
         std::cout << " -train <type>               enable estimation of an adequate regularization parameter for" << std::endl;
         std::cout << "                             velocity field; the measure to decide on regularization parameter is" << std::endl;
         std::cout << "                             determinant of deformation gradient / jacobian; the user needs to " << std::endl;
@@ -1471,6 +1837,10 @@ PetscErrorCode RegOpt::Usage(bool advanced) {
         std::cout << "                             regularization parameter for a particular registration problem  (e.g.," << std::endl;
         std::cout << "                             identified via the training option above)" << std::endl;
         std::cout << " -betainit <dbl>             initial regularization weight for parameter continuation (default is 1.0)" << std::endl;
+        std::cout << " -pcontgroups <int>          split the mpi tasks into <int> groups of equal size; each group evaluates" << std::endl;
+        std::cout << "                             a different candidate regularization weight during the search (training)" << std::endl;
+        std::cout << "                             concurrently; the bracket is narrowed based on the results of all groups;" << std::endl;
+        std::cout << "                             group <k> > 0 writes its output (and console output) with prefix 'group<k>-'" << std::endl;
 
         // ####################### advanced options #######################
         if (advanced) {
@@ -1487,12 +1857,18 @@ PetscErrorCode RegOpt::Usage(bool advanced) {
         std::cout << " -nt <int>                   number of time points (for time integration; default: 4)" << std::endl;
 //        std::cout << " -iporder <int>              order of interpolation model (default is 3)" << std::endl;
         std::cout << " -rkorder <int>              order of rk time integration used to compute the characteristic (default is 2)" << std::endl;
+        std::cout << " -scalingsquaring            compute deformation map and displacement field by scaling and squaring" << std::endl;
+        std::cout << "                             (log2(nt) compositions instead of nt time steps)" << std::endl;
+        std::cout << " -adaptaccuracy              use fewer time steps and linear interpolation in early iterations;" << std::endl;
+        std::cout << "                             accuracy is increased as the relative gradient norm decreases" << std::endl;
         std::cout << line << std::endl;
         std::cout << " memory distribution and parallelism" << std::endl;
         std::cout << line << std::endl;
         std::cout << " -nthreads <int>             number of threads (default: 1)" << std::endl;
         std::cout << " -np <int>x<int>             distribution of mpi tasks (cartesian grid) (example: -np 2x4 results" << std::endl;
         std::cout << "                             results in MPI distribution of size (nx1/2,nx2/4,nx3) for each mpi task)" << std::endl;
+        std::cout << " -gridopscache <int>         memory (in MB) for cached grid transfer operators (default: 1024)" << std::endl;
+        std::cout << " -fftwisdom <dir>            import/export fftw wisdom from/to <dir> (reduces fft setup time)" << std::endl;
         std::cout << line << std::endl;
         std::cout << " logging" << std::endl;
         std::cout << line << std::endl;
@@ -1500,6 +1876,15 @@ PetscErrorCode RegOpt::Usage(bool advanced) {
         std::cout << " -logconvergence             log convergence (residual; user needs to set '-x' option)" << std::endl;
         std::cout << " -logkrylovres               log residual of krylov subpsace method (user needs to set '-x' option)" << std::endl;
         std::cout << " -logworkload                log cpu time and counters (user needs to set '-x' option)" << std::endl;
+        std::cout << " -logtrace                   write trace of function calls per rank (chrome trace format) and" << std::endl;
+        std::cout << "                             summary of slowest rank per function (user needs to set '-x' option)" << std::endl;
+        std::cout << " -tracebuffer <int>          number of trace events per thread (default: 262144; oldest events" << std::endl;
+        std::cout << "                             are overwritten)" << std::endl;
+        std::cout << " -logperf                    log hardware counters (cycles, instructions, cache misses) for fft," << std::endl;
+        std::cout << "                             interpolation and spectral kernels (requires build with USEPERF;" << std::endl;
+        std::cout << "                             user needs to set '-x' option)" << std::endl;
+        std::cout << " -perfrawevent <hex>         additional raw hardware event for -logperf (e.g., vector fp ops;" << std::endl;
+        std::cout << "                             see 'perf list' for the codes of your cpu)" << std::endl;
         std::cout << " -storecheckpoints           store iterates after each iteration (files will be overwritten); this is" << std::endl;
         std::cout << "                             a safeguard for large scale runs in case the code crashes" << std::endl;
         std::cout << line << std::endl;
@@ -1508,11 +1893,14 @@ PetscErrorCode RegOpt::Usage(bool advanced) {
         std::cout << " -iterates                   store/write out iterates (deformed template image and velocity field)" << std::endl;
         std::cout << " -results                    store intermediate results/data (for scale, grid, and para continuation)" << std::endl;
         std::cout << " -timeseries                 store time series (use with caution)" << std::endl;
+        std::cout << " -asyncio <int>              write nifti output in background thread (write-behind); <int> is the max" << std::endl;
+        std::cout << "                             number of pending outputs (default: 0, i.e., synchronous output)" << std::endl;
         std::cout << " -nx <int>x<int>x<int>       grid size (e.g., 32x64x32); allows user to control grid size for synthetic" << std::endl;
         std::cout << "                             problems; assumed to be uniform if single integer is provided" << std::endl;
         std::cout << " -format <type>              specify the output format for the images/vector fields; default is NIFTI (*.nii.gz)" << std::endl;
         std::cout << "                                 nifti        NIFTI format (*.nii.gz; standard in medical imaging)" << std::endl;
         std::cout << "                                 netcdf       NETCDF format (*.nc; common in simulations/parallel computing)" << std::endl;
+        std::cout << "                                 claire       chunked, compressed volume (*.clr; written in parallel)" << std::endl;
 //        std::cout << "                                 hdf5         HDF5 format (*.hdf5)" << std::endl;
         std::cout << " -synthetic <int>            solve synthetic test problem; <int> ranges from 0 to 3 and defines" << std::endl;
         std::cout << "                             the type of synthetic test problem (use 3 for incompressible velocity)" << std::endl;
@@ -1628,6 +2016,23 @@ PetscErrorCode RegOpt::CheckArguments() {
         }
     }
 
+    if (this->m_Distance.type == LNCC && this->m_Distance.lnccradius < 1) {
+        msg = "\n\x1b[31m window radius for local ncc must be at least 1\x1b[0m\n";
+        ierr = PetscPrintf(PETSC_COMM_WORLD, msg.c_str()); CHKERRQ(ierr);
+        ierr = this->Usage(true); CHKERRQ(ierr);
+    }
+
+    if (this->m_Distance.type == MI && this->m_Distance.mibins < 8) {
+        msg = "\n\x1b[31m number of histogram bins for mutual information must be at least 8\x1b[0m\n";
+        ierr = PetscPrintf(PETSC_COMM_WORLD, msg.c_str()); CHKERRQ(ierr);
+        ierr = this->Usage(true); CHKERRQ(ierr);
+    }
+
+    if (this->m_RegFlags.activeregion && this->m_FileNames.mask.empty()) {
+        ierr = WrngMsg("active region requires a mask (-mask); solving on entire domain"); CHKERRQ(ierr);
+        this->m_RegFlags.activeregion = false;
+    }
+
     if (this->m_ParaCont.strategy == PCONTINUATION) {
         betav = this->m_ParaCont.targetbeta;
         if (betav <= 0.0 || betav > 1.0) {
@@ -1647,6 +2052,27 @@ PetscErrorCode RegOpt::CheckArguments() {
         }
     }
 
+    if (this->m_FFT.gridopscache < 0) {
+        msg = "\n\x1b[31m memory for grid transfer operators has to be non-negative\x1b[0m\n";
+        ierr = PetscPrintf(PETSC_COMM_WORLD, msg.c_str()); CHKERRQ(ierr);
+        ierr = this->Usage(true); CHKERRQ(ierr);
+    }
+
+    if (this->m_ReadWriteFlags.asyncdepth < 0) {
+        msg = "\n\x1b[31m depth of io queue has to be non-negative\x1b[0m\n";
+        ierr = PetscPrintf(PETSC_COMM_WORLD, msg.c_str()); CHKERRQ(ierr);
+        ierr = this->Usage(true); CHKERRQ(ierr);
+    }
+
+    if (this->m_ParaCont.ngroups > 1) {
+        if ( this->m_ParaCont.strategy != PCONTBINSEARCH
+            && this->m_ParaCont.strategy != PCONTREDUCESEARCH ) {
+            msg = "\n\x1b[31m parallel search requires training ('-train <type>')\x1b[0m\n";
+            ierr = PetscPrintf(PETSC_COMM_WORLD, msg.c_str()); CHKERRQ(ierr);
+            ierr = this->Usage(true); CHKERRQ(ierr);
+        }
+    }
+
     if (this->m_ScaleCont.enabled && this->m_ParaCont.enabled) {
         msg = "\n\x1b[31m combined parameter and scale continuation not available \x1b[0m\n";
         ierr = PetscPrintf(PETSC_COMM_WORLD, msg.c_str()); CHKERRQ(ierr);
@@ -1671,6 +2097,12 @@ PetscErrorCode RegOpt::CheckArguments() {
         }
     }
 
+    if (this->m_Log.enabled[LOGTRACE] && this->m_Log.tracebuffer <= 0) {
+        msg = "\x1b[31m size of trace buffer needs to be positive: %d\x1b[0m\n";
+        ierr = PetscPrintf(PETSC_COMM_WORLD, msg.c_str(), static_cast<int>(this->m_Log.tracebuffer)); CHKERRQ(ierr);
+        ierr = this->Usage(true); CHKERRQ(ierr);
+    }
+
     if (this->m_Log.enabled[LOGKSPRES]) {
         if (this->m_Verbosity <= 1) {
             this->m_Verbosity = 2;
@@ -1700,6 +2132,12 @@ PetscErrorCode RegOpt::CheckArguments() {
         ierr = this->Usage(true); CHKERRQ(ierr);
     }
 
+    if (this->m_OptPara.lbfgsmem < 1) {
+        msg = "\x1b[31m number of stored update pairs for lbfgs has to be positive\x1b[0m\n";
+        ierr = PetscPrintf(PETSC_COMM_WORLD, msg.c_str()); CHKERRQ(ierr);
+        ierr = this->Usage(true); CHKERRQ(ierr);
+    }
+
     ierr = Assert(this->m_NumThreads > 0, "omp threads < 0"); CHKERRQ(ierr);
 
     PetscFunctionReturn(ierr);
@@ -1719,6 +2157,18 @@ PetscErrorCode RegOpt::DoSetup(bool dispteaser) {
 
     this->Enter(__func__);
 
+    // hardware counters (we continue without them if not supported)
+    if (this->m_Log.enabled[LOGPERF] && !PerfCounter::IsEnabled()) {
+        if (!PerfCounter::Initialize(this->m_Log.perfrawevent)) {
+            ierr = WrngMsg("hardware counters not available (build with USEPERF; check perf_event_paranoid)"); CHKERRQ(ierr);
+        }
+    }
+
+    // start tracing (the spans of this function are incomplete)
+    if (this->m_Log.enabled[LOGTRACE] && !this->m_Tracer.IsEnabled()) {
+        ierr = this->m_Tracer.Initialize(static_cast<size_t>(this->m_Log.tracebuffer)); CHKERRQ(ierr);
+    }
+
     ierr = this->InitializeFFT(); CHKERRQ(ierr);
 
     // display the options to the user
@@ -1779,6 +2229,8 @@ PetscErrorCode RegOpt::SetPresetParameters() {
         this->m_OptPara.presolvemaxit = 10;
         this->m_OptPara.tol[2] = 5E-2;  // use 5E-2 if results are not acceptable reduce; 1E-1 and 2.5E-1
         this->m_OptPara.presolvetol[2] = 5E-1;
+        // an inner krylov solve is overkill for this accuracy
+        if (!this->m_OptPara.methodset) this->m_OptPara.method = QUASINEWTON;
     } else if (this->m_SolveType == ACC_AGG) {
         // use slow and aggressive method
         this->m_RegNorm.type = H1SN;
@@ -1798,6 +2250,8 @@ PetscErrorCode RegOpt::SetPresetParameters() {
         this->m_OptPara.presolvemaxit = 10;
         this->m_OptPara.tol[2] = 5E-2;
         this->m_OptPara.presolvetol[2] = 5E-1;
+        // an inner krylov solve is overkill for this accuracy
+        if (!this->m_OptPara.methodset) this->m_OptPara.method = QUASINEWTON;
     } else if (this->m_SolveType == ACC_SMOOTH) {
         // use slow and smooth method
         //this->m_RegNorm.type = H2SN;
@@ -2042,6 +2496,17 @@ PetscErrorCode RegOpt::DisplayOptions() {
                 std::cout << "normalized cross-correlation" << std::endl;
                 break;
             }
+            case LNCC:
+            {
+                std::cout << "local normalized cross-correlation (radius "
+                          << this->m_Distance.lnccradius << ")" << std::endl;
+                break;
+            }
+            case MI:
+            {
+                std::cout << "mutual information (" << this->m_Distance.mibins << " bins)" << std::endl;
+                break;
+            }
             case SL2AUX:
             {
                 std::cout << "squared l2-distance measure for coupling" << std::endl;
@@ -2107,6 +2572,11 @@ PetscErrorCode RegOpt::DisplayOptions() {
             } else if (this->m_ParaCont.strategy == PCONTREDUCESEARCH) {
                 std::cout << "search by reduction" << std::endl;
             }
+            if (this->m_ParaCont.ngroups > 1) {
+                std::cout << std::left << std::setw(indent) << " "
+                          << std::setw(align) << "number of groups"
+                          << this->m_ParaCont.ngroups << std::endl;
+            }
             std::cout << std::left << std::setw(indent) << " "
                       << std::setw(align) << "bound det(grad(y))"
                       << this->m_Monitor.detdgradbound << std::endl;
@@ -2229,6 +2699,12 @@ PetscErrorCode RegOpt::DisplayOptions() {
                 newtontype = true;
                 break;
             }
+            case QUASINEWTON:
+            {
+                std::cout << "limited memory bfgs method (m="
+                          << this->m_OptPara.lbfgsmem << ")" << std::endl;
+                break;
+            }
             default:
             {
                 ierr = ThrowError("optimization method not implemented"); CHKERRQ(ierr);
@@ -2546,7 +3022,28 @@ PetscErrorCode RegOpt::ResetTimers() {
     }
     this->m_IPAccumTime = 0.0;
 
+    for (int i = 0; i < NCOMMPHASES; ++i) {
+        for (int j = 0; j < NCOMMVALUES; ++j) {
+            for (int k = 0; k < NVALTYPES; ++k) {
+                this->m_CommStats[i][j][k] = 0.0;
+            }
+        }
+    }
 
+    // the communication counters are shared by all instances (e.g.,
+    // the options of the coarse grid in the preconditioner); we do
+    // not reset them if an instance is initialized or copied
+    if (this->m_SetupDone) {
+        CommCounter::Reset();
+    }
+
+    for (int i = 0; i < NPERFREGIONS; ++i) {
+        for (int j = 0; j < NPERFEVENTS; ++j) {
+            for (int k = 0; k < NVALTYPES; ++k) {
+                this->m_PerfStats[i][j][k] = 0.0;
+            }
+        }
+    }
 
     this->Exit(__func__);
 
@@ -2579,6 +3076,23 @@ PetscErrorCode RegOpt::ResetTimer(TimerType id) {
 
 
 
+/*! names of spans for timers (see -logtrace) */
+static const char* TimerName[NTIMERS] = {
+    "timer:time-to-solution",
+    "timer:pde-solve",
+    "timer:hessian-matvec",
+    "timer:precond-setup",
+    "timer:precond-matvec",
+    "timer:gradient",
+    "timer:objective",
+    "timer:fft-setup",
+    "timer:fft",
+    "timer:interpolation",
+};
+
+
+
+
 /********************************************************************
  * @brief start the timer (checks if running)
  *******************************************************************/
@@ -2598,6 +3112,10 @@ PetscErrorCode RegOpt::StartTimer(TimerType id) {
 
     this->Exit(__func__);
 
+    // open span after we left this function (keep spans nested)
+    if (this->m_Tracer.IsEnabled()) this->m_Tracer.Begin(TimerName[id]);
+    if (id == FFTSELFEXEC) PerfCounter::Start(PERFFFT);
+
     PetscFunctionReturn(ierr);
 }
 
@@ -2613,6 +3131,9 @@ PetscErrorCode RegOpt::StopTimer(TimerType id) {
 
     PetscFunctionBegin;
 
+    if (id == FFTSELFEXEC) PerfCounter::Stop(PERFFFT);
+    if (this->m_Tracer.IsEnabled()) this->m_Tracer.End(TimerName[id]);
+
     this->Enter(__func__);
 
     msg = "fatal error: timer has not been started";
@@ -2785,6 +3306,157 @@ PetscErrorCode RegOpt::ProcessTimers() {
     if (fftall != NULL) {delete [] fftall; fftall = NULL;}
     if (interpall != NULL) {delete [] interpall; interpall = NULL;}
 
+    ierr = this->ProcessCommCounters(); CHKERRQ(ierr);
+    ierr = this->ProcessPerfCounters(); CHKERRQ(ierr);
+
+    this->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/*! names of communication phases and counters (see -logworkload) */
+static const char* CommPhaseName[NCOMMPHASES] = {
+    "fft transpose",
+    "ghost",
+    "scatter",
+    "value return",
+    "grid change",
+    "reduction",
+};
+static const char* CommValueName[NCOMMVALUES] = {
+    "bytes sent",
+    "bytes recv",
+    "msgs sent",
+    "msgs recv",
+    "peers",
+};
+
+
+
+
+/********************************************************************
+ * @brief compute min/max/avg of communication volume over all ranks;
+ * the counters of the low level kernels are shared by all grids of
+ * a rank; the volume of the fft transposes is not exposed by accfft;
+ * we estimate it from the pencil decomposition and the number of
+ * ffts of this grid (two all-to-all transposes per fft)
+ *******************************************************************/
+PetscErrorCode RegOpt::ProcessCommCounters() {
+    PetscErrorCode ierr = 0;
+    const int n = NCOMMPHASES*NCOMMVALUES;
+    double ival[n], xmin[n], xmax[n], xsum[n], nlocal, bytes, frac;
+    int rval, rank, nproc, p[2], nmsg;
+
+    PetscFunctionBegin;
+
+    this->Enter(__func__);
+
+    MPI_Comm_rank(PETSC_COMM_WORLD, &rank);
+    MPI_Comm_size(PETSC_COMM_WORLD, &nproc);
+
+    for (int i = 0; i < NCOMMPHASES; ++i) {
+        for (int j = 0; j < NCOMMVALUES; ++j) {
+            ival[i*NCOMMVALUES + j] = CommCounter::Get(static_cast<CommPhase>(i), static_cast<CommValue>(j));
+        }
+    }
+
+    // estimate for fft transposes (complex data of r2c transform)
+    p[0] = this->m_CartGridDims[0];
+    p[1] = this->m_CartGridDims[1];
+    nlocal = static_cast<double>(this->m_Domain.nx[0])*static_cast<double>(this->m_Domain.nx[1])
+           * static_cast<double>(this->m_Domain.nx[2]/2 + 1)/static_cast<double>(nproc);
+    frac = 0.0; nmsg = 0;
+    for (int i = 0; i < 2; ++i) {
+        frac += static_cast<double>(p[i] - 1)/static_cast<double>(p[i]);
+        nmsg += p[i] - 1;
+    }
+    bytes = static_cast<double>(this->m_Counter[FFT])*frac*nlocal*2.0*sizeof(ScalarType);
+    ival[COMMFFT*NCOMMVALUES + COMMBYTESSENT] = bytes;
+    ival[COMMFFT*NCOMMVALUES + COMMBYTESRECV] = bytes;
+    ival[COMMFFT*NCOMMVALUES + COMMMSGSENT] = static_cast<double>(this->m_Counter[FFT])*nmsg;
+    ival[COMMFFT*NCOMMVALUES + COMMMSGRECV] = static_cast<double>(this->m_Counter[FFT])*nmsg;
+    ival[COMMFFT*NCOMMVALUES + COMMPEERS] = this->m_Counter[FFT] > 0 ? static_cast<double>(std::max(p[0] - 1, p[1] - 1)) : 0.0;
+
+    rval = MPI_Reduce(ival, xmin, n, MPI_DOUBLE, MPI_MIN, 0, PETSC_COMM_WORLD);
+    ierr = Assert(rval == MPI_SUCCESS, "mpi reduce returned error"); CHKERRQ(ierr);
+    rval = MPI_Reduce(ival, xmax, n, MPI_DOUBLE, MPI_MAX, 0, PETSC_COMM_WORLD);
+    ierr = Assert(rval == MPI_SUCCESS, "mpi reduce returned error"); CHKERRQ(ierr);
+    rval = MPI_Reduce(ival, xsum, n, MPI_DOUBLE, MPI_SUM, 0, PETSC_COMM_WORLD);
+    ierr = Assert(rval == MPI_SUCCESS, "mpi reduce returned error"); CHKERRQ(ierr);
+
+    for (int i = 0; i < NCOMMPHASES; ++i) {
+        for (int j = 0; j < NCOMMVALUES; ++j) {
+            this->m_CommStats[i][j][LOG] = ival[i*NCOMMVALUES + j];
+            this->m_CommStats[i][j][MIN] = xmin[i*NCOMMVALUES + j];
+            this->m_CommStats[i][j][MAX] = xmax[i*NCOMMVALUES + j];
+            this->m_CommStats[i][j][AVG] = xsum[i*NCOMMVALUES + j]/static_cast<double>(nproc);
+        }
+    }
+
+    this->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/*! names of hardware counter regions and events (see -logperf) */
+static const char* PerfRegionName[NPERFREGIONS] = {
+    "fft",
+    "interp kernel",
+    "spectral",
+};
+static const char* PerfEventName[NPERFEVENTS] = {
+    "cycles",
+    "instructions",
+    "llc refs",
+    "llc misses",
+    "raw event",
+};
+
+
+
+
+/********************************************************************
+ * @brief compute min/max/avg of hardware counters over all ranks
+ *******************************************************************/
+PetscErrorCode RegOpt::ProcessPerfCounters() {
+    PetscErrorCode ierr = 0;
+    const int n = NPERFREGIONS*NPERFEVENTS;
+    double ival[n], xmin[n], xmax[n], xsum[n];
+    int rval, nproc;
+
+    PetscFunctionBegin;
+
+    this->Enter(__func__);
+
+    MPI_Comm_size(PETSC_COMM_WORLD, &nproc);
+
+    for (int i = 0; i < NPERFREGIONS; ++i) {
+        for (int j = 0; j < NPERFEVENTS; ++j) {
+            ival[i*NPERFEVENTS + j] = PerfCounter::Get(static_cast<PerfRegion>(i), static_cast<PerfEvent>(j));
+        }
+    }
+
+    rval = MPI_Reduce(ival, xmin, n, MPI_DOUBLE, MPI_MIN, 0, PETSC_COMM_WORLD);
+    ierr = Assert(rval == MPI_SUCCESS, "mpi reduce returned error"); CHKERRQ(ierr);
+    rval = MPI_Reduce(ival, xmax, n, MPI_DOUBLE, MPI_MAX, 0, PETSC_COMM_WORLD);
+    ierr = Assert(rval == MPI_SUCCESS, "mpi reduce returned error"); CHKERRQ(ierr);
+    rval = MPI_Reduce(ival, xsum, n, MPI_DOUBLE, MPI_SUM, 0, PETSC_COMM_WORLD);
+    ierr = Assert(rval == MPI_SUCCESS, "mpi reduce returned error"); CHKERRQ(ierr);
+
+    for (int i = 0; i < NPERFREGIONS; ++i) {
+        for (int j = 0; j < NPERFEVENTS; ++j) {
+            this->m_PerfStats[i][j][LOG] = ival[i*NPERFEVENTS + j];
+            this->m_PerfStats[i][j][MIN] = xmin[i*NPERFEVENTS + j];
+            this->m_PerfStats[i][j][MAX] = xmax[i*NPERFEVENTS + j];
+            this->m_PerfStats[i][j][AVG] = xsum[i*NPERFEVENTS + j]/static_cast<double>(nproc);
+        }
+    }
 
     this->Exit(__func__);
 
@@ -2810,6 +3482,12 @@ PetscErrorCode RegOpt::ResetCounters() {
         this->m_Counter[i] = 0;
     }
 
+    // communication volume is reported together with the counters
+    // (see ResetTimers)
+    if (this->m_SetupDone) {
+        CommCounter::Reset();
+    }
+
     this->Exit(__func__);
 
     PetscFunctionReturn(ierr);
@@ -2849,7 +3527,8 @@ PetscErrorCode RegOpt::WriteLogFile(bool coarse) {
         this->m_PostFix = "";
     }
 
-    if (this->m_Log.enabled[LOGLOAD]) {
+    // hardware counters are part of the workload log
+    if (this->m_Log.enabled[LOGLOAD] || this->m_Log.enabled[LOGPERF]) {
         ierr = this->WriteWorkLoadLog(); CHKERRQ(ierr);
     }
 
@@ -2861,6 +3540,10 @@ PetscErrorCode RegOpt::WriteLogFile(bool coarse) {
         ierr = this->WriteConvergenceLog(); CHKERRQ(ierr);
     }
 
+    if (this->m_Log.enabled[LOGTRACE]) {
+        ierr = this->m_Tracer.Write(this->m_FileNames.xfolder, this->m_PostFix); CHKERRQ(ierr);
+    }
+
     PetscFunctionReturn(ierr);
 }
 
@@ -3166,6 +3849,58 @@ PetscErrorCode RegOpt::WriteWorkLoadLog(std::ostream& logwriter) {
                   << " " << 0
                   << " " << 0
                   << std::endl;
+
+        // communication volume per phase
+        for (int i = 0; i < NCOMMPHASES; ++i) {
+            for (int j = 0; j < NCOMMVALUES; ++j) {
+                count = 1;
+                logwriter << "\"comm " << CommPhaseName[i] << " " << CommValueName[j] << "\""
+                          << " " << count << std::scientific
+                          << " " << this->m_CommStats[i][j][MIN]
+                          << " " << this->m_CommStats[i][j][MAX]
+                          << " " << this->m_CommStats[i][j][AVG]
+                          << " " << this->m_CommStats[i][j][MAX]
+                          << std::endl;
+            }
+        }
+
+        // hardware counters per kernel region (summed over threads)
+        if (this->m_Log.enabled[LOGPERF]) {
+            for (int i = 0; i < NPERFREGIONS; ++i) {
+                for (int j = 0; j < NPERFEVENTS; ++j) {
+                    count = 1;
+                    logwriter << "\"perf " << PerfRegionName[i] << " " << PerfEventName[j] << "\""
+                              << " " << count << std::scientific
+                              << " " << this->m_PerfStats[i][j][MIN]
+                              << " " << this->m_PerfStats[i][j][MAX]
+                              << " " << this->m_PerfStats[i][j][AVG]
+                              << " " << this->m_PerfStats[i][j][MAX]
+                              << std::endl;
+                }
+
+                // derived from mean over ranks (memory traffic estimated
+                // as llc misses times cache line size)
+                double cycles = this->m_PerfStats[i][PERFCYCLES][AVG];
+                double bytes = 64.0*this->m_PerfStats[i][PERFLLCMISS][AVG];
+                double work = PerfCounter::HasRawEvent() ? this->m_PerfStats[i][PERFRAW][AVG]
+                                                         : this->m_PerfStats[i][PERFINSTR][AVG];
+                logwriter << "\"perf " << PerfRegionName[i] << " ipc\""
+                          << " " << 0 << std::scientific
+                          << " " << 0
+                          << " " << 0
+                          << " " << (cycles > 0.0 ? this->m_PerfStats[i][PERFINSTR][AVG]/cycles : 0.0)
+                          << " " << 0
+                          << std::endl;
+                logwriter << "\"perf " << PerfRegionName[i]
+                          << (PerfCounter::HasRawEvent() ? " raw per byte\"" : " instr per byte\"")
+                          << " " << 0 << std::scientific
+                          << " " << 0
+                          << " " << 0
+                          << " " << (bytes > 0.0 ? work/bytes : 0.0)
+                          << " " << 0
+                          << std::endl;
+            }
+        }
     }
 
     this->Exit(__func__);
@@ -3614,6 +4349,73 @@ PetscErrorCode RegOpt::WriteWorkLoadLogReadable(std::ostream& logwriter) {
             logwriter << ss.str() << std::endl;
             ss.clear(); ss.str(std::string());
         }
+
+        logwriter << std::endl;
+        logwriter << line << std::endl;
+        logwriter << "# communication (per rank; fft transposes are estimated)" << std::endl;
+        logwriter << line << std::endl;
+
+        ss  << std::scientific << std::left
+            << std::setw(2*nstr) << " " << std::right
+            << std::setw(nnum) << "min(p)"
+            << std::setw(nnum) << "max(p)"
+            << std::setw(nnum) << "mean(p)";
+        logwriter << ss.str() << std::endl;
+        ss.clear(); ss.str(std::string());
+
+        for (int i = 0; i < NCOMMPHASES; ++i) {
+            // skip phases without communication
+            if (this->m_CommStats[i][COMMMSGSENT][MAX] == 0.0
+                && this->m_CommStats[i][COMMMSGRECV][MAX] == 0.0) continue;
+            for (int j = 0; j < NCOMMVALUES; ++j) {
+                ssnum << " " << CommPhaseName[i] << " " << CommValueName[j];
+                ss  << std::scientific << std::left
+                    << std::setw(2*nstr) << ssnum.str() << std::right
+                    << std::setw(nnum) << this->m_CommStats[i][j][MIN]
+                    << std::setw(nnum) << this->m_CommStats[i][j][MAX]
+                    << std::setw(nnum) << this->m_CommStats[i][j][AVG];
+                logwriter << ss.str() << std::endl;
+                ss.clear(); ss.str(std::string());
+                ssnum.clear(); ssnum.str(std::string());
+            }
+        }
+
+        // derived quantities from mean over ranks; the memory traffic
+        // is estimated as llc misses times cache line size (64 bytes)
+        if (this->m_Log.enabled[LOGPERF]) {
+            double cycles, instr, llcref, llcmiss, raw, bytes;
+            logwriter << std::endl;
+            logwriter << line << std::endl;
+            logwriter << "# hardware counters (sum over threads; mean over ranks)" << std::endl;
+            logwriter << line << std::endl;
+
+            ss  << std::scientific << std::left
+                << std::setw(nstr) << " " << std::right
+                << std::setw(nnum) << "ipc"
+                << std::setw(nnum) << "llc miss rate"
+                << std::setw(nnum) << "mem bytes (est)"
+                << std::setw(nnum) << (PerfCounter::HasRawEvent() ? "raw/byte" : "instr/byte");
+            logwriter << ss.str() << std::endl;
+            ss.clear(); ss.str(std::string());
+
+            for (int i = 0; i < NPERFREGIONS; ++i) {
+                cycles  = this->m_PerfStats[i][PERFCYCLES][AVG];
+                instr   = this->m_PerfStats[i][PERFINSTR][AVG];
+                llcref  = this->m_PerfStats[i][PERFLLCREF][AVG];
+                llcmiss = this->m_PerfStats[i][PERFLLCMISS][AVG];
+                raw     = PerfCounter::HasRawEvent() ? this->m_PerfStats[i][PERFRAW][AVG] : instr;
+                bytes   = 64.0*llcmiss;
+                if (cycles == 0.0) continue;
+                ss  << std::scientific << std::left
+                    << std::setw(nstr) << std::string(" ") + PerfRegionName[i] << std::right
+                    << std::setw(nnum) << instr/cycles
+                    << std::setw(nnum) << (llcref > 0.0 ? llcmiss/llcref : 0.0)
+                    << std::setw(nnum) << bytes
+                    << std::setw(nnum) << (bytes > 0.0 ? raw/bytes : 0.0);
+                logwriter << ss.str() << std::endl;
+                ss.clear(); ss.str(std::string());
+            }
+        }
     }
 
     this->Exit(__func__);
@@ -159,6 +159,8 @@ PetscErrorCode RegToolsOpt::ParseArguments(int argc, char** argv) {
             }
         } else if (strcmp(argv[1], "-adapttimestep") == 0) {
             this->m_PDESolver.adapttimestep = true;
+        } else if (strcmp(argv[1], "-scalingsquaring") == 0) {
+            this->m_PDESolver.scalingsquaring = true;
         } else if (strcmp(argv[1], "-cflnumber") == 0) {
             argc--; argv++;
             this->m_PDESolver.cflnumber = atof(argv[1]);
@@ -188,9 +190,14 @@ PetscErrorCode RegToolsOpt::ParseArguments(int argc, char** argv) {
             }
         } else if (strcmp(argv[1], "-disablesmoothing") == 0) {
             this->m_RegFlags.applysmoothing = false;
+        } else if (strcmp(argv[1], "-recursivesmoothing") == 0) {
+            this->m_RegFlags.recursivesmoothing = true;
         } else if (strcmp(argv[1], "-nthreads") == 0) {
             argc--; argv++;
             this->m_NumThreads = atoi(argv[1]);
+        } else if (strcmp(argv[1], "-fftwisdom") == 0) {
+            argc--; argv++;
+            this->m_FFT.wisdomdir = argv[1];
         } else if (strcmp(argv[1], "-np") == 0) {
             argc--; argv++;
             const std::string npinput = argv[1];
@@ -216,6 +223,8 @@ PetscErrorCode RegToolsOpt::ParseArguments(int argc, char** argv) {
                 this->m_FileNames.extension = ".nii.gz";
             } else if (strcmp(argv[1], "2nc") == 0) {
                 this->m_FileNames.extension = ".nc";
+            } else if (strcmp(argv[1], "2clr") == 0) {
+                this->m_FileNames.extension = ".clr";
             }
             this->m_RegToolFlags.convert = true;
         } else if (strcmp(argv[1], "-usenc") == 0) {
@@ -231,12 +240,19 @@ PetscErrorCode RegToolsOpt::ParseArguments(int argc, char** argv) {
             this->m_ReadWriteFlags.detdefgrad = true;
         } else if (strcmp(argv[1], "-defmap") == 0) {
             this->m_ReadWriteFlags.defmap = true;
+        } else if (strcmp(argv[1], "-invdefmap") == 0) {
+            this->m_ReadWriteFlags.defmap = true;
+            this->m_ReadWriteFlags.invdefmap = true;
+        } else if (strcmp(argv[1], "-invdefmapfixedpoint") == 0) {
+            this->m_RegFlags.invdefmapfixedpoint = true;
         } else if (strcmp(argv[1], "-deffield") == 0) {
             this->m_ReadWriteFlags.deffield = true;
         } else if (strcmp(argv[1], "-timeseries") == 0) {
             this->m_ReadWriteFlags.timeseries = true;
         } else if (strcmp(argv[1], "-detdefgradfromdeffield") == 0) {
             this->m_RegFlags.detdefgradfromdeffield = true;
+        } else if (strcmp(argv[1], "-detdefgradlowmem") == 0) {
+            this->m_RegFlags.detdefgradlowmem = true;
         } else if (strcmp(argv[1], "-residual") == 0) {
             this->m_RegToolFlags.computeresidual = true;
         } else if (strcmp(argv[1], "-r2t") == 0) {
@@ -412,6 +428,7 @@ PetscErrorCode RegToolsOpt::Usage(bool advanced) {
         std::cout << " -nthreads <int>             number of threads (default: 1)" << std::endl;
         std::cout << " -np <int>x<int>             distribution of mpi tasks (cartesian grid) (example: -np 2x4 results" << std::endl;
         std::cout << "                             results in MPI distribution of size (nx1/2,nx2/4,nx3) for each mpi task)" << std::endl;
+        std::cout << " -fftwisdom <dir>            import/export fftw wisdom from/to <dir> (reduces fft setup time)" << std::endl;
         }
         // ####################### advanced options #######################
         std::cout << line << std::endl;
@@ -439,6 +456,9 @@ PetscErrorCode RegToolsOpt::Usage(bool advanced) {
         std::cout << " -invdetdefgrad              compute inverse of determinant of deformation gradient (input: velocity field)" << std::endl;
         std::cout << " -deffield                   compute displacement field u (input: velocity field)" << std::endl;
         std::cout << " -defmap                     compute deformation map y (input: velocity field)" << std::endl;
+        std::cout << " -invdefmap                  compute deformation map y and its inverse in one pass (input: velocity field)" << std::endl;
+        std::cout << " -invdefmapfixedpoint        compute inverse deformation map by fixed point iteration (warm started" << std::endl;
+        std::cout << "                             with forward displacement; instead of integrating backward characteristic)" << std::endl;
         std::cout << " -residual                   compute residual between scalar fields ('-mr' and '-mt' options)" << std::endl;
         std::cout << " -error                      compute error between scalar fields ('-mr' and '-mt' options)" << std::endl;
         std::cout << " -analyze                    compute analytics for scalar field (-ifile option)" << std::endl;
@@ -454,11 +474,15 @@ PetscErrorCode RegToolsOpt::Usage(bool advanced) {
         std::cout << "                             the user needs to specify the labels to be transported via the '-labels' option" << std::endl;
         std::cout << "                             option (see below)" << std::endl;
         std::cout << " -labels <l1,l2,...>         labels to be transported (ids/numbers of labels)" << std::endl;
-        std::cout << " -saveprob                   enable this flag to write probability maps for individual labels to file" << std::endl;
+        std::cout << " -saveprob                   enable this flag to write probability maps for individual labels to file;" << std::endl;
+        std::cout << "                             by default, labels that are far apart share a component, which reduces" << std::endl;
+        std::cout << "                             memory and runtime for large numbers of labels (disabled by this flag)" << std::endl;
         std::cout << " -r2t                        map (transport) from reference to template space by enabling this flag" << std::endl;
         // ####################### advanced options #######################
         if (advanced) {
         std::cout << " -detdefgradfromdeffield     compute gradient of some input scalar field ('-ifile' option)" << std::endl;
+        std::cout << " -detdefgradlowmem           compute determinant of deformation gradient without storing the" << std::endl;
+        std::cout << "                             gradient (selected automatically if memory is tight)" << std::endl;
         std::cout << " -grad                       compute gradient of some input scalar field ('-ifile' option)" << std::endl;
         std::cout << " -xtimeseries                store time series (use with caution)" << std::endl;
         std::cout << "                             problems; assumed to be uniform if single integer is provided" << std::endl;
@@ -471,6 +495,7 @@ PetscErrorCode RegToolsOpt::Usage(bool advanced) {
         std::cout << "                             units: voxel size; if only one parameter is set" << std::endl;
         std::cout << "                             uniform smoothing is assumed: default: 1x1x1)" << std::endl;
         std::cout << " -disablesmoothing           disable smoothing" << std::endl;
+        std::cout << " -recursivesmoothing         apply gaussian smoothing with recursive filters in real space" << std::endl;
         std::cout << line << std::endl;
         std::cout << " ### solver specific parameters (numerics)" << std::endl;
         std::cout << line << std::endl;
@@ -482,8 +507,10 @@ PetscErrorCode RegToolsOpt::Usage(bool advanced) {
         std::cout << "                             <type> is one of the following" << std::endl;
         std::cout << "                                 2nii         convert to nifti" << std::endl;
         std::cout << "                                 2nc          convert to netcdf" << std::endl;
+        std::cout << "                                 2clr         convert to chunked, compressed claire volume" << std::endl;
         std::cout << " -nt <int>                   number of time points (for time integration; default: 4)" << std::endl;
         std::cout << " -adapttimestep              vary number of time steps according to defined number" << std::endl;
+        std::cout << " -scalingsquaring            compute deformation map and displacement field by scaling and squaring" << std::endl;
         std::cout << " -cflnumber <dbl>            set cfl number" << std::endl;
         std::cout << " -interpolationorder <int>   order of interpolation model (default is 3)" << std::endl;
         }
@@ -102,9 +102,7 @@ PetscErrorCode RegularizationH1::EvaluateFunctional(ScalarType* R, VecField* v)
         this->m_Opt->IncrementCounter(FFT, FFTGRAD);
 
         // compute inner products
-        ierr = VecTDot(this->m_WorkVecField->m_X1, this->m_WorkVecField->m_X1, &value); CHKERRQ(ierr); H1v +=value;
-        ierr = VecTDot(this->m_WorkVecField->m_X2, this->m_WorkVecField->m_X2, &value); CHKERRQ(ierr); H1v +=value;
-        ierr = VecTDot(this->m_WorkVecField->m_X3, this->m_WorkVecField->m_X3, &value); CHKERRQ(ierr); H1v +=value;
+        ierr = this->m_WorkVecField->SquaredNormLocal(value); CHKERRQ(ierr); H1v += value;
 
 
         // X2 gradient
@@ -116,9 +114,7 @@ PetscErrorCode RegularizationH1::EvaluateFunctional(ScalarType* R, VecField* v)
         this->m_Opt->IncrementCounter(FFT, FFTGRAD);
 
         // compute inner products
-        ierr = VecTDot(this->m_WorkVecField->m_X1, this->m_WorkVecField->m_X1, &value); CHKERRQ(ierr); H1v +=value;
-        ierr = VecTDot(this->m_WorkVecField->m_X2, this->m_WorkVecField->m_X2, &value); CHKERRQ(ierr); H1v +=value;
-        ierr = VecTDot(this->m_WorkVecField->m_X3, this->m_WorkVecField->m_X3, &value); CHKERRQ(ierr); H1v +=value;
+        ierr = this->m_WorkVecField->SquaredNormLocal(value); CHKERRQ(ierr); H1v += value;
 
 
         // X3 gradient
@@ -130,21 +126,17 @@ PetscErrorCode RegularizationH1::EvaluateFunctional(ScalarType* R, VecField* v)
         this->m_Opt->IncrementCounter(FFT, FFTGRAD);
 
         // compute inner products
-        ierr = VecTDot(this->m_WorkVecField->m_X1, this->m_WorkVecField->m_X1, &value); CHKERRQ(ierr); H1v +=value;
-        ierr = VecTDot(this->m_WorkVecField->m_X2, this->m_WorkVecField->m_X2, &value); CHKERRQ(ierr); H1v +=value;
-        ierr = VecTDot(this->m_WorkVecField->m_X3, this->m_WorkVecField->m_X3, &value); CHKERRQ(ierr); H1v +=value;
+        ierr = this->m_WorkVecField->SquaredNormLocal(value); CHKERRQ(ierr); H1v += value;
 
         // restore arrays for velocity field
         ierr = v->RestoreArrays(p_v1, p_v2, p_v3); CHKERRQ(ierr);
 
-        L2v = 0.0;
-        ierr = VecTDot(v->m_X1, v->m_X1, &value); CHKERRQ(ierr); L2v +=value;
-        ierr = VecTDot(v->m_X2, v->m_X2, &value); CHKERRQ(ierr); L2v +=value;
-        ierr = VecTDot(v->m_X3, v->m_X3, &value); CHKERRQ(ierr); L2v +=value;
+        ierr = v->SquaredNormLocal(L2v); CHKERRQ(ierr);
 
         // add up contributions
         //*R = 0.5*(beta[0]*H1v + beta[1]*L2v);
-        *R = 0.5*hd*beta[0]*(H1v + beta[1]*L2v);
+        ierr = this->m_Opt->m_Reduction.Add(H1v + beta[1]*L2v, R, 0.5*hd*beta[0]); CHKERRQ(ierr);
+        ierr = this->m_Opt->m_Reduction.Flush(); CHKERRQ(ierr);
 
         // increment fft timer
         this->m_Opt->IncreaseFFTTimers(timer);
@@ -204,6 +196,7 @@ PetscErrorCode RegularizationH1::EvaluateGradient(VecField* dvR, VecField* v) {
         scale = this->m_Opt->ComputeFFTScale();
 
         applytime = -MPI_Wtime();
+        PerfCounter::Start(PERFSPECTRAL);
 #pragma omp parallel
 {
         ScalarType lapik,regop;
@@ -245,6 +238,7 @@ PetscErrorCode RegularizationH1::EvaluateGradient(VecField* dvR, VecField* v) {
             }
         }
 }  // pragma omp parallel
+        PerfCounter::Stop(PERFSPECTRAL);
         applytime += MPI_Wtime();
         timer[FFTHADAMARD] += applytime;
 
@@ -354,6 +348,7 @@ PetscErrorCode RegularizationH1::ApplyInverse(VecField* Ainvx, VecField* x, bool
         scale = this->m_Opt->ComputeFFTScale();
 
         applytime = -MPI_Wtime();
+        PerfCounter::Start(PERFSPECTRAL);
 
 #pragma omp parallel
 {
@@ -396,6 +391,7 @@ PetscErrorCode RegularizationH1::ApplyInverse(VecField* Ainvx, VecField* x, bool
             }
         }
 }  // pragma omp parallel
+        PerfCounter::Stop(PERFSPECTRAL);
         applytime += MPI_Wtime();
         timer[FFTHADAMARD] += applytime;
 
@@ -455,6 +451,28 @@ PetscErrorCode RegularizationH1::GetExtremeEigValsInvOp(ScalarType& emin, Scalar
 
 
 
+/********************************************************************
+ * @brief fourier symbol of (the square root of) the inverse
+ * regularization operator (without fft scaling)
+ *******************************************************************/
+ScalarType RegularizationH1::GetInverseSymbol(ScalarType lapik, bool applysqrt) {
+    ScalarType beta[2], regop;
+
+    beta[0] = this->m_Opt->m_RegNorm.beta[0];
+    beta[1] = this->m_Opt->m_RegNorm.beta[1];
+
+    // if regularization weight is zero, the operator is the identity
+    if (beta[0] == 0.0) return 1.0;
+
+    regop = beta[0]*(-lapik + beta[1]);
+    if (applysqrt) regop = sqrt(regop);
+
+    return 1.0/regop;
+}
+
+
+
+
 }  // namespace reg
 
 
@@ -68,7 +68,7 @@ PetscErrorCode RegularizationH1SN::EvaluateFunctional(ScalarType* R, VecField* v
                 *p_gv21 = NULL, *p_gv22 = NULL, *p_gv23 = NULL,
                 *p_gv31 = NULL, *p_gv32 = NULL, *p_gv33 = NULL;
     std::bitset<3> xyz = 0; xyz[0] = 1; xyz[1] = 1; xyz[2] = 1;
-    ScalarType beta, value, hd;
+    ScalarType beta, value, rloc = 0.0, hd;
     double timer[NFFTTIMERS] = {0};
 
     PetscFunctionBegin;
@@ -99,9 +99,7 @@ PetscErrorCode RegularizationH1SN::EvaluateFunctional(ScalarType* R, VecField* v
         this->m_Opt->IncrementCounter(FFT, FFTGRAD);
 
         // compute inner products
-        ierr = VecTDot(this->m_WorkVecField->m_X1, this->m_WorkVecField->m_X1, &value); *R +=value;
-        ierr = VecTDot(this->m_WorkVecField->m_X2, this->m_WorkVecField->m_X2, &value); *R +=value;
-        ierr = VecTDot(this->m_WorkVecField->m_X3, this->m_WorkVecField->m_X3, &value); *R +=value;
+        ierr = this->m_WorkVecField->SquaredNormLocal(value); CHKERRQ(ierr); rloc += value;
 
 
         // X2 gradient
@@ -113,9 +111,7 @@ PetscErrorCode RegularizationH1SN::EvaluateFunctional(ScalarType* R, VecField* v
         this->m_Opt->IncrementCounter(FFT, FFTGRAD);
 
         // compute inner products
-        ierr = VecTDot(this->m_WorkVecField->m_X1, this->m_WorkVecField->m_X1, &value); *R +=value;
-        ierr = VecTDot(this->m_WorkVecField->m_X2, this->m_WorkVecField->m_X2, &value); *R +=value;
-        ierr = VecTDot(this->m_WorkVecField->m_X3, this->m_WorkVecField->m_X3, &value); *R +=value;
+        ierr = this->m_WorkVecField->SquaredNormLocal(value); CHKERRQ(ierr); rloc += value;
 
 
         // X3 gradient
@@ -131,14 +127,13 @@ PetscErrorCode RegularizationH1SN::EvaluateFunctional(ScalarType* R, VecField* v
         ierr = VecRestoreArray(this->m_WorkVecField->m_X3, &p_gv33); CHKERRQ(ierr);
 
         // compute inner products
-        ierr = VecTDot(this->m_WorkVecField->m_X1, this->m_WorkVecField->m_X1, &value); *R +=value;
-        ierr = VecTDot(this->m_WorkVecField->m_X2, this->m_WorkVecField->m_X2, &value); *R +=value;
-        ierr = VecTDot(this->m_WorkVecField->m_X3, this->m_WorkVecField->m_X3, &value); *R +=value;
+        ierr = this->m_WorkVecField->SquaredNormLocal(value); CHKERRQ(ierr); rloc += value;
 
         ierr = v->RestoreArrays(p_v1, p_v2, p_v3); CHKERRQ(ierr);
 
         // multiply with regularization weight
-        *R = 0.5*hd*beta*(*R);
+        ierr = this->m_Opt->m_Reduction.Add(rloc, R, 0.5*hd*beta); CHKERRQ(ierr);
+        ierr = this->m_Opt->m_Reduction.Flush(); CHKERRQ(ierr);
 
         // increment fft timer
         this->m_Opt->IncreaseFFTTimers(timer);
@@ -196,6 +191,7 @@ PetscErrorCode RegularizationH1SN::EvaluateGradient(VecField* dvR, VecField* v)
         scale = this->m_Opt->ComputeFFTScale();
 
         applytime = -MPI_Wtime();
+        PerfCounter::Start(PERFSPECTRAL);
 #pragma omp parallel
 {
         ScalarType lapik, regop;
@@ -232,6 +228,7 @@ PetscErrorCode RegularizationH1SN::EvaluateGradient(VecField* dvR, VecField* v)
             }
         }
 }  // pragma omp parallel
+        PerfCounter::Stop(PERFSPECTRAL);
         applytime += MPI_Wtime();
         timer[FFTHADAMARD] += applytime;
 
@@ -335,6 +332,7 @@ PetscErrorCode RegularizationH1SN::ApplyInverse(VecField* Ainvx, VecField* x, bo
         scale = this->m_Opt->ComputeFFTScale();
 
         applytime = -MPI_Wtime();
+        PerfCounter::Start(PERFSPECTRAL);
 #pragma omp parallel
 {
         ScalarType lapik, regop;
@@ -373,6 +371,7 @@ PetscErrorCode RegularizationH1SN::ApplyInverse(VecField* Ainvx, VecField* x, bo
             }
         }
 }  // pragma omp parallel
+        PerfCounter::Stop(PERFSPECTRAL);
         applytime += MPI_Wtime();
         timer[FFTHADAMARD] += applytime;
 
@@ -431,6 +430,27 @@ PetscErrorCode RegularizationH1SN::GetExtremeEigValsInvOp(ScalarType& emin, Scal
 
 
 
+/********************************************************************
+ * @brief fourier symbol of (the square root of) the inverse
+ * regularization operator (without fft scaling)
+ *******************************************************************/
+ScalarType RegularizationH1SN::GetInverseSymbol(ScalarType lapik, bool applysqrt) {
+    ScalarType beta, regop;
+
+    beta = this->m_Opt->m_RegNorm.beta[0];
+
+    // if regularization weight is zero, the operator is the identity
+    if (beta == 0.0) return 1.0;
+
+    regop = (fabs(lapik) == 0.0) ? beta : -beta*lapik;
+    if (applysqrt) regop = sqrt(regop);
+
+    return 1.0/regop;
+}
+
+
+
+
 } // end of name space
 
 
@@ -107,6 +107,7 @@ PetscErrorCode RegularizationH2SN::EvaluateFunctional(ScalarType* R, VecField* v
         this->m_Opt->IncrementCounter(FFT, 3);
 
         applytime = -MPI_Wtime();
+        PerfCounter::Start(PERFSPECTRAL);
 #pragma omp parallel
 {
         ScalarType lapik, regop;
@@ -142,6 +143,7 @@ PetscErrorCode RegularizationH2SN::EvaluateFunctional(ScalarType* R, VecField* v
             }
         }
 }  // pragma omp parallel
+        PerfCounter::Stop(PERFSPECTRAL);
         applytime += MPI_Wtime();
         timer[FFTHADAMARD] += applytime;
 
@@ -155,12 +157,11 @@ PetscErrorCode RegularizationH2SN::EvaluateFunctional(ScalarType* R, VecField* v
         this->m_Opt->IncrementCounter(FFT, 3);
 
         // compute inner product
-        ierr = VecTDot(this->m_WorkVecField->m_X1, this->m_WorkVecField->m_X1, &ipxi); CHKERRQ(ierr); value += ipxi;
-        ierr = VecTDot(this->m_WorkVecField->m_X2, this->m_WorkVecField->m_X2, &ipxi); CHKERRQ(ierr); value += ipxi;
-        ierr = VecTDot(this->m_WorkVecField->m_X3, this->m_WorkVecField->m_X3, &ipxi); CHKERRQ(ierr); value += ipxi;
+        ierr = this->m_WorkVecField->SquaredNormLocal(value); CHKERRQ(ierr);
 
         // multiply with regularization weight
-        *R = static_cast<ScalarType>(0.5*beta*hd*value);
+        ierr = this->m_Opt->m_Reduction.Add(value, R, 0.5*beta*hd); CHKERRQ(ierr);
+        ierr = this->m_Opt->m_Reduction.Flush(); CHKERRQ(ierr);
 
         // increment fft timer
         this->m_Opt->IncreaseFFTTimers(timer);
@@ -223,6 +224,7 @@ PetscErrorCode RegularizationH2SN::EvaluateGradient(VecField* dvR, VecField* v)
         this->m_Opt->IncrementCounter(FFT, 3);
 
         applytime = -MPI_Wtime();
+        PerfCounter::Start(PERFSPECTRAL);
 #pragma omp parallel
 {
         ScalarType lapik, regop;
@@ -259,6 +261,7 @@ PetscErrorCode RegularizationH2SN::EvaluateGradient(VecField* dvR, VecField* v)
             }
         }
 }  // pragma omp parallel
+        PerfCounter::Stop(PERFSPECTRAL);
         applytime += MPI_Wtime();
         timer[FFTHADAMARD] += applytime;
 
@@ -367,6 +370,7 @@ PetscErrorCode RegularizationH2SN::ApplyInverse(VecField* ainvv, VecField* v, bo
         this->m_Opt->IncrementCounter(FFT, 3);
 
         applytime = -MPI_Wtime();
+        PerfCounter::Start(PERFSPECTRAL);
 #pragma omp parallel
 {
         ScalarType lapik, regop;
@@ -404,6 +408,7 @@ PetscErrorCode RegularizationH2SN::ApplyInverse(VecField* ainvv, VecField* v, bo
             }
         }
 }  // pragma omp parallel
+        PerfCounter::Stop(PERFSPECTRAL);
         applytime += MPI_Wtime();
         timer[FFTHADAMARD] += applytime;
 
@@ -461,6 +466,27 @@ PetscErrorCode RegularizationH2SN::GetExtremeEigValsInvOp(ScalarType& emin, Scal
 
 
 
+/********************************************************************
+ * @brief fourier symbol of (the square root of) the inverse
+ * regularization operator (without fft scaling)
+ *******************************************************************/
+ScalarType RegularizationH2SN::GetInverseSymbol(ScalarType lapik, bool applysqrt) {
+    ScalarType beta, regop;
+
+    beta = this->m_Opt->m_RegNorm.beta[0];
+
+    // if regularization weight is zero, the operator is the identity
+    if (beta == 0.0) return 1.0;
+
+    regop = (std::abs(lapik) == 0.0) ? beta : beta*(lapik*lapik);
+    if (applysqrt) regop = std::sqrt(regop);
+
+    return 1.0/regop;
+}
+
+
+
+
 }  // namespace reg
 
 
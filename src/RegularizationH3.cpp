@@ -106,6 +106,7 @@ PetscErrorCode RegularizationH3::EvaluateFunctional(ScalarType* R, VecField* v)
         this->m_Opt->IncrementCounter(FFT, 3);
 
         applytime = -MPI_Wtime();
+        PerfCounter::Start(PERFSPECTRAL);
 #pragma omp parallel
 {
         ScalarType lapik, regop[6], gradik[3];
@@ -153,6 +154,7 @@ PetscErrorCode RegularizationH3::EvaluateFunctional(ScalarType* R, VecField* v)
             }
         }
 }  // pragma omp parallel
+        PerfCounter::Stop(PERFSPECTRAL);
         applytime += MPI_Wtime();
         timer[FFTHADAMARD] += applytime;
 
@@ -166,15 +168,14 @@ PetscErrorCode RegularizationH3::EvaluateFunctional(ScalarType* R, VecField* v)
         this->m_Opt->IncrementCounter(FFT, 3);
 
         // compute inner product
-        ierr=VecTDot(this->m_WorkVecField->m_X1, this->m_WorkVecField->m_X1, &ipxi); CHKERRQ(ierr); *R += ipxi;
-        ierr=VecTDot(this->m_WorkVecField->m_X2, this->m_WorkVecField->m_X2, &ipxi); CHKERRQ(ierr); *R += ipxi;
-        ierr=VecTDot(this->m_WorkVecField->m_X3, this->m_WorkVecField->m_X3, &ipxi); CHKERRQ(ierr); *R += ipxi;
+        ierr = this->m_WorkVecField->SquaredNormLocal(ipxi); CHKERRQ(ierr);
 
         // increment fft timer
         this->m_Opt->IncreaseFFTTimers(timer);
 
         // multiply with regularization weight
-        *R *= 0.5*hd;
+        ierr = this->m_Opt->m_Reduction.Add(ipxi, R, 0.5*hd); CHKERRQ(ierr);
+        ierr = this->m_Opt->m_Reduction.Flush(); CHKERRQ(ierr);
     }
 
     this->m_Opt->Exit(__func__);
@@ -232,6 +233,7 @@ PetscErrorCode RegularizationH3::EvaluateGradient(VecField* dvR, VecField* v) {
         this->m_Opt->IncrementCounter(FFT, 3);
 
         applytime = -MPI_Wtime();
+        PerfCounter::Start(PERFSPECTRAL);
 #pragma omp parallel
 {
         ScalarType trihik, regop;
@@ -269,6 +271,7 @@ PetscErrorCode RegularizationH3::EvaluateGradient(VecField* dvR, VecField* v) {
             }
         }
 }  // pragma omp parallel
+        PerfCounter::Stop(PERFSPECTRAL);
         applytime += MPI_Wtime();
         timer[FFTHADAMARD] += applytime;
 
@@ -375,6 +378,7 @@ PetscErrorCode RegularizationH3::ApplyInverse(VecField* Ainvx, VecField* x, bool
         this->m_Opt->IncrementCounter(FFT, 3);
 
         applytime = -MPI_Wtime();
+        PerfCounter::Start(PERFSPECTRAL);
 #pragma omp parallel
 {
         ScalarType trihik, regop;
@@ -413,6 +417,7 @@ PetscErrorCode RegularizationH3::ApplyInverse(VecField* Ainvx, VecField* x, bool
             }
         }
 }  // pragma omp parallel
+        PerfCounter::Stop(PERFSPECTRAL);
         applytime += MPI_Wtime();
         timer[FFTHADAMARD] += applytime;
 
@@ -472,6 +477,29 @@ PetscErrorCode RegularizationH3::GetExtremeEigValsInvOp(ScalarType& emin, Scalar
 
 
 
+/********************************************************************
+ * @brief fourier symbol of (the square root of) the inverse
+ * regularization operator (without fft scaling)
+ *******************************************************************/
+ScalarType RegularizationH3::GetInverseSymbol(ScalarType lapik, bool applysqrt) {
+    ScalarType beta[2], trihik, regop;
+
+    beta[0] = this->m_Opt->m_RegNorm.beta[0];
+    beta[1] = this->m_Opt->m_RegNorm.beta[1];
+
+    // if regularization weight is zero, the operator is the identity
+    if (beta[0] == 0.0) return 1.0;
+
+    trihik = std::pow(lapik, 3);
+    regop = beta[0]*(-trihik + beta[1]);
+    if (applysqrt) regop = sqrt(regop);
+
+    return 1.0/regop;
+}
+
+
+
+
 }  // end of name space
 
 #endif  // _REGULARIZATIONREGISTRATIONH2_CPP_
@@ -104,6 +104,7 @@ PetscErrorCode RegularizationH3SN::EvaluateFunctional(ScalarType* R, VecField* v
         this->m_Opt->IncrementCounter(FFT, 3);
 
         applytime = -MPI_Wtime();
+        PerfCounter::Start(PERFSPECTRAL);
 #pragma omp parallel
 {
         ScalarType lapik, regop[6], gradik[3];
@@ -151,6 +152,7 @@ PetscErrorCode RegularizationH3SN::EvaluateFunctional(ScalarType* R, VecField* v
             }
         }
 }  // pragma omp parallel
+        PerfCounter::Stop(PERFSPECTRAL);
         applytime += MPI_Wtime();
         timer[FFTHADAMARD] += applytime;
 
@@ -164,15 +166,14 @@ PetscErrorCode RegularizationH3SN::EvaluateFunctional(ScalarType* R, VecField* v
         this->m_Opt->IncrementCounter(FFT, 3);
 
         // compute inner product
-        ierr=VecTDot(this->m_WorkVecField->m_X1, this->m_WorkVecField->m_X1, &ipxi); CHKERRQ(ierr); *R += ipxi;
-        ierr=VecTDot(this->m_WorkVecField->m_X2, this->m_WorkVecField->m_X2, &ipxi); CHKERRQ(ierr); *R += ipxi;
-        ierr=VecTDot(this->m_WorkVecField->m_X3, this->m_WorkVecField->m_X3, &ipxi); CHKERRQ(ierr); *R += ipxi;
+        ierr = this->m_WorkVecField->SquaredNormLocal(ipxi); CHKERRQ(ierr);
 
         // increment fft timer
         this->m_Opt->IncreaseFFTTimers(timer);
 
         // multiply with regularization weight
-        *R *= 0.5*hd*beta;
+        ierr = this->m_Opt->m_Reduction.Add(ipxi, R, 0.5*hd*beta); CHKERRQ(ierr);
+        ierr = this->m_Opt->m_Reduction.Flush(); CHKERRQ(ierr);
     }
 
     this->m_Opt->Exit(__func__);
@@ -228,6 +229,7 @@ PetscErrorCode RegularizationH3SN::EvaluateGradient(VecField* dvR, VecField* v)
         this->m_Opt->IncrementCounter(FFT, 3);
 
         applytime = -MPI_Wtime();
+        PerfCounter::Start(PERFSPECTRAL);
 #pragma omp parallel
 {
         ScalarType trihik, regop;
@@ -265,6 +267,7 @@ PetscErrorCode RegularizationH3SN::EvaluateGradient(VecField* dvR, VecField* v)
             }
         }
 }  // pragma omp parallel
+        PerfCounter::Stop(PERFSPECTRAL);
         applytime += MPI_Wtime();
         timer[FFTHADAMARD] += applytime;
 
@@ -369,6 +372,7 @@ PetscErrorCode RegularizationH3SN::ApplyInverse(VecField* Ainvx, VecField* x, bo
         this->m_Opt->IncrementCounter(FFT, 3);
 
         applytime = -MPI_Wtime();
+        PerfCounter::Start(PERFSPECTRAL);
 #pragma omp parallel
 {
         ScalarType lapik, regop;
@@ -405,6 +409,7 @@ PetscErrorCode RegularizationH3SN::ApplyInverse(VecField* Ainvx, VecField* x, bo
             }
         }
 }  // pragma omp parallel
+        PerfCounter::Stop(PERFSPECTRAL);
         applytime += MPI_Wtime();
         timer[FFTHADAMARD] += applytime;
 
@@ -463,6 +468,27 @@ PetscErrorCode RegularizationH3SN::GetExtremeEigValsInvOp(ScalarType& emin, Scal
 
 
 
+/********************************************************************
+ * @brief fourier symbol of (the square root of) the inverse
+ * regularization operator (without fft scaling)
+ *******************************************************************/
+ScalarType RegularizationH3SN::GetInverseSymbol(ScalarType lapik, bool applysqrt) {
+    ScalarType beta, regop;
+
+    beta = this->m_Opt->m_RegNorm.beta[0];
+
+    // if regularization weight is zero, the operator is the identity
+    if (beta == 0.0) return 1.0;
+
+    regop = (std::abs(lapik) == 0.0) ? beta : -beta*std::pow(lapik, 3);
+    if (applysqrt) regop = sqrt(regop);
+
+    return 1.0/regop;
+}
+
+
+
+
 }  // end of name space
 
 #endif  // _REGULARIZATIONREGISTRATIONH3SN_CPP_
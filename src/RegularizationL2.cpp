@@ -79,10 +79,9 @@ PetscErrorCode RegularizationL2
 
     // if regularization weight is zero, do noting
     if (beta != 0.0) {
-        ierr = VecTDot(v->m_X1, v->m_X1, &ipxi); CHKERRQ(ierr); *R += ipxi;
-        ierr = VecTDot(v->m_X2, v->m_X2, &ipxi); CHKERRQ(ierr); *R += ipxi;
-        ierr = VecTDot(v->m_X3, v->m_X3, &ipxi); CHKERRQ(ierr); *R += ipxi;
-        *R *= 0.5*hd*beta;
+        ierr = v->SquaredNormLocal(ipxi); CHKERRQ(ierr);
+        ierr = this->m_Opt->m_Reduction.Add(ipxi, R, 0.5*hd*beta); CHKERRQ(ierr);
+        ierr = this->m_Opt->m_Reduction.Flush(); CHKERRQ(ierr);
     }
 
     this->m_Opt->Exit(__func__);
@@ -242,6 +241,22 @@ PetscErrorCode RegularizationL2
 
 
 
+/********************************************************************
+ * @brief fourier symbol of (the square root of) the inverse
+ * regularization operator (without fft scaling)
+ *******************************************************************/
+ScalarType RegularizationL2::GetInverseSymbol(ScalarType lapik, bool applysqrt) {
+    ScalarType beta;
+
+    beta = this->m_Opt->m_RegNorm.beta[0];
+
+    // as in ApplyInverse, the operator is applied without square root
+    return (beta == 0.0) ? 1.0 : 1.0/beta;
+}
+
+
+
+
 }  // namespace reg
 
 
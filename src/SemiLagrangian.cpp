@@ -30,6 +30,13 @@ namespace reg {
 
 
 
+/*! width (in grid points) of the layer around the active region in
+ *  which we blend from transported to unchanged values */
+static const IntType s_ActiveRegionTaper = 6;
+
+
+
+
 /********************************************************************
  * @brief default constructor
  *******************************************************************/
@@ -82,6 +89,12 @@ PetscErrorCode SemiLagrangian::Initialize() {
     this->m_Dofs[0] = 1;
     this->m_Dofs[1] = 3;
 
+    this->m_Mask = NULL;
+    this->m_MaskState = 0;
+    this->m_UseActiveRegion = false;
+    this->m_Compact[0] = false;
+    this->m_Compact[1] = false;
+
     PetscFunctionReturn(ierr);
 }
 
@@ -146,6 +159,260 @@ PetscErrorCode SemiLagrangian::SetWorkVecField(VecField* x) {
 
 
 
+/********************************************************************
+ * @brief set mask that defines the region of interest; if the active
+ * region is enabled (-activeregion), trajectories and interpolation
+ * are only computed inside a box that contains the support of the mask
+ * (dilated by the distance information travels during the solve; see
+ * ComputeActiveRegion); outside of this box, the transported fields
+ * are left unchanged
+ * @param mask mask (can be a null pointer; disables active region)
+ *******************************************************************/
+PetscErrorCode SemiLagrangian::SetActiveRegion(Vec mask) {
+    PetscErrorCode ierr = 0;
+    IntType isize[3], istart[3], lo[3], hi[3], i1, i2, i3, l;
+    PetscObjectState state = 0;
+    const ScalarType *p_m = NULL;
+    int merr;
+
+    PetscFunctionBegin;
+
+    if (!this->m_Opt->m_RegFlags.activeregion || mask == NULL) {
+        this->m_Mask = NULL;
+        PetscFunctionReturn(ierr);
+    }
+
+    // nothing to be done if mask has not changed
+    ierr = PetscObjectStateGet(reinterpret_cast<PetscObject>(mask), &state); CHKERRQ(ierr);
+    if (mask == this->m_Mask && state == this->m_MaskState) {
+        PetscFunctionReturn(ierr);
+    }
+
+    this->m_Opt->Enter(__func__);
+
+    for (int i = 0; i < 3; ++i) {
+        isize[i]  = this->m_Opt->m_Domain.isize[i];
+        istart[i] = this->m_Opt->m_Domain.istart[i];
+        lo[i] = this->m_Opt->m_Domain.nx[i];
+        hi[i] = -1;
+    }
+
+    // bounding box of support of mask (the mask is smooth, so we
+    // threshold it)
+    ierr = VecGetArrayRead(mask, &p_m); CHKERRQ(ierr);
+    for (i1 = 0; i1 < isize[0]; ++i1) {  // x1
+        for (i2 = 0; i2 < isize[1]; ++i2) {  // x2
+            for (i3 = 0; i3 < isize[2]; ++i3) {  // x3
+                l = GetLinearIndex(i1, i2, i3, isize);
+                if (p_m[l] > 1E-3) {
+                    lo[0] = PetscMin(lo[0], i1 + istart[0]); hi[0] = PetscMax(hi[0], i1 + istart[0]);
+                    lo[1] = PetscMin(lo[1], i2 + istart[1]); hi[1] = PetscMax(hi[1], i2 + istart[1]);
+                    lo[2] = PetscMin(lo[2], i3 + istart[2]); hi[2] = PetscMax(hi[2], i3 + istart[2]);
+                }
+            }  // i3
+        }  // i2
+    }  // i1
+    ierr = VecRestoreArrayRead(mask, &p_m); CHKERRQ(ierr);
+
+    merr = MPI_Allreduce(lo, this->m_MaskBox, 3, MPIU_INT, MPI_MIN, PETSC_COMM_WORLD);
+    ierr = MPIERRQ(merr); CHKERRQ(ierr);
+    merr = MPI_Allreduce(hi, this->m_MaskBox + 3, 3, MPIU_INT, MPI_MAX, PETSC_COMM_WORLD);
+    ierr = MPIERRQ(merr); CHKERRQ(ierr);
+
+    // empty mask: use entire domain
+    for (int i = 0; i < 3; ++i) {
+        if (this->m_MaskBox[3+i] < this->m_MaskBox[i]) {
+            this->m_MaskBox[i] = 0;
+            this->m_MaskBox[3+i] = this->m_Opt->m_Domain.nx[i] - 1;
+        }
+    }
+
+    // the state we read above is the current state of the mask
+    this->m_Mask = mask;
+    this->m_MaskState = state;
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief get the local indices of the points the state or adjoint
+ * plan is restricted to; values outside of these points are not
+ * transported, so that pointwise kernels that act on transported
+ * fields can be restricted to the same points
+ * @param index list of local indices (NULL if not restricted)
+ * @param flag state or adjoint
+ *******************************************************************/
+PetscErrorCode SemiLagrangian::GetActiveIndex(const std::vector<IntType>*& index, std::string flag) {
+    PetscErrorCode ierr = 0;
+    int id;
+    PetscFunctionBegin;
+
+    id = strcmp(flag.c_str(), "state") == 0 ? 0 : 1;
+    index = this->m_Compact[id] ? &this->m_ActiveIndex[id] : NULL;
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief compute the active points for the trajectory; a point in the
+ * region of interest depends on values that are at most |v|_inf*T away
+ * (T = 1); in addition, each time step can pull in errors from at
+ * most the interpolation stencil; we dilate the bounding box of the
+ * mask accordingly (if we hit the boundary, we use the entire extent
+ * of the domain in this direction, since the domain is periodic);
+ * the box is padded by a layer in which the transported values are
+ * blended (cosine taper) into the unchanged values outside; a jump at
+ * the boundary of the box would cause ringing in spectral derivatives
+ * (e.g., grad(m) in the body force)
+ * @param v velocity field
+ * @param flag state or adjoint
+ *******************************************************************/
+PetscErrorCode SemiLagrangian::ComputeActiveRegion(VecField* v, std::string flag) {
+    PetscErrorCode ierr = 0;
+    IntType isize[3], istart[3], nx[3], lo[3], hi[3], pad[3], nl, nt, radius, stencil, i1, i2, i3, l;
+    ScalarType w1, w2, w3;
+    const ScalarType *p_v1 = NULL, *p_v2 = NULL, *p_v3 = NULL;
+    ScalarType vmax = 0.0, vmaxloc = 0.0;
+    std::stringstream ss;
+    int merr, id;
+
+    PetscFunctionBegin;
+
+    this->m_UseActiveRegion = false;
+    if (this->m_Mask == NULL) {
+        PetscFunctionReturn(ierr);
+    }
+
+    this->m_Opt->Enter(__func__);
+
+    id = strcmp(flag.c_str(), "state") == 0 ? 0 : 1;
+    nl = this->m_Opt->m_Domain.nl;
+    nt = this->m_Opt->m_Domain.nt;
+    stencil = (this->m_Opt->m_PDESolver.iporder + 1)/2 + 1;
+
+    // max norm of velocity
+    ierr = v->GetArraysRead(p_v1, p_v2, p_v3); CHKERRQ(ierr);
+#pragma omp parallel for reduction(max:vmaxloc)
+    for (IntType i = 0; i < nl; ++i) {
+        ScalarType vnorm = PetscSqrtReal(p_v1[i]*p_v1[i] + p_v2[i]*p_v2[i] + p_v3[i]*p_v3[i]);
+        vmaxloc = PetscMax(vmaxloc, vnorm);
+    }
+    ierr = v->RestoreArraysRead(p_v1, p_v2, p_v3); CHKERRQ(ierr);
+    merr = MPI_Allreduce(&vmaxloc, &vmax, 1, MPIU_REAL, MPI_MAX, PETSC_COMM_WORLD);
+    ierr = MPIERRQ(merr); CHKERRQ(ierr);
+
+    for (int i = 0; i < 3; ++i) {
+        isize[i]  = this->m_Opt->m_Domain.isize[i];
+        istart[i] = this->m_Opt->m_Domain.istart[i];
+        nx[i]     = this->m_Opt->m_Domain.nx[i];
+
+        radius = static_cast<IntType>(std::ceil(vmax/this->m_Opt->m_Domain.hx[i])) + nt*stencil;
+        pad[i] = s_ActiveRegionTaper;
+        lo[i] = this->m_MaskBox[i] - radius;
+        hi[i] = this->m_MaskBox[3+i] + radius;
+        if (lo[i] - pad[i] < 0 || hi[i] + pad[i] >= nx[i]) {
+            lo[i] = 0; hi[i] = nx[i] - 1; pad[i] = 0;
+        }
+    }
+
+    // local list of active points (sorted) and weights of taper
+    this->m_ActiveIndex[id].clear();
+    this->m_ActiveWeight[id].clear();
+    for (i1 = 0; i1 < isize[0]; ++i1) {  // x1
+        w1 = this->TaperWeight(i1 + istart[0], lo[0], hi[0], pad[0]);
+        if (w1 == 0.0) continue;
+        for (i2 = 0; i2 < isize[1]; ++i2) {  // x2
+            w2 = w1*this->TaperWeight(i2 + istart[1], lo[1], hi[1], pad[1]);
+            if (w2 == 0.0) continue;
+            for (i3 = 0; i3 < isize[2]; ++i3) {  // x3
+                w3 = w2*this->TaperWeight(i3 + istart[2], lo[2], hi[2], pad[2]);
+                if (w3 == 0.0) continue;
+                l = GetLinearIndex(i1, i2, i3, isize);
+                this->m_ActiveIndex[id].push_back(l);
+                this->m_ActiveWeight[id].push_back(w3);
+            }  // i3
+        }  // i2
+    }  // i1
+
+    // only restrict if there is something to be gained (the list can
+    // be empty, if the local pencil is outside of the active region)
+    this->m_UseActiveRegion = static_cast<IntType>(this->m_ActiveIndex[id].size()) < nl;
+
+    if (this->m_Opt->m_Verbosity > 2) {
+        ss << "active region (" << flag << "): [" << lo[0] << "," << hi[0] << "]x["
+           << lo[1] << "," << hi[1] << "]x[" << lo[2] << "," << hi[2] << "]";
+        ierr = DbgMsg(ss.str()); CHKERRQ(ierr);
+    }
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief weight of grid point for blending transported values into
+ * unchanged values; 1 inside [lo, hi], cosine decay to 0 within pad
+ * grid points outside of it
+ *******************************************************************/
+ScalarType SemiLagrangian::TaperWeight(IntType i, IntType lo, IntType hi, IntType pad) {
+    IntType d = 0;
+    if (i < lo) d = lo - i;
+    if (i > hi) d = i - hi;
+    if (d == 0) return 1.0;
+    if (d > pad) return 0.0;
+    return 0.5*(1.0 + PetscCosReal(PETSC_PI*static_cast<ScalarType>(d)/static_cast<ScalarType>(pad + 1)));
+}
+
+
+
+
+/********************************************************************
+ * @brief set values at active points from interpolated values; outside
+ * of the active region the input is left unchanged; in the layer around
+ * the active region we blend (see ComputeActiveRegion)
+ * @param xo output (can be the same as xi)
+ * @param xi input (values that are not transported)
+ * @param xq interpolated values at active points
+ * @param id state (0) or adjoint (1) plan
+ *******************************************************************/
+PetscErrorCode SemiLagrangian::SetActiveValues(ScalarType* xo, const ScalarType* xi,
+                                               const ScalarType* xq, int id) {
+    PetscErrorCode ierr = 0;
+    IntType nl, neval;
+    const IntType* idx = NULL;
+    const ScalarType* w = NULL;
+
+    PetscFunctionBegin;
+
+    nl = this->m_Opt->m_Domain.nl;
+    neval = static_cast<IntType>(this->m_ActiveIndex[id].size());
+    idx = this->m_ActiveIndex[id].data();
+    w = this->m_ActiveWeight[id].data();
+
+    if (xo != xi) {
+        for (IntType i = 0; i < nl; ++i) xo[i] = xi[i];
+    }
+    for (IntType j = 0; j < neval; ++j) {
+        xo[idx[j]] += w[j]*(xq[j] - xo[idx[j]]);
+    }
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
 /********************************************************************
  * @brief compute the trajectory from the velocity field based
  * on an rk2 scheme (todo: make the velocity field a const vector)
@@ -167,6 +434,9 @@ PetscErrorCode SemiLagrangian::ComputeTrajectory(VecField* v, std::string flag)
         }
     }
 
+    // restrict trajectory to region of interest (if set)
+    ierr = this->ComputeActiveRegion(v, flag); CHKERRQ(ierr);
+
     // compute trajectory
 
     if (this->m_Opt->m_PDESolver.rkorder == 2) {
@@ -176,6 +446,7 @@ PetscErrorCode SemiLagrangian::ComputeTrajectory(VecField* v, std::string flag)
     } else {
         ierr = ThrowError("rk order not implemented"); CHKERRQ(ierr);
     }
+    this->m_UseActiveRegion = false;
 
     this->m_Opt->Exit(__func__);
 
@@ -488,6 +759,9 @@ PetscErrorCode SemiLagrangian::SetQueryPoints(ScalarType* y1, ScalarType* y2, Sc
         this->m_X[3*i+2] = y3[i]/(2.0*PETSC_PI);
     }
 
+    // arbitrary query points are never restricted to the active region
+    this->m_UseActiveRegion = false;
+
     // evaluate right hand side
     ierr = this->CommunicateCoord(flag); CHKERRQ(ierr);
 
@@ -535,8 +809,9 @@ PetscErrorCode SemiLagrangian::Interpolate(Vec* xo, Vec xi, std::string flag) {
  *******************************************************************/
 PetscErrorCode SemiLagrangian::Interpolate(ScalarType* xo, ScalarType* xi, std::string flag) {
     PetscErrorCode ierr = 0;
-    int nx[3], isize_g[3], isize[3], istart_g[3], istart[3], c_dims[2], neval, order, nghost;
+    int nx[3], isize_g[3], isize[3], istart_g[3], istart[3], c_dims[2], neval, order, nghost, id;
     IntType nl, nalloc;
+    ScalarType* p_q = NULL;
     std::stringstream ss;
     double timers[4] = {0, 0, 0, 0};
 
@@ -553,6 +828,18 @@ PetscErrorCode SemiLagrangian::Interpolate(ScalarType* xo, ScalarType* xi, std::
     order  = this->m_Opt->m_PDESolver.iporder;
     nghost = order;
     neval  = static_cast<int>(nl);
+    p_q    = xo;
+
+    // only evaluate at active points (values outside are not transported)
+    id = strcmp(flag.c_str(), "state") == 0 ? 0 : 1;
+    if (this->m_Compact[id]) {
+        neval = static_cast<int>(this->m_ActiveIndex[id].size());
+        p_q   = this->m_X;
+    }
+
+    // use linear interpolation if requested by accuracy adaptive solver
+    // (the ghost layer is not changed)
+    if (this->m_Opt->m_PDESolver.iplinear) order = 1;
 
     for (int i = 0; i < 3; ++i) {
         nx[i]     = static_cast<int>(this->m_Opt->m_Domain.nx[i]);
@@ -577,13 +864,17 @@ PetscErrorCode SemiLagrangian::Interpolate(ScalarType* xo, ScalarType* xi, std::
     // compute interpolation for all components of the input scalar field
     if (strcmp(flag.c_str(), "state") == 0) {
         this->m_StatePlan->interpolate(this->m_ScaFieldGhost, nx, isize, istart,
-                                       neval, nghost, xo, c_dims, this->m_Opt->m_FFT.mpicomm, timers, 0);
+                                       neval, nghost, p_q, c_dims, this->m_Opt->m_FFT.mpicomm, timers, 0, order);
     } else if (strcmp(flag.c_str(), "adjoint") == 0) {
         this->m_AdjointPlan->interpolate(this->m_ScaFieldGhost, nx, isize, istart,
-                                       neval, nghost, xo, c_dims, this->m_Opt->m_FFT.mpicomm, timers, 0);
+                                       neval, nghost, p_q, c_dims, this->m_Opt->m_FFT.mpicomm, timers, 0, order);
     } else {
         ierr = ThrowError("flag wrong"); CHKERRQ(ierr);
     }
+
+    if (this->m_Compact[id]) {
+        ierr = this->SetActiveValues(xo, xi, p_q, id); CHKERRQ(ierr);
+    }
     ierr = this->m_Opt->StopTimer(IPSELFEXEC); CHKERRQ(ierr);
     this->m_Opt->IncreaseInterpTimers(timers);
     this->m_Opt->IncrementCounter(IP);
@@ -632,10 +923,10 @@ PetscErrorCode SemiLagrangian::Interpolate(VecField* vo, VecField* vi, std::stri
 PetscErrorCode SemiLagrangian::Interpolate(ScalarType* wx1, ScalarType* wx2, ScalarType* wx3,
                                            ScalarType* vx1, ScalarType* vx2, ScalarType* vx3, std::string flag) {
     PetscErrorCode ierr = 0;
-    int nx[3], isize_g[3], isize[3], istart_g[3], istart[3], c_dims[2], nghost, order;
+    int nx[3], isize_g[3], isize[3], istart_g[3], istart[3], c_dims[2], nghost, order, id;
     double timers[4] = {0, 0, 0, 0};
     std::stringstream ss;
-    IntType nl, nlghost, nalloc;
+    IntType nl, nlghost, nalloc, neval;
 
     PetscFunctionBegin;
 
@@ -652,6 +943,14 @@ PetscErrorCode SemiLagrangian::Interpolate(ScalarType* wx1, ScalarType* wx2, Sca
     order = this->m_Opt->m_PDESolver.iporder;
     nghost = order;
 
+    // only evaluate at active points (values outside are not transported)
+    id = strcmp(flag.c_str(), "state") == 0 ? 0 : 1;
+    neval = this->m_Compact[id] ? static_cast<IntType>(this->m_ActiveIndex[id].size()) : nl;
+
+    // use linear interpolation if requested by accuracy adaptive solver
+    // (the ghost layer is not changed)
+    if (this->m_Opt->m_PDESolver.iplinear) order = 1;
+
     for (int i = 0; i < 3; ++i) {
         nx[i] = static_cast<int>(this->m_Opt->m_Domain.nx[i]);
         isize[i] = static_cast<int>(this->m_Opt->m_Domain.isize[i]);
@@ -702,21 +1001,27 @@ PetscErrorCode SemiLagrangian::Interpolate(ScalarType* wx1, ScalarType* wx2, Sca
     if (strcmp(flag.c_str(),"state") == 0) {
         ierr = Assert(this->m_StatePlan != NULL, "null pointer"); CHKERRQ(ierr);
         this->m_StatePlan->interpolate(this->m_VecFieldGhost, nx, isize, istart,
-                                       nl, nghost, this->m_X, c_dims, this->m_Opt->m_FFT.mpicomm, timers, 1);
+                                       neval, nghost, this->m_X, c_dims, this->m_Opt->m_FFT.mpicomm, timers, 1, order);
     } else if (strcmp(flag.c_str(),"adjoint") == 0) {
         ierr = Assert(this->m_AdjointPlan != NULL, "null pointer"); CHKERRQ(ierr);
         this->m_AdjointPlan->interpolate(this->m_VecFieldGhost, nx, isize, istart,
-                                         nl, nghost, this->m_X, c_dims, this->m_Opt->m_FFT.mpicomm, timers, 1);
+                                         neval, nghost, this->m_X, c_dims, this->m_Opt->m_FFT.mpicomm, timers, 1, order);
     } else {
         ierr = ThrowError("flag wrong"); CHKERRQ(ierr);
     }
 
     ierr = this->m_Opt->StopTimer(IPSELFEXEC); CHKERRQ(ierr);
 
-    for (IntType i = 0; i < nl; ++i) {
-        wx1[i] = this->m_X[0*nl+i];
-        wx2[i] = this->m_X[1*nl+i];
-        wx3[i] = this->m_X[2*nl+i];
+    if (this->m_Compact[id]) {
+        ierr = this->SetActiveValues(wx1, vx1, &this->m_X[0*neval], id); CHKERRQ(ierr);
+        ierr = this->SetActiveValues(wx2, vx2, &this->m_X[1*neval], id); CHKERRQ(ierr);
+        ierr = this->SetActiveValues(wx3, vx3, &this->m_X[2*neval], id); CHKERRQ(ierr);
+    } else {
+        for (IntType i = 0; i < nl; ++i) {
+            wx1[i] = this->m_X[0*nl+i];
+            wx2[i] = this->m_X[1*nl+i];
+            wx3[i] = this->m_X[2*nl+i];
+        }
     }
 
     this->m_Opt->IncreaseInterpTimers(timers);
@@ -730,13 +1035,116 @@ PetscErrorCode SemiLagrangian::Interpolate(ScalarType* wx1, ScalarType* wx2, Sca
 
 
 
+/********************************************************************
+ * @brief interpolate vector field at the query points of the state
+ * and the adjoint plan; the field and its ghost layer are shared
+ * by both evaluations (used to integrate forward and backward
+ * characteristics in the same time loop)
+ * @param[out] wx1, wx2, wx3 values at state query points
+ * @param[out] zx1, zx2, zx3 values at adjoint query points
+ * @param[in] vx1, vx2, vx3 vector field to be interpolated
+ *******************************************************************/
+PetscErrorCode SemiLagrangian::InterpolateStateAndAdjoint(ScalarType* wx1, ScalarType* wx2, ScalarType* wx3,
+                                                          ScalarType* zx1, ScalarType* zx2, ScalarType* zx3,
+                                                          ScalarType* vx1, ScalarType* vx2, ScalarType* vx3) {
+    PetscErrorCode ierr = 0;
+    int nx[3], isize_g[3], isize[3], istart_g[3], istart[3], c_dims[2], nghost, order;
+    double timers[4] = {0, 0, 0, 0};
+    IntType nl, nlghost, nalloc, neval;
+    ScalarType *p_o[2][3] = {{wx1, wx2, wx3}, {zx1, zx2, zx3}};
+    Interp3_Plan* plan[2];
+
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    ierr = Assert(vx1 != NULL && vx2 != NULL && vx3 != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(wx1 != NULL && wx2 != NULL && wx3 != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(zx1 != NULL && zx2 != NULL && zx3 != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_StatePlan != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_AdjointPlan != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_X != NULL, "null pointer"); CHKERRQ(ierr);
+
+    nl = this->m_Opt->m_Domain.nl;
+    order = this->m_Opt->m_PDESolver.iporder;
+    nghost = order;
+    if (this->m_Opt->m_PDESolver.iplinear) order = 1;
+
+    for (int i = 0; i < 3; ++i) {
+        nx[i] = static_cast<int>(this->m_Opt->m_Domain.nx[i]);
+        isize[i] = static_cast<int>(this->m_Opt->m_Domain.isize[i]);
+        istart[i] = static_cast<int>(this->m_Opt->m_Domain.istart[i]);
+    }
+    c_dims[0] = this->m_Opt->m_CartGridDims[0];
+    c_dims[1] = this->m_Opt->m_CartGridDims[1];
+
+    plan[0] = this->m_StatePlan;
+    plan[1] = this->m_AdjointPlan;
+
+    for (IntType i = 0; i < nl; ++i) {
+        this->m_X[0*nl+i] = vx1[i];
+        this->m_X[1*nl+i] = vx2[i];
+        this->m_X[2*nl+i] = vx3[i];
+    }
+
+    ierr = this->m_Opt->StartTimer(IPSELFEXEC); CHKERRQ(ierr);
+
+    nalloc = accfft_ghost_xyz_local_size_dft_r2c(this->m_Opt->m_FFT.plan, nghost, isize_g, istart_g);
+    nlghost = 1;
+    for (int i = 0; i < 3; ++i) {
+        nlghost *= static_cast<IntType>(isize_g[i]);
+    }
+    if (this->m_VecFieldGhost == NULL) {
+        this->m_VecFieldGhost = reinterpret_cast<ScalarType*>(accfft_alloc(3*nalloc));
+    }
+
+    // communicate ghost points once for both evaluations
+    for (int i = 0; i < 3; i++) {
+        accfft_get_ghost_xyz(this->m_Opt->m_FFT.plan, nghost, isize_g, &this->m_X[i*nl],
+                             &this->m_VecFieldGhost[i*nlghost]);
+    }
+
+    ierr = this->m_Opt->StopTimer(IPSELFEXEC); CHKERRQ(ierr);
+
+    for (int id = 0; id < 2; ++id) {
+        neval = this->m_Compact[id] ? static_cast<IntType>(this->m_ActiveIndex[id].size()) : nl;
+
+        ierr = this->m_Opt->StartTimer(IPSELFEXEC); CHKERRQ(ierr);
+        plan[id]->interpolate(this->m_VecFieldGhost, nx, isize, istart,
+                              neval, nghost, this->m_X, c_dims, this->m_Opt->m_FFT.mpicomm, timers, 1, order);
+        ierr = this->m_Opt->StopTimer(IPSELFEXEC); CHKERRQ(ierr);
+
+        if (this->m_Compact[id]) {
+            ierr = this->SetActiveValues(p_o[id][0], vx1, &this->m_X[0*neval], id); CHKERRQ(ierr);
+            ierr = this->SetActiveValues(p_o[id][1], vx2, &this->m_X[1*neval], id); CHKERRQ(ierr);
+            ierr = this->SetActiveValues(p_o[id][2], vx3, &this->m_X[2*neval], id); CHKERRQ(ierr);
+        } else {
+            for (IntType i = 0; i < nl; ++i) {
+                p_o[id][0][i] = this->m_X[0*nl+i];
+                p_o[id][1][i] = this->m_X[1*nl+i];
+                p_o[id][2][i] = this->m_X[2*nl+i];
+            }
+        }
+        this->m_Opt->IncrementCounter(IPVEC);
+    }
+
+    this->m_Opt->IncreaseInterpTimers(timers);
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
 /********************************************************************
  * @brief communicate the coordinate vector (query points)
  * @param flag to switch between forward and adjoint solves
  *******************************************************************/
 PetscErrorCode SemiLagrangian::CommunicateCoord(std::string flag) {
     PetscErrorCode ierr;
-    int nx[3], nl, isize[3], istart[3], nghost;
+    int nx[3], nl, neval, isize[3], istart[3], nghost, id;
     int c_dims[2];
     double timers[4] = {0, 0, 0, 0};
     std::stringstream ss;
@@ -761,6 +1169,21 @@ PetscErrorCode SemiLagrangian::CommunicateCoord(std::string flag) {
 
     ierr = this->m_Opt->StartTimer(IPSELFEXEC); CHKERRQ(ierr);
 
+    // restrict query points to active region (compact in place; the
+    // indices are sorted, so that we never overwrite unread points)
+    neval = nl;
+    id = strcmp(flag.c_str(), "state") == 0 ? 0 : 1;
+    this->m_Compact[id] = this->m_UseActiveRegion;
+    if (this->m_Compact[id]) {
+        const IntType* idx = this->m_ActiveIndex[id].data();
+        neval = static_cast<int>(this->m_ActiveIndex[id].size());
+        for (int j = 0; j < neval; ++j) {
+            this->m_X[3*j+0] = this->m_X[3*idx[j]+0];
+            this->m_X[3*j+1] = this->m_X[3*idx[j]+1];
+            this->m_X[3*j+2] = this->m_X[3*idx[j]+2];
+        }
+    }
+
     if (strcmp(flag.c_str(), "state") == 0) {
         // characteristic for state equation should have been computed already
         ierr = Assert(this->m_X != NULL, "null pointer"); CHKERRQ(ierr);
@@ -777,7 +1200,7 @@ PetscErrorCode SemiLagrangian::CommunicateCoord(std::string flag) {
         }
 
         // scatter
-        this->m_StatePlan->scatter(nx, isize, istart, nl, nghost, this->m_X,
+        this->m_StatePlan->scatter(nx, isize, istart, neval, nghost, this->m_X,
                                    c_dims, this->m_Opt->m_FFT.mpicomm, timers);
     } else if (strcmp(flag.c_str(), "adjoint") == 0) {
         // characteristic for adjoint equation should have been computed already
@@ -795,7 +1218,7 @@ PetscErrorCode SemiLagrangian::CommunicateCoord(std::string flag) {
         }
 
         // communicate coordinates
-        this->m_AdjointPlan->scatter(nx, isize, istart, nl, nghost, this->m_X,
+        this->m_AdjointPlan->scatter(nx, isize, istart, neval, nghost, this->m_X,
                                      c_dims, this->m_Opt->m_FFT.mpicomm, timers);
     } else {
         ierr = ThrowError("flag wrong"); CHKERRQ(ierr);
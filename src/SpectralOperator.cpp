@@ -0,0 +1,365 @@
+/*************************************************************************
+ *  Copyright (c) 2016.
+ *  All rights reserved.
+ *  This file is part of the CLAIRE library.
+ *
+ *  CLAIRE is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CLAIRE is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CLAIRE.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#ifndef _SPECTRALOPERATOR_CPP_
+#define _SPECTRALOPERATOR_CPP_
+
+#include <math.h>
+#include "SpectralOperator.hpp"
+
+
+
+
+namespace reg {
+
+
+
+
+/********************************************************************
+ * @brief default constructor
+ *******************************************************************/
+SpectralOperator::SpectralOperator() {
+    this->Initialize();
+}
+
+
+
+
+/********************************************************************
+ * @brief default destructor
+ *******************************************************************/
+SpectralOperator::~SpectralOperator(void) {
+    this->ClearMemory();
+}
+
+
+
+
+/********************************************************************
+ * @brief constructor
+ *******************************************************************/
+SpectralOperator::SpectralOperator(RegOpt* opt) {
+    this->Initialize();
+    this->m_Opt = opt;
+}
+
+
+
+
+/********************************************************************
+ * @brief init variables
+ *******************************************************************/
+PetscErrorCode SpectralOperator::Initialize(void) {
+    PetscFunctionBegin;
+
+    this->m_Opt = NULL;
+
+    this->m_x1hat = NULL;
+    this->m_x2hat = NULL;
+    this->m_x3hat = NULL;
+
+    PetscFunctionReturn(0);
+}
+
+
+
+
+/********************************************************************
+ * @brief clean up (spectral data is owned by the caller)
+ *******************************************************************/
+PetscErrorCode SpectralOperator::ClearMemory(void) {
+    PetscFunctionBegin;
+
+    this->m_Stages.clear();
+
+    PetscFunctionReturn(0);
+}
+
+
+
+
+/********************************************************************
+ * @brief set containers for spectral data
+ *******************************************************************/
+PetscErrorCode SpectralOperator::SetSpectralData(ComplexType* xhat1,
+                                                 ComplexType* xhat2,
+                                                 ComplexType* xhat3) {
+    PetscErrorCode ierr = 0;
+    PetscFunctionBegin;
+
+    ierr = Assert(xhat1 != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(xhat2 != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(xhat3 != NULL, "null pointer"); CHKERRQ(ierr);
+
+    this->m_x1hat = xhat1;
+    this->m_x2hat = xhat2;
+    this->m_x3hat = xhat3;
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief remove all stages
+ *******************************************************************/
+PetscErrorCode SpectralOperator::Reset(void) {
+    PetscFunctionBegin;
+
+    this->m_Stages.clear();
+
+    PetscFunctionReturn(0);
+}
+
+
+
+
+/********************************************************************
+ * @brief append (relaxed) leray projection
+ *******************************************************************/
+PetscErrorCode SpectralOperator::AddProjection(ScalarType betav, ScalarType betaw) {
+    PetscErrorCode ierr = 0;
+    Stage stage;
+    PetscFunctionBegin;
+
+    ierr = Assert(betaw >= 0.0, "negative weight"); CHKERRQ(ierr);
+
+    stage.type = SPECPROJECTION;
+    stage.param[0] = betav;
+    stage.param[1] = betaw;
+    stage.param[2] = 0.0;
+    stage.applysqrt = false;
+    stage.regularization = NULL;
+    this->m_Stages.push_back(stage);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief append (square root of) inverse of regularization operator
+ *******************************************************************/
+PetscErrorCode SpectralOperator::AddInverseRegularization(Regularization* regularization,
+                                                          bool applysqrt) {
+    PetscErrorCode ierr = 0;
+    Stage stage;
+    PetscFunctionBegin;
+
+    ierr = Assert(regularization != NULL, "null pointer"); CHKERRQ(ierr);
+
+    stage.type = SPECINVREG;
+    stage.param[0] = 0.0;
+    stage.param[1] = 0.0;
+    stage.param[2] = 0.0;
+    stage.applysqrt = applysqrt;
+    stage.regularization = regularization;
+    this->m_Stages.push_back(stage);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief append gaussian filter; sigma is given in number of grid
+ * points (as for Preprocessing::GaussianSmoothing)
+ *******************************************************************/
+PetscErrorCode SpectralOperator::AddGaussianFilter(ScalarType* sigma) {
+    PetscErrorCode ierr = 0;
+    Stage stage;
+    PetscFunctionBegin;
+
+    ierr = Assert(sigma != NULL, "null pointer"); CHKERRQ(ierr);
+
+    stage.type = SPECGAUSSIAN;
+    for (int i = 0; i < 3; ++i) {
+        stage.param[i] = sigma[i]*this->m_Opt->m_Domain.hx[i];
+        stage.param[i] *= stage.param[i];
+    }
+    stage.applysqrt = false;
+    stage.regularization = NULL;
+    this->m_Stages.push_back(stage);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief apply all stages in one fft round trip; the output may be
+ * the same field as the input
+ *******************************************************************/
+PetscErrorCode SpectralOperator::Apply(VecField* y, VecField* x) {
+    PetscErrorCode ierr = 0;
+    ScalarType *p_x1 = NULL, *p_x2 = NULL, *p_x3 = NULL, scale;
+    IntType nx[3];
+    int nstages;
+    double applytime;
+    double timer[NFFTTIMERS] = {0};
+    PetscFunctionBegin;
+
+    this->m_Opt->Enter(__func__);
+
+    ierr = Assert(x != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(y != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_x1hat != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_x2hat != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_x3hat != NULL, "null pointer"); CHKERRQ(ierr);
+
+    nx[0] = this->m_Opt->m_Domain.nx[0];
+    nx[1] = this->m_Opt->m_Domain.nx[1];
+    nx[2] = this->m_Opt->m_Domain.nx[2];
+
+    scale = this->m_Opt->ComputeFFTScale();
+    nstages = this->GetNumStages();
+
+    // compute forward fft
+    ierr = x->GetArrays(p_x1, p_x2, p_x3); CHKERRQ(ierr);
+    this->m_Opt->StartTimer(FFTSELFEXEC);
+    accfft_execute_r2c_t(this->m_Opt->m_FFT.plan, p_x1, this->m_x1hat, timer);
+    accfft_execute_r2c_t(this->m_Opt->m_FFT.plan, p_x2, this->m_x2hat, timer);
+    accfft_execute_r2c_t(this->m_Opt->m_FFT.plan, p_x3, this->m_x3hat, timer);
+    this->m_Opt->StopTimer(FFTSELFEXEC);
+    this->m_Opt->IncrementCounter(FFT, 3);
+    ierr = x->RestoreArrays(p_x1, p_x2, p_x3); CHKERRQ(ierr);
+
+    applytime = -MPI_Wtime();
+    PerfCounter::Start(PERFSPECTRAL);
+#pragma omp parallel
+{
+    IntType i, i1, i2, i3, w[3];
+    long int k[3];
+    ScalarType lapik, c, sik, divre, divim, xre[3], xim[3];
+    const Stage* stage = NULL;
+#pragma omp for
+    for (i1 = 0; i1 < this->m_Opt->m_FFT.osize[0]; ++i1) {
+        for (i2 = 0; i2 < this->m_Opt->m_FFT.osize[1]; ++i2) {
+            for (i3 = 0; i3 < this->m_Opt->m_FFT.osize[2]; ++i3) {
+                w[0] = i1 + this->m_Opt->m_FFT.ostart[0];
+                w[1] = i2 + this->m_Opt->m_FFT.ostart[1];
+                w[2] = i3 + this->m_Opt->m_FFT.ostart[2];
+
+                // wave number including nyquist frequency (filter)
+                for (int d = 0; d < 3; ++d) {
+                    k[d] = static_cast<long int>(w[d] > nx[d]/2 ? w[d] - nx[d] : w[d]);
+                }
+
+                // wave number for differential operators (nyquist set to zero)
+                ComputeWaveNumber(w, nx);
+                lapik = -static_cast<ScalarType>(w[0]*w[0] + w[1]*w[1] + w[2]*w[2]);
+
+                i = GetLinearIndex(i1, i2, i3, this->m_Opt->m_FFT.osize);
+
+                xre[0] = this->m_x1hat[i][0]; xim[0] = this->m_x1hat[i][1];
+                xre[1] = this->m_x2hat[i][0]; xim[1] = this->m_x2hat[i][1];
+                xre[2] = this->m_x3hat[i][0]; xim[2] = this->m_x3hat[i][1];
+
+                for (int s = 0; s < nstages; ++s) {
+                    stage = &this->m_Stages[s];
+                    switch (stage->type) {
+                        case SPECPROJECTION:
+                        {
+                            // mean and nyquist modes are divergence free
+                            if (lapik == 0.0) break;
+
+                            // c (k k^T / |k|^2) \hat{x} (real valued symbol; acts
+                            // on real and imaginary part separately)
+                            c = 1.0;
+                            if (stage->param[1] != 0.0) {
+                                c = 1.0/(stage->param[1]*(-lapik + 1.0));
+                                c = 1.0/(stage->param[0]*c + 1.0);
+                            }
+                            c /= -lapik;
+
+                            divre = w[0]*xre[0] + w[1]*xre[1] + w[2]*xre[2];
+                            divim = w[0]*xim[0] + w[1]*xim[1] + w[2]*xim[2];
+                            for (int d = 0; d < 3; ++d) {
+                                xre[d] -= c*w[d]*divre;
+                                xim[d] -= c*w[d]*divim;
+                            }
+                            break;
+                        }
+                        case SPECINVREG:
+                        {
+                            sik = stage->regularization->GetInverseSymbol(lapik, stage->applysqrt);
+                            for (int d = 0; d < 3; ++d) {
+                                xre[d] *= sik; xim[d] *= sik;
+                            }
+                            break;
+                        }
+                        case SPECGAUSSIAN:
+                        {
+                            sik = 0.5*(k[0]*k[0]*stage->param[0]
+                                     + k[1]*k[1]*stage->param[1]
+                                     + k[2]*k[2]*stage->param[2]);
+                            sik = exp(-sik);
+                            for (int d = 0; d < 3; ++d) {
+                                xre[d] *= sik; xim[d] *= sik;
+                            }
+                            break;
+                        }
+                        default:
+                        {
+                            break;
+                        }
+                    }
+                }
+
+                this->m_x1hat[i][0] = scale*xre[0]; this->m_x1hat[i][1] = scale*xim[0];
+                this->m_x2hat[i][0] = scale*xre[1]; this->m_x2hat[i][1] = scale*xim[1];
+                this->m_x3hat[i][0] = scale*xre[2]; this->m_x3hat[i][1] = scale*xim[2];
+            }
+        }
+    }
+}  // pragma omp parallel
+    PerfCounter::Stop(PERFSPECTRAL);
+    applytime += MPI_Wtime();
+    timer[FFTHADAMARD] += applytime;
+
+    // compute inverse fft
+    ierr = y->GetArrays(p_x1, p_x2, p_x3); CHKERRQ(ierr);
+    this->m_Opt->StartTimer(FFTSELFEXEC);
+    accfft_execute_c2r_t(this->m_Opt->m_FFT.plan, this->m_x1hat, p_x1, timer);
+    accfft_execute_c2r_t(this->m_Opt->m_FFT.plan, this->m_x2hat, p_x2, timer);
+    accfft_execute_c2r_t(this->m_Opt->m_FFT.plan, this->m_x3hat, p_x3, timer);
+    this->m_Opt->StopTimer(FFTSELFEXEC);
+    this->m_Opt->IncrementCounter(FFT, 3);
+    ierr = y->RestoreArrays(p_x1, p_x2, p_x3); CHKERRQ(ierr);
+
+    this->m_Opt->IncreaseFFTTimers(timer);
+
+    this->m_Opt->Exit(__func__);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+}  // namespace reg
+
+
+
+
+#endif  // _SPECTRALOPERATOR_CPP_
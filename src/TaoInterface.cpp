@@ -180,6 +180,32 @@ PetscErrorCode PrecondMatVec(PC Hpre, Vec x, Vec Hprex) {
 
 
 
+/****************************************************************************
+ * @brief applies the limited memory bfgs approximation of the inverse
+ * hessian (used as shell preconditioner together with KSPPREONLY, i.e.,
+ * the newton step is replaced by a quasi-newton step)
+ ****************************************************************************/
+PetscErrorCode LBFGSMatVec(PC Hpre, Vec x, Vec Hprex) {
+    PetscErrorCode ierr = 0;
+    void* ptr;
+    Optimizer *optimizer = NULL;
+
+    PetscFunctionBegin;
+
+    ierr = PCShellGetContext(Hpre, &ptr); CHKERRQ(ierr);
+
+    optimizer = reinterpret_cast<Optimizer*>(ptr);
+    ierr = Assert(optimizer != NULL, "null pointer"); CHKERRQ(ierr);
+
+    // apply inverse hessian approximation
+    ierr = optimizer->ApplyLBFGS(Hprex, x); CHKERRQ(ierr);
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
 /****************************************************************************
  * @brief convergence test for optimization
  * @param tao pointer to tao solver
@@ -187,7 +213,7 @@ PetscErrorCode PrecondMatVec(PC Hpre, Vec x, Vec Hprex) {
  ****************************************************************************/
 PetscErrorCode CheckConvergenceGradObj(Tao tao, void* ptr) {
     PetscErrorCode ierr = 0;
-    IntType iter, maxiter, miniter, iterbound;
+    IntType iter, itertao, iteroffset, maxiter, miniter, iterbound;
     OptimizationProblem* optprob = NULL;
     std::stringstream ss, sc;
     ScalarType jx, jxold, gnorm, step, gatol, grtol,
@@ -202,12 +228,20 @@ PetscErrorCode CheckConvergenceGradObj(Tao tao, void* ptr) {
     optprob = reinterpret_cast<OptimizationProblem*>(ptr);
     ierr = Assert(optprob != NULL, "null pointer"); CHKERRQ(ierr);
 
+    // accuracy of pde solves changed in the monitor; terminate the
+    // solve (it is restarted on the new discretization)
+    if (optprob->GetOptions()->m_Monitor.accuracychanged) {
+        ierr = TaoSetConvergedReason(tao, TAO_CONVERGED_USER); CHKERRQ(ierr);
+        PetscFunctionReturn(ierr);
+    }
+
     miniter   = optprob->GetOptions()->m_OptPara.miniter;     // lower bound for iterations
     iterbound = optprob->GetOptions()->m_OptPara.iterbound;   // upper bound for iterations
     gtolbound = optprob->GetOptions()->m_OptPara.gtolbound;   // lower bound for gradient
 
     jxold     = optprob->GetOptions()->m_Monitor.jvalold;     // value of objective from former iteration
     g0norm    = optprob->GetOptions()->m_Monitor.gradnorm0;   // initial norm of gradient
+    iteroffset = optprob->GetOptions()->m_Monitor.iteroffset; // iterations of former solves (restarts)
 
     // compute minimal step size
     minstep = std::pow(2.0, 10.0);
@@ -223,6 +257,7 @@ PetscErrorCode CheckConvergenceGradObj(Tao tao, void* ptr) {
     ierr = TaoGetTolerances(tao, NULL, NULL, &gatol, &grtol, &gttol); CHKERRQ(ierr);
 #endif
     ierr = TaoGetMaximumIterations(tao, &maxiter); CHKERRQ(ierr);
+    maxiter += iteroffset;
     if (maxiter > iterbound) iterbound = maxiter;
 
     // compute tolerances for stopping conditions
@@ -234,8 +269,9 @@ PetscErrorCode CheckConvergenceGradObj(Tao tao, void* ptr) {
     tolg = std::pow(gttol, 1.0/3.0);
 #endif
 
-    // get solution status
-    ierr = TaoGetSolutionStatus(tao, &iter, &jx, &gnorm, NULL, &step, NULL); CHKERRQ(ierr);
+    // get solution status (tao counts from zero after a restart)
+    ierr = TaoGetSolutionStatus(tao, &itertao, &jx, &gnorm, NULL, &step, NULL); CHKERRQ(ierr);
+    iter = itertao + iteroffset;
     ierr = TaoGetSolutionVector(tao, &x); CHKERRQ(ierr);
 
     // compute theta
@@ -262,7 +298,9 @@ PetscErrorCode CheckConvergenceGradObj(Tao tao, void* ptr) {
     for (int i = 0; i < nstop; ++i) stop[i] = false;
 
     // only check convergence criteria after a certain number of iterations
-    if (iter >= miniter && iter > 1) {
+    // (step and former objective are only available after the first
+    // iterations of a (restarted) solve)
+    if (iter >= miniter && itertao > 1) {
         if (step < minstep) {
             ierr = TaoSetConvergedReason(tao, TAO_CONVERGED_STEPTOL); CHKERRQ(ierr);
             PetscFunctionReturn(ierr);
@@ -390,7 +428,7 @@ PetscErrorCode CheckConvergenceGradObj(Tao tao, void* ptr) {
  ****************************************************************************/
 PetscErrorCode CheckConvergenceGrad(Tao tao, void* ptr) {
     PetscErrorCode ierr = 0;
-    IntType iter, maxiter, miniter;
+    IntType iter, itertao, iteroffset, maxiter, miniter;
     OptimizationProblem* optprob = NULL;
     ScalarType J, gnorm, step, gatol, grtol, gttol, g0norm, minstep;
     bool stop[3];
@@ -402,11 +440,19 @@ PetscErrorCode CheckConvergenceGrad(Tao tao, void* ptr) {
     optprob = reinterpret_cast<OptimizationProblem*>(ptr);
     ierr = Assert(optprob != NULL, "null pointer"); CHKERRQ(ierr);
 
+    // accuracy of pde solves changed in the monitor; terminate the
+    // solve (it is restarted on the new discretization)
+    if (optprob->GetOptions()->m_Monitor.accuracychanged) {
+        ierr = TaoSetConvergedReason(tao, TAO_CONVERGED_USER); CHKERRQ(ierr);
+        PetscFunctionReturn(ierr);
+    }
+
     verbosity = optprob->GetOptions()->m_Verbosity;
 
     minstep = std::pow(2.0, 10.0);
     minstep = 1.0 / minstep;
     miniter = optprob->GetOptions()->m_OptPara.miniter;
+    iteroffset = optprob->GetOptions()->m_Monitor.iteroffset;
 
     // get initial gradient
     g0norm = optprob->GetOptions()->m_Monitor.gradnorm0;
@@ -418,8 +464,11 @@ PetscErrorCode CheckConvergenceGrad(Tao tao, void* ptr) {
     ierr = TaoGetTolerances(tao, NULL, NULL, &gatol, &grtol, &gttol); CHKERRQ(ierr);
 #endif
 
+    // iterations are counted over restarts of the solve
     ierr = TaoGetMaximumIterations(tao, &maxiter); CHKERRQ(ierr);
-    ierr = TaoGetSolutionStatus(tao, &iter, &J, &gnorm, NULL, &step, NULL); CHKERRQ(ierr);
+    ierr = TaoGetSolutionStatus(tao, &itertao, &J, &gnorm, NULL, &step, NULL); CHKERRQ(ierr);
+    maxiter += iteroffset;
+    iter = itertao + iteroffset;
 
     // check for NaN value
     if (PetscIsInfOrNanReal(J)) {
@@ -438,7 +487,8 @@ PetscErrorCode CheckConvergenceGrad(Tao tao, void* ptr) {
     // only check convergence criteria after a certain number of iterations
     stop[0] = false; stop[1] = false; stop[2] = false;
     optprob->Converged(false);
-    if (iter >= miniter) {
+    // (the first iterate of a restarted solve has no step yet)
+    if (iter >= miniter && (itertao > 0 || iteroffset == 0)) {
         if (verbosity > 1) {
             ss << "step size in linesearch: " << std::scientific << step;
             ierr = DbgMsg(ss.str()); CHKERRQ(ierr);
@@ -536,6 +586,7 @@ PetscErrorCode OptimizationMonitor(Tao tao, void* ptr) {
     OptimizationProblem* optprob = NULL;
     Vec x = NULL;
     TaoConvergedReason convreason;
+    bool accuracychanged = false;
 
     PetscFunctionBegin;
 
@@ -556,6 +607,13 @@ PetscErrorCode OptimizationMonitor(Tao tao, void* ptr) {
     // save gradient norm
     optprob->GetOptions()->m_Monitor.gradnorm = gnorm;
 
+    // a restarted solve starts at the last iterate of the former solve,
+    // which has already been monitored (see Optimizer::Run)
+    if (iter == 0 && optprob->GetOptions()->m_Monitor.iteroffset > 0) {
+        PetscFunctionReturn(ierr);
+    }
+    iter += optprob->GetOptions()->m_Monitor.iteroffset;
+
     // remember current iterate
     optprob->IncrementIterations();
 
@@ -595,6 +653,20 @@ PetscErrorCode OptimizationMonitor(Tao tao, void* ptr) {
         PetscPrintf(MPI_COMM_WORLD, "%-80s\n", msg);
     }
 
+    // adapt accuracy of pde solves (we are in between two line searches);
+    // tao keeps the objective value of the current iterate as reference
+    // for the next line search; if the discretization changed we terminate
+    // the solve (see convergence tests) and the optimizer restarts it warm
+    // on the new discretization (see Optimizer::Run)
+    if (optprob->GetOptions()->m_PDESolver.adaptaccuracy
+        && convreason == TAO_CONTINUE_ITERATING) {
+        ierr = optprob->AdaptAccuracy(x, gnorm/gnorm0, accuracychanged); CHKERRQ(ierr);
+        if (accuracychanged) {
+            optprob->GetOptions()->m_Monitor.accuracychanged = true;
+            ierr = TaoSetConvergedReason(tao, TAO_CONVERGED_USER); CHKERRQ(ierr);
+        }
+    }
+
     // go home
     PetscFunctionReturn(ierr);
 }
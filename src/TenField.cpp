@@ -21,6 +21,7 @@
 #define _TENFIELD_CPP_
 
 #include "TenField.hpp"
+#include "PointwiseKernel.hpp"
 
 
 
@@ -614,10 +615,7 @@ PetscErrorCode TenField::Scale(Vec s) {
                            p_x21, p_x22, p_x23,
                            p_x31, p_x32, p_x33); CHKERRQ(ierr);
 
-#pragma omp parallel
-{
-#pragma omp for
-    for (IntType i = 0; i < nl; ++i) {
+    PointwiseKernel(nl, [=] (IntType i) {
         ScalarType scale = p_s[i];
         p_x11[i] *= scale;
         p_x12[i] *= scale;
@@ -628,8 +626,7 @@ PetscErrorCode TenField::Scale(Vec s) {
         p_x31[i] *= scale;
         p_x32[i] *= scale;
         p_x33[i] *= scale;
-    }
-} // pragma omp parallel
+    });
 
     // get pointers
     ierr = VecRestoreArray(s, &p_s); CHKERRQ(ierr);
@@ -644,12 +641,23 @@ PetscErrorCode TenField::Scale(Vec s) {
 
 
 /********************************************************************
- * @brief interface for AXPY
+ * @brief interface for AXPY (this = this + s*t); all nine
+ * components are updated in a single pass
  *******************************************************************/
-PetscErrorCode TenField::AXPY(ScalarType s,TenField* t) {
+PetscErrorCode TenField::AXPY(ScalarType s, TenField* t) {
     PetscErrorCode ierr = 0;
+#ifndef REG_HAS_CUDA
+    IntType nl;
+    ScalarType *p_y11 = NULL, *p_y12 = NULL, *p_y13 = NULL,
+               *p_y21 = NULL, *p_y22 = NULL, *p_y23 = NULL,
+               *p_y31 = NULL, *p_y32 = NULL, *p_y33 = NULL;
+    const ScalarType *p_x11 = NULL, *p_x12 = NULL, *p_x13 = NULL,
+                     *p_x21 = NULL, *p_x22 = NULL, *p_x23 = NULL,
+                     *p_x31 = NULL, *p_x32 = NULL, *p_x33 = NULL;
+#endif
     PetscFunctionBegin;
 
+#ifdef REG_HAS_CUDA
     ierr = VecAXPY(this->m_X11, s, t->m_X11); CHKERRQ(ierr);
     ierr = VecAXPY(this->m_X12, s, t->m_X12); CHKERRQ(ierr);
     ierr = VecAXPY(this->m_X13, s, t->m_X13); CHKERRQ(ierr);
@@ -661,23 +669,65 @@ PetscErrorCode TenField::AXPY(ScalarType s,TenField* t) {
     ierr = VecAXPY(this->m_X31, s, t->m_X31); CHKERRQ(ierr);
     ierr = VecAXPY(this->m_X32, s, t->m_X32); CHKERRQ(ierr);
     ierr = VecAXPY(this->m_X33, s, t->m_X33); CHKERRQ(ierr);
+#else
+    ierr = VecGetLocalSize(this->m_X11, &nl); CHKERRQ(ierr);
+    ierr = t->GetArraysRead(p_x11, p_x12, p_x13,
+                            p_x21, p_x22, p_x23,
+                            p_x31, p_x32, p_x33); CHKERRQ(ierr);
+    ierr = this->GetArrays(p_y11, p_y12, p_y13,
+                           p_y21, p_y22, p_y23,
+                           p_y31, p_y32, p_y33); CHKERRQ(ierr);
+
+    PointwiseKernel(nl, [=] (IntType i) {
+        p_y11[i] += s*p_x11[i];
+        p_y12[i] += s*p_x12[i];
+        p_y13[i] += s*p_x13[i];
+        p_y21[i] += s*p_x21[i];
+        p_y22[i] += s*p_x22[i];
+        p_y23[i] += s*p_x23[i];
+        p_y31[i] += s*p_x31[i];
+        p_y32[i] += s*p_x32[i];
+        p_y33[i] += s*p_x33[i];
+    });
+
+    ierr = this->RestoreArrays(p_y11, p_y12, p_y13,
+                               p_y21, p_y22, p_y23,
+                               p_y31, p_y32, p_y33); CHKERRQ(ierr);
+    ierr = t->RestoreArraysRead(p_x11, p_x12, p_x13,
+                                p_x21, p_x22, p_x23,
+                                p_x31, p_x32, p_x33); CHKERRQ(ierr);
+#endif
 
-    PetscFunctionReturn(0);
+    PetscFunctionReturn(ierr);
 }
 
 
 
 
 /********************************************************************
- * @brief interface for WAXPY
+ * @brief interface for WAXPY (this = s*tv + tw); all nine
+ * components are updated in a single pass
  *******************************************************************/
 PetscErrorCode TenField::WAXPY(ScalarType s, TenField* tv, TenField* tw) {
     PetscErrorCode ierr = 0;
+#ifndef REG_HAS_CUDA
+    IntType nl;
+    ScalarType *p_y11 = NULL, *p_y12 = NULL, *p_y13 = NULL,
+               *p_y21 = NULL, *p_y22 = NULL, *p_y23 = NULL,
+               *p_y31 = NULL, *p_y32 = NULL, *p_y33 = NULL;
+    const ScalarType *p_v11 = NULL, *p_v12 = NULL, *p_v13 = NULL,
+                     *p_v21 = NULL, *p_v22 = NULL, *p_v23 = NULL,
+                     *p_v31 = NULL, *p_v32 = NULL, *p_v33 = NULL,
+                     *p_w11 = NULL, *p_w12 = NULL, *p_w13 = NULL,
+                     *p_w21 = NULL, *p_w22 = NULL, *p_w23 = NULL,
+                     *p_w31 = NULL, *p_w32 = NULL, *p_w33 = NULL;
+#endif
     PetscFunctionBegin;
 
-    ierr = VecWAXPY(this->m_X11, s,tv->m_X11, tw->m_X11); CHKERRQ(ierr);
-    ierr = VecWAXPY(this->m_X12, s,tv->m_X12, tw->m_X12); CHKERRQ(ierr);
-    ierr = VecWAXPY(this->m_X13, s,tv->m_X13, tw->m_X13); CHKERRQ(ierr);
+#ifdef REG_HAS_CUDA
+    ierr = VecWAXPY(this->m_X11, s, tv->m_X11, tw->m_X11); CHKERRQ(ierr);
+    ierr = VecWAXPY(this->m_X12, s, tv->m_X12, tw->m_X12); CHKERRQ(ierr);
+    ierr = VecWAXPY(this->m_X13, s, tv->m_X13, tw->m_X13); CHKERRQ(ierr);
 
     ierr = VecWAXPY(this->m_X21, s, tv->m_X21, tw->m_X21); CHKERRQ(ierr);
     ierr = VecWAXPY(this->m_X22, s, tv->m_X22, tw->m_X22); CHKERRQ(ierr);
@@ -686,6 +736,40 @@ PetscErrorCode TenField::WAXPY(ScalarType s, TenField* tv, TenField* tw) {
     ierr = VecWAXPY(this->m_X31, s, tv->m_X31, tw->m_X31); CHKERRQ(ierr);
     ierr = VecWAXPY(this->m_X32, s, tv->m_X32, tw->m_X32); CHKERRQ(ierr);
     ierr = VecWAXPY(this->m_X33, s, tv->m_X33, tw->m_X33); CHKERRQ(ierr);
+#else
+    ierr = VecGetLocalSize(this->m_X11, &nl); CHKERRQ(ierr);
+    ierr = tv->GetArraysRead(p_v11, p_v12, p_v13,
+                             p_v21, p_v22, p_v23,
+                             p_v31, p_v32, p_v33); CHKERRQ(ierr);
+    ierr = tw->GetArraysRead(p_w11, p_w12, p_w13,
+                             p_w21, p_w22, p_w23,
+                             p_w31, p_w32, p_w33); CHKERRQ(ierr);
+    ierr = this->GetArrays(p_y11, p_y12, p_y13,
+                           p_y21, p_y22, p_y23,
+                           p_y31, p_y32, p_y33); CHKERRQ(ierr);
+
+    PointwiseKernel(nl, [=] (IntType i) {
+        p_y11[i] = s*p_v11[i] + p_w11[i];
+        p_y12[i] = s*p_v12[i] + p_w12[i];
+        p_y13[i] = s*p_v13[i] + p_w13[i];
+        p_y21[i] = s*p_v21[i] + p_w21[i];
+        p_y22[i] = s*p_v22[i] + p_w22[i];
+        p_y23[i] = s*p_v23[i] + p_w23[i];
+        p_y31[i] = s*p_v31[i] + p_w31[i];
+        p_y32[i] = s*p_v32[i] + p_w32[i];
+        p_y33[i] = s*p_v33[i] + p_w33[i];
+    });
+
+    ierr = this->RestoreArrays(p_y11, p_y12, p_y13,
+                               p_y21, p_y22, p_y23,
+                               p_y31, p_y32, p_y33); CHKERRQ(ierr);
+    ierr = tw->RestoreArraysRead(p_w11, p_w12, p_w13,
+                                 p_w21, p_w22, p_w23,
+                                 p_w31, p_w32, p_w33); CHKERRQ(ierr);
+    ierr = tv->RestoreArraysRead(p_v11, p_v12, p_v13,
+                                 p_v21, p_v22, p_v23,
+                                 p_v31, p_v32, p_v33); CHKERRQ(ierr);
+#endif
 
     PetscFunctionReturn(ierr);
 }
@@ -0,0 +1,346 @@
+/*************************************************************************
+ *  Copyright (c) 2018.
+ *  All rights reserved.
+ *  This file is part of the CLAIRE library.
+ *
+ *  CLAIRE is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CLAIRE is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CLAIRE.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#ifndef _TRACER_CPP_
+#define _TRACER_CPP_
+
+#include <map>
+#include <algorithm>
+#include <cstring>
+#include "Tracer.hpp"
+
+
+
+
+namespace reg {
+
+
+
+
+/********************************************************************
+ * @brief default constructor
+ *******************************************************************/
+Tracer::Tracer() {
+    this->m_NumThreads = 0;
+    this->m_T0 = 0.0;
+    this->m_Enabled = false;
+}
+
+
+
+
+/********************************************************************
+ * @brief default destructor
+ *******************************************************************/
+Tracer::~Tracer() {
+}
+
+
+
+
+/********************************************************************
+ * @brief allocate ring buffers; we synchronize the ranks before we
+ * take the reference time, so that the traces of all ranks can be
+ * overlaid
+ *******************************************************************/
+PetscErrorCode Tracer::Initialize(size_t nevents) {
+    PetscErrorCode ierr = 0;
+    int rval;
+    PetscFunctionBegin;
+
+    ierr = Assert(nevents > 0, "trace buffer size must be positive"); CHKERRQ(ierr);
+
+    this->m_Enabled = false;
+    this->m_NumThreads = omp_get_max_threads();
+    try {
+        this->m_Buffer.resize(this->m_NumThreads);
+        for (int i = 0; i < this->m_NumThreads; ++i) {
+            this->m_Buffer[i].events.resize(nevents);
+            this->m_Buffer[i].head = 0;
+            this->m_Buffer[i].count = 0;
+            this->m_Buffer[i].dropped = 0;
+        }
+    } catch (std::bad_alloc& err) {
+        ierr = reg::ThrowError(err); CHKERRQ(ierr);
+    }
+
+    rval = MPI_Barrier(PETSC_COMM_WORLD);
+    ierr = Assert(rval == MPI_SUCCESS, "mpi error"); CHKERRQ(ierr);
+    this->m_T0 = MPI_Wtime();
+    this->m_Enabled = true;
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief match begin/end events and compute spans (with self time);
+ * end events whose begin event has been overwritten are ignored;
+ * spans that are still open are closed at the last event
+ *******************************************************************/
+PetscErrorCode Tracer::ComputeSpans(std::vector<Span>& spans) {
+    PetscErrorCode ierr = 0;
+    PetscFunctionBegin;
+
+    spans.clear();
+    for (int tid = 0; tid < this->m_NumThreads; ++tid) {
+        const Buffer& b = this->m_Buffer[tid];
+        const size_t n = b.events.size();
+        std::vector<Span> stack;
+        std::vector<double> children;
+        double tlast = 0.0;
+
+        for (size_t k = 0; k < b.count; ++k) {
+            const Event& e = b.events[(b.head + n - b.count + k) % n];
+            tlast = e.time;
+            if (e.begin) {
+                Span s;
+                s.thread = tid;
+                s.name = e.name;
+                s.start = e.time;
+                s.duration = 0.0;
+                s.self = 0.0;
+                stack.push_back(s);
+                children.push_back(0.0);
+                continue;
+            }
+
+            // find matching begin event (names are static strings)
+            int j = static_cast<int>(stack.size()) - 1;
+            while (j >= 0 && stack[j].name != e.name && strcmp(stack[j].name, e.name) != 0) --j;
+            if (j < 0) continue;
+
+            // close spans (also unbalanced inner ones)
+            while (static_cast<int>(stack.size()) > j) {
+                Span s = stack.back();
+                s.duration = e.time - s.start;
+                s.self = s.duration - children.back();
+                stack.pop_back(); children.pop_back();
+                if (!children.empty()) children.back() += s.duration;
+                spans.push_back(s);
+            }
+        }
+
+        while (!stack.empty()) {
+            Span s = stack.back();
+            s.duration = tlast - s.start;
+            s.self = s.duration - children.back();
+            stack.pop_back(); children.pop_back();
+            if (!children.empty()) children.back() += s.duration;
+            spans.push_back(s);
+        }
+    }
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief write trace of this rank in chrome trace event format
+ * (complete events; time stamps in micro seconds)
+ *******************************************************************/
+PetscErrorCode Tracer::WriteTrace(std::string filename, const std::vector<Span>& spans) {
+    PetscErrorCode ierr = 0;
+    std::ofstream file;
+    int rank;
+    PetscFunctionBegin;
+
+    MPI_Comm_rank(PETSC_COMM_WORLD, &rank);
+
+    file.open(filename.c_str());
+    ierr = Assert(file.is_open(), "could not open file for writing"); CHKERRQ(ierr);
+
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" << std::endl;
+    file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << rank
+         << ",\"args\":{\"name\":\"rank " << rank << "\"}}";
+    file << std::fixed << std::setprecision(3);
+    for (size_t i = 0; i < spans.size(); ++i) {
+        file << "," << std::endl
+             << "{\"name\":\"" << spans[i].name << "\",\"cat\":\"claire\",\"ph\":\"X\""
+             << ",\"ts\":" << 1E6*(spans[i].start - this->m_T0)
+             << ",\"dur\":" << 1E6*spans[i].duration
+             << ",\"pid\":" << rank << ",\"tid\":" << spans[i].thread << "}";
+    }
+    file << std::endl << "]}" << std::endl;
+    file.close();
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief write summary on rank 0; for each span we report the self
+ * time on the slowest rank; since the solver is bulk synchronous,
+ * the sum of these times is an estimate for the critical path; we
+ * only consider the master thread of each rank
+ *******************************************************************/
+PetscErrorCode Tracer::WriteSummary(std::string filename, const std::vector<Span>& spans) {
+    PetscErrorCode ierr = 0;
+    std::map<std::string, std::vector<double> > local;
+    std::map<std::string, std::vector<double> >::iterator it;
+    std::stringstream ss;
+    std::string buffer;
+    std::vector<int> sizes, offsets;
+    std::vector<char> recv;
+    unsigned long dropped = 0, droppedall = 0;
+    int rank, nproc, n, rval;
+    PetscFunctionBegin;
+
+    MPI_Comm_rank(PETSC_COMM_WORLD, &rank);
+    MPI_Comm_size(PETSC_COMM_WORLD, &nproc);
+
+    // accumulate: inclusive time, self time, count
+    for (size_t i = 0; i < spans.size(); ++i) {
+        if (spans[i].thread != 0) continue;
+        std::vector<double>& v = local[spans[i].name];
+        if (v.empty()) v.assign(3, 0.0);
+        v[0] += spans[i].duration;
+        v[1] += spans[i].self;
+        v[2] += 1.0;
+    }
+    for (it = local.begin(); it != local.end(); ++it) {
+        ss << it->first << " " << std::scientific << std::setprecision(9)
+           << it->second[0] << " " << it->second[1] << " " << it->second[2] << "\n";
+    }
+    buffer = ss.str();
+    for (int i = 0; i < this->m_NumThreads; ++i) dropped += this->m_Buffer[i].dropped;
+
+    // gather tables on rank 0
+    n = static_cast<int>(buffer.size());
+    sizes.resize(nproc); offsets.resize(nproc);
+    rval = MPI_Gather(&n, 1, MPI_INT, sizes.data(), 1, MPI_INT, 0, PETSC_COMM_WORLD);
+    ierr = Assert(rval == MPI_SUCCESS, "mpi error"); CHKERRQ(ierr);
+    if (rank == 0) {
+        offsets[0] = 0;
+        for (int p = 1; p < nproc; ++p) offsets[p] = offsets[p-1] + sizes[p-1];
+        recv.resize(offsets[nproc-1] + sizes[nproc-1] + 1);
+    }
+    rval = MPI_Gatherv(const_cast<char*>(buffer.data()), n, MPI_CHAR, recv.data(),
+                       sizes.data(), offsets.data(), MPI_CHAR, 0, PETSC_COMM_WORLD);
+    ierr = Assert(rval == MPI_SUCCESS, "mpi error"); CHKERRQ(ierr);
+    rval = MPI_Reduce(&dropped, &droppedall, 1, MPI_UNSIGNED_LONG, MPI_SUM, 0, PETSC_COMM_WORLD);
+    ierr = Assert(rval == MPI_SUCCESS, "mpi error"); CHKERRQ(ierr);
+
+    if (rank != 0) {
+        PetscFunctionReturn(ierr);
+    }
+
+    // merge: per span max/avg of self time, max inclusive time
+    struct Entry {double maxself, sumself, maxincl, count; int rankmax;};
+    std::map<std::string, Entry> table;
+    std::vector<std::pair<double, std::string> > order;
+    double critpath = 0.0;
+    for (int p = 0; p < nproc; ++p) {
+        std::istringstream is(std::string(recv.data() + offsets[p], sizes[p]));
+        std::string name;
+        double incl, self, count;
+        while (is >> name >> incl >> self >> count) {
+            Entry& e = table[name];
+            if (e.count == 0.0) {e.maxself = -1.0; e.sumself = 0.0; e.maxincl = 0.0; e.rankmax = 0;}
+            if (self > e.maxself) {e.maxself = self; e.rankmax = p;}
+            e.sumself += self;
+            e.maxincl = std::max(e.maxincl, incl);
+            e.count = std::max(e.count, count);
+        }
+    }
+    for (std::map<std::string, Entry>::iterator t = table.begin(); t != table.end(); ++t) {
+        order.push_back(std::make_pair(t->second.maxself, t->first));
+        critpath += t->second.maxself;
+    }
+    std::sort(order.rbegin(), order.rend());
+
+    std::ofstream file(filename.c_str());
+    ierr = Assert(file.is_open(), "could not open file for writing"); CHKERRQ(ierr);
+    file << "# trace summary (" << nproc << " ranks; master thread; times in seconds)" << std::endl;
+    file << "# critical path estimate (sum of max self time): " << std::scientific << critpath << std::endl;
+    if (droppedall != 0) {
+        file << "# warning: " << droppedall << " events were overwritten (increase -tracebuffer)" << std::endl;
+    }
+    file << std::left << std::setw(48) << "# span"
+         << std::right << std::setw(16) << "max self" << std::setw(16) << "avg self"
+         << std::setw(10) << "imbal" << std::setw(8) << "rank"
+         << std::setw(16) << "max incl" << std::setw(10) << "calls" << std::setw(9) << "crit %" << std::endl;
+    for (size_t i = 0; i < order.size(); ++i) {
+        const Entry& e = table[order[i].second];
+        double avg = e.sumself/static_cast<double>(nproc);
+        file << std::left << std::setw(48) << order[i].second
+             << std::right << std::scientific << std::setprecision(6)
+             << std::setw(16) << e.maxself << std::setw(16) << avg
+             << std::fixed << std::setprecision(2)
+             << std::setw(10) << (avg > 0.0 ? e.maxself/avg : 1.0)
+             << std::setw(8) << e.rankmax << std::scientific << std::setprecision(6)
+             << std::setw(16) << e.maxincl << std::setw(10) << static_cast<long>(e.count)
+             << std::fixed << std::setprecision(1)
+             << std::setw(9) << (critpath > 0.0 ? 100.0*e.maxself/critpath : 0.0)
+             << std::endl;
+    }
+    file.close();
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief write trace of each rank (trace-rank<id>.json) and merged
+ * summary (trace-summary.log); collective
+ *******************************************************************/
+PetscErrorCode Tracer::Write(std::string path, std::string postfix) {
+    PetscErrorCode ierr = 0;
+    std::vector<Span> spans;
+    std::stringstream ss;
+    int rank;
+    PetscFunctionBegin;
+
+    if (!this->m_Enabled) {
+        PetscFunctionReturn(ierr);
+    }
+
+    // stop recording while we process the buffers
+    this->m_Enabled = false;
+
+    MPI_Comm_rank(PETSC_COMM_WORLD, &rank);
+
+    ierr = this->ComputeSpans(spans); CHKERRQ(ierr);
+
+    ss << path << "trace-rank" << rank << postfix << ".json";
+    ierr = this->WriteTrace(ss.str(), spans); CHKERRQ(ierr);
+    ierr = this->WriteSummary(path + "trace-summary" + postfix + ".log", spans); CHKERRQ(ierr);
+
+    this->m_Enabled = true;
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+}  // namespace reg
+
+
+
+
+#endif  // _TRACER_CPP_
@@ -21,6 +21,7 @@
 #define _VECFIELD_CPP_
 
 #include "VecField.hpp"
+#include "PointwiseKernel.hpp"
 
 
 
@@ -98,6 +99,12 @@ PetscErrorCode VecField::Initialize(void) {
     this->m_X2 = NULL;
     this->m_X3 = NULL;
 
+    this->m_PlacedVec = NULL;
+    this->m_PlacedArray = NULL;
+    this->m_PlacedReadOnly = false;
+
+    this->m_LocalVec = NULL;
+
     PetscFunctionReturn(ierr);
 }
 
@@ -111,6 +118,8 @@ PetscErrorCode VecField::ClearMemory() {
     PetscErrorCode ierr = 0;
     PetscFunctionBegin;
 
+    ierr = this->ResetComponents(); CHKERRQ(ierr);
+
     if (this->m_X1 != NULL) {
         ierr = VecDestroy(&this->m_X1); CHKERRQ(ierr);
         this->m_X1 = NULL;
@@ -123,6 +132,10 @@ PetscErrorCode VecField::ClearMemory() {
         ierr = VecDestroy(&this->m_X3); CHKERRQ(ierr);
         this->m_X3 = NULL;
     }
+    if (this->m_LocalVec != NULL) {
+        ierr = VecDestroy(&this->m_LocalVec); CHKERRQ(ierr);
+        this->m_LocalVec = NULL;
+    }
 
     PetscFunctionReturn(0);
 }
@@ -248,6 +261,11 @@ PetscErrorCode VecField::Allocate(IntType nl, IntType ng) {
         ierr = VecSetFromOptions(this->m_X3); CHKERRQ(ierr);
     #endif
 
+    // place pages with the thread that operates on them
+    ierr = FirstTouch(this->m_X1); CHKERRQ(ierr);
+    ierr = FirstTouch(this->m_X2); CHKERRQ(ierr);
+    ierr = FirstTouch(this->m_X3); CHKERRQ(ierr);
+
     PetscFunctionReturn(ierr);
 }
 
@@ -473,6 +491,95 @@ PetscErrorCode VecField::GetComponents(Vec w) {
 
 
 
+/********************************************************************
+ * @brief alias the individual components of the vector field to
+ * the blocks [x1|x2|x3] of a flat petsc vector; this avoids the
+ * copies in Set/GetComponents for transient fields; the view has
+ * to be released with ResetComponents before the flat vector is
+ * used elsewhere
+ * @param[in] w flat vector of local size 3*nl
+ * @param[in] readonly if true, the components must not be written;
+ * otherwise the view holds the content of w and is written back by
+ * ResetComponents (i.e., it can be used in place)
+ *******************************************************************/
+PetscErrorCode VecField::PlaceComponents(Vec w, bool readonly) {
+    PetscErrorCode ierr = 0;
+    IntType nl, n;
+    PetscFunctionBegin;
+
+    ierr = Assert(w != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_X1 != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_X2 != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_X3 != NULL, "null pointer"); CHKERRQ(ierr);
+    ierr = Assert(this->m_PlacedVec == NULL, "components already placed"); CHKERRQ(ierr);
+
+    ierr = VecGetLocalSize(w, &n); CHKERRQ(ierr);
+    ierr = VecGetLocalSize(this->m_X1, &nl); CHKERRQ(ierr);
+    ierr = Assert(n == 3*nl, "dimension mismatch"); CHKERRQ(ierr);
+
+    this->m_PlacedVec = w;
+    this->m_PlacedReadOnly = readonly;
+
+#ifdef REG_HAS_CUDA
+    // device arrays are managed by petsc; fall back to copies
+    ierr = this->SetComponents(w); CHKERRQ(ierr);
+#else
+    if (readonly) {
+        const ScalarType *p_w = NULL;
+        ierr = VecGetArrayRead(w, &p_w); CHKERRQ(ierr);
+        this->m_PlacedArray = const_cast<ScalarType*>(p_w);
+    } else {
+        ierr = VecGetArray(w, &this->m_PlacedArray); CHKERRQ(ierr);
+    }
+    ierr = VecPlaceArray(this->m_X1, this->m_PlacedArray       ); CHKERRQ(ierr);
+    ierr = VecPlaceArray(this->m_X2, this->m_PlacedArray +   nl); CHKERRQ(ierr);
+    ierr = VecPlaceArray(this->m_X3, this->m_PlacedArray + 2*nl); CHKERRQ(ierr);
+#endif
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief release the view created by PlaceComponents; the
+ * components point to their own storage again
+ *******************************************************************/
+PetscErrorCode VecField::ResetComponents() {
+    PetscErrorCode ierr = 0;
+    PetscFunctionBegin;
+
+    if (this->m_PlacedVec == NULL) {
+        PetscFunctionReturn(ierr);
+    }
+
+#ifdef REG_HAS_CUDA
+    if (!this->m_PlacedReadOnly) {
+        ierr = this->GetComponents(this->m_PlacedVec); CHKERRQ(ierr);
+    }
+#else
+    ierr = VecResetArray(this->m_X1); CHKERRQ(ierr);
+    ierr = VecResetArray(this->m_X2); CHKERRQ(ierr);
+    ierr = VecResetArray(this->m_X3); CHKERRQ(ierr);
+    if (this->m_PlacedReadOnly) {
+        const ScalarType *p_w = this->m_PlacedArray;
+        ierr = VecRestoreArrayRead(this->m_PlacedVec, &p_w); CHKERRQ(ierr);
+    } else {
+        ierr = VecRestoreArray(this->m_PlacedVec, &this->m_PlacedArray); CHKERRQ(ierr);
+    }
+#endif
+
+    this->m_PlacedVec = NULL;
+    this->m_PlacedArray = NULL;
+    this->m_PlacedReadOnly = false;
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
 /********************************************************************
  * @brief scale vector by scalar value
  *******************************************************************/
@@ -507,17 +614,12 @@ PetscErrorCode VecField::Scale(Vec s) {
     ierr = GetRawPointer(s, &p_s); CHKERRQ(ierr);
     ierr = this->GetArrays(p_v1, p_v2, p_v3); CHKERRQ(ierr);
 
-#pragma omp parallel
-{
-    ScalarType scale;
-#pragma omp for
-    for (IntType i = 0; i < nl; ++i) {
-        scale = p_s[i];
+    PointwiseKernel(nl, [=] (IntType i) {
+        ScalarType scale = p_s[i];
         p_v1[i] = scale*p_v1[i];
         p_v2[i] = scale*p_v2[i];
         p_v3[i] = scale*p_v3[i];
-    }
-}  // pragma omp parallel
+    });
 
     // get pointers
     ierr = this->RestoreArrays(p_v1, p_v2, p_v3); CHKERRQ(ierr);
@@ -548,17 +650,12 @@ PetscErrorCode VecField::Scale(VecField* v, Vec s) {
     ierr = this->GetArrays(p_v1, p_v2, p_v3); CHKERRQ(ierr);
     ierr = v->GetArrays(p_sv1, p_sv2, p_sv3); CHKERRQ(ierr);
 
-#pragma omp parallel
-{
-    ScalarType scale;
-#pragma omp for
-    for (IntType i = 0; i < nl; ++i) {
-        scale = p_s[i];
+    PointwiseKernel(nl, [=] (IntType i) {
+        ScalarType scale = p_s[i];
         p_sv1[i] = scale*p_v1[i];
         p_sv2[i] = scale*p_v2[i];
         p_sv3[i] = scale*p_v3[i];
-    }
-}  // pragma omp parallel
+    });
 
     // get pointers
     ierr = RestoreRawPointer(s, &p_s); CHKERRQ(ierr);
@@ -572,16 +669,36 @@ PetscErrorCode VecField::Scale(VecField* v, Vec s) {
 
 
 /********************************************************************
- * @brief interface for AXPY
+ * @brief interface for AXPY (this = this + s*v); all three
+ * components are updated in a single pass
  *******************************************************************/
 PetscErrorCode VecField::AXPY(ScalarType s, VecField* v) {
     PetscErrorCode ierr = 0;
-
+#ifndef REG_HAS_CUDA
+    IntType nl;
+    ScalarType *p_y1 = NULL, *p_y2 = NULL, *p_y3 = NULL;
+    const ScalarType *p_x1 = NULL, *p_x2 = NULL, *p_x3 = NULL;
+#endif
     PetscFunctionBegin;
 
+#ifdef REG_HAS_CUDA
     ierr = VecAXPY(this->m_X1, s, v->m_X1); CHKERRQ(ierr);
     ierr = VecAXPY(this->m_X2, s, v->m_X2); CHKERRQ(ierr);
     ierr = VecAXPY(this->m_X3, s, v->m_X3); CHKERRQ(ierr);
+#else
+    ierr = VecGetLocalSize(this->m_X1, &nl); CHKERRQ(ierr);
+    ierr = v->GetArraysRead(p_x1, p_x2, p_x3); CHKERRQ(ierr);
+    ierr = this->GetArraysReadWrite(p_y1, p_y2, p_y3); CHKERRQ(ierr);
+
+    PointwiseKernel(nl, [=] (IntType i) {
+        p_y1[i] += s*p_x1[i];
+        p_y2[i] += s*p_x2[i];
+        p_y3[i] += s*p_x3[i];
+    });
+
+    ierr = this->RestoreArraysReadWrite(p_y1, p_y2, p_y3); CHKERRQ(ierr);
+    ierr = v->RestoreArraysRead(p_x1, p_x2, p_x3); CHKERRQ(ierr);
+#endif
 
     PetscFunctionReturn(ierr);
 }
@@ -590,16 +707,77 @@ PetscErrorCode VecField::AXPY(ScalarType s, VecField* v) {
 
 
 /********************************************************************
- * @brief interface for WAXPY
+ * @brief interface for AYPX (this = v + s*this); all three
+ * components are updated in a single pass
  *******************************************************************/
-PetscErrorCode VecField::WAXPY(ScalarType s, VecField* v, VecField* w) {
+PetscErrorCode VecField::AYPX(ScalarType s, VecField* v) {
     PetscErrorCode ierr = 0;
+#ifndef REG_HAS_CUDA
+    IntType nl;
+    ScalarType *p_y1 = NULL, *p_y2 = NULL, *p_y3 = NULL;
+    const ScalarType *p_x1 = NULL, *p_x2 = NULL, *p_x3 = NULL;
+#endif
+    PetscFunctionBegin;
+
+#ifdef REG_HAS_CUDA
+    ierr = VecAYPX(this->m_X1, s, v->m_X1); CHKERRQ(ierr);
+    ierr = VecAYPX(this->m_X2, s, v->m_X2); CHKERRQ(ierr);
+    ierr = VecAYPX(this->m_X3, s, v->m_X3); CHKERRQ(ierr);
+#else
+    ierr = VecGetLocalSize(this->m_X1, &nl); CHKERRQ(ierr);
+    ierr = v->GetArraysRead(p_x1, p_x2, p_x3); CHKERRQ(ierr);
+    ierr = this->GetArraysReadWrite(p_y1, p_y2, p_y3); CHKERRQ(ierr);
 
+    PointwiseKernel(nl, [=] (IntType i) {
+        p_y1[i] = p_x1[i] + s*p_y1[i];
+        p_y2[i] = p_x2[i] + s*p_y2[i];
+        p_y3[i] = p_x3[i] + s*p_y3[i];
+    });
+
+    ierr = this->RestoreArraysReadWrite(p_y1, p_y2, p_y3); CHKERRQ(ierr);
+    ierr = v->RestoreArraysRead(p_x1, p_x2, p_x3); CHKERRQ(ierr);
+#endif
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief interface for WAXPY (this = s*v + w); all three
+ * components are updated in a single pass
+ *******************************************************************/
+PetscErrorCode VecField::WAXPY(ScalarType s, VecField* v, VecField* w) {
+    PetscErrorCode ierr = 0;
+#ifndef REG_HAS_CUDA
+    IntType nl;
+    ScalarType *p_y1 = NULL, *p_y2 = NULL, *p_y3 = NULL;
+    const ScalarType *p_v1 = NULL, *p_v2 = NULL, *p_v3 = NULL,
+                     *p_w1 = NULL, *p_w2 = NULL, *p_w3 = NULL;
+#endif
     PetscFunctionBegin;
 
+#ifdef REG_HAS_CUDA
     ierr = VecWAXPY(this->m_X1, s, v->m_X1, w->m_X1); CHKERRQ(ierr);
     ierr = VecWAXPY(this->m_X2, s, v->m_X2, w->m_X2); CHKERRQ(ierr);
     ierr = VecWAXPY(this->m_X3, s, v->m_X3, w->m_X3); CHKERRQ(ierr);
+#else
+    ierr = VecGetLocalSize(this->m_X1, &nl); CHKERRQ(ierr);
+    ierr = v->GetArraysRead(p_v1, p_v2, p_v3); CHKERRQ(ierr);
+    ierr = w->GetArraysRead(p_w1, p_w2, p_w3); CHKERRQ(ierr);
+    ierr = this->GetArrays(p_y1, p_y2, p_y3); CHKERRQ(ierr);
+
+    PointwiseKernel(nl, [=] (IntType i) {
+        p_y1[i] = s*p_v1[i] + p_w1[i];
+        p_y2[i] = s*p_v2[i] + p_w2[i];
+        p_y3[i] = s*p_v3[i] + p_w3[i];
+    });
+
+    ierr = this->RestoreArrays(p_y1, p_y2, p_y3); CHKERRQ(ierr);
+    ierr = w->RestoreArraysRead(p_w1, p_w2, p_w3); CHKERRQ(ierr);
+    ierr = v->RestoreArraysRead(p_v1, p_v2, p_v3); CHKERRQ(ierr);
+#endif
 
     PetscFunctionReturn(ierr);
 }
@@ -689,6 +867,152 @@ PetscErrorCode VecField::Norm(ScalarType& nvx1, ScalarType& nvx2, ScalarType& nv
 }
 
 
+
+
+/********************************************************************
+ * @brief allocate sequential vector used to access the local part of
+ * the components without copying (device builds)
+ *******************************************************************/
+PetscErrorCode VecField::SetupLocalVector(IntType nl) {
+    PetscErrorCode ierr = 0;
+    PetscFunctionBegin;
+
+    if (this->m_LocalVec == NULL) {
+        ierr = VecCreate(PETSC_COMM_SELF, &this->m_LocalVec); CHKERRQ(ierr);
+        ierr = VecSetSizes(this->m_LocalVec, nl, nl); CHKERRQ(ierr);
+    #ifdef REG_HAS_CUDA
+        ierr = VecSetType(this->m_LocalVec, VECSEQCUDA); CHKERRQ(ierr);
+    #else
+        ierr = VecSetType(this->m_LocalVec, VECSEQ); CHKERRQ(ierr);
+    #endif
+    }
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief compute local part of squared l2 norm of vector field; the
+ * caller is responsible for the reduction across ranks
+ *******************************************************************/
+PetscErrorCode VecField::SquaredNormLocal(ScalarType& value) {
+    PetscErrorCode ierr = 0;
+    ScalarType nvx1, nvx2, nvx3;
+
+    PetscFunctionBegin;
+
+    ierr = this->SquaredNormLocal(nvx1, nvx2, nvx3); CHKERRQ(ierr);
+    value = nvx1 + nvx2 + nvx3;
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
+/********************************************************************
+ * @brief compute local part of squared l2 norm of the individual
+ * components of the vector field (no reduction)
+ *******************************************************************/
+PetscErrorCode VecField::SquaredNormLocal(ScalarType& nvx1, ScalarType& nvx2, ScalarType& nvx3) {
+    PetscErrorCode ierr = 0;
+    IntType nl;
+#ifdef REG_HAS_CUDA
+    Vec x[3];
+    ScalarType v[3];
+#else
+    ScalarType v1 = 0.0, v2 = 0.0, v3 = 0.0;
+    const ScalarType *p_x1 = NULL, *p_x2 = NULL, *p_x3 = NULL;
+#endif
+
+    PetscFunctionBegin;
+
+    ierr = VecGetLocalSize(this->m_X1, &nl); CHKERRQ(ierr);
+
+#ifdef REG_HAS_CUDA
+    // dot products of the local (sequential) parts stay on the device
+    ierr = this->SetupLocalVector(nl); CHKERRQ(ierr);
+    x[0] = this->m_X1; x[1] = this->m_X2; x[2] = this->m_X3;
+    for (int i = 0; i < 3; ++i) {
+        ierr = VecGetLocalVectorRead(x[i], this->m_LocalVec); CHKERRQ(ierr);
+        ierr = VecDot(this->m_LocalVec, this->m_LocalVec, &v[i]); CHKERRQ(ierr);
+        ierr = VecRestoreLocalVectorRead(x[i], this->m_LocalVec); CHKERRQ(ierr);
+    }
+    nvx1 = v[0]; nvx2 = v[1]; nvx3 = v[2];
+#else
+    ierr = VecGetArrayRead(this->m_X1, &p_x1); CHKERRQ(ierr);
+    ierr = VecGetArrayRead(this->m_X2, &p_x2); CHKERRQ(ierr);
+    ierr = VecGetArrayRead(this->m_X3, &p_x3); CHKERRQ(ierr);
+#pragma omp parallel for reduction(+:v1,v2,v3)
+    for (IntType i = 0; i < nl; ++i) {
+        v1 += p_x1[i]*p_x1[i];
+        v2 += p_x2[i]*p_x2[i];
+        v3 += p_x3[i]*p_x3[i];
+    }
+    ierr = VecRestoreArrayRead(this->m_X1, &p_x1); CHKERRQ(ierr);
+    ierr = VecRestoreArrayRead(this->m_X2, &p_x2); CHKERRQ(ierr);
+    ierr = VecRestoreArrayRead(this->m_X3, &p_x3); CHKERRQ(ierr);
+
+    nvx1 = v1; nvx2 = v2; nvx3 = v3;
+#endif
+
+    PetscFunctionReturn(ierr);
+}
+
+
+/********************************************************************
+ * @brief compute local part of the max norm of the vector field (over
+ * all components); the caller is responsible for the reduction
+ *******************************************************************/
+PetscErrorCode VecField::NormInfLocal(ScalarType& value) {
+    PetscErrorCode ierr = 0;
+    IntType nl;
+    ScalarType vmax = 0.0;
+#ifdef REG_HAS_CUDA
+    Vec x[3];
+    ScalarType vi;
+#else
+    const ScalarType *p_x1 = NULL, *p_x2 = NULL, *p_x3 = NULL;
+#endif
+
+    PetscFunctionBegin;
+
+    ierr = VecGetLocalSize(this->m_X1, &nl); CHKERRQ(ierr);
+
+#ifdef REG_HAS_CUDA
+    ierr = this->SetupLocalVector(nl); CHKERRQ(ierr);
+    x[0] = this->m_X1; x[1] = this->m_X2; x[2] = this->m_X3;
+    for (int i = 0; i < 3; ++i) {
+        ierr = VecGetLocalVectorRead(x[i], this->m_LocalVec); CHKERRQ(ierr);
+        ierr = VecNorm(this->m_LocalVec, NORM_INFINITY, &vi); CHKERRQ(ierr);
+        ierr = VecRestoreLocalVectorRead(x[i], this->m_LocalVec); CHKERRQ(ierr);
+        vmax = PetscMax(vmax, vi);
+    }
+#else
+    ierr = VecGetArrayRead(this->m_X1, &p_x1); CHKERRQ(ierr);
+    ierr = VecGetArrayRead(this->m_X2, &p_x2); CHKERRQ(ierr);
+    ierr = VecGetArrayRead(this->m_X3, &p_x3); CHKERRQ(ierr);
+#pragma omp parallel for reduction(max:vmax)
+    for (IntType i = 0; i < nl; ++i) {
+        vmax = PetscMax(vmax, PetscAbsReal(p_x1[i]));
+        vmax = PetscMax(vmax, PetscAbsReal(p_x2[i]));
+        vmax = PetscMax(vmax, PetscAbsReal(p_x3[i]));
+    }
+    ierr = VecRestoreArrayRead(this->m_X1, &p_x1); CHKERRQ(ierr);
+    ierr = VecRestoreArrayRead(this->m_X2, &p_x2); CHKERRQ(ierr);
+    ierr = VecRestoreArrayRead(this->m_X3, &p_x3); CHKERRQ(ierr);
+#endif
+
+    value = vmax;
+
+    PetscFunctionReturn(ierr);
+}
+
+
+
+
 /********************************************************************
  * @brief print debug info
  *******************************************************************/
@@ -5,6 +5,7 @@
 #include <mpi.h>
 #include <accfft.h>
 #include <interp3.hpp>
+#include "CommCounter.hpp"
 //#define VERBOSE2
 
 /*
@@ -114,6 +115,11 @@ void ghost_left_right(pvfmm::Iterator<Real> padded_data, Real* data, int g_size,
 	MPI_Wait(&rs_s_request, &ierr);
 	MPI_Wait(&rs_r_request, &ierr);
 
+	if (nprocs_r > 1) {
+		double nbytes = static_cast<double>(rs_buf_size + ls_buf_size) * sizeof(Real);
+		reg::CommCounter::Add(reg::COMMGHOST, nbytes, nbytes, 2, 2, nprocs_r > 2 ? 2 : 1);
+	}
+
 #ifdef VERBOSE2
 	if(procid==1) {
 		for (int i=0;i<isize[0];++i) {
@@ -282,6 +288,11 @@ void ghost_top_bottom(pvfmm::Iterator<Real> ghost_data, pvfmm::Iterator<Real> pa
 	MPI_Wait(&ts_s_request, &ierr);
 	MPI_Wait(&ts_r_request, &ierr);
 
+	if (nprocs_c > 1) {
+		double nbytes = static_cast<double>(bs_buf_size + ts_buf_size) * sizeof(Real);
+		reg::CommCounter::Add(reg::COMMGHOST, nbytes, nbytes, 2, 2, nprocs_c > 2 ? 2 : 1);
+	}
+
 #ifdef VERBOSE2
 	if(procid==0) {
 		std::cout<<"procid= "<<procid<<" padded_array=\n";
@@ -4089,6 +4089,75 @@ void interp3_ghost_xyz_p(Real* reg_grid_vals, int data_dof, int* N_reg,
 
 }  // end of interp3_ghost_xyz_p
 
+/*
+ * Performs a 3D (tri)linear interpolation for a row major periodic input (x \in [0,1) )
+ * This function assumes that the input grid values have been padded on all sides
+ * by g_size grids (g_size >= 1). The layout of the input and the query points is
+ * identical to the cubic interp3_ghost_xyz_p; only the stencil (2x2x2) differs.
+ * @param[in] reg_grid_vals The function value at the regular grid
+ * @param[in] data_dof The degrees of freedom of the input function.
+ * @param[in] N_reg An integer pointer that specifies the size of the grid in each dimension.
+ * @param[in] N_pts The number of query points
+ * @param[in] g_size The number of ghost points padded around the input array
+ * @param[in] query_points The coordinates of the query points where the interpolated values are sought.
+ * @param[out] query_values The interpolated values
+ */
+void lin_interp3_ghost_xyz_p(Real* reg_grid_vals, int data_dof, int* N_reg,
+		int* N_reg_g, int * isize_g, int* istart, const int N_pts,
+		const int g_size, Real* query_points_in, Real* query_values,
+		bool query_values_already_scaled) {
+	Real* query_points;
+
+	if (query_values_already_scaled == false) {
+		query_points = (Real*) malloc(N_pts * COORD_DIM * sizeof(Real));
+		memcpy(query_points, query_points_in, N_pts * COORD_DIM * sizeof(Real));
+		rescale_xyz(g_size, N_reg, N_reg_g, istart, N_pts, query_points);
+	} else {
+		query_points = query_points_in;
+	}
+	const int N_reg3 = isize_g[0] * isize_g[1] * isize_g[2];
+
+#pragma omp parallel for
+	for (int i = 0; i < N_pts; i++) {
+		Real M[COORD_DIM][2];
+		int grid_indx[COORD_DIM];
+
+		for (int j = 0; j < COORD_DIM; j++) {
+			Real point = query_points[COORD_DIM * i + j];
+			grid_indx[j] = floor(point);
+			point -= grid_indx[j];
+			while (grid_indx[j] < 0)
+				grid_indx[j] += N_reg_g[j];
+			M[j][0] = 1.0 - point;
+			M[j][1] = point;
+		}
+
+		for (int k = 0; k < data_dof; k++) {
+			Real val = 0;
+			for (int j2 = 0; j2 < 2; j2++) {
+				for (int j1 = 0; j1 < 2; j1++) {
+					for (int j0 = 0; j0 < 2; j0++) {
+						int indx = ((grid_indx[2] + j2) % isize_g[2])
+								+ isize_g[2]
+										* ((grid_indx[1] + j1) % isize_g[1])
+								+ isize_g[2] * isize_g[1]
+										* ((grid_indx[0] + j0) % isize_g[0]);
+						val += M[0][j0] * M[1][j1] * M[2][j2]
+								* reg_grid_vals[indx + k * N_reg3];
+					}
+				}
+			}
+			query_values[i + k * N_pts] = val;
+		}
+	}
+
+	if (query_values_already_scaled == false) {
+		free(query_points);
+	}
+	return;
+
+}  // end of lin_interp3_ghost_xyz_p
+
 /*
  * Performs a 3D cubic interpolation for a row major periodic input (x \in [0,1) )
  * This function assumes that the input grid values have been padded on all sides